@@ -0,0 +1,265 @@
+/** \file
+    \brief Batch decoding of bit streams.
+    \details This header file contains a function that decodes many
+        independent buffers, such as packets, in parallel.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_BATCH_HPP
+#define BOOST_BITSTREAM_BATCH_HPP
+
+#include <boost/bitstream/cursor.hpp>
+#include <boost/config.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <ios>
+#include <vector>
+
+#if !defined(BOOST_NO_CXX11_HDR_THREAD) && !defined(BOOST_NO_CXX11_HDR_ATOMIC)
+#  define BOOST_BITSTREAM_BATCH_THREADS
+#  include <atomic>
+#  include <system_error>
+#  include <thread>
+#endif
+
+namespace boost {
+
+namespace bitstream {
+
+// bit_range //////////////////////////////////////////////////////////////////
+
+/**
+    This class represents one buffer of a batch: a char array and the number
+	of bits in it.
+*/
+struct bit_range
+{
+	/**
+		Constructor.
+
+		\param[in] buffer_ Pointer to char array.
+		\param[in] bits_ Number of bits in char array.
+	*/
+	bit_range(const char *buffer_ = NULL, std::streamsize bits_ = 0) :
+		buffer(buffer_), bits(bits_)
+	{
+		// Do nothing.
+	}
+
+	/**
+		Pointer to char array.
+	*/
+	const char *buffer;
+
+	/**
+		Number of bits in char array.
+	*/
+	std::streamsize bits;
+};
+
+namespace detail {
+
+/**
+	This class holds what the workers of one decode_batch() call share.
+
+	\note Only next is written by more than one thread. Each result and
+	state is written by whichever worker claimed its index.
+*/
+template <typename Decoder, typename Result>
+struct batch_job
+{
+	const bit_range *ranges;
+	size_t count;
+	size_t chunk;
+	const Decoder *decoder;
+	Result *results;
+	std::ios_base::iostate *states;
+#ifdef BOOST_BITSTREAM_BATCH_THREADS
+	std::atomic<size_t> next;
+#else
+	size_t next;
+#endif
+
+	/**
+		Claim the next chunk of items.
+
+		\param[out] begin Index of first item of chunk.
+		\param[out] end Index just past last item of chunk.
+		\return Whether there was anything left to claim.
+	*/
+	bool claim(size_t &begin, size_t &end)
+	{
+#ifdef BOOST_BITSTREAM_BATCH_THREADS
+		begin = next.fetch_add(chunk, std::memory_order_relaxed);
+#else
+		begin = next;
+		next += chunk;
+#endif
+		end = std::min(count, begin + chunk);
+
+		return begin < count;
+	}
+
+	/**
+		Decode chunks until there are none left.
+
+		\note Each worker has its own copy of the decoder, so any scratch
+		state the decoder keeps is per thread.
+	*/
+	void work()
+	{
+		Decoder decoder(*this->decoder);
+		size_t begin, end;
+		while (claim(begin, end))
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				std::ios_base::iostate state;
+				try
+				{
+					bit_reader r(ranges[i].buffer, ranges[i].bits);
+					decoder(r, results[i]);
+					state = r.fail() ? std::ios_base::failbit :
+						r.eof() ? std::ios_base::eofbit : std::ios_base::goodbit;
+				}
+				catch (...)
+				{
+					state = std::ios_base::badbit;
+				}
+
+				if (states != NULL)
+				{
+					states[i] = state;
+				}
+			}
+		}
+	}
+};
+
+#ifdef BOOST_BITSTREAM_BATCH_THREADS
+template <typename Job>
+void run_batch_job(Job *job)
+{
+	job->work();
+}
+#endif
+
+} // namespace detail
+
+// Batch decoding /////////////////////////////////////////////////////////////
+
+/**
+	Decode each of many independent buffers.
+
+	\note Each buffer is read by its own bit_reader, so nothing is shared
+	between items, not even a repeat count. The items are split into chunks
+	that the calling thread and threads - 1 other threads claim as they go,
+	so a slow item holds up only its own chunk. Results are written in the
+	order of the buffers.
+
+	\note Failure is per item and reported in states rather than by
+	exception: failbit if the reader failed, i.e., a field ran past the end
+	or a constant did not match; eofbit if all bits were read; goodbit if
+	some were left over; and badbit if the decoder threw. Decoders may also
+	mark an item as failed by calling r.setstate().
+
+	\param[in] ranges Array of buffers.
+	\param[in] count Number of buffers.
+	\param[in] decoder Function object called as decoder(bit_reader &,
+	Result &) for each buffer; each thread calls its own copy.
+	\param[out] results Array of count results.
+	\param[out] states Array of count states, or NULL.
+	\param[in] threads Number of threads to decode with, including the
+	calling one; 0 for as many as there are hardware threads. Without
+	C++11 threads, the calling thread does it all.
+*/
+template <typename Decoder, typename Result>
+void decode_batch(const bit_range *ranges, size_t count, Decoder decoder,
+	Result *results, std::ios_base::iostate *states = NULL,
+	unsigned threads = 0)
+{
+	detail::batch_job<Decoder, Result> job;
+	job.ranges = ranges;
+	job.count = count;
+	job.decoder = &decoder;
+	job.results = results;
+	job.states = states;
+	job.next = 0;
+
+#ifdef BOOST_BITSTREAM_BATCH_THREADS
+	if (threads == 0)
+	{
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// Several chunks per thread evens out items of different cost, but
+	// chunks are big enough that claiming one is rare.
+	job.chunk = std::max(size_t(1), std::min(size_t(256), count / (threads * 8)));
+
+	std::vector<std::thread> workers;
+	workers.reserve(threads - 1);
+	for (unsigned i = 1; i < threads && i * job.chunk < count; ++i)
+	{
+		try
+		{
+			workers.push_back(std::thread(detail::run_batch_job<
+				detail::batch_job<Decoder, Result> >, &job));
+		}
+		catch (const std::system_error &)
+		{
+			// Do with the threads there are.
+			break;
+		}
+	}
+
+	job.work();
+
+	for (size_t i = 0; i < workers.size(); ++i)
+	{
+		workers[i].join();
+	}
+#else
+	job.chunk = count;
+	job.work();
+#endif
+}
+
+/**
+	Decode each of many independent buffers.
+
+	\note See decode_batch(const bit_range *, size_t, Decoder, Result *,
+	std::ios_base::iostate *, unsigned). results and states are resized to
+	the number of buffers.
+
+	\param[in] ranges Buffers.
+	\param[in] decoder Function object called as decoder(bit_reader &,
+	Result &) for each buffer.
+	\param[out] results Results, in the order of the buffers.
+	\param[out] states States, in the order of the buffers.
+	\param[in] threads Number of threads to decode with; 0 for as many as
+	there are hardware threads.
+*/
+template <typename Decoder, typename Result>
+void decode_batch(const std::vector<bit_range> &ranges, Decoder decoder,
+	std::vector<Result> &results, std::vector<std::ios_base::iostate> &states,
+	unsigned threads = 0)
+{
+	results.resize(ranges.size());
+	states.resize(ranges.size());
+	if (!ranges.empty())
+	{
+		decode_batch(&ranges[0], ranges.size(), decoder, &results[0],
+			&states[0], threads);
+	}
+}
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
@@ -16,6 +16,9 @@
 
 #include <bitset>
 #include <boost/typeof/typeof.hpp>
+#include <boost/type_traits/is_base_of.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/utility/enable_if.hpp>
 #include <boost/bitstream/istream.hpp>
 #include <boost/bitstream/ostream.hpp>
 
@@ -53,7 +56,7 @@ public:
         \param[in] which Open mode.
     */
     explicit ibitstream(std::ios_base::openmode which = std::ios_base::in) :
-        m_bitbuf(which), istream(&m_bitbuf)
+        istream(&m_bitbuf), m_bitbuf(which)
     {
     }
 
@@ -66,10 +69,56 @@ public:
     */
     explicit ibitstream(const char *buffer, std::streamsize size_,
         std::ios_base::openmode which = std::ios_base::in) :
-        m_bitbuf(buffer, size_, which), istream(&m_bitbuf)
+        istream(&m_bitbuf), m_bitbuf(buffer, size_, which)
     {
     }
 
+	/**
+		Constructor.
+
+		\note E.g., ibitstream(buffer, size, lsb_first) for DEFLATE. See
+		bitbuf::order().
+
+		\param[in] buffer Pointer to char array to be accessed.
+		\param[in] size_ Number of accessible bits in char array.
+		\param[in] order Order in which bits of char array are numbered.
+		\param[in] which Open mode.
+	*/
+	ibitstream(const char *buffer, std::streamsize size_, bit_order order,
+		std::ios_base::openmode which = std::ios_base::in) :
+		istream(&m_bitbuf), m_bitbuf(buffer, size_, which)
+	{
+		m_bitbuf.order(order);
+	}
+
+	/**
+		Constructor.
+
+		\note The stream reads from its own copy of bb, which is cheap
+		because a plain bitbuf refers to bits rather than owning them. This
+		is for the result of istream::substream() or bitbuf::slice(), which
+		are plain bitbufs; the bits must outlive the stream. A class derived
+		from bitbuf, which would be sliced to its bitbuf part, does not
+		compile here; use ibitstream(bitbuf *) for it.
+
+		\param[in] bb Buffer whose bits are to be accessed.
+	*/
+	explicit ibitstream(const bitbuf &bb) : istream(&m_bitbuf), m_bitbuf(bb)
+	{
+	}
+
+	/**
+		Constructor.
+
+		\note The stream reads from bb instead of its own buffer, e.g., a
+		streambitbuf. bb must outlive the stream.
+
+		\param[in] bb Buffer from which to extract bits.
+	*/
+	explicit ibitstream(bitbuf *bb) : istream(bb), m_bitbuf(std::ios_base::in)
+	{
+	}
+
     /**
         Get the bitbuf object associated with the stream upon construction.
 
@@ -77,7 +126,7 @@ public:
     */
     bitbuf *rdbuf() const
     {
-        return const_cast<BOOST_TYPEOF(rdbuf())>(&m_bitbuf);
+        return iob::rdbuf();
     }
 
     /**
@@ -102,10 +151,21 @@ public:
 		*/
 	void data(char *buffer, std::streamsize size_)
 	{
-		m_bitbuf.data(buffer, size_);
+		iob::rdbuf()->data(buffer, size_);
 	}
 
 private:
+	/**
+		Constructor, declared but not defined, that catches classes derived
+		from bitbuf, which ibitstream(const bitbuf &) would slice.
+
+		\param[in] bb Buffer that is not a plain bitbuf.
+	*/
+	template <typename Bitbuf>
+	explicit ibitstream(const Bitbuf &bb, typename boost::enable_if_c<
+		boost::is_base_of<bitbuf, Bitbuf>::value &&
+		!boost::is_same<bitbuf, Bitbuf>::value>::type * = NULL);
+
     /**
         Buffer from which this class serially extracts bits.
     */
@@ -133,7 +193,7 @@ public:
         \param[in] which Open mode.
     */
     explicit obitstream(std::ios_base::openmode which = std::ios_base::out) :
-        m_bitbuf(which), ostream(&m_bitbuf)
+        ostream(&m_bitbuf), m_bitbuf(which)
     {
     }
 
@@ -146,10 +206,39 @@ public:
     */
     explicit obitstream(const char *buffer, std::streamsize size_,
         std::ios_base::openmode which = std::ios_base::out) :
-        m_bitbuf(buffer, size_, which), ostream(&m_bitbuf)
+        ostream(&m_bitbuf), m_bitbuf(buffer, size_, which)
     {
     }
 
+	/**
+		Constructor.
+
+		\note E.g., obitstream(buffer, size, lsb_first) for DEFLATE. See
+		bitbuf::order().
+
+		\param[in] buffer Pointer to char array to be accessed.
+		\param[in] size_ Number of accessible bits in char array.
+		\param[in] order Order in which bits of char array are numbered.
+		\param[in] which Open mode.
+	*/
+	obitstream(const char *buffer, std::streamsize size_, bit_order order,
+		std::ios_base::openmode which = std::ios_base::out) :
+		ostream(&m_bitbuf), m_bitbuf(buffer, size_, which)
+	{
+		m_bitbuf.order(order);
+	}
+
+	/**
+		Destructor.
+
+		\note Bits still collected by the stream are written to the buffer
+		here because the buffer is destroyed before the base class.
+	*/
+	~obitstream()
+	{
+		flush();
+	}
+
     /**
         Get pointer to current contents of the stream.
 
@@ -0,0 +1,390 @@
+/** \file
+    \brief Scatter-gather bit-stream buffer.
+    \details This header file contains a bitbuf that accesses the bits of
+        a chain of separate char arrays as one sequence.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_CHAINBUF_HPP
+#define BOOST_BITSTREAM_CHAINBUF_HPP
+
+#include <boost/bitstream/iob.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace boost {
+
+namespace bitstream {
+
+// chainbitbuf ////////////////////////////////////////////////////////////////
+
+/**
+    This class represents a chain of char arrays, such as NIC buffers or IP
+	fragments, accessed as one sequence of bits.
+
+    \note The get area is the current segment, so a field that lies within
+	one segment is extracted on the usual inline path. Only a field that
+	straddles segments goes through xsgetn(), which assembles it from the
+	pieces; nothing is copied to linearize the chain.
+
+	\note Positions are bit offsets from the start of the first segment.
+	Segments are not owned and must outlive their use.
+
+    \note This is an input buffer; its output sequence is empty.
+*/
+class chainbitbuf : public bitbuf
+{
+public:
+	/**
+		Type of segment: pointer to char array and number of bytes in it.
+	*/
+	typedef std::pair<const char *, std::size_t> segment;
+
+	/**
+		Constructor.
+
+		\note The chain is empty until assign() is called.
+	*/
+	chainbitbuf() : bitbuf(std::ios_base::in), m_segment(0), m_bits(0)
+	{
+		setg(NULL, 0, 0, 0);
+		setp(NULL, 0, 0);
+	}
+
+	/**
+		Constructor.
+
+		\param[in] first Iterator to first segment.
+		\param[in] last Iterator just past last segment.
+	*/
+	template <typename InputIterator>
+	chainbitbuf(InputIterator first, InputIterator last) :
+		bitbuf(std::ios_base::in), m_segment(0), m_bits(0)
+	{
+		assign(first, last);
+	}
+
+	/**
+		Replace chain of segments and position at start of first one.
+
+		\note Storage for the chain is reused, so a chainbitbuf can be kept
+		for decoding packet after packet.
+
+		\param[in] first Iterator to first segment.
+		\param[in] last Iterator just past last segment.
+	*/
+	template <typename InputIterator>
+	void assign(InputIterator first, InputIterator last)
+	{
+		m_segments.clear();
+		m_starts.clear();
+		m_bits = 0;
+		for (; first != last; ++first)
+		{
+			const segment s(first->first, first->second);
+			m_segments.push_back(s);
+			m_starts.push_back(m_bits);
+			m_bits += static_cast<bitpos>(s.second) * CHAR_BIT;
+		}
+
+		setp(NULL, 0, 0);
+		select(0);
+	}
+
+	/**
+		Get number of bits in chain.
+
+		\return Number of bits in all segments.
+	*/
+	bitpos bits() const
+	{
+		return m_bits;
+	}
+
+protected:
+	// Virtual buffer-management and positioning functions ////////////////////
+
+	/**
+		Set buffer to access.
+
+		\note Not supported; use assign().
+
+		\return NULL.
+	*/
+	virtual bitbuf *setbuf(unsigned char *, std::streamsize)
+	{
+		return NULL;
+	}
+
+	/**
+		Determine whether slices may be made of the get area.
+
+		\note Not supported. A slice could only be made within the current
+		segment, so it would fail at the end of one even though the bits
+		carry on in the next.
+
+		\return false.
+	*/
+	virtual bool sliceable() const
+	{
+		return false;
+	}
+
+	/**
+		Set get pointer relative to current position.
+
+		\param[in] offset Amount by which get pointer is adjusted.
+		\param[in] way From which pointer offset is applied for new position.
+		\param[in] which Open mode.
+		\return New position after get pointer modified.
+	*/
+	virtual std::streampos seekoff(std::streamoff offset,
+		std::ios_base::seekdir way,
+		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+	{
+		bitpos new_position = bitpos(-1);
+
+		if ((which & std::ios_base::in) != 0)
+		{
+			switch (way)
+			{
+			case std::ios_base::beg:
+				new_position = seek(offset);
+				break;
+
+			case std::ios_base::cur:
+				new_position = seek(position() + offset);
+				break;
+
+			case std::ios_base::end:
+				new_position = seek(m_bits + offset);
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		return std::streampos(new_position);
+	}
+
+	/**
+		Set get pointer to absolute position.
+
+		\param[in] position New absolute position for get pointer.
+		\param[in] which Open mode.
+		\return New position after get pointer modified or
+		std::streampos(-1) if error.
+	*/
+	virtual std::streampos seekpos(std::streampos position,
+		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+	{
+		bitpos new_position = bitpos(-1);
+
+		if ((which & std::ios_base::in) != 0)
+		{
+			new_position = seek(std::streamoff(position));
+		}
+
+		return std::streampos(new_position);
+	}
+
+	// Virtual input functions ////////////////////////////////////////////////
+
+	/**
+		Get number of bits available beyond the current segment.
+
+		\return Number of bits in later segments; -1 if none.
+	*/
+	virtual std::streamsize showmanyb()
+	{
+		const bitpos available = m_bits - position();
+
+		return available > 0 ? available : -1;
+	}
+
+	/**
+		Get sequence of bits.
+
+		\note This is only called when the field does not fit in what is left
+		of the current segment. The field is assembled from as many segments
+		as it spans, or, if the chain is too short, nothing is read.
+
+		\param[out] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits read from buffer or zero if error or eof.
+	*/
+	virtual std::streamsize xsgetn(bitfield &value, std::streamsize size)
+	{
+		std::streamsize bits_read = 0;
+
+		if (size > 0 &&
+			size <= static_cast<std::streamsize>(sizeof value * CHAR_BIT) &&
+			size <= m_bits - position())
+		{
+			bitfield field = 0;
+			for (std::streamsize left = size; left > 0; )
+			{
+				if (gptr() == egptr())
+				{
+					select(m_segment + 1);
+				}
+
+				const std::streamsize piece_size = std::min(left,
+					static_cast<std::streamsize>(egptr() - gptr()));
+				if (piece_size > 0)
+				{
+					bitfield piece = 0;
+					bitbuf::xsgetn(piece, piece_size);
+					field = piece_size == size ? piece :
+						order() == lsb_first ? field | (piece << (size - left)) :
+						(field << piece_size) | piece;
+					left -= piece_size;
+				}
+			}
+
+			value = field;
+			bits_read = size;
+		}
+
+		return bits_read;
+	}
+
+	/**
+		Get sequence of bits without advancing get pointer.
+
+		\note See xsgetn(). The field is assembled the same way, then the get
+		area is put back as it was.
+
+		\param[out] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits peeked at or zero if error or eof.
+	*/
+	virtual std::streamsize xspeekn(bitfield &value, std::streamsize size)
+	{
+		const size_t segment = m_segment;
+		const bitpos get_position = gptr();
+
+		const std::streamsize bits_read = xsgetn(value, size);
+
+		select(segment);
+		gbump(get_position);
+
+		return bits_read;
+	}
+
+	/**
+		Get bit without changing current position.
+
+		\param[out] value Bit at the current position.
+		\return Whether there are more bits to read.
+	*/
+	virtual bool underflow(bitfield &value)
+	{
+		while (gptr() == egptr() && m_segment + 1 < m_segments.size())
+		{
+			select(m_segment + 1);
+		}
+
+		return bitbuf::underflow(value);
+	}
+
+private:
+	/**
+		Get absolute position of get pointer.
+
+		\return Position of next bit to be read.
+	*/
+	bitpos position() const
+	{
+		return (m_segments.empty() ? 0 : m_starts[m_segment]) + gptr();
+	}
+
+	/**
+		Make segment the get area, positioned at its start.
+
+		\param[in] index Index of segment; if past the last segment, the get
+		area is empty.
+	*/
+	void select(size_t index)
+	{
+		if (index < m_segments.size())
+		{
+			m_segment = index;
+			setg(reinterpret_cast<unsigned char *>(
+				const_cast<char *>(m_segments[index].first)), 0, 0,
+				static_cast<bitpos>(m_segments[index].second) * CHAR_BIT);
+		}
+		else
+		{
+			m_segment = m_segments.empty() ? 0 : m_segments.size() - 1;
+			setg(NULL, 0, 0, 0);
+		}
+	}
+
+	/**
+		Move get pointer to position.
+
+		\param[in] position Absolute bit position.
+		\return position if successful; otherwise, bitpos(-1).
+	*/
+	bitpos seek(bitpos position)
+	{
+		bitpos new_position = bitpos(-1);
+
+		if (position >= 0 && position <= m_bits)
+		{
+			// Find the last segment that starts at or before position, which
+			// is the last non-empty one at the very end of the chain.
+			size_t index = static_cast<size_t>(std::upper_bound(
+				m_starts.begin(), m_starts.end(), position) - m_starts.begin());
+			index = index == 0 ? 0 : index - 1;
+			while (index > 0 && m_starts[index] == m_bits && position == m_bits)
+			{
+				--index;
+			}
+
+			select(index);
+			if (!m_segments.empty())
+			{
+				gbump(position - m_starts[index]);
+			}
+			new_position = position;
+		}
+
+		return new_position;
+	}
+
+	/**
+		Segments of chain.
+	*/
+	std::vector<segment> m_segments;
+
+	/**
+		Absolute bit position of start of each segment.
+	*/
+	std::vector<bitpos> m_starts;
+
+	/**
+		Index of current segment.
+	*/
+	size_t m_segment;
+
+	/**
+		Number of bits in chain.
+	*/
+	bitpos m_bits;
+};
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
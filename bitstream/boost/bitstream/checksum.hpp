@@ -0,0 +1,1087 @@
+/** \file
+    \brief Checksums computed while reading and writing.
+    \details This header file contains CRCs and the Internet checksum, and a
+        bitbuf decorator that updates one over the bits a stream reads or
+        writes, so that no second pass over the buffer is needed.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_CHECKSUM_HPP
+#define BOOST_BITSTREAM_CHECKSUM_HPP
+
+#include <boost/bitstream/istream.hpp>
+#include <boost/bitstream/ostream.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/endian/conversion.hpp>
+#include <boost/integer.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <cstring>
+
+#if defined(__SSE4_2__)
+#  define BOOST_BITSTREAM_CRC32C_SSE42
+#  include <nmmintrin.h>
+#endif
+#if defined(__ARM_FEATURE_CRC32)
+#  define BOOST_BITSTREAM_CRC32_ARM
+#  include <arm_acle.h>
+#endif
+
+namespace boost {
+
+namespace bitstream {
+
+namespace detail {
+
+/**
+	Which instruction, if any, computes a CRC 64 bits at a time: 0 for none,
+	so slicing-by-8 is used; 1 for SSE4.2 crc32 (CRC-32C); 2 for ARMv8
+	crc32c; 3 for ARMv8 crc32 (CRC-32).
+*/
+template <size_t Bits, boost::uint64_t Polynomial, bool Reflected>
+struct crc_instruction
+{
+	static const int value =
+#if defined(BOOST_BITSTREAM_CRC32C_SSE42)
+		Bits == 32 && Polynomial == 0x1EDC6F41 && Reflected ? 1 :
+#endif
+#if defined(BOOST_BITSTREAM_CRC32_ARM)
+		Bits == 32 && Polynomial == 0x1EDC6F41 && Reflected ? 2 :
+		Bits == 32 && Polynomial == 0x04C11DB7 && Reflected ? 3 :
+#endif
+		0;
+};
+
+/**
+	Reverse the low bits of an integral.
+
+	\param[in] value Bits to reverse.
+	\param[in] bits Number of low bits.
+	\return Bits in reverse order.
+*/
+inline boost::uint64_t reflect_bits(boost::uint64_t value, size_t bits)
+{
+	boost::uint64_t reflected = 0;
+	for (size_t i = 0; i < bits; ++i, value >>= 1)
+	{
+		reflected = (reflected << 1) | (value & 1);
+	}
+
+	return reflected;
+}
+
+} // namespace detail
+
+// crc ////////////////////////////////////////////////////////////////////////
+
+/**
+    Objects of this class compute a cyclic redundancy check of up to 64 bits,
+	with parameters as in the Rocksoft model, e.g., for CRC-32,
+	crc<32, 0x04C11DB7, 0xFFFFFFFF, true, 0xFFFFFFFF>.
+
+	\note Bytes are processed eight at a time with slicing-by-8 tables, one
+	set of 16 KiB per type, built at static initialization. Where the
+	compiler targets it, CRC-32C uses the SSE4.2 crc32 instruction, and
+	CRC-32 and CRC-32C the ARMv8 CRC instructions, instead.
+
+	\tparam Bits Width of CRC, 1 through 64.
+	\tparam Polynomial Generator polynomial, without its top term.
+	\tparam Initial Initial value of register.
+	\tparam Reflected Whether bytes are processed LSB first and the result
+	is reflected, as for CRC-32; otherwise, MSB first.
+	\tparam FinalXor Value combined with register to give checksum().
+*/
+template <size_t Bits, boost::uint64_t Polynomial, boost::uint64_t Initial,
+	bool Reflected, boost::uint64_t FinalXor>
+class crc
+{
+public:
+	BOOST_STATIC_ASSERT(Bits > 0 && Bits <= 64);
+
+	/**
+		Type of checksum.
+	*/
+	typedef typename boost::uint_t<Bits>::least value_type;
+
+	/**
+		Constructor.
+	*/
+	crc() : m_register(initial_register())
+	{
+		// Do nothing.
+	}
+
+	/**
+		Start over.
+	*/
+	void reset()
+	{
+		m_register = initial_register();
+	}
+
+	/**
+		Process bytes.
+
+		\param[in] bytes Bytes to process.
+		\param[in] count Number of bytes.
+	*/
+	void process_bytes(const unsigned char *bytes, size_t count)
+	{
+		const boost::integral_constant<int, detail::crc_instruction<Bits,
+			Polynomial, Reflected>::value> instruction;
+
+		for (; count >= sizeof(boost::uint64_t); count -= sizeof(boost::uint64_t),
+			bytes += sizeof(boost::uint64_t))
+		{
+			boost::uint64_t block;
+			std::memcpy(&block, bytes, sizeof block);
+			process_block(block, instruction);
+		}
+
+		for (; count > 0; --count, ++bytes)
+		{
+			m_register = Reflected ?
+				(m_register >> CHAR_BIT) ^ s_tables.table[0][(m_register ^ *bytes) & 0xff] :
+				(m_register << CHAR_BIT) ^ s_tables.table[0][
+					(m_register >> 56 ^ *bytes) & 0xff];
+		}
+	}
+
+	/**
+		Process part of a byte, the last of the checksum.
+
+		\param[in] byte Byte to process.
+		\param[in] bits Number of bits of byte to process, which are its high
+		bits in msb_first order, or its low bits in lsb_first order.
+		\param[in] order Order of bits in byte.
+	*/
+	void process_bits(unsigned char byte, size_t bits, bit_order order)
+	{
+		const size_t low = order == msb_first ? CHAR_BIT - bits : 0;
+		for (size_t i = 0; i < bits; ++i)
+		{
+			const size_t bit = Reflected ? low + i : low + bits - 1 - i;
+			process_bit((byte >> bit) & 1);
+		}
+	}
+
+	/**
+		Get checksum of what has been processed.
+
+		\return Checksum.
+	*/
+	value_type checksum() const
+	{
+		const boost::uint64_t value = Reflected ? m_register :
+			m_register >> (64 - Bits);
+
+		return static_cast<value_type>((value ^ FinalXor) & mask());
+	}
+
+private:
+	/**
+		Slicing-by-8 tables: table[k][b] is the register after byte b and k
+		zero bytes.
+	*/
+	struct tables
+	{
+		tables()
+		{
+			for (size_t b = 0; b < 256; ++b)
+			{
+				boost::uint64_t r = Reflected ? b : boost::uint64_t(b) << 56;
+				for (int i = 0; i < CHAR_BIT; ++i)
+				{
+					r = Reflected ? (r >> 1) ^ ((r & 1) != 0 ? polynomial() : 0) :
+						(r << 1) ^ ((r >> 63) != 0 ? polynomial() : 0);
+				}
+				table[0][b] = r;
+			}
+			for (size_t k = 1; k < 8; ++k)
+			{
+				for (size_t b = 0; b < 256; ++b)
+				{
+					const boost::uint64_t r = table[k - 1][b];
+					table[k][b] = Reflected ? (r >> CHAR_BIT) ^ table[0][r & 0xff] :
+						(r << CHAR_BIT) ^ table[0][r >> 56];
+				}
+			}
+		}
+
+		boost::uint64_t table[8][256];
+	};
+
+	/**
+		Get mask of checksum bits.
+
+		\return Mask.
+	*/
+	static boost::uint64_t mask()
+	{
+		return ~boost::uint64_t(0) >> (64 - Bits);
+	}
+
+	/**
+		Get polynomial as it is applied to register: reflected, or
+		left-justified in 64 bits.
+
+		\return Polynomial.
+	*/
+	static boost::uint64_t polynomial()
+	{
+		return Reflected ? detail::reflect_bits(Polynomial & mask(), Bits) :
+			(Polynomial & mask()) << (64 - Bits);
+	}
+
+	/**
+		Get initial value of register.
+
+		\return Register.
+	*/
+	static boost::uint64_t initial_register()
+	{
+		return Reflected ? detail::reflect_bits(Initial & mask(), Bits) :
+			(Initial & mask()) << (64 - Bits);
+	}
+
+	/**
+		Process one bit.
+
+		\param[in] bit Bit to process.
+	*/
+	void process_bit(unsigned bit)
+	{
+		if (Reflected)
+		{
+			m_register ^= bit;
+			m_register = (m_register >> 1) ^ ((m_register & 1) != 0 ? polynomial() : 0);
+		}
+		else
+		{
+			m_register ^= boost::uint64_t(bit) << 63;
+			m_register = (m_register << 1) ^ ((m_register >> 63) != 0 ? polynomial() : 0);
+		}
+	}
+
+	/**
+		Process eight bytes, as loaded from memory, with the tables.
+	*/
+	void process_block(boost::uint64_t block, boost::integral_constant<int, 0>)
+	{
+		const boost::uint64_t (&t)[8][256] = s_tables.table;
+
+		if (Reflected)
+		{
+			const boost::uint64_t r = m_register ^ boost::endian::native_to_little(block);
+			m_register = t[7][r & 0xff] ^ t[6][(r >> 8) & 0xff] ^
+				t[5][(r >> 16) & 0xff] ^ t[4][(r >> 24) & 0xff] ^
+				t[3][(r >> 32) & 0xff] ^ t[2][(r >> 40) & 0xff] ^
+				t[1][(r >> 48) & 0xff] ^ t[0][r >> 56];
+		}
+		else
+		{
+			const boost::uint64_t r = m_register ^ boost::endian::native_to_big(block);
+			m_register = t[7][r >> 56] ^ t[6][(r >> 48) & 0xff] ^
+				t[5][(r >> 40) & 0xff] ^ t[4][(r >> 32) & 0xff] ^
+				t[3][(r >> 24) & 0xff] ^ t[2][(r >> 16) & 0xff] ^
+				t[1][(r >> 8) & 0xff] ^ t[0][r & 0xff];
+		}
+	}
+
+#if defined(BOOST_BITSTREAM_CRC32C_SSE42)
+	void process_block(boost::uint64_t block, boost::integral_constant<int, 1>)
+	{
+		m_register = _mm_crc32_u64(m_register, block);
+	}
+#endif
+
+#if defined(BOOST_BITSTREAM_CRC32_ARM)
+	void process_block(boost::uint64_t block, boost::integral_constant<int, 2>)
+	{
+		m_register = __crc32cd(static_cast<boost::uint32_t>(m_register), block);
+	}
+
+	void process_block(boost::uint64_t block, boost::integral_constant<int, 3>)
+	{
+		m_register = __crc32d(static_cast<boost::uint32_t>(m_register), block);
+	}
+#endif
+
+	/**
+		Register: reflected, or left-justified in 64 bits.
+	*/
+	boost::uint64_t m_register;
+
+	/**
+		Tables shared by all objects of this type.
+	*/
+	static const tables s_tables;
+};
+
+template <size_t Bits, boost::uint64_t Polynomial, boost::uint64_t Initial,
+	bool Reflected, boost::uint64_t FinalXor>
+const typename crc<Bits, Polynomial, Initial, Reflected, FinalXor>::tables
+	crc<Bits, Polynomial, Initial, Reflected, FinalXor>::s_tables;
+
+/**
+	CRC-16/CCITT-FALSE, MSB first, as in many framed protocols.
+*/
+typedef crc<16, 0x1021, 0xFFFF, false, 0> crc16_ccitt;
+
+/**
+	CRC-32, as in Ethernet, zlib and PNG.
+*/
+typedef crc<32, 0x04C11DB7, 0xFFFFFFFF, true, 0xFFFFFFFF> crc32;
+
+/**
+	CRC-32C (Castagnoli), as in iSCSI and SCTP.
+*/
+typedef crc<32, 0x1EDC6F41, 0xFFFFFFFF, true, 0xFFFFFFFF> crc32c;
+
+/**
+	CRC-32/MPEG-2, MSB first, as in MPEG transport stream sections.
+*/
+typedef crc<32, 0x04C11DB7, 0xFFFFFFFF, false, 0> crc32_mpeg2;
+
+// internet_checksum //////////////////////////////////////////////////////////
+
+/**
+    Objects of this class compute the Internet checksum of RFC 1071, the
+	ones' complement of the ones' complement sum of 16-bit big-endian words,
+	as in IPv4, TCP and UDP headers.
+
+	\note Four bytes are added at a time; the sum is folded to 16 bits only
+	by checksum(). A last odd byte is the high half of a word.
+*/
+class internet_checksum
+{
+public:
+	/**
+		Type of checksum.
+	*/
+	typedef boost::uint16_t value_type;
+
+	/**
+		Constructor.
+	*/
+	internet_checksum() : m_sum(0), m_odd(false)
+	{
+		// Do nothing.
+	}
+
+	/**
+		Start over.
+	*/
+	void reset()
+	{
+		m_sum = 0;
+		m_odd = false;
+	}
+
+	/**
+		Process bytes.
+
+		\param[in] bytes Bytes to process.
+		\param[in] count Number of bytes.
+	*/
+	void process_bytes(const unsigned char *bytes, size_t count)
+	{
+		if (m_odd && count > 0)
+		{
+			m_sum += *bytes++;
+			--count;
+			m_odd = false;
+		}
+
+		for (; count >= sizeof(boost::uint32_t); count -= sizeof(boost::uint32_t),
+			bytes += sizeof(boost::uint32_t))
+		{
+			boost::uint32_t word;
+			std::memcpy(&word, bytes, sizeof word);
+			m_sum += boost::endian::big_to_native(word);
+		}
+
+		for (; count > 0; --count, ++bytes)
+		{
+			m_sum += m_odd ? boost::uint64_t(*bytes) : boost::uint64_t(*bytes) << CHAR_BIT;
+			m_odd = !m_odd;
+		}
+	}
+
+	/**
+		Process part of a byte, the last of the checksum.
+
+		\note Bits of the byte that are not processed count as 0.
+
+		\param[in] byte Byte to process.
+		\param[in] bits Number of bits of byte to process, which are its high
+		bits in msb_first order, or its low bits in lsb_first order.
+		\param[in] order Order of bits in byte.
+	*/
+	void process_bits(unsigned char byte, size_t bits, bit_order order)
+	{
+		const unsigned mask = (1u << bits) - 1;
+		const unsigned char part = static_cast<unsigned char>(order == msb_first ?
+			byte & (mask << (CHAR_BIT - bits)) : byte & mask);
+		process_bytes(&part, 1);
+	}
+
+	/**
+		Get checksum of what has been processed.
+
+		\return Checksum.
+	*/
+	value_type checksum() const
+	{
+		boost::uint64_t sum = m_sum;
+		while ((sum >> 16) != 0)
+		{
+			sum = (sum & 0xffff) + (sum >> 16);
+		}
+
+		return static_cast<value_type>(~sum & 0xffff);
+	}
+
+private:
+	/**
+		Sum of words, not yet folded.
+	*/
+	boost::uint64_t m_sum;
+
+	/**
+		Whether the next byte is the low half of a word.
+	*/
+	bool m_odd;
+};
+
+// basic_checksumbitbuf ///////////////////////////////////////////////////////
+
+/**
+    This class represents another bitbuf whose bits are checksummed as they
+	are read or written.
+
+	\note The get and put areas are those of the other buffer, so reads and
+	writes that fit in them stay on the inline paths. Bits that have been
+	read or written are checksummed in bulk, straight from the buffer, when
+	they are about to leave the area, e.g., before a streambitbuf refills or
+	a vectorbitbuf grows, and on end(); the bits of fields that straddle
+	areas are checksummed as they are passed on. Byte-aligned runs go to the
+	checksum as they are; others are regrouped 56 bits at a time.
+
+	\note The checksum is over the sequence of bits read, or written,
+	between begin() and end(), taken as bytes in the order of the buffer; a
+	last partial byte is passed to Checksum::process_bits(). Seeking while a
+	checksum is running checksums the bits up to the seek and carries on
+	from the new position.
+
+	\note The other buffer must not be used directly while this one is; its
+	pointers are brought up to date whenever this one defers to it and on
+	destruction.
+
+	\tparam Checksum A crc or internet_checksum, or any class with
+	process_bytes(), process_bits(), checksum() and reset() as they have.
+*/
+template <typename Checksum>
+class basic_checksumbitbuf : public bitbuf
+{
+public:
+	/**
+		Constructor.
+
+		\param[in,out] bb Buffer to read or write.
+		\param[in] which std::ios_base::in to checksum bits read;
+		std::ios_base::out to checksum bits written.
+	*/
+	explicit basic_checksumbitbuf(bitbuf &bb,
+		std::ios_base::openmode which = std::ios_base::in) :
+		bitbuf(which), m_bitbuf(bb), m_which(which), m_running(false),
+		m_mark(0), m_pending(0), m_pending_bits(0)
+	{
+		attach();
+	}
+
+	/**
+		Destructor.
+	*/
+	virtual ~basic_checksumbitbuf()
+	{
+		detach();
+	}
+
+	/**
+		Start a checksum at the current position.
+	*/
+	void begin()
+	{
+		m_checksum.reset();
+		m_pending = 0;
+		m_pending_bits = 0;
+		m_mark = position();
+		m_running = true;
+	}
+
+	/**
+		Finish the checksum at the current position.
+
+		\return Checksum of the bits since begin().
+	*/
+	typename Checksum::value_type end()
+	{
+		if (m_running)
+		{
+			update();
+			if (m_pending_bits > 0)
+			{
+				const unsigned char byte = static_cast<unsigned char>(
+					order() == msb_first ? m_pending << (CHAR_BIT - m_pending_bits) :
+					m_pending);
+				m_checksum.process_bits(byte, m_pending_bits, order());
+			}
+			m_running = false;
+		}
+
+		return m_checksum.checksum();
+	}
+
+	/**
+		Determine whether a checksum is running.
+
+		\return Whether begin() has been called since end().
+	*/
+	bool running() const
+	{
+		return m_running;
+	}
+
+	/**
+		Get the checksum.
+
+		\return Checksum object, which end() has brought up to date.
+	*/
+	const Checksum &checksum() const
+	{
+		return m_checksum;
+	}
+
+protected:
+	// Virtual buffer-management and positioning functions ////////////////////
+
+	/**
+		Set buffer to access.
+
+		\note Not supported; the other buffer owns it.
+
+		\return NULL.
+	*/
+	virtual bitbuf *setbuf(unsigned char *, std::streamsize)
+	{
+		return NULL;
+	}
+
+	/**
+		Determine whether slices may be made of the get area.
+
+		\note The areas are the other buffer's, so this is whatever it says.
+
+		\return Whether the other buffer makes slices.
+	*/
+	virtual bool sliceable() const
+	{
+		return m_bitbuf.sliceable();
+	}
+
+	/**
+		Set get or put pointer relative to current position.
+
+		\note See class notes on seeking.
+
+		\param[in] offset Amount by which pointer is adjusted.
+		\param[in] way From which pointer offset is applied for new position.
+		\param[in] which Open mode.
+		\return New position, as the other buffer has it.
+	*/
+	virtual std::streampos seekoff(std::streamoff offset,
+		std::ios_base::seekdir way,
+		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+	{
+		detach();
+		const std::streampos new_position = m_bitbuf.pubseekoff(offset, way, which);
+		attach();
+
+		return new_position;
+	}
+
+	/**
+		Set get or put pointer to absolute position.
+
+		\note See class notes on seeking.
+
+		\param[in] position New absolute position.
+		\param[in] which Open mode.
+		\return New position, as the other buffer has it.
+	*/
+	virtual std::streampos seekpos(std::streampos position,
+		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+	{
+		detach();
+		const std::streampos new_position = m_bitbuf.pubseekpos(position, which);
+		attach();
+
+		return new_position;
+	}
+
+	/**
+		Checksum the bits so far and synchronize the other buffer.
+
+		\return 0 if successful; -1 otherwise.
+	*/
+	virtual int sync()
+	{
+		detach();
+		const int result = m_bitbuf.pubsync();
+		attach();
+
+		return result;
+	}
+
+	// Virtual input functions ////////////////////////////////////////////////
+
+	/**
+		Get number of bits available, e.g., after a refill of the other
+		buffer.
+
+		\return Number of bits that can be read; -1 if none.
+	*/
+	virtual std::streamsize showmanyb()
+	{
+		detach();
+		const std::streamsize available = m_bitbuf.in_avail();
+		attach();
+
+		return available;
+	}
+
+	/**
+		Get sequence of bits.
+
+		\note A field that is not all in the get area is read from the other
+		buffer and checksummed here; otherwise, it is checksummed later,
+		straight from the buffer.
+
+		\param[out] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits read from buffer or zero if error or eof.
+	*/
+	virtual std::streamsize xsgetn(bitfield &value, std::streamsize size)
+	{
+		std::streamsize bits_read;
+
+		if (size <= egptr() - gptr())
+		{
+			bits_read = bitbuf::xsgetn(value, size);
+		}
+		else
+		{
+			detach();
+			bits_read = m_bitbuf.sgetn(value, size);
+			if (bits_read > 0 && counts(std::ios_base::in))
+			{
+				add(value, static_cast<size_t>(bits_read));
+			}
+			attach();
+		}
+
+		return bits_read;
+	}
+
+	/**
+		Get sequence of bits without advancing get pointer.
+
+		\param[out] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits peeked at or zero if error or eof.
+	*/
+	virtual std::streamsize xspeekn(bitfield &value, std::streamsize size)
+	{
+		std::streamsize bits_read;
+
+		if (size <= egptr() - gptr())
+		{
+			bits_read = bitbuf::xspeekn(value, size);
+		}
+		else
+		{
+			detach();
+			bits_read = m_bitbuf.speekn(value, size);
+			attach();
+		}
+
+		return bits_read;
+	}
+
+	/**
+		Get bit without changing current position.
+
+		\param[out] value Bit at the current position.
+		\return Whether there are more bits to read.
+	*/
+	virtual bool underflow(bitfield &value)
+	{
+		detach();
+		const bool got_bit = m_bitbuf.sgetb(value);
+		attach();
+
+		return got_bit;
+	}
+
+	// Virtual output functions ///////////////////////////////////////////////
+
+	/**
+		Put sequence of bits.
+
+		\note See xsgetn().
+
+		\param[in] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits written to buffer or zero if error or eof.
+	*/
+	virtual std::streamsize xsputn(bitfield value, std::streamsize size)
+	{
+		std::streamsize bits_written;
+
+		if (size <= epptr() - pptr())
+		{
+			bits_written = bitbuf::xsputn(value, size);
+		}
+		else
+		{
+			detach();
+			bits_written = m_bitbuf.sputn(value, size);
+			if (bits_written > 0 && counts(std::ios_base::out))
+			{
+				add(value, static_cast<size_t>(bits_written));
+			}
+			attach();
+		}
+
+		return bits_written;
+	}
+
+	/**
+		Put bit at put pointer, e.g., after the other buffer grows.
+
+		\param[in] b Bit to be put.
+		\return Whether the bit was put.
+	*/
+	virtual bool overflow(bitfield b)
+	{
+		detach();
+		const bool put_bit = m_bitbuf.sputb(b);
+		if (put_bit && counts(std::ios_base::out))
+		{
+			add(b, 1);
+		}
+		attach();
+
+		return put_bit;
+	}
+
+private:
+	/**
+		Determine whether bits moving one way are checksummed.
+
+		\param[in] which std::ios_base::in or std::ios_base::out.
+		\return Whether a checksum is running over them.
+	*/
+	bool counts(std::ios_base::openmode which) const
+	{
+		return m_running && (m_which & which) != 0;
+	}
+
+	/**
+		Get the pointer that the checksum follows.
+
+		\return gptr() or pptr().
+	*/
+	bitpos position() const
+	{
+		return (m_which & std::ios_base::in) != 0 ? gptr() : pptr();
+	}
+
+	/**
+		Take on the areas and bit order of the other buffer.
+	*/
+	void attach()
+	{
+		setg(m_bitbuf.m_buffer, m_bitbuf.eback(), m_bitbuf.gptr(),
+			m_bitbuf.egptr());
+		setp(m_bitbuf.m_buffer, m_bitbuf.pbase(), m_bitbuf.epptr());
+		pbump(m_bitbuf.pptr() - m_bitbuf.pbase());
+		order(m_bitbuf.order());
+		m_mark = position();
+	}
+
+	/**
+		Checksum what has been read or written and give the other buffer
+		its pointers back.
+	*/
+	void detach()
+	{
+		update();
+		m_bitbuf.gbump(gptr() - m_bitbuf.gptr());
+		m_bitbuf.pbump(pptr() - m_bitbuf.pptr());
+	}
+
+	/**
+		Checksum the bits between the mark and the pointer.
+	*/
+	void update()
+	{
+		static const size_t chunk_bits = 56;
+
+		const bitpos end = position();
+		if (m_running && m_buffer != NULL && end > m_mark)
+		{
+			bitpos from = m_mark;
+			const bitpos limit = (m_which & std::ios_base::in) != 0 ? egptr() : epptr();
+			if (m_pending_bits == 0 && from % CHAR_BIT == 0)
+			{
+				const size_t bytes = static_cast<size_t>(end - from) / CHAR_BIT;
+				m_checksum.process_bytes(m_buffer + from / CHAR_BIT, bytes);
+				from += static_cast<bitpos>(bytes) * CHAR_BIT;
+			}
+			for (; from < end; from += chunk_bits)
+			{
+				const size_t bits = static_cast<size_t>(std::min(
+					bitpos(chunk_bits), end - from));
+				add(get_window_bits(order(), m_buffer + from / CHAR_BIT,
+					static_cast<size_t>(from % CHAR_BIT), bits,
+					bytes_remaining(from, limit)), bits);
+			}
+		}
+		m_mark = end;
+	}
+
+	/**
+		Checksum a field, after any bits left over from the last one.
+
+		\param[in] value Bits, right-justified, in the order of this buffer.
+		\param[in] bits Number of bits, 1 through 64.
+	*/
+	void add(bitfield value, size_t bits)
+	{
+		static const size_t chunk_bits = 56;
+
+		if (bits > chunk_bits)
+		{
+			// Leave room for the bits left over.
+			const size_t rest = bits - chunk_bits;
+			if (order() == msb_first)
+			{
+				add(value >> rest, chunk_bits);
+				add(value & low_bits_mask(rest), rest);
+			}
+			else
+			{
+				add(value & low_bits_mask(chunk_bits), chunk_bits);
+				add(value >> chunk_bits, rest);
+			}
+		}
+		else
+		{
+			value &= low_bits_mask(bits);
+			const size_t total = m_pending_bits + bits;
+			const size_t whole = total / CHAR_BIT * CHAR_BIT;
+			const size_t rest = total - whole;
+			bitfield field;
+			if (order() == msb_first)
+			{
+				field = (m_pending << bits) | value;
+				m_pending = field & ((bitfield(1) << rest) - 1);
+				field >>= rest;
+			}
+			else
+			{
+				field = m_pending | (value << m_pending_bits);
+				m_pending = field >> whole;
+				field = whole > 0 ? field & low_bits_mask(whole) : 0;
+			}
+			m_pending_bits = rest;
+
+			if (whole > 0)
+			{
+				unsigned char bytes[sizeof(bitfield)];
+				store_wide(order(), bytes, field, whole);
+				m_checksum.process_bytes(bytes, whole / CHAR_BIT);
+			}
+		}
+	}
+
+	/**
+		Buffer read or written.
+	*/
+	bitbuf &m_bitbuf;
+
+	/**
+		Whether bits read or bits written are checksummed.
+	*/
+	std::ios_base::openmode m_which;
+
+	/**
+		Whether a checksum is running.
+	*/
+	bool m_running;
+
+	/**
+		Position up to which bits have been checksummed.
+	*/
+	bitpos m_mark;
+
+	/**
+		Bits checksummed but not yet a whole byte, right-justified.
+	*/
+	bitfield m_pending;
+
+	/**
+		Number of bits in m_pending, less than CHAR_BIT.
+	*/
+	size_t m_pending_bits;
+
+	/**
+		Checksum.
+	*/
+	Checksum m_checksum;
+};
+
+// checksum_filter ////////////////////////////////////////////////////////////
+
+/**
+    Objects of this class checksum what a stream reads or writes between
+	begin_crc() and end_crc(), e.g.,
+	\code
+	boost::bitstream::checksum_filter<boost::bitstream::crc32> crc(bin);
+	crc.begin_crc();
+	bin >> header >> payload;
+	const boost::uint32_t computed = crc.end_crc();
+	bin >> expected;
+	\endcode
+
+	\note The stream's bitbuf is wrapped in a basic_checksumbitbuf for as
+	long as this object exists and restored on destruction. For an ostream,
+	bits it has collected but not yet written (see ostream::unitbuf()) are
+	flushed by begin_crc() and end_crc(), so that exactly the bits inserted
+	in between are checksummed.
+
+	\tparam Checksum A crc or internet_checksum.
+*/
+template <typename Checksum>
+class checksum_filter : private boost::noncopyable
+{
+public:
+	/**
+		Constructor.
+
+		\param[in,out] ibs Stream whose extracted bits are checksummed.
+	*/
+	explicit checksum_filter(istream &ibs) : m_stream(ibs), m_ostream(NULL),
+		m_previous(ibs.rdbuf()), m_bitbuf(*ibs.rdbuf(), std::ios_base::in)
+	{
+		attach();
+	}
+
+	/**
+		Constructor.
+
+		\param[in,out] obs Stream whose inserted bits are checksummed.
+	*/
+	explicit checksum_filter(ostream &obs) : m_stream(obs), m_ostream(&obs),
+		m_previous(obs.flush().rdbuf()), m_bitbuf(*obs.rdbuf(), std::ios_base::out)
+	{
+		attach();
+	}
+
+	/**
+		Destructor.
+	*/
+	~checksum_filter()
+	{
+		if (m_ostream != NULL)
+		{
+			m_ostream->flush();
+		}
+		const std::ios_base::iostate state = m_stream.rdstate();
+		m_stream.rdbuf(m_previous);
+		m_stream.clear(state);
+	}
+
+	/**
+		Start a checksum at the current position of the stream.
+	*/
+	void begin_crc()
+	{
+		if (m_ostream != NULL)
+		{
+			m_ostream->flush();
+		}
+		m_bitbuf.begin();
+	}
+
+	/**
+		Finish the checksum at the current position of the stream.
+
+		\return Checksum of the bits since begin_crc().
+	*/
+	typename Checksum::value_type end_crc()
+	{
+		if (m_ostream != NULL)
+		{
+			m_ostream->flush();
+		}
+
+		return m_bitbuf.end();
+	}
+
+private:
+	/**
+		Put the checksumming buffer between the stream and its bitbuf,
+		keeping the stream state.
+	*/
+	void attach()
+	{
+		const std::ios_base::iostate state = m_stream.rdstate();
+		m_stream.rdbuf(&m_bitbuf);
+		m_stream.clear(state);
+	}
+
+	/**
+		Stream being checksummed.
+	*/
+	iob &m_stream;
+
+	/**
+		Stream being checksummed, if it is an ostream.
+	*/
+	ostream *m_ostream;
+
+	/**
+		Buffer of stream before construction.
+	*/
+	bitbuf *m_previous;
+
+	/**
+		Checksumming buffer over m_previous.
+	*/
+	basic_checksumbitbuf<Checksum> m_bitbuf;
+};
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
@@ -0,0 +1,652 @@
+/** \file
+    \brief Record codecs for bit streams.
+    \details This header file contains functions that extract and insert
+        whole structs, whose bit layout is described once by adapting them
+        as Boost.Fusion sequences.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_CODEC_HPP
+#define BOOST_BITSTREAM_CODEC_HPP
+
+#include <boost/bitstream/istream.hpp>
+#include <boost/bitstream/ostream.hpp>
+#include <boost/fusion/include/begin.hpp>
+#include <boost/fusion/include/deref.hpp>
+#include <boost/fusion/include/end.hpp>
+#include <boost/fusion/include/equal_to.hpp>
+#include <boost/fusion/include/is_sequence.hpp>
+#include <boost/fusion/include/next.hpp>
+#include <boost/fusion/include/value_of.hpp>
+#include <boost/integer.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <bitset>
+
+namespace boost {
+
+namespace bitstream {
+
+// Field types ////////////////////////////////////////////////////////////////
+
+/**
+    This class represents a bit field of N bits, held in an integral.
+
+	\note Use this for members of a record whose width is not that of their
+	type, e.g., field<4> for a 4-bit count. It converts to and from T.
+
+	\tparam N Number of bits in field.
+	\tparam T Type of integral that holds value of field.
+*/
+template <size_t N, typename T = typename boost::uint_t<N>::least>
+class field
+{
+	BOOST_STATIC_ASSERT(N > 0 && N <= sizeof(T) * CHAR_BIT);
+
+public:
+	/**
+		Type of value of field.
+	*/
+	typedef T value_type;
+
+	/**
+		Constructor.
+
+		\param[in] value Value of field.
+	*/
+	field(T value = T()) : m_value(value)
+	{
+		// Do nothing.
+	}
+
+	/**
+		Get value of field.
+
+		\return Value of field.
+	*/
+	operator T() const
+	{
+		return m_value;
+	}
+
+private:
+	/**
+		Value of field.
+	*/
+	T m_value;
+};
+
+/**
+    This class represents a bit field of N bits that always has the same
+	value, such as the version of a protocol.
+
+	\note A record member of this type takes no storage of its own to speak
+	of. Decoding fails if the bits in the stream are not Value; encoding
+	always inserts Value.
+
+	\tparam N Number of bits in field.
+	\tparam Value Value of field.
+*/
+template <size_t N, bitfield Value>
+struct constant
+{
+	BOOST_STATIC_ASSERT(N > 0 && N <= sizeof(bitfield) * CHAR_BIT);
+	BOOST_STATIC_ASSERT(N == sizeof(bitfield) * CHAR_BIT ||
+		(Value >> (N % (sizeof(bitfield) * CHAR_BIT))) == 0);
+
+	/**
+		Value of field.
+	*/
+	static const bitfield value = Value;
+};
+
+// Field traits ///////////////////////////////////////////////////////////////
+
+/**
+	This class describes how a member of a record maps to a bit field.
+
+	\note There are specializations for bool, integrals, std::bitset, field
+	and constant. Specialize it for other types of member. bits is the width
+	of the field, assign() stores a value extracted from the stream and
+	returns false if the value is not acceptable, and value() gets the value
+	to insert.
+
+	\tparam T Type of member.
+*/
+template <typename T, typename Enable = void>
+struct field_traits;
+
+template <>
+struct field_traits<bool>
+{
+	static const size_t bits = 1;
+
+	static bool assign(bool &b, bitfield value)
+	{
+		b = value != 0;
+
+		return true;
+	}
+
+	static bitfield value(bool b)
+	{
+		return b ? 1 : 0;
+	}
+};
+
+template <typename T>
+struct field_traits<T, typename boost::enable_if_c<
+	boost::is_integral<T>::value && !boost::is_same<T, bool>::value>::type>
+{
+	static const size_t bits = sizeof(T) * CHAR_BIT;
+
+	static bool assign(T &t, bitfield value)
+	{
+		t = static_cast<T>(value);
+
+		return true;
+	}
+
+	static bitfield value(T t)
+	{
+		return static_cast<bitfield>(t);
+	}
+};
+
+template <size_t N>
+struct field_traits<std::bitset<N> >
+{
+	BOOST_STATIC_ASSERT(N > 0 && N <= sizeof(bitfield) * CHAR_BIT);
+
+	static const size_t bits = N;
+
+	static bool assign(std::bitset<N> &bs, bitfield value)
+	{
+		bs = value;
+
+		return true;
+	}
+
+	static bitfield value(const std::bitset<N> &bs)
+	{
+		return static_cast<bitfield>(bs.to_ullong());
+	}
+};
+
+template <size_t N, typename T>
+struct field_traits<field<N, T> >
+{
+	static const size_t bits = N;
+
+	static bool assign(field<N, T> &f, bitfield value)
+	{
+		f = static_cast<T>(value);
+
+		return true;
+	}
+
+	static bitfield value(const field<N, T> &f)
+	{
+		return static_cast<bitfield>(static_cast<T>(f));
+	}
+};
+
+template <size_t N, bitfield Value>
+struct field_traits<constant<N, Value> >
+{
+	static const size_t bits = N;
+
+	static bool assign(constant<N, Value> &, bitfield value)
+	{
+		return value == Value;
+	}
+
+	static bitfield value(const constant<N, Value> &)
+	{
+		return Value;
+	}
+};
+
+// codec_access ///////////////////////////////////////////////////////////////
+
+/**
+	This class gives record codecs access to the bit-field kernels of bitbuf.
+
+	\note Positions passed to get_bits() and put_bits() are relative to the
+	byte pointer returned by get_record() or put_record().
+*/
+class codec_access
+{
+public:
+	/**
+		Get pointer to next bits if they are all in the get area, and advance
+		past them.
+
+		\param[in,out] bb Buffer from which to get record.
+		\param[in] bits Number of bits in record.
+		\param[out] offset Bit position of record within first byte.
+		\param[out] byte_count Number of bytes that may be read at pointer.
+		\return Pointer to first byte of record, or NULL if not all of it is
+		in the get area or the buffer is not msb_first, in which case nothing
+		is read.
+	*/
+	static const unsigned char *get_record(bitbuf &bb, std::streamsize bits,
+		size_t &offset, size_t &byte_count)
+	{
+		const unsigned char *byte_pointer = NULL;
+
+		if (bb.order() == msb_first && bits <= bb.egptr() - bb.gptr())
+		{
+			byte_pointer = bb.current_get_byte();
+			offset = static_cast<size_t>(bb.gptr() % CHAR_BIT);
+			byte_count = bitbuf::bytes_remaining(bb.gptr(), bb.egptr());
+			bb.gbump(bits);
+		}
+
+		return byte_pointer;
+	}
+
+	/**
+		Get pointer to where next bits go if they all fit in the put area, and
+		advance past them.
+
+		\param[in,out] bb Buffer to which to put record.
+		\param[in] bits Number of bits in record.
+		\param[out] offset Bit position of record within first byte.
+		\param[out] byte_count Number of bytes that may be written at pointer.
+		\return Pointer to first byte of record, or NULL if not all of it
+		fits in the put area or the buffer is not msb_first, in which case
+		nothing is written.
+	*/
+	static unsigned char *put_record(bitbuf &bb, std::streamsize bits,
+		size_t &offset, size_t &byte_count)
+	{
+		unsigned char *byte_pointer = NULL;
+
+		if (bb.order() == msb_first && bits <= bb.epptr() - bb.pptr())
+		{
+			byte_pointer = bb.current_put_byte();
+			offset = static_cast<size_t>(bb.pptr() % CHAR_BIT);
+			byte_count = bitbuf::bytes_remaining(bb.pptr(), bb.epptr());
+			bb.pbump(bits);
+		}
+
+		return byte_pointer;
+	}
+
+	/**
+		Get field of record.
+
+		\tparam N Number of bits in field.
+		\param[in] byte_pointer Pointer to first byte of record.
+		\param[in] position Bit position of field relative to byte_pointer.
+		\param[in] byte_count Number of bytes that may be read at byte_pointer.
+		\return Value of field.
+	*/
+	template <size_t N>
+	static bitfield get_bits(const unsigned char *byte_pointer, size_t position,
+		size_t byte_count)
+	{
+		return bitbuf::get_bits<N>(byte_pointer + position / CHAR_BIT,
+			position % CHAR_BIT, byte_count - position / CHAR_BIT);
+	}
+
+	/**
+		Put field of record.
+
+		\tparam N Number of bits in field.
+		\param[in] byte_pointer Pointer to first byte of record.
+		\param[in] position Bit position of field relative to byte_pointer.
+		\param[in] value Value of field.
+		\param[in] byte_count Number of bytes that may be written at
+		byte_pointer.
+	*/
+	template <size_t N>
+	static void put_bits(unsigned char *byte_pointer, size_t position,
+		bitfield value, size_t byte_count)
+	{
+		bitbuf::put_bits<N>(byte_pointer + position / CHAR_BIT,
+			position % CHAR_BIT, value, byte_count - position / CHAR_BIT);
+	}
+
+#ifdef BOOST_BITSTREAM_STATS
+	/**
+		Count fields of record just gotten or put, as sgetn() and sputn()
+		would have.
+
+		\tparam Record record_element of record.
+		\param[in,out] bb Buffer from which record was gotten or to which it
+		was put.
+		\param[in] input Whether record was gotten rather than put.
+	*/
+	template <typename Record>
+	static void count_record(bitbuf &bb, bool input)
+	{
+		Record::template count<0>(bb.m_stats, (input ? bb.gptr() : bb.pptr()) -
+			static_cast<bitpos>(Record::bits), input);
+	}
+#endif
+};
+
+namespace detail {
+
+// Record layout //////////////////////////////////////////////////////////////
+
+template <typename T,
+	bool Sequence = boost::fusion::traits::is_sequence<T>::value>
+struct record_element;
+
+/**
+	This class walks the fields of a record from First to Last.
+
+	\note Offset, the position of each field within the record, is a
+	compile-time constant, so decoding and encoding a record whose position
+	in the buffer is byte aligned is straight-line code with constant shifts
+	and masks.
+*/
+template <typename First, typename Last,
+	bool End = boost::fusion::result_of::equal_to<First, Last>::value>
+struct record_fields
+{
+	typedef record_element<
+		typename boost::fusion::result_of::value_of<First>::type> head;
+	typedef record_fields<
+		typename boost::fusion::result_of::next<First>::type, Last> tail;
+
+	static const size_t bits = head::bits + tail::bits;
+
+	template <size_t Offset>
+	static bool get(const unsigned char *byte_pointer, size_t offset,
+		size_t byte_count, const First &i)
+	{
+		const bool okay = head::template get<Offset>(byte_pointer, offset,
+			byte_count, boost::fusion::deref(i));
+
+		return tail::template get<Offset + head::bits>(byte_pointer, offset,
+			byte_count, boost::fusion::next(i)) && okay;
+	}
+
+	template <size_t Offset>
+	static void put(unsigned char *byte_pointer, size_t offset,
+		size_t byte_count, const First &i)
+	{
+		head::template put<Offset>(byte_pointer, offset, byte_count,
+			boost::fusion::deref(i));
+		tail::template put<Offset + head::bits>(byte_pointer, offset,
+			byte_count, boost::fusion::next(i));
+	}
+
+	template <size_t Offset>
+	static void count(stream_stats &stats, bitpos position, bool input)
+	{
+		head::template count<Offset>(stats, position, input);
+		tail::template count<Offset + head::bits>(stats, position, input);
+	}
+
+	static void extract(istream &ibs, const First &i)
+	{
+		head::extract(ibs, boost::fusion::deref(i));
+		tail::extract(ibs, boost::fusion::next(i));
+	}
+
+	static void insert(ostream &obs, const First &i)
+	{
+		head::insert(obs, boost::fusion::deref(i));
+		tail::insert(obs, boost::fusion::next(i));
+	}
+};
+
+template <typename First, typename Last>
+struct record_fields<First, Last, true>
+{
+	static const size_t bits = 0;
+
+	template <size_t Offset>
+	static bool get(const unsigned char *, size_t, size_t, const First &)
+	{
+		return true;
+	}
+
+	template <size_t Offset>
+	static void put(unsigned char *, size_t, size_t, const First &)
+	{
+		// Do nothing.
+	}
+
+	template <size_t Offset>
+	static void count(stream_stats &, bitpos, bool)
+	{
+		// Do nothing.
+	}
+
+	static void extract(istream &, const First &)
+	{
+		// Do nothing.
+	}
+
+	static void insert(ostream &, const First &)
+	{
+		// Do nothing.
+	}
+};
+
+/**
+	This class maps a member that is a single field.
+*/
+template <typename T>
+struct record_element<T, false>
+{
+	typedef field_traits<T> traits;
+
+	static const size_t bits = traits::bits;
+
+	template <size_t Offset>
+	static bool get(const unsigned char *byte_pointer, size_t offset,
+		size_t byte_count, T &t)
+	{
+		return traits::assign(t, codec_access::get_bits<traits::bits>(
+			byte_pointer, offset + Offset, byte_count));
+	}
+
+	template <size_t Offset>
+	static void put(unsigned char *byte_pointer, size_t offset,
+		size_t byte_count, const T &t)
+	{
+		codec_access::put_bits<traits::bits>(byte_pointer, offset + Offset,
+			traits::value(t), byte_count);
+	}
+
+	template <size_t Offset>
+	static void count(stream_stats &stats, bitpos position, bool input)
+	{
+		if (input)
+		{
+			stats.count_read(position + static_cast<bitpos>(Offset), bits);
+		}
+		else
+		{
+			stats.count_write(position + static_cast<bitpos>(Offset), bits);
+		}
+	}
+
+	static void extract(istream &ibs, T &t)
+	{
+		bitfield value;
+		if (ibs.read<traits::bits>(value) && !traits::assign(t, value))
+		{
+			ibs.setstate(std::ios_base::failbit);
+		}
+	}
+
+	static void insert(ostream &obs, const T &t)
+	{
+		obs.write<traits::bits>(traits::value(t));
+	}
+};
+
+/**
+	This class maps a member that is itself a record, i.e., a Fusion
+	sequence, whose fields are laid out in place.
+*/
+template <typename T>
+struct record_element<T, true>
+{
+	typedef record_fields<
+		typename boost::fusion::result_of::begin<T>::type,
+		typename boost::fusion::result_of::end<T>::type> fields;
+	typedef record_fields<
+		typename boost::fusion::result_of::begin<const T>::type,
+		typename boost::fusion::result_of::end<const T>::type> const_fields;
+
+	static const size_t bits = fields::bits;
+
+	template <size_t Offset>
+	static bool get(const unsigned char *byte_pointer, size_t offset,
+		size_t byte_count, T &t)
+	{
+		return fields::template get<Offset>(byte_pointer, offset, byte_count,
+			boost::fusion::begin(t));
+	}
+
+	template <size_t Offset>
+	static void put(unsigned char *byte_pointer, size_t offset,
+		size_t byte_count, const T &t)
+	{
+		const_fields::template put<Offset>(byte_pointer, offset, byte_count,
+			boost::fusion::begin(t));
+	}
+
+	template <size_t Offset>
+	static void count(stream_stats &stats, bitpos position, bool input)
+	{
+		fields::template count<Offset>(stats, position, input);
+	}
+
+	static void extract(istream &ibs, T &t)
+	{
+		fields::extract(ibs, boost::fusion::begin(t));
+	}
+
+	static void insert(ostream &obs, const T &t)
+	{
+		const_fields::insert(obs, boost::fusion::begin(t));
+	}
+};
+
+} // namespace detail
+
+// Record codec ///////////////////////////////////////////////////////////////
+
+/**
+	Number of bits in a record.
+
+	\tparam S Struct adapted as a Fusion sequence, e.g., with
+	BOOST_FUSION_ADAPT_STRUCT.
+*/
+template <typename S>
+struct record_bits :
+	boost::integral_constant<size_t, detail::record_element<S>::bits>
+{
+};
+
+/**
+	Get record from input stream.
+
+	\note The fields are extracted in the order in which S was adapted, each
+	as if by ibs >> member, with the width given by field_traits. When the
+	whole record is in the get area, which is checked once, the fields are
+	extracted with no further checks; otherwise, e.g., when the record
+	straddles buffers of a chainbitbuf, they are extracted one at a time.
+	Either way, the stream fails if the stream is too short or a constant
+	member does not match.
+
+	\param[in,out] ibs Input stream from which to get record.
+	\param[out] s Record.
+	\return Reference to input stream.
+*/
+template <typename S>
+typename boost::enable_if<boost::fusion::traits::is_sequence<S>, istream &>::type
+decode(istream &ibs, S &s)
+{
+	typedef detail::record_element<S> record;
+
+	if (ibs.good())
+	{
+		size_t offset, byte_count;
+		const unsigned char * const byte_pointer = codec_access::get_record(
+			*ibs.rdbuf(), record::bits, offset, byte_count);
+		if (byte_pointer == NULL)
+		{
+			record::extract(ibs, s);
+		}
+		else
+		{
+			if (!record::template get<0>(byte_pointer, offset, byte_count, s))
+			{
+				ibs.setstate(std::ios_base::failbit);
+			}
+			BOOST_BITSTREAM_COUNT(codec_access::count_record<record>(*ibs.rdbuf(), true));
+
+			if (ibs.rdbuf()->in_avail() <= 0)
+			{
+				ibs.setstate(std::ios_base::eofbit);
+			}
+		}
+	}
+	else
+	{
+		ibs.setstate(std::ios_base::failbit);
+	}
+
+	return ibs;
+}
+
+/**
+	Put record to output stream.
+
+	\note See decode(). When unitbuf() is false, the fields are simply
+	combined one at a time like any other insertions.
+
+	\param[in,out] obs Output stream to which to put record.
+	\param[in] s Record.
+	\return Reference to output stream.
+*/
+template <typename S>
+typename boost::enable_if<boost::fusion::traits::is_sequence<S>, ostream &>::type
+encode(ostream &obs, const S &s)
+{
+	typedef detail::record_element<S> record;
+
+	if (obs.good())
+	{
+		size_t offset, byte_count;
+		unsigned char * const byte_pointer = obs.unitbuf() ?
+			codec_access::put_record(*obs.rdbuf(), record::bits, offset,
+				byte_count) : NULL;
+		if (byte_pointer == NULL)
+		{
+			record::insert(obs, s);
+		}
+		else
+		{
+			record::template put<0>(byte_pointer, offset, byte_count, s);
+			BOOST_BITSTREAM_COUNT(codec_access::count_record<record>(*obs.rdbuf(), false));
+		}
+	}
+
+	return obs;
+}
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
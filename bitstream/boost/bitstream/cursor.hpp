@@ -0,0 +1,1121 @@
+/** \file
+    \brief Bit-stream cursors.
+    \details This header file contains lightweight value types that read and
+        write bits of contiguous memory with the same operators as the
+        bit-stream classes.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_CURSOR_HPP
+#define BOOST_BITSTREAM_CURSOR_HPP
+
+#include <boost/bitstream/istream.hpp>
+#include <boost/bitstream/ostream.hpp>
+#include <boost/spirit/home/support/container.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/typeof/typeof.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+
+namespace boost {
+
+namespace bitstream {
+
+// bit_reader /////////////////////////////////////////////////////////////////
+
+/**
+    Objects of this class read and interpret sequences of bits from
+	contiguous memory, like an ibitstream, but as a plain value.
+
+	\note There is no bitbuf, no virtual function and no state word: a
+	bit_reader is a pointer, the current and end positions and a repeat
+	count, which is trivially copyable and usually lives in registers. A
+	read that goes past the end fails by moving the current position past the
+	end, so fail() is position > end and eof() is position >= end. To parse
+	speculatively, copy the reader and, to backtrack, assign the copy
+	back.
+
+	\note This is for buffers in memory; use an ibitstream over a streambitbuf
+	or chainbitbuf for anything else. Bits are numbered in the bit_order
+	given to the constructor, as by bitbuf::order().
+*/
+class bit_reader
+{
+public:
+	/**
+		Constructor.
+
+		\param[in] buffer Pointer to char array to be read.
+		\param[in] bits Number of bits in char array.
+		\param[in] order Order in which bits are numbered.
+	*/
+	bit_reader(const char *buffer, std::streamsize bits,
+		bit_order order = msb_first) :
+		m_buffer(reinterpret_cast<const unsigned char *>(buffer)),
+		m_position(0), m_end(bits), m_repeat(0), m_order(order)
+	{
+		// Do nothing.
+	}
+
+	/**
+		Get order in which bits are numbered.
+
+		\return Bit order.
+	*/
+	bit_order order() const
+	{
+		return m_order;
+	}
+
+	/**
+		Get repeat value.
+
+		\see istream::repeat().
+
+		\return Repeat value.
+	*/
+	size_t repeat() const
+	{
+		return m_repeat;
+	}
+
+	/**
+		Set repeat count for subsequent container extractions.
+
+		\see istream::repeat(size_t).
+
+		\param repeat Number of bit fields to extract to each subsequent
+		container.
+		\return This reader.
+	*/
+	bit_reader &repeat(size_t repeat)
+	{
+		m_repeat = repeat;
+
+		return *this;
+	}
+
+	/**
+		Get bits, where number of bits is known at compile time.
+
+		\tparam N Number of bits to read.
+		\param[out] value Integral to receive bits; zero on failure.
+		\return This reader.
+	*/
+	template <size_t N>
+	bit_reader &read(bitfield &value)
+	{
+		BOOST_STATIC_ASSERT(N > 0 && N <= sizeof(bitfield) * CHAR_BIT);
+
+		if (static_cast<bitpos>(N) <= m_end - m_position)
+		{
+			const unsigned char * const byte_pointer = m_buffer + m_position / CHAR_BIT;
+			const size_t intra_byte_bit_offset = static_cast<size_t>(m_position % CHAR_BIT);
+			const size_t byte_count = bitbuf::bytes_remaining(m_position, m_end);
+			value = m_order == msb_first ?
+				bitbuf::get_bits<N>(byte_pointer, intra_byte_bit_offset, byte_count) :
+				bitbuf::get_lsb_bits<N>(byte_pointer, intra_byte_bit_offset, byte_count);
+			m_position += N;
+		}
+		else
+		{
+			value = 0;
+			set_fail();
+		}
+
+		return *this;
+	}
+
+	/**
+		Get bits.
+
+		\param[out] value Integral to receive bits; zero on failure.
+		\param[in] bits Number of bits to read.
+		\return This reader.
+	*/
+	bit_reader &read(bitfield &value, std::streamsize bits)
+	{
+		if (bits > 0 &&
+			bits <= static_cast<std::streamsize>(sizeof value * CHAR_BIT) &&
+			bits <= m_end - m_position)
+		{
+			value = bitbuf::get_window_bits(m_order, m_buffer + m_position / CHAR_BIT,
+				static_cast<size_t>(m_position % CHAR_BIT),
+				static_cast<size_t>(bits),
+				bitbuf::bytes_remaining(m_position, m_end));
+			m_position += bits;
+		}
+		else
+		{
+			value = 0;
+			set_fail();
+		}
+
+		return *this;
+	}
+
+	/**
+		Get field of any number of bits.
+
+		\note See istream::read_wide().
+
+		\param[out] bytes Array of (bits + CHAR_BIT - 1) / CHAR_BIT bytes to
+		receive field; zeroed on failure.
+		\param[in] bits Number of bits in field.
+		\return This reader.
+	*/
+	bit_reader &read_wide(unsigned char *bytes, std::streamsize bits)
+	{
+		if (bits >= 0 && bits <= m_end - m_position)
+		{
+			bitbuf::get_wide(m_order, m_buffer + m_position / CHAR_BIT,
+				static_cast<size_t>(m_position % CHAR_BIT),
+				static_cast<size_t>(bits),
+				bitbuf::bytes_remaining(m_position, m_end), bytes);
+			m_position += bits;
+		}
+		else
+		{
+			if (bits > 0)
+			{
+				std::memset(bytes, 0, static_cast<size_t>(bits + CHAR_BIT - 1) / CHAR_BIT);
+			}
+			set_fail();
+		}
+
+		return *this;
+	}
+
+	/**
+		Get next bits without advancing.
+
+		\note See istream::show_bits(); near the end, what is left is
+		followed by zeros, i.e., shifted left or, with lsb_first, not.
+
+		\param[in] bits Number of bits to peek at, up to the number of bits
+		in bitfield.
+		\return Next bits, right-justified.
+	*/
+	bitfield show_bits(std::streamsize bits) const
+	{
+		bitfield value = 0;
+
+		const bitpos available = std::min(static_cast<bitpos>(bits),
+			m_end - m_position);
+		if (available > 0)
+		{
+			value = bitbuf::get_window_bits(m_order, m_buffer + m_position / CHAR_BIT,
+				static_cast<size_t>(m_position % CHAR_BIT),
+				static_cast<size_t>(available),
+				bitbuf::bytes_remaining(m_position, m_end));
+			if (m_order == msb_first)
+			{
+				value <<= bits - available;
+			}
+		}
+
+		return value;
+	}
+
+	/**
+		Skip bits, e.g., those of a code found with show_bits().
+
+		\note Same as ignore().
+
+		\param[in] bits Number of bits to skip.
+		\return This reader.
+	*/
+	bit_reader &skip(std::streamsize bits)
+	{
+		return ignore(bits);
+	}
+
+	/**
+		Ignore, or skip over, bits.
+
+		\note Unlike istream::ignore(), skipping past the end fails.
+
+		\param[in] bits Number of bits to ignore.
+		\return This reader.
+	*/
+	bit_reader &ignore(std::streamsize bits = 1)
+	{
+		if (bits >= 0 && bits <= m_end - m_position)
+		{
+			m_position += bits;
+		}
+		else
+		{
+			set_fail();
+		}
+
+		return *this;
+	}
+
+	/**
+		Align current position to next bit multiple if not already at one.
+
+		\param[in] bit Bit multiple, such as 8 for byte alignment.
+		\return This reader.
+	*/
+	bit_reader &aligng(size_t bit)
+	{
+		if (!fail() && bit > 0)
+		{
+			const bitpos multiple = static_cast<bitpos>(bit);
+			ignore(static_cast<std::streamsize>(
+				(multiple - m_position % multiple) % multiple));
+		}
+
+		return *this;
+	}
+
+	/**
+		Determine whether current position is aligned to bit multiple.
+
+		\param[in] bit Bit multiple, such as 8 for byte alignment.
+		\return Whether current position is bit-multiple aligned.
+	*/
+	bool alignedg(size_t bit) const
+	{
+		return m_position % static_cast<bitpos>(bit) == 0;
+	}
+
+	/**
+		Get current position.
+
+		\return Bit position of next bit to be read; -1 if failed.
+	*/
+	std::streampos tellg() const
+	{
+		return std::streampos(fail() ? bitpos(-1) : m_position);
+	}
+
+	/**
+		Set current position.
+
+		\note This does nothing once the reader has failed; to backtrack from
+		a failure, assign a copy made before it.
+
+		\param[in] position Bit position.
+		\return This reader.
+	*/
+	bit_reader &seekg(std::streampos position)
+	{
+		const bitpos new_position = static_cast<bitpos>(std::streamoff(position));
+
+		if (!fail())
+		{
+			if (new_position >= 0 && new_position <= m_end)
+			{
+				m_position = new_position;
+			}
+			else
+			{
+				set_fail();
+			}
+		}
+
+		return *this;
+	}
+
+	/**
+		Get number of bits left to read.
+
+		\return Number of bits from current position to end; -1 if none.
+	*/
+	std::streamsize in_avail() const
+	{
+		return m_end > m_position ?
+			static_cast<std::streamsize>(m_end - m_position) : -1;
+	}
+
+	/**
+		Check whether there are bits left to read and nothing has failed.
+
+		\return Whether position < end.
+	*/
+	bool good() const
+	{
+		return m_position < m_end;
+	}
+
+	/**
+		Check whether the end has been reached.
+
+		\return Whether position >= end.
+	*/
+	bool eof() const
+	{
+		return m_position >= m_end;
+	}
+
+	/**
+		Check whether a read has failed.
+
+		\return Whether position > end.
+	*/
+	bool fail() const
+	{
+		return m_position > m_end;
+	}
+
+	/**
+		Set error state.
+
+		\note There are no state flags: failbit or badbit makes the reader
+		fail, and eofbit moves it to the end.
+
+		\param[in] state Error state flags to set.
+	*/
+	void setstate(std::ios_base::iostate state)
+	{
+		if ((state & (std::ios_base::failbit | std::ios_base::badbit)) != 0)
+		{
+			set_fail();
+		}
+		else if ((state & std::ios_base::eofbit) != 0 && m_position < m_end)
+		{
+			m_position = m_end;
+		}
+	}
+
+	/**
+		Evaluate reader for success.
+
+		\return Whether no read has failed, i.e., !fail().
+	*/
+	operator bool() const
+	{
+		return !fail();
+	}
+
+private:
+	/**
+		Record failure by moving past the end.
+	*/
+	void set_fail()
+	{
+		m_position = m_end + 1;
+	}
+
+	/**
+		Pointer to char array being read.
+	*/
+	const unsigned char *m_buffer;
+
+	/**
+		Position of next bit to be read.
+	*/
+	bitpos m_position;
+
+	/**
+		Position of bit after last bit in char array.
+	*/
+	bitpos m_end;
+
+	/**
+		Number of bit fields to extract per container.
+	*/
+	size_t m_repeat;
+
+	/**
+		Order in which bits of char array are numbered.
+	*/
+	bit_order m_order;
+};
+
+// bit_writer /////////////////////////////////////////////////////////////////
+
+/**
+    Objects of this class write sequences of bits to contiguous memory, like
+	an obitstream, but as a plain value.
+
+	\note See bit_reader, including for bit order. Each field is written
+	through immediately, so there is nothing to flush; a write that does not
+	fit fails by moving the current position past the end, and nothing is
+	written.
+*/
+class bit_writer
+{
+public:
+	/**
+		Constructor.
+
+		\param[in] buffer Pointer to char array to be written.
+		\param[in] bits Number of bits in char array.
+		\param[in] order Order in which bits are numbered.
+	*/
+	bit_writer(char *buffer, std::streamsize bits,
+		bit_order order = msb_first) :
+		m_buffer(reinterpret_cast<unsigned char *>(buffer)),
+		m_position(0), m_end(bits), m_repeat(0), m_order(order)
+	{
+		// Do nothing.
+	}
+
+	/**
+		Get order in which bits are numbered.
+
+		\return Bit order.
+	*/
+	bit_order order() const
+	{
+		return m_order;
+	}
+
+	/**
+		Get repeat value.
+
+		\return Repeat value.
+	*/
+	size_t repeat() const
+	{
+		return m_repeat;
+	}
+
+	/**
+		Set repeat count for subsequent container insertions.
+
+		\param repeat Number of bit fields to insert from each subsequent
+		container.
+		\return This writer.
+	*/
+	bit_writer &repeat(size_t repeat)
+	{
+		m_repeat = repeat;
+
+		return *this;
+	}
+
+	/**
+		Put one bit.
+
+		\param[in] value Bit to write.
+		\return This writer.
+	*/
+	bit_writer &put(bitfield value)
+	{
+		return write<1>(value);
+	}
+
+	/**
+		Put bits, where number of bits is known at compile time.
+
+		\tparam N Number of bits to write.
+		\param[in] value Integral from which to write bits.
+		\return This writer.
+	*/
+	template <size_t N>
+	bit_writer &write(bitfield value)
+	{
+		BOOST_STATIC_ASSERT(N > 0 && N <= sizeof(bitfield) * CHAR_BIT);
+
+		if (static_cast<bitpos>(N) <= m_end - m_position)
+		{
+			unsigned char * const byte_pointer = m_buffer + m_position / CHAR_BIT;
+			const size_t intra_byte_bit_offset = static_cast<size_t>(m_position % CHAR_BIT);
+			const size_t byte_count = bitbuf::bytes_remaining(m_position, m_end);
+			if (m_order == msb_first)
+			{
+				bitbuf::put_bits<N>(byte_pointer, intra_byte_bit_offset, value,
+					byte_count);
+			}
+			else
+			{
+				bitbuf::put_lsb_bits<N>(byte_pointer, intra_byte_bit_offset, value,
+					byte_count);
+			}
+			m_position += N;
+		}
+		else
+		{
+			set_fail();
+		}
+
+		return *this;
+	}
+
+	/**
+		Put bits.
+
+		\param[in] value Integral from which to write bits.
+		\param[in] bits Number of bits to write.
+		\return This writer.
+	*/
+	bit_writer &write(bitfield value, std::streamsize bits)
+	{
+		if (bits > 0 &&
+			bits <= static_cast<std::streamsize>(sizeof value * CHAR_BIT) &&
+			bits <= m_end - m_position)
+		{
+			bitbuf::put_window_bits(m_order, m_buffer + m_position / CHAR_BIT,
+				static_cast<size_t>(m_position % CHAR_BIT),
+				static_cast<size_t>(bits), value,
+				bitbuf::bytes_remaining(m_position, m_end));
+			m_position += bits;
+		}
+		else
+		{
+			set_fail();
+		}
+
+		return *this;
+	}
+
+	/**
+		Put field of any number of bits.
+
+		\note See ostream::write_wide().
+
+		\param[in] bytes Array of (bits + CHAR_BIT - 1) / CHAR_BIT bytes of
+		field.
+		\param[in] bits Number of bits in field.
+		\return This writer.
+	*/
+	bit_writer &write_wide(const unsigned char *bytes, std::streamsize bits)
+	{
+		if (bits >= 0 && bits <= m_end - m_position)
+		{
+			bitbuf::put_wide(m_order, m_buffer + m_position / CHAR_BIT,
+				static_cast<size_t>(m_position % CHAR_BIT),
+				static_cast<size_t>(bits),
+				bitbuf::bytes_remaining(m_position, m_end), bytes);
+			m_position += bits;
+		}
+		else
+		{
+			set_fail();
+		}
+
+		return *this;
+	}
+
+	/**
+		Ignore, or skip over, bits, leaving them as they are.
+
+		\param[in] bits Number of bits to ignore.
+		\return This writer.
+	*/
+	bit_writer &ignore(std::streamsize bits = 1)
+	{
+		if (bits >= 0 && bits <= m_end - m_position)
+		{
+			m_position += bits;
+		}
+		else
+		{
+			set_fail();
+		}
+
+		return *this;
+	}
+
+	/**
+		Align current position to next bit multiple if not already at one.
+
+		\param[in] bit Bit multiple, such as 8 for byte alignment.
+		\return This writer.
+	*/
+	bit_writer &alignp(size_t bit)
+	{
+		if (!fail() && bit > 0)
+		{
+			const bitpos multiple = static_cast<bitpos>(bit);
+			ignore(static_cast<std::streamsize>(
+				(multiple - m_position % multiple) % multiple));
+		}
+
+		return *this;
+	}
+
+	/**
+		Determine whether current position is aligned to bit multiple.
+
+		\param[in] bit Bit multiple, such as 8 for byte alignment.
+		\return Whether current position is bit-multiple aligned.
+	*/
+	bool alignedp(size_t bit) const
+	{
+		return m_position % static_cast<bitpos>(bit) == 0;
+	}
+
+	/**
+		Get current position.
+
+		\return Bit position of next bit to be written; -1 if failed.
+	*/
+	std::streampos tellp() const
+	{
+		return std::streampos(fail() ? bitpos(-1) : m_position);
+	}
+
+	/**
+		Set current position.
+
+		\note See bit_reader::seekg().
+
+		\param[in] position Bit position.
+		\return This writer.
+	*/
+	bit_writer &seekp(std::streampos position)
+	{
+		const bitpos new_position = static_cast<bitpos>(std::streamoff(position));
+
+		if (!fail())
+		{
+			if (new_position >= 0 && new_position <= m_end)
+			{
+				m_position = new_position;
+			}
+			else
+			{
+				set_fail();
+			}
+		}
+
+		return *this;
+	}
+
+	/**
+		Check whether there is room left and nothing has failed.
+
+		\return Whether position < end.
+	*/
+	bool good() const
+	{
+		return m_position < m_end;
+	}
+
+	/**
+		Check whether the end has been reached.
+
+		\return Whether position >= end.
+	*/
+	bool eof() const
+	{
+		return m_position >= m_end;
+	}
+
+	/**
+		Check whether a write has failed.
+
+		\return Whether position > end.
+	*/
+	bool fail() const
+	{
+		return m_position > m_end;
+	}
+
+	/**
+		Set error state.
+
+		\note There are no state flags: failbit or badbit makes the writer
+		fail, and eofbit moves it to the end.
+
+		\param[in] state Error state flags to set.
+	*/
+	void setstate(std::ios_base::iostate state)
+	{
+		if ((state & (std::ios_base::failbit | std::ios_base::badbit)) != 0)
+		{
+			set_fail();
+		}
+		else if ((state & std::ios_base::eofbit) != 0 && m_position < m_end)
+		{
+			m_position = m_end;
+		}
+	}
+
+	/**
+		Evaluate writer for success.
+
+		\return Whether no write has failed, i.e., !fail().
+	*/
+	operator bool() const
+	{
+		return !fail();
+	}
+
+private:
+	/**
+		Record failure by moving past the end.
+	*/
+	void set_fail()
+	{
+		m_position = m_end + 1;
+	}
+
+	/**
+		Pointer to char array being written.
+	*/
+	unsigned char *m_buffer;
+
+	/**
+		Position of next bit to be written.
+	*/
+	bitpos m_position;
+
+	/**
+		Position of bit after last bit in char array.
+	*/
+	bitpos m_end;
+
+	/**
+		Number of bit fields to insert per container.
+	*/
+	size_t m_repeat;
+
+	/**
+		Order in which bits of char array are numbered.
+	*/
+	bit_order m_order;
+};
+
+// bit_reader operator overloads //////////////////////////////////////////////
+
+/**
+    Get single bit from reader and place in bool.
+
+    \param[in,out] r Reference to bit_reader on left-hand side of operator.
+    \param[out] b bool on right-hand side of operator.
+    \return Reference to bit_reader parameter.
+*/
+inline bit_reader &operator>>(bit_reader &r, bool &b)
+{
+	bitfield value;
+	r.read<1>(value);
+	b = value != 0;
+
+	return r;
+}
+
+/**
+    Get single bit from reader that must be equal to bool.
+
+	\note On mismatch, the reader fails.
+
+    \param[in,out] r Reference to bit_reader on left-hand side of operator.
+    \param[in] b bool on right-hand side of operator.
+    \return Reference to bit_reader parameter.
+*/
+inline bit_reader &operator>>(bit_reader &r, const bool &b)
+{
+	bool value;
+	if (r >> value && value != b)
+	{
+		r.setstate(std::ios_base::failbit);
+	}
+
+	return r;
+}
+
+/**
+	Get bits from reader and place in bitset.
+
+	\param[in,out] r Reference to bit_reader on left-hand side of operator.
+	\param[out] bs bitset on right-hand side of operator.
+	\return Reference to bit_reader parameter.
+*/
+template <size_t N>
+typename boost::enable_if_c<(N <= sizeof(bitfield) * CHAR_BIT), bit_reader &>::type
+operator>>(bit_reader &r, std::bitset<N> &bs)
+{
+	bitfield value;
+	r.read<N>(value);
+	bs = value;
+
+	return r;
+}
+
+/**
+	Get bits from reader and place in bitset wider than bitfield.
+
+	\param[in,out] r Reference to bit_reader on left-hand side of operator.
+	\param[out] bs bitset on right-hand side of operator.
+	\return Reference to bit_reader parameter.
+*/
+template <size_t N>
+typename boost::enable_if_c<(N > sizeof(bitfield) * CHAR_BIT), bit_reader &>::type
+operator>>(bit_reader &r, std::bitset<N> &bs)
+{
+	unsigned char bytes[(N + CHAR_BIT - 1) / CHAR_BIT];
+	r.read_wide(bytes, N);
+	bs = detail::bytes_to_bitset<N>(bytes, r.order());
+
+	return r;
+}
+
+/**
+	Get bits from reader that must be equal to bitset value.
+
+	\param[in,out] r Reference to bit_reader on left-hand side of operator.
+	\param[in] bs bitset on right-hand side of operator.
+	\return Reference to bit_reader parameter.
+*/
+template <size_t N>
+bit_reader &operator>>(bit_reader &r, const std::bitset<N> &bs)
+{
+	std::bitset<N> value;
+	if (r >> value && value != bs)
+	{
+		r.setstate(std::ios_base::failbit);
+	}
+
+	return r;
+}
+
+/**
+	Get bit field from reader and place in integral.
+
+	\param[in,out] r Reference to bit_reader on left-hand side of operator.
+	\param[out] b Integral on right-hand side of operator.
+	\return Reference to bit_reader parameter.
+*/
+template <typename T>
+typename boost::enable_if_c<
+	!boost::spirit::traits::is_container<T>::value,
+	bit_reader &>::type
+	operator>>(bit_reader &r, T &b)
+{
+	bitfield value;
+	r.read<sizeof(T) * CHAR_BIT>(value);
+	b = static_cast<T>(value);
+
+	return r;
+}
+
+/**
+	Get bit field from reader that must be equal to integral value.
+
+	\param[in,out] r Reference to bit_reader on left-hand side of operator.
+	\param[in] b Integral on right-hand side of operator.
+	\return Reference to bit_reader parameter.
+*/
+template <typename T>
+typename boost::enable_if_c<
+	!boost::spirit::traits::is_container<T>::value,
+	bit_reader &>::type
+	operator>>(bit_reader &r, const T &b)
+{
+	BOOST_TYPEOF_TPL(b) value;
+	if (r >> value && value != b)
+	{
+		r.setstate(std::ios_base::failbit);
+	}
+
+	return r;
+}
+
+/**
+	Get bit fields from reader that must be equal to elements in container.
+
+	\param[in,out] r Reference to bit_reader on left-hand side of operator.
+	\param[in] c Container on right-hand side of operator.
+	\return Reference to bit_reader parameter.
+*/
+template <typename C>
+typename boost::enable_if_c<
+	boost::spirit::traits::is_container<C>::value,
+	bit_reader &
+>::type
+operator>>(bit_reader &r, const C &c)
+{
+	for (BOOST_AUTO_TPL(it, c.begin()); it != c.end(); ++it)
+	{
+		r >> *it;
+	}
+
+	return r;
+}
+
+/**
+	Get bit fields from reader and place in each element of container.
+
+	\param[in,out] r Reference to bit_reader.
+	\param[out] c Container, already sized.
+	\return Reference to bit_reader parameter.
+*/
+template <typename C>
+bit_reader &extract_elements(bit_reader &r, C &c)
+{
+	for (BOOST_AUTO_TPL(it, c.begin()); it != c.end(); ++it)
+	{
+		// (See extract_elements(istream &, C &) about std::vector<bool>.)
+		typename C::value_type v;
+		r >> v;
+		*it = v;
+	}
+
+	return r;
+}
+
+/**
+	Get bit fields from reader and place in container.
+
+	\see operator>>(istream &, C &) for variable-size containers.
+
+	\param[in,out] r Reference to bit_reader on left-hand side of operator.
+	\param[out] c Container on right-hand side of operator.
+	\return Reference to bit_reader parameter.
+*/
+template <typename C>
+typename boost::enable_if_c<
+	boost::spirit::traits::is_container<C>::value && has_resize<C>::value,
+	bit_reader &
+>::type
+operator>>(bit_reader &r, C &c)
+{
+	c.resize(r.repeat() == 0 ? c.size() : r.repeat());
+
+	return extract_elements(r, c);
+}
+
+/**
+	Get bit fields from reader and place in fixed-size container.
+
+	\param[in,out] r Reference to bit_reader on left-hand side of operator.
+	\param[out] c Container on right-hand side of operator.
+	\return Reference to bit_reader parameter.
+*/
+template <typename C>
+typename boost::enable_if_c<
+	boost::spirit::traits::is_container<C>::value && !has_resize<C>::value,
+	bit_reader &
+>::type
+operator>>(bit_reader &r, C &c)
+{
+	return extract_elements(r, c);
+}
+
+// bit_writer operator overloads //////////////////////////////////////////////
+
+/**
+    Put single bit as bool to writer.
+
+    \param[in,out] w Reference to bit_writer on left-hand side of operator.
+    \param[in] b bool on right-hand side of operator.
+    \return Reference to bit_writer parameter.
+*/
+inline bit_writer &operator<<(bit_writer &w, bool b)
+{
+	return w.write<1>(b ? 1 : 0);
+}
+
+/**
+    Put bits from bitset to writer.
+
+    \param[in,out] w Reference to bit_writer on left-hand side of operator.
+    \param[in] bs bitset on right-hand side of operator.
+    \return Reference to bit_writer parameter.
+*/
+template <size_t N>
+typename boost::enable_if_c<(N <= sizeof(bitfield) * CHAR_BIT), bit_writer &>::type
+operator<<(bit_writer &w, const std::bitset<N> &bs)
+{
+	return w.write<N>(bs.to_ullong());
+}
+
+/**
+    Put bits from bitset wider than bitfield to writer.
+
+    \param[in,out] w Reference to bit_writer on left-hand side of operator.
+    \param[in] bs bitset on right-hand side of operator.
+    \return Reference to bit_writer parameter.
+*/
+template <size_t N>
+typename boost::enable_if_c<(N > sizeof(bitfield) * CHAR_BIT), bit_writer &>::type
+operator<<(bit_writer &w, const std::bitset<N> &bs)
+{
+	unsigned char bytes[(N + CHAR_BIT - 1) / CHAR_BIT];
+	detail::bitset_to_bytes(bs, w.order(), bytes);
+
+	return w.write_wide(bytes, N);
+}
+
+/**
+	Put integral bit field to writer.
+
+	\param[in,out] w Reference to bit_writer on left-hand side of operator.
+	\param[in] b Integral on right-hand side of operator.
+	\return Reference to bit_writer parameter.
+*/
+template <typename T>
+typename boost::enable_if_c<
+	!boost::spirit::traits::is_container<T>::value,
+	bit_writer &
+>::type
+operator<<(bit_writer &w, const T &b)
+{
+	return w.write<sizeof(T) * CHAR_BIT>(static_cast<bitfield>(b));
+}
+
+/**
+	Put bit fields from each element of container to writer.
+
+	\param[in,out] w Reference to bit_writer on left-hand side of operator.
+	\param[in] c Container on right-hand side of operator.
+	\return Reference to bit_writer parameter.
+*/
+template <typename C>
+typename boost::enable_if_c<
+	boost::spirit::traits::is_container<C>::value,
+	bit_writer &
+>::type
+operator<<(bit_writer &w, const C &c)
+{
+	for (BOOST_AUTO_TPL(it, c.begin()); it != c.end(); ++it)
+	{
+		w << *it;
+	}
+
+	return w;
+}
+
+// Bit order of readers and writers ///////////////////////////////////////////
+
+namespace detail {
+
+///@{
+/**
+	Get order in which a reader's or writer's bits are numbered, for
+	decoders written for either a stream or a cursor.
+
+	\param[in] s istream, ostream, bit_reader or bit_writer.
+	\return Bit order.
+*/
+inline bit_order order_of(const istream &s)
+{
+	return s.rdbuf() != NULL ? s.rdbuf()->order() : msb_first;
+}
+
+inline bit_order order_of(const ostream &s)
+{
+	return s.rdbuf() != NULL ? s.rdbuf()->order() : msb_first;
+}
+
+inline bit_order order_of(const bit_reader &s)
+{
+	return s.order();
+}
+
+inline bit_order order_of(const bit_writer &s)
+{
+	return s.order();
+}
+///@}
+
+} // namespace detail
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
@@ -0,0 +1,516 @@
+/** \file
+    \brief Bit-stream buffer and input stream fed as bytes arrive.
+    \details This header file contains a bitbuf to which bytes are appended
+        as they are received, an input bit-stream class that uses it, and a
+        resume point that turns running out of bits into a request for more,
+        so that partially received input is decoded incrementally.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_FEEDBUF_HPP
+#define BOOST_BITSTREAM_FEEDBUF_HPP
+
+#include <boost/bitstream/istream.hpp>
+#include <boost/noncopyable.hpp>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace boost {
+
+namespace bitstream {
+
+// basic_feedbitbuf ///////////////////////////////////////////////////////////
+
+/**
+    This class represents a sequence of bits that grows at the end as bytes
+	are received, e.g., from a TCP connection or datagram fragments.
+
+	\note feed() appends bytes without moving the get pointer, so parsing
+	carries on from the exact bit where it ran out. discard() frees the
+	bytes before the get pointer, so memory is bounded by what has not been
+	parsed yet. Positions are bit offsets from the first byte ever fed, and
+	do not change when bytes are discarded; seeking is possible anywhere in
+	the bytes kept.
+
+	\note Until finish() is called, reaching the end only means that more
+	bytes have not arrived yet; see basic_resume_point.
+
+    \note This is an input buffer; its output sequence is empty. It is not
+	copyable, as a copy would still point into this object's storage.
+*/
+template <class Allocator = std::allocator<unsigned char> >
+class basic_feedbitbuf : public bitbuf, private boost::noncopyable
+{
+public:
+	/**
+		Type of storage.
+	*/
+	typedef std::vector<unsigned char, Allocator> vector_type;
+
+	/**
+		Constructor.
+
+		\param[in] allocator Allocator for storage.
+	*/
+	explicit basic_feedbitbuf(const Allocator &allocator = Allocator()) :
+		bitbuf(std::ios_base::in), m_bytes(allocator), m_origin(0),
+		m_finished(false)
+	{
+		setg(NULL, 0, 0, 0);
+		setp(NULL, 0, 0);
+	}
+
+	/**
+		Append bytes to the input sequence.
+
+		\param[in] bytes Bytes received.
+		\param[in] count Number of bytes.
+		\return Whether the bytes were appended; false if storage could not
+		grow or finish() has been called.
+	*/
+	bool feed(const char *bytes, std::streamsize count)
+	{
+		bool fed = !m_finished && count >= 0;
+
+		if (fed && count > 0)
+		{
+			const bitpos get_position = gptr();
+
+			try
+			{
+				m_bytes.insert(m_bytes.end(), bytes, bytes + count);
+			}
+			catch (const std::bad_alloc &)
+			{
+				fed = false;
+			}
+
+			refresh(get_position);
+		}
+
+		return fed;
+	}
+
+	/**
+		Mark the end of the input; nothing more will be fed.
+	*/
+	void finish()
+	{
+		m_finished = true;
+	}
+
+	/**
+		Determine whether the end of the input has been marked.
+
+		\return Whether finish() has been called.
+	*/
+	bool finished() const
+	{
+		return m_finished;
+	}
+
+	/**
+		Get number of bits fed so far.
+
+		\return Position just past the last bit fed.
+	*/
+	std::streamsize bits() const
+	{
+		return static_cast<std::streamsize>(m_origin + egptr());
+	}
+
+	/**
+		Free the bytes before the one containing the get pointer.
+
+		\note Afterwards, the get pointer cannot be moved back before that
+		byte.
+	*/
+	void discard()
+	{
+		const size_t count = static_cast<size_t>(gptr() / CHAR_BIT);
+
+		if (count > 0)
+		{
+			const bitpos get_position = gptr() - static_cast<bitpos>(count) * CHAR_BIT;
+			m_bytes.erase(m_bytes.begin(), m_bytes.begin() + count);
+			m_origin += static_cast<bitpos>(count) * CHAR_BIT;
+			refresh(get_position);
+		}
+	}
+
+protected:
+	// Virtual buffer-management and positioning functions ////////////////////
+
+	/**
+		Set buffer to access.
+
+		\note Not supported; this object owns its storage.
+
+		\return NULL.
+	*/
+	virtual bitbuf *setbuf(unsigned char *, std::streamsize)
+	{
+		return NULL;
+	}
+
+	/**
+		Determine whether slices may be made of the get area.
+
+		\note Not supported. feed() may reallocate storage and discard()
+		moves it, so a slice of it would dangle.
+
+		\return false.
+	*/
+	virtual bool sliceable() const
+	{
+		return false;
+	}
+
+	/**
+		Set get pointer relative to current position.
+
+		\note std::ios_base::end is relative to bits().
+
+		\param[in] offset Amount by which get pointer is adjusted.
+		\param[in] way From which pointer offset is applied for new position.
+		\param[in] which Open mode.
+		\return New position after get pointer modified.
+	*/
+	virtual std::streampos seekoff(std::streamoff offset,
+		std::ios_base::seekdir way,
+		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+	{
+		std::streampos new_position = std::streampos(-1);
+
+		if ((which & std::ios_base::in) != 0)
+		{
+			bitpos target = -1;
+
+			switch (way)
+			{
+			case std::ios_base::beg:
+				target = offset;
+				break;
+
+			case std::ios_base::cur:
+				target = m_origin + gptr() + offset;
+				break;
+
+			case std::ios_base::end:
+				target = bits() + offset;
+				break;
+
+			default:
+				break;
+			}
+
+			new_position = seekpos(std::streampos(target), which);
+		}
+
+		return new_position;
+	}
+
+	/**
+		Set get pointer to absolute position.
+
+		\param[in] position New absolute position for get pointer.
+		\param[in] which Open mode.
+		\return New position after get pointer modified or
+		std::streampos(-1) if it is not within the bytes kept.
+	*/
+	virtual std::streampos seekpos(std::streampos position,
+		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+	{
+		std::streampos new_position = std::streampos(-1);
+		const bitpos target = std::streamoff(position);
+
+		if ((which & std::ios_base::in) != 0 && target >= m_origin &&
+			target <= bits())
+		{
+			refresh(target - m_origin);
+			new_position = position;
+		}
+
+		return new_position;
+	}
+
+private:
+	/**
+		Make the bytes kept the get area.
+
+		\param[in] get_position Position of get pointer relative to first
+		byte kept.
+	*/
+	void refresh(bitpos get_position)
+	{
+		unsigned char * const buffer = m_bytes.empty() ? NULL : &m_bytes[0];
+		setg(buffer, 0, get_position, static_cast<bitpos>(m_bytes.size()) * CHAR_BIT);
+		setp(buffer, 0, 0);
+	}
+
+	/**
+		Bytes fed and not discarded.
+	*/
+	vector_type m_bytes;
+
+	/**
+		Absolute bit position of first byte kept.
+	*/
+	bitpos m_origin;
+
+	/**
+		Whether finish() has been called.
+	*/
+	bool m_finished;
+};
+
+/**
+	A fed bitbuf using the default allocator.
+*/
+typedef basic_feedbitbuf<> feedbitbuf;
+
+// basic_ifeedbitstream ///////////////////////////////////////////////////////
+
+/**
+    This class provides an interface to read bits from an input stream that
+	is fed as bytes arrive.
+
+	\note Like its buffer, this class is not copyable.
+
+	\see basic_feedbitbuf.
+*/
+template <class Allocator = std::allocator<unsigned char> >
+class basic_ifeedbitstream : public istream, private boost::noncopyable
+{
+public:
+	/**
+		Constructor.
+
+		\param[in] allocator Allocator for storage.
+	*/
+	explicit basic_ifeedbitstream(const Allocator &allocator = Allocator()) :
+		istream(&m_bitbuf), m_bitbuf(allocator)
+	{
+	}
+
+	/**
+		Get the bitbuf object associated with the stream upon construction.
+
+		\return A pointer to the bitbuf object associated with the stream.
+	*/
+	basic_feedbitbuf<Allocator> *rdbuf() const
+	{
+		return const_cast<basic_feedbitbuf<Allocator> *>(&m_bitbuf);
+	}
+
+	/**
+		Append bytes to the input sequence.
+
+		\see basic_feedbitbuf::feed().
+
+		\param[in] bytes Bytes received.
+		\param[in] count Number of bytes.
+		\return This bit stream.
+	*/
+	basic_ifeedbitstream &feed(const char *bytes, std::streamsize count)
+	{
+		if (!m_bitbuf.feed(bytes, count))
+		{
+			badbit();
+		}
+
+		return *this;
+	}
+
+	/**
+		Mark the end of the input.
+	*/
+	void finish()
+	{
+		m_bitbuf.finish();
+	}
+
+	/**
+		Determine whether the end of the input has been marked.
+
+		\return Whether finish() has been called.
+	*/
+	bool finished() const
+	{
+		return m_bitbuf.finished();
+	}
+
+	/**
+		Get number of bits fed so far.
+
+		\return Position just past the last bit fed.
+	*/
+	std::streamsize bits() const
+	{
+		return m_bitbuf.bits();
+	}
+
+	/**
+		Free the bytes before the one containing the get pointer.
+	*/
+	void discard()
+	{
+		m_bitbuf.discard();
+	}
+
+private:
+	/**
+		Buffer from which this class serially reads bits.
+	*/
+	basic_feedbitbuf<Allocator> m_bitbuf;
+};
+
+/**
+	A fed input bit stream using the default allocator.
+*/
+typedef basic_ifeedbitstream<> ifeedbitstream;
+
+// basic_resume_point /////////////////////////////////////////////////////////
+
+/**
+	Result of an attempt to decode from a fed stream.
+*/
+enum decode_status
+{
+	/**
+		Everything was there and decoded.
+	*/
+	decode_complete,
+
+	/**
+		More bytes are needed; the stream is back where the attempt started.
+	*/
+	decode_need_more,
+
+	/**
+		The input is invalid, or ended for good before the attempt was done.
+	*/
+	decode_failed
+};
+
+/**
+    Objects of this class let a decoder stop where a fed stream runs out and
+	carry on when more bytes arrive, e.g.,
+	\code
+	void on_receive(const char *bytes, std::streamsize count)
+	{
+		in.feed(bytes, count);
+		boost::bitstream::resume_point step(in);
+		for (;;)
+		{
+			in >> record;
+			if (step.result() != boost::bitstream::decode_complete)
+			{
+				break;
+			}
+			handle(record);
+			in.discard();
+		}
+	}
+	\endcode
+
+	\note Each decoding step since the last result() is either complete, in
+	which case the resume point moves up to the current position; or it ran
+	out of bits before finish() was called, in which case the stream is put
+	back at the resume point with its state cleared, to be tried again after
+	the next feed(); or it failed. Only the step that ran out is redone, so
+	decoding a large message in steps costs time in proportion to its size,
+	however it arrives.
+
+	\note A step that fails, e.g., on a const field that does not match,
+	and then runs out too, needs more bytes as far as the stream state
+	tells; the failure is reported when it is retried with more bytes.
+
+	\tparam FeedStream basic_ifeedbitstream type.
+*/
+template <typename FeedStream>
+class basic_resume_point : private boost::noncopyable
+{
+public:
+	/**
+		Constructor.
+
+		\param[in,out] in Stream to resume.
+	*/
+	explicit basic_resume_point(FeedStream &in) : m_stream(in),
+		m_position(in.tellg())
+	{
+		// Do nothing.
+	}
+
+	/**
+		Settle the decoding done since construction or the last call.
+
+		\return Whether it completed, needs more bytes or failed.
+	*/
+	decode_status result()
+	{
+		decode_status status;
+
+		if (!m_stream.fail())
+		{
+			// The end of what has arrived is not the end of the input.
+			if (!m_stream.finished())
+			{
+				m_stream.clear(m_stream.rdstate() & ~std::ios_base::eofbit);
+			}
+			m_position = m_stream.tellg();
+			status = decode_complete;
+		}
+		else if (m_stream.eof() && !m_stream.bad() && !m_stream.finished())
+		{
+			m_stream.clear();
+			m_stream.seekg(m_position);
+			status = decode_need_more;
+		}
+		else
+		{
+			status = decode_failed;
+		}
+
+		return status;
+	}
+
+	/**
+		Get position from which decoding resumes.
+
+		\return Position of get pointer after last complete step.
+	*/
+	std::streampos position() const
+	{
+		return m_position;
+	}
+
+private:
+	/**
+		Stream to resume.
+	*/
+	FeedStream &m_stream;
+
+	/**
+		Position of get pointer after last complete step.
+	*/
+	std::streampos m_position;
+};
+
+/**
+	A resume point for the fed input bit stream using the default allocator.
+*/
+typedef basic_resume_point<ifeedbitstream> resume_point;
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
@@ -15,8 +15,29 @@
 #define BOOST_BITSTREAM_IOB_HPP
 
 #include <boost/assert.hpp>
+#include <boost/bitstream/packed.hpp>
+#include <boost/bitstream/stats.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/endian/conversion.hpp>
+#include <boost/integer.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/array.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_const.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <algorithm>
+#include <bitset>
+#include <climits>
+#include <cstring>
+#include <functional>
 #include <iostream>
 #include <ios>
+#include <vector>
+#ifndef BOOST_NO_CXX11_HDR_ARRAY
+#include <array>
+#endif
 
 namespace boost {
 
@@ -28,8 +49,153 @@ namespace bitstream {
 */
 typedef uintmax_t bitfield;
 
+/** Integral type for bit positions and offsets within a bitbuf.
+
+	\note std::streampos is a class that also carries multibyte conversion
+	state, which is meaningless for bits, and converting it to and from an
+	integral is not free. bitbuf keeps positions in this plain 64-bit type and
+	uses std::streampos only at its public interface.
+*/
+typedef boost::int64_t bitpos;
+
+// Traits /////////////////////////////////////////////////////////////////////
+
+/**
+	The value member of this class expresses whether the type is an integral
+	that can be copied to and from a bit stream as whole bytes, i.e., not bool
+	and not const.
+
+	\param[out] value Whether type is such an integral.
+*/
+template <typename T>
+struct is_bulk_integral : boost::integral_constant<bool,
+	boost::is_integral<T>::value && !boost::is_same<T, bool>::value &&
+	!boost::is_const<T>::value && sizeof(T) <= sizeof(bitfield)>
+{
+};
+
+/**
+	The value member of this class expresses whether the container stores
+	its elements contiguously and those elements are integrals for which
+	is_bulk_integral holds.
+
+	\note Such containers are extracted and inserted with
+	bitbuf::sgetaligned() and bitbuf::sputaligned() when byte aligned.
+
+	\param[out] value Whether container is such a container.
+*/
+template <typename C>
+struct is_contiguous_integral : boost::false_type
+{
+};
+
+template <typename T, typename Allocator>
+struct is_contiguous_integral<std::vector<T, Allocator> > :
+	is_bulk_integral<T>
+{
+};
+
+template <typename T, std::size_t N>
+struct is_contiguous_integral<boost::array<T, N> > : is_bulk_integral<T>
+{
+};
+
+#ifndef BOOST_NO_CXX11_HDR_ARRAY
+template <typename T, std::size_t N>
+struct is_contiguous_integral<std::array<T, N> > : is_bulk_integral<T>
+{
+};
+#endif
+
+// bit_order //////////////////////////////////////////////////////////////////
+
+/**
+	Order in which a bitbuf numbers the bits of its char array.
+*/
+enum bit_order
+{
+	/**
+		First bit is the MSB of the first byte, and a field's first bit is its
+		most significant, as in network protocols and MPEG.
+	*/
+	msb_first,
+
+	/**
+		First bit is the LSB of the first byte, and a field's first bit is its
+		least significant, i.e., multibyte fields are little endian, as in
+		DEFLATE, CAN signals and x86 bitmaps.
+	*/
+	lsb_first
+};
+
+namespace detail {
+
+/**
+	Convert a wide field, as copied by bitbuf::sgetwide(), to a bitset.
+
+	\param[in] bytes (N + CHAR_BIT - 1) / CHAR_BIT bytes of field.
+	\param[in] order Order of bits in bytes.
+	\return bitset whose bit 0 is the least-significant bit of the field.
+*/
+template <size_t N>
+std::bitset<N> bytes_to_bitset(const unsigned char *bytes, bit_order order)
+{
+	const size_t byte_count = (N + CHAR_BIT - 1) / CHAR_BIT;
+
+	std::bitset<N> bs;
+	for (size_t i = 0; i < byte_count; ++i)
+	{
+		if (order == msb_first)
+		{
+			// The low bits of a partial last byte are padding.
+			const size_t bits = std::min(size_t(CHAR_BIT), N - i * CHAR_BIT);
+			bs <<= bits;
+			bs |= std::bitset<N>(bytes[i] >> (CHAR_BIT - bits));
+		}
+		else
+		{
+			bs |= std::bitset<N>(bytes[i]) << (i * CHAR_BIT);
+		}
+	}
+
+	return bs;
+}
+
+/**
+	Convert a bitset to a wide field, as copied by bitbuf::sputwide().
+
+	\param[in] bs bitset whose bit 0 is the least-significant bit of the
+	field.
+	\param[in] order Order of bits in bytes.
+	\param[out] bytes (N + CHAR_BIT - 1) / CHAR_BIT bytes of field.
+*/
+template <size_t N>
+void bitset_to_bytes(const std::bitset<N> &bs, bit_order order,
+	unsigned char *bytes)
+{
+	const size_t byte_count = (N + CHAR_BIT - 1) / CHAR_BIT;
+	const std::bitset<N> byte_mask(UCHAR_MAX);
+
+	for (size_t i = 0; i < byte_count; ++i)
+	{
+		const size_t end = (i + 1) * CHAR_BIT;
+		const std::bitset<N> byte = order == lsb_first ? bs >> (i * CHAR_BIT) :
+			end <= N ? bs >> (N - end) : bs << (end - N);
+		bytes[i] = static_cast<unsigned char>((byte & byte_mask).to_ulong());
+	}
+}
+
+} // namespace detail
+
 // bitbuf /////////////////////////////////////////////////////////////////////
 
+class bit_reader;
+class bit_writer;
+class codec_access;
+class unchecked;
+class packet_template;
+template <typename Checksum> class basic_checksumbitbuf;
+
 /**
     This class represents contiguous memory, accessed as a sequence of bit
     fields.
@@ -38,8 +204,18 @@ typedef uintmax_t bitfield;
     stringbuf. The main difference is that this class provides access to bits
     whereas stringbuf provides access to characters.
 
-    \note Currently, this class can only be used to read bits from a buffer;
-    however, it could be easily be fleshed out for writing bits, too.
+    \note Like stringbuf, this class has a get area, from which bits are read
+    with sgetn() and sgetb(), and a put area, to which bits are written with
+    sputn() and sputb(); here, both are on the same char array. Derived
+    classes grow the array or refill it from a device (see vectorbuf.hpp and
+    streambuf.hpp).
+
+	\note If BOOST_BITSTREAM_PAD_AREAS is defined, the get positions, the
+	put positions, and the buffer pointer and bit order that both read are
+	each padded onto cache lines of their own, for a reader and a writer in
+	different threads (see ringbuf.hpp). Like BOOST_BITSTREAM_STATS, it
+	changes the layout, so it must be defined the same way in every
+	translation unit of a program.
 */
 class bitbuf
 {
@@ -51,7 +227,7 @@ public:
 	*/
 	explicit bitbuf(std::ios_base::openmode which =
 		std::ios_base::in | std::ios_base::out) : m_buffer(NULL),
-		m_eback(0), m_gptr(0), m_egptr(0),
+		m_order(msb_first), m_eback(0), m_gptr(0), m_egptr(0),
 		m_pbase(0), m_pptr(0), m_epptr(0)
 	{
 		// TBD Output not support, so can't append.
@@ -69,11 +245,19 @@ public:
     bitbuf(const char *buffer, std::streamsize size_,
         std::ios_base::openmode which = std::ios_base::in | std::ios_base::out) :
         m_buffer(reinterpret_cast<unsigned char *>(const_cast<char *>(buffer))),
-		m_eback(0), m_gptr(0), m_egptr(size_),
+		m_order(msb_first), m_eback(0), m_gptr(0), m_egptr(size_),
 		m_pbase(0), m_pptr(0), m_epptr(size_)
 	{
 	}
 
+	/**
+		Destructor.
+	*/
+	virtual ~bitbuf()
+	{
+		// Do nothing.
+	}
+
     /**
         Get pointer to char-array stream buffer.
 
@@ -96,7 +280,91 @@ public:
 	*/
 	std::streamsize size() const
 	{
-		return egptr();
+		return egptr() - eback();
+	}
+
+	/**
+		Get order in which bits are numbered.
+
+		\return Bit order.
+	*/
+	bit_order order() const
+	{
+		return m_order;
+	}
+
+	/**
+		Set order in which bits are numbered.
+
+		\note This changes how the bits already in the char array are read,
+		not the bits themselves, so data in LSB-first form needs no pre-pass.
+		Slices get the order of the buffer they view.
+
+		\param[in] order_ Bit order.
+	*/
+	void order(bit_order order_)
+	{
+		m_order = order_;
+	}
+
+	/**
+		Get a buffer that views part of the accessible input sequence.
+
+		\note No bits are copied; the slice refers to the same char array, so
+		it must not outlive it. The slice's positions start at 0 and it cannot
+		seek outside its bits. If this buffer can also write those bits, so
+		can the slice.
+
+		\note Buffers whose bytes move or are reused, i.e., streambitbuf,
+		chainbitbuf, feedbitbuf and ringbitbuf, make no slices, since a
+		slice would dangle after the next refill or feed.
+
+		\param[in] begin Position of first bit in slice.
+		\param[in] end Position just past last bit in slice.
+		\return Buffer for bits [begin, end); empty if they are not all
+		within the accessible input sequence or this buffer makes no slices.
+	*/
+	bitbuf slice(std::streampos begin, std::streampos end) const
+	{
+		return make_slice(eback() + std::streamoff(begin),
+			eback() + std::streamoff(end));
+	}
+
+	/**
+		Copy bits from the accessible input sequence of one buffer to the
+		accessible output sequence of another, or of the same one.
+
+		\note Neither buffer's pointers move. When both positions are at the
+		same offset within a byte, e.g., both byte aligned, the bytes between
+		are a memmove(); otherwise, the destination is brought to a byte
+		boundary and then written 64 bits at a time, each a funnel shift of
+		two source loads. The ranges may overlap.
+
+		\param[in] src Buffer to copy from.
+		\param[in] src_pos Position of first bit relative to src's eback().
+		\param[in,out] dst Buffer to copy to.
+		\param[in] dst_pos Position of first bit relative to dst's pbase().
+		\param[in] size Number of bits to copy.
+		\return Number of bits copied: size, or 0 if either range is not
+		all within its sequence or the buffers' bit orders differ.
+	*/
+	static std::streamsize copy_bits(const bitbuf &src, std::streampos src_pos,
+		bitbuf &dst, std::streampos dst_pos, std::streamsize size)
+	{
+		const bitpos from = src.eback() + std::streamoff(src_pos);
+		const bitpos to = dst.pbase() + std::streamoff(dst_pos);
+		std::streamsize bits_copied = 0;
+
+		if (size >= 0 && src.m_order == dst.m_order &&
+			src.eback() <= from && from + size <= src.egptr() &&
+			dst.pbase() <= to && to + size <= dst.epptr())
+		{
+			blit_bits(src.m_order, src.m_buffer, from, dst.m_buffer, to,
+				static_cast<size_t>(size));
+			bits_copied = size;
+		}
+
+		return bits_copied;
 	}
 
     /**
@@ -124,6 +392,8 @@ public:
         std::ios_base::seekdir way,
 		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
     {
+		BOOST_BITSTREAM_COUNT(m_stats.count_seekoff(which));
+
         return seekoff(offset, way, which);
     }
 
@@ -137,6 +407,8 @@ public:
     std::streampos pubseekpos(std::streampos position,
 		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
     {
+		BOOST_BITSTREAM_COUNT(m_stats.count_seekpos(which));
+
         return seekpos(position, which);
     }
 
@@ -162,16 +434,48 @@ public:
         return sync();
     }
 
+	// Instrumentation ////////////////////////////////////////////////////////
+
+	/**
+		Get instrumentation counters.
+
+		\note Counters are only kept if BOOST_BITSTREAM_STATS is defined;
+		otherwise, they are all 0. See stream_stats.
+
+		\return Snapshot of counters.
+	*/
+	stream_stats stats() const
+	{
+#ifdef BOOST_BITSTREAM_STATS
+		return m_stats;
+#else
+		return stream_stats();
+#endif
+	}
+
+	/**
+		Zero instrumentation counters.
+	*/
+	void reset_stats()
+	{
+		BOOST_BITSTREAM_COUNT(m_stats.reset());
+	}
+
 	// Input functions ////////////////////////////////////////////////////////
 
 	/**
 		Number of bits currently available to read.
 
-		\return Number of readable bits.
+		\note Like streambuf::in_avail(), this is the number of bits left in
+		the get area or, if there are none, whatever showmanyb() says.
+
+		\return Number of readable bits; -1 if certainly none.
 	*/
-	std::streamsize in_avail() const
+	std::streamsize in_avail()
 	{
-		return egptr() - gptr();
+		const std::streamsize available = egptr() - gptr();
+
+		return available > 0 ? available : showmanyb();
 	}
 
     /**
@@ -188,6 +492,9 @@ public:
 	/**
 		Get current bit at get pointer.
 
+		\note This does not advance the get pointer, so, like speekn(), it
+		is not counted in stats().
+
 		\param[out] value Current bit.
 		\return Whether okay (eof has not been encountered).
 	*/
@@ -195,25 +502,22 @@ public:
 	{
 		// Note: This is an optimization of "return sgetn(bitfield, 1) == 1;"
 
-		bool get_succeeded = true;
+		bool get_succeeded;
 
-		if (gptr() == std::streampos(-1) || gptr() == egptr())
+		if (gptr() == bitpos(-1) || gptr() == egptr())
 		{
 			get_succeeded = underflow(b);
 		}
 		else
 		{
-			const size_t intra_byte_bit_offset = gptr() % CHAR_BIT;
-			const size_t shift_amount = (CHAR_BIT - ((1 + intra_byte_bit_offset) % CHAR_BIT)) % CHAR_BIT;
+			const size_t shift_amount = bit_shift(gptr());
 			const unsigned char mask = 1 << shift_amount;
 			b = (*current_get_byte() & mask) >> shift_amount;
 
-			gbump(1);
-
 			get_succeeded = true;
 		}
 
-		return get_succeeded = true;;
+		return get_succeeded;
 	}
 
     /**
@@ -225,173 +529,762 @@ public:
     */
     std::streamsize sgetn(bitfield &value, std::streamsize size)
     {
-        return xsgetn(value, size);
-    }
-
-    /**
-        Advance get pointer and return next bit.
+		const std::streamsize bits_read = xsgetn(value, size);
+		BOOST_BITSTREAM_COUNT(m_stats.count_read(gptr() - bits_read, bits_read));
 
-        \param[out] value Next bit.
-        \return Whether okay (eof has not been encountered).
-    */
-    bool snextb(bitfield &value)
-    {
-		bitfield dummy;
-		return sbumpb(dummy) && sgetb(value);
+        return bits_read;
     }
 
 	/**
-		Put bit at get pointer.
+		Get sequence of bits whose size is known at compile time.
 
-		\param[out] b Bit to be put back.
-		\return Whether okay (eof has not been encountered).
+		\note When the field lies within the accessible input sequence, it is
+		extracted inline without calling xsgetn(). Masks, shift amounts and the
+		maximum span of bytes are then compile-time constants, and a
+		byte-aligned 8-, 16-, 32- or 64-bit field is a single load. Otherwise,
+		this defers to xsgetn() like sgetn(value, N).
+
+		\tparam N Number of bits in sequence of bits.
+		\param[out] value Value of bit field.
+		\return Number of bits read from buffer or zero if error or eof.
 	*/
-	bool sputbackb(bitfield b)
+	template <size_t N>
+	std::streamsize sgetn(bitfield &value)
 	{
-		bool putback_succeeded;
+		BOOST_STATIC_ASSERT(N > 0 && N <= sizeof(bitfield) * CHAR_BIT);
 
-		if (gptr() == std::streampos(-1) || gptr() == eback() ||
-			b != atgptrb(-1))
+		std::streamsize bits_read;
+
+		if (static_cast<bitpos>(N) <= egptr() - gptr())
 		{
-			putback_succeeded = pbackfail(b);
+			value = get_field<N>(current_get_byte(), gptr() % CHAR_BIT,
+				bytes_remaining(gptr(), egptr()));
+			gbump(N);
+			bits_read = N;
 		}
 		else
 		{
-			gbump(-1);
-			putback_succeeded = gptr() != std::streampos(-1);
+			bits_read = xsgetn(value, N);
 		}
+		BOOST_BITSTREAM_COUNT(m_stats.count_read(gptr() - bits_read, bits_read));
 
-		return putback_succeeded;
+		return bits_read;
 	}
 
 	/**
-		Move get pointer backwards and return bit at new position.
+		Get sequence of bits without advancing get pointer.
 
-		\param[out] value Bit before position prior to call.
-		\return Whether okay (eof has not been encountered).
+		\note This is look-ahead for table-driven decoders: peek at the next
+		few bits, then sskipn() past as many as were used. When the bits lie
+		within the accessible input sequence, they are loaded inline with no
+		seek; otherwise, this defers to xspeekn().
+
+		\param[out] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits peeked at or zero if error or eof.
 	*/
-	bool sungetb(bitfield &b)
+	std::streamsize speekn(bitfield &value, std::streamsize size)
 	{
-		bool unget_succeeded;
+		return size <= egptr() - gptr() ? xsgetn_nobump(value, size) :
+			xspeekn(value, size);
+	}
+
+	/**
+		Get sequence of bits whose size is known at compile time without
+		advancing get pointer.
+
+		\note See speekn(bitfield &, std::streamsize) and sgetn<N>().
+
+		\tparam N Number of bits in sequence of bits.
+		\param[out] value Value of bit field.
+		\return Number of bits peeked at or zero if error or eof.
+	*/
+	template <size_t N>
+	std::streamsize speekn(bitfield &value)
+	{
+		BOOST_STATIC_ASSERT(N > 0 && N <= sizeof(bitfield) * CHAR_BIT);
+
+		std::streamsize bits_read;
 
-		if (gptr() == std::streampos(-1) || gptr() == eback())
+		if (static_cast<bitpos>(N) <= egptr() - gptr())
 		{
-			bitfield dummy;
-			unget_succeeded = pbackfail(dummy);
+			value = get_field<N>(current_get_byte(), gptr() % CHAR_BIT,
+				bytes_remaining(gptr(), egptr()));
+			bits_read = N;
 		}
 		else
 		{
-			gbump(-1);
-			unget_succeeded = atgptrb(b);
+			bits_read = xspeekn(value, N);
 		}
 
-		return unget_succeeded;
+		return bits_read;
 	}
 
-	// Output functions ///////////////////////////////////////////////////////
-
 	/**
-		Put bit at put pointer.
+		Advance get pointer.
 
-		\param[out] b Current bit.
-		\return Whether okay (eof has not been encountered).
+		\note Within the accessible input sequence, this only moves the get
+		pointer; beyond it, it defers to seekoff().
+
+		\param[in] size Number of bits to skip.
+		\return Number of bits skipped or zero if error or eof.
 	*/
-	bool sputb(bitfield b)
+	std::streamsize sskipn(std::streamsize size)
 	{
-		// Note: This is an optimization of "return sputn(bitfield, 1) == 1;"
+		std::streamsize bits_skipped = 0;
 
-		bool put_succeeded = true;
-
-		if (pptr() == std::streampos(-1) || pptr() == epptr())
+		if (size >= 0 && size <= egptr() - gptr())
 		{
-			put_succeeded = overflow(b);
+			gbump(size);
+			bits_skipped = size;
 		}
-		else
+		else if (pubseekoff(size, std::ios_base::cur, std::ios_base::in) !=
+			std::streampos(-1))
 		{
-			const size_t intra_byte_bit_offset = pptr() % CHAR_BIT;
-			const size_t shift_amount = (CHAR_BIT - ((1 + intra_byte_bit_offset) % CHAR_BIT)) % CHAR_BIT;
-			const unsigned char mask = ~(1 << shift_amount);
-			unsigned char * const byte_pointer = current_put_byte();
-			*byte_pointer = *byte_pointer & mask | (b & 1) << shift_amount;
-
-			pbump(1);
+			bits_skipped = size;
 		}
 
-		return put_succeeded;
+		return bits_skipped;
 	}
 
 	/**
-		Put sequence of bits.
-
-		\param[in] value Value of bit field.
-		\param[in] size Number of bits in sequence of bits.
-		\return Number of bits written to buffer or zero if error or eof.
+		Find a sequence of bits in the get area without advancing get
+		pointer.
+
+		\note Only the offsets offset, offset + step, offset + 2 * step,
+		etc., from gptr() are tried, and only where all size bits are in the
+		get area. When they are all byte aligned and size is a multiple of
+		CHAR_BIT, candidates are found by their first byte, with memchr() if
+		step is one byte; otherwise, each is a shift of a 64-bit window that
+		is reloaded only when the candidate moves to another byte.
+
+		\param[in] pattern Sequence of bits, right-justified, in the order of
+		this buffer.
+		\param[in] size Number of bits in pattern, 1 through the number of
+		bits in bitfield.
+		\param[in,out] offset Offset from gptr() of first candidate; on
+		return, of the match or, if none, of the first candidate that did
+		not fit in the get area.
+		\param[in] step Distance between candidates, at least 1.
+		\return Whether the pattern was found.
 	*/
-	std::streamsize sputn(bitfield value, std::streamsize size)
+	bool sfind(bitfield pattern, std::streamsize size, std::streamsize &offset,
+		std::streamsize step = 1)
 	{
-		return xsputn(value, size);
-	}
+		static const size_t window_bits = sizeof(boost::uint64_t) * CHAR_BIT;
 
-protected:
-	// Input functions ////////////////////////////////////////////////////////
+		bool found = false;
 
-	/**
-        Returns first bit position in accessible input sequence.
+		if (size > 0 && size <= static_cast<std::streamsize>(window_bits) &&
+			offset >= 0 && step > 0)
+		{
+			pattern &= low_bits_mask(static_cast<size_t>(size));
+			const bitpos end = egptr() - size;
+			bitpos position = gptr() + offset;
 
-        \return Position of first bit.
-    */
-    std::streampos eback() const
-    {
-        return m_eback;
-    }
+			if (position % CHAR_BIT == 0 && step % CHAR_BIT == 0 &&
+				size % CHAR_BIT == 0)
+			{
+				// Byte-aligned: find first byte, then compare the rest.
+				const unsigned char lead = static_cast<unsigned char>(
+					m_order == msb_first ? pattern >> (size - CHAR_BIT) : pattern);
+				const size_t byte_step = static_cast<size_t>(step / CHAR_BIT);
+				const unsigned char *byte_pointer = m_buffer + position / CHAR_BIT;
+				while (!found && position <= end)
+				{
+					if (byte_step == 1)
+					{
+						const unsigned char * const last = m_buffer + end / CHAR_BIT;
+						byte_pointer = static_cast<const unsigned char *>(std::memchr(
+							byte_pointer, lead, static_cast<size_t>(last - byte_pointer) + 1));
+						if (byte_pointer == NULL)
+						{
+							position = (end / CHAR_BIT + 1) * CHAR_BIT;
+							break;
+						}
+						position = static_cast<bitpos>(byte_pointer - m_buffer) * CHAR_BIT;
+					}
+					if (*byte_pointer == lead && get_field(byte_pointer, 0,
+						static_cast<size_t>(size), bytes_remaining(position, egptr())) == pattern)
+					{
+						found = true;
+					}
+					else
+					{
+						position += step;
+						byte_pointer += byte_step;
+					}
+				}
+			}
+			else
+			{
+				// Shift a 64-bit window to each candidate, if it fits in one.
+				const bool in_window = size + CHAR_BIT - 1 <= static_cast<std::streamsize>(window_bits);
+				const unsigned char *window_byte = NULL;
+				boost::uint64_t window = 0;
+				for (; position <= end; position += step)
+				{
+					const unsigned char * const byte_pointer = m_buffer + position / CHAR_BIT;
+					const size_t intra_byte_bit_offset = static_cast<size_t>(position % CHAR_BIT);
+					bitfield field;
+					if (in_window)
+					{
+						if (byte_pointer != window_byte)
+						{
+							const size_t byte_count = bytes_remaining(position, egptr());
+							window = m_order == msb_first ? load_window(byte_pointer, byte_count) :
+								load_lsb_window(byte_pointer, byte_count);
+							window_byte = byte_pointer;
+						}
+						field = m_order == msb_first ?
+							(window << intra_byte_bit_offset) >> (window_bits - size) :
+							(window >> intra_byte_bit_offset) & low_bits_mask(static_cast<size_t>(size));
+					}
+					else
+					{
+						field = get_field(byte_pointer, intra_byte_bit_offset,
+							static_cast<size_t>(size), bytes_remaining(position, egptr()));
+					}
+					if (field == pattern)
+					{
+						found = true;
+						break;
+					}
+				}
+			}
 
-	/**
-		Returns bit position within accessible input sequence of next bit to be
-		read.
+			offset = static_cast<std::streamsize>(position - gptr());
+		}
 
-		\note The "get pointer."
+		return found;
+	}
 
-		\return Next bit position.
+	/**
+		Get array of integrals, each a big-endian bit field of
+		sizeof(T) * CHAR_BIT bits, from a byte-aligned get pointer.
+
+		\note This is a single bounds check, a memcpy() and a byte swap of
+		each integral, which the compiler is free to vectorize. With
+		lsb_first, the integrals are little endian instead. It only does
+		anything when the get pointer is byte aligned and all the bytes lie
+		within the accessible input sequence; otherwise, nothing is read and
+		the caller is expected to fall back to sgetn<N>() for each integral.
+
+		\param[out] values Array to receive integrals.
+		\param[in] count Number of integrals.
+		\return Number of integrals read, either count or zero.
 	*/
-	std::streampos gptr() const
+	template <typename T>
+	typename boost::enable_if_c<is_bulk_integral<T>::value, size_t>::type
+	sgetaligned(T *values, size_t count)
 	{
-		return m_gptr;
+		size_t values_read = 0;
+
+		if (gptr() % CHAR_BIT == 0 &&
+			count <= static_cast<size_t>(egptr() - gptr()) / (sizeof(T) * CHAR_BIT))
+		{
+			std::memcpy(values, current_get_byte(), count * sizeof(T));
+			for (size_t i = 0; m_order == msb_first && i < count; ++i)
+			{
+				boost::endian::big_to_native_inplace(values[i]);
+			}
+			for (size_t i = 0; m_order == lsb_first && i < count; ++i)
+			{
+				boost::endian::little_to_native_inplace(values[i]);
+			}
+			gbump(static_cast<bitpos>(count * sizeof(T) * CHAR_BIT));
+			values_read = count;
+			BOOST_BITSTREAM_COUNT(m_stats.count_reads(
+				gptr() - static_cast<bitpos>(count * sizeof(T) * CHAR_BIT),
+				sizeof(T) * CHAR_BIT, count));
+		}
+
+		return values_read;
 	}
 
 	/**
-		Returns bit position just past last bit in accessible input sequence.
-
-		\return Position after last bit.
+		Get array of N-bit fields packed back to back, each into an integral.
+
+		\note This only does anything when all the fields lie within the
+		accessible input sequence; otherwise, nothing is read and the caller
+		is expected to fall back to sgetn<N>() for each field. Batches of
+		eight fields are unpacked with SIMD instructions where available (see
+		packed.hpp) and the rest with the same kernel as sgetn<N>(). The SIMD
+		kernels are MSB first only.
+
+		\tparam N Number of bits in each field.
+		\param[out] values Array to receive integrals.
+		\param[in] count Number of fields.
+		\return Number of fields read, either count or zero.
 	*/
-	std::streampos egptr() const
+	template <size_t N, typename T>
+	typename boost::enable_if_c<is_bulk_integral<T>::value, size_t>::type
+	sgetpacked(T *values, size_t count)
 	{
-		return m_egptr;
+		BOOST_STATIC_ASSERT(N > 0 && N <= sizeof(T) * CHAR_BIT);
+
+		size_t values_read = 0;
+
+		if (count <= static_cast<size_t>(egptr() - gptr()) / N)
+		{
+			const unsigned char * const byte_pointer = current_get_byte();
+			const size_t offset = static_cast<size_t>(gptr() % CHAR_BIT);
+			const size_t byte_count = bytes_remaining(gptr(), egptr());
+
+			size_t i = m_order == msb_first ? detail::unpack<N>(byte_pointer,
+				offset, values, count, byte_count) : 0;
+			for (size_t position = offset + i * N; i < count; ++i, position += N)
+			{
+				values[i] = static_cast<T>(get_field<N>(
+					byte_pointer + position / CHAR_BIT, position % CHAR_BIT,
+					byte_count - position / CHAR_BIT));
+			}
+
+			gbump(static_cast<bitpos>(count * N));
+			values_read = count;
+			BOOST_BITSTREAM_COUNT(m_stats.count_reads(
+				gptr() - static_cast<bitpos>(count * N), N, count));
+		}
+
+		return values_read;
 	}
 
 	/**
-		Advances the get pointer by specified number of bit positions.
+		Get a buffer that views the next bits and advance past them.
 
-		\param[in] offset Value by which to increase the get pointer.
+		\note See slice(). This only succeeds if all the bits are within the
+		get area and this buffer makes slices; otherwise, nothing is read.
+
+		\param[out] slice Buffer for the next bits.
+		\param[in] bits Number of bits in slice.
+		\return Whether the slice was made.
 	*/
-	void gbump(std::streamoff offset)
+	bool sgetslice(bitbuf &slice, std::streamsize bits)
 	{
-		seekoff(offset, std::ios_base::cur, std::ios_base::in);
+		bool got_slice = false;
+
+		if (sliceable() && bits >= 0 && bits <= egptr() - gptr())
+		{
+			slice = make_slice(gptr(), gptr() + bits);
+			gbump(bits);
+			got_slice = true;
+		}
+
+		return got_slice;
 	}
 
 	/**
-        Set pointer and offsets that define boundaries of and position within
-        accessible input sequence.
+		Get a field of any number of bits.
+
+		\note The field is copied to (size + CHAR_BIT - 1) / CHAR_BIT bytes in
+		the order of this buffer, i.e., left-justified, first bit in the MSB
+		of the first byte, or, with lsb_first, in the LSB; any bits of the
+		last byte past the field are 0. This is for fields wider than
+		bitfield, such as 128-bit IDs and 256-bit bitmaps. Within the get
+		area, each 64 bits are a funnel shift of two loads, or a memcpy()
+		when the get pointer is byte aligned; otherwise, the field is read
+		64 bits at a time with xsgetn().
+
+		\param[out] bytes Array to receive field.
+		\param[in] size Number of bits in field.
+		\return Number of bits read, which is less than size only on error
+		or eof.
+	*/
+	std::streamsize sgetwide(unsigned char *bytes, std::streamsize size)
+	{
+		static const std::streamsize window_bits = sizeof(bitfield) * CHAR_BIT;
 
-        \param[in] buffer Pointer to char array to be accessed.
-        \param[in] gbeg Position of first accessible bit in char array.
-        \param[in] gnext Position of next bit to read.
-        \param[in] gend Position of bit immediately after last accessible bit
-        in char array.
-    */
-    void setg(unsigned char *buffer, std::streampos gbeg, std::streampos gnext,
-        std::streampos gend)
-    {
-        m_buffer = buffer;
+		std::streamsize bits_read = 0;
+
+		if (size >= 0 && size <= egptr() - gptr())
+		{
+			get_wide(m_order, current_get_byte(), gptr() % CHAR_BIT,
+				static_cast<size_t>(size), bytes_remaining(gptr(), egptr()),
+				bytes);
+			gbump(size);
+			bits_read = size;
+		}
+		else
+		{
+			for (; bits_read < size; bits_read += window_bits)
+			{
+				const std::streamsize bits = std::min(
+					std::streamsize(window_bits), size - bits_read);
+				bitfield value;
+				if (xsgetn(value, bits) != bits)
+				{
+					break;
+				}
+				store_wide(bytes + bits_read / CHAR_BIT, value,
+					static_cast<size_t>(bits));
+			}
+			bits_read = std::min(bits_read, size);
+		}
+		BOOST_BITSTREAM_COUNT(m_stats.count_read(gptr() - bits_read, bits_read));
+
+		return bits_read;
+	}
+
+	/**
+		Get bits and put them to another buffer.
+
+		\note Only as many bits as are in this buffer's get area and fit in
+		dst's put area are copied, with copy_bits(); there is no underflow()
+		or overflow(). Both buffers' pointers are advanced past them.
+
+		\param[in,out] dst Buffer to put bits to.
+		\param[in] size Number of bits to copy, at most.
+		\return Number of bits copied, which is 0 if the bit orders differ.
+	*/
+	std::streamsize sgetcopy(bitbuf &dst, std::streamsize size)
+	{
+		std::streamsize bits = std::min(size, std::min(egptr() - gptr(),
+			dst.epptr() - dst.pptr()));
+
+		if (bits > 0 && m_order == dst.m_order)
+		{
+			blit_bits(m_order, m_buffer, gptr(), dst.m_buffer, dst.pptr(),
+				static_cast<size_t>(bits));
+			gbump(bits);
+			dst.pbump(bits);
+			BOOST_BITSTREAM_COUNT(m_stats.count_read(gptr() - bits, bits));
+			BOOST_BITSTREAM_COUNT(dst.m_stats.count_write(dst.pptr() - bits, bits));
+		}
+		else
+		{
+			bits = 0;
+		}
+
+		return bits;
+	}
+
+    /**
+        Advance get pointer and return next bit.
+
+        \param[out] value Next bit.
+        \return Whether okay (eof has not been encountered).
+    */
+    bool snextb(bitfield &value)
+    {
+		bitfield dummy;
+		return sbumpb(dummy) && sgetb(value);
+    }
+
+	/**
+		Put bit at get pointer.
+
+		\param[out] b Bit to be put back.
+		\return Whether okay (eof has not been encountered).
+	*/
+	bool sputbackb(bitfield b)
+	{
+		bool putback_succeeded;
+
+		if (gptr() == bitpos(-1) || gptr() == eback() ||
+			b != atgptrb(-1))
+		{
+			putback_succeeded = pbackfail(b);
+		}
+		else
+		{
+			gbump(-1);
+			putback_succeeded = gptr() != bitpos(-1);
+		}
+
+		return putback_succeeded;
+	}
+
+	/**
+		Move get pointer backwards and return bit at new position.
+
+		\param[out] value Bit before position prior to call.
+		\return Whether okay (eof has not been encountered).
+	*/
+	bool sungetb(bitfield &b)
+	{
+		bool unget_succeeded;
+
+		if (gptr() == bitpos(-1) || gptr() == eback())
+		{
+			bitfield dummy;
+			unget_succeeded = pbackfail(dummy);
+		}
+		else
+		{
+			gbump(-1);
+			unget_succeeded = atgptrb(b);
+		}
+
+		return unget_succeeded;
+	}
+
+	// Output functions ///////////////////////////////////////////////////////
+
+	/**
+		Put bit at put pointer.
+
+		\param[out] b Current bit.
+		\return Whether okay (eof has not been encountered).
+	*/
+	bool sputb(bitfield b)
+	{
+		// Note: This is an optimization of "return sputn(bitfield, 1) == 1;"
+
+		bool put_succeeded = true;
+
+		if (pptr() == bitpos(-1) || pptr() == epptr())
+		{
+			put_succeeded = overflow(b);
+		}
+		else
+		{
+			const size_t shift_amount = bit_shift(pptr());
+			const unsigned char mask = ~(1 << shift_amount);
+			unsigned char * const byte_pointer = current_put_byte();
+			*byte_pointer = (*byte_pointer & mask) | ((b & 1) << shift_amount);
+
+			pbump(1);
+		}
+		BOOST_BITSTREAM_COUNT(m_stats.count_write(pptr() - 1, put_succeeded ? 1 : 0));
+
+		return put_succeeded;
+	}
+
+	/**
+		Put sequence of bits.
+
+		\param[in] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits written to buffer or zero if error or eof.
+	*/
+	std::streamsize sputn(bitfield value, std::streamsize size)
+	{
+		const std::streamsize bits_written = xsputn(value, size);
+		BOOST_BITSTREAM_COUNT(m_stats.count_write(pptr() - bits_written, bits_written));
+
+		return bits_written;
+	}
+
+	/**
+		Put sequence of bits whose size is known at compile time.
+
+		\note See note for sgetn<N>(); this defers to xsputn() when the field
+		does not fit in the accessible output sequence.
+
+		\tparam N Number of bits in sequence of bits.
+		\param[in] value Value of bit field.
+		\return Number of bits written to buffer or zero if error or eof.
+	*/
+	template <size_t N>
+	std::streamsize sputn(bitfield value)
+	{
+		BOOST_STATIC_ASSERT(N > 0 && N <= sizeof(bitfield) * CHAR_BIT);
+
+		std::streamsize bits_written;
+
+		if (static_cast<bitpos>(N) <= epptr() - pptr())
+		{
+			put_field<N>(current_put_byte(), pptr() % CHAR_BIT, value,
+				bytes_remaining(pptr(), epptr()));
+			pbump(N);
+			bits_written = N;
+		}
+		else
+		{
+			bits_written = xsputn(value, N);
+		}
+		BOOST_BITSTREAM_COUNT(m_stats.count_write(pptr() - bits_written, bits_written));
+
+		return bits_written;
+	}
+
+	/**
+		Put array of integrals, each as a big-endian bit field of
+		sizeof(T) * CHAR_BIT bits, at a byte-aligned put pointer.
+
+		\note See note for sgetaligned(); nothing is written unless the put
+		pointer is byte aligned and all the bytes fit in the accessible output
+		sequence.
+
+		\param[in] values Array of integrals.
+		\param[in] count Number of integrals.
+		\return Number of integrals written, either count or zero.
+	*/
+	template <typename T>
+	typename boost::enable_if_c<is_bulk_integral<T>::value, size_t>::type
+	sputaligned(const T *values, size_t count)
+	{
+		size_t values_written = 0;
+
+		if (pptr() % CHAR_BIT == 0 &&
+			count <= static_cast<size_t>(epptr() - pptr()) / (sizeof(T) * CHAR_BIT))
+		{
+			unsigned char * const p = current_put_byte();
+			for (size_t i = 0; i < count; ++i)
+			{
+				const T value = m_order == msb_first ?
+					boost::endian::native_to_big(values[i]) :
+					boost::endian::native_to_little(values[i]);
+				std::memcpy(p + i * sizeof(T), &value, sizeof(T));
+			}
+			pbump(static_cast<bitpos>(count * sizeof(T) * CHAR_BIT));
+			values_written = count;
+			BOOST_BITSTREAM_COUNT(m_stats.count_writes(
+				pptr() - static_cast<bitpos>(count * sizeof(T) * CHAR_BIT),
+				sizeof(T) * CHAR_BIT, count));
+		}
+
+		return values_written;
+	}
+
+	/**
+		Put array of integrals as N-bit fields packed back to back.
+
+		\note See note for sgetpacked(); nothing is written unless all the
+		fields fit in the accessible output sequence. The fields are collected
+		in a register and stored a 64-bit word at a time, so each byte is
+		written once rather than read, masked and written for every field
+		that touches it; SIMD instructions, where available, combine batches
+		of eight fields first (see packed.hpp). The packing kernels are MSB
+		first only, so with lsb_first nothing is written.
+
+		\tparam N Number of bits in each field.
+		\param[in] values Array of integrals.
+		\param[in] count Number of fields.
+		\return Number of fields written, either count or zero.
+	*/
+	template <size_t N, typename T>
+	typename boost::enable_if_c<is_bulk_integral<T>::value, size_t>::type
+	sputpacked(const T *values, size_t count)
+	{
+		BOOST_STATIC_ASSERT(N > 0 && N <= sizeof(bitfield) * CHAR_BIT);
+
+		size_t values_written = 0;
+
+		if (m_order == msb_first &&
+			count <= static_cast<size_t>(epptr() - pptr()) / N)
+		{
+			detail::pack<N>(current_put_byte(),
+				static_cast<size_t>(pptr() % CHAR_BIT), values, count);
+			pbump(static_cast<bitpos>(count * N));
+			values_written = count;
+			BOOST_BITSTREAM_COUNT(m_stats.count_writes(
+				pptr() - static_cast<bitpos>(count * N), N, count));
+		}
+
+		return values_written;
+	}
+
+	/**
+		Put a field of any number of bits.
+
+		\note This is the counterpart of sgetwide(), with the field in bytes
+		the same way.
+
+		\param[in] bytes Array of (size + CHAR_BIT - 1) / CHAR_BIT bytes of
+		field.
+		\param[in] size Number of bits in field.
+		\return Number of bits written, which is less than size only on
+		error or eof.
+	*/
+	std::streamsize sputwide(const unsigned char *bytes, std::streamsize size)
+	{
+		static const std::streamsize window_bits = sizeof(bitfield) * CHAR_BIT;
+
+		std::streamsize bits_written = 0;
+
+		if (size >= 0 && size <= epptr() - pptr())
+		{
+			put_wide(m_order, current_put_byte(), pptr() % CHAR_BIT,
+				static_cast<size_t>(size), bytes_remaining(pptr(), epptr()),
+				bytes);
+			pbump(size);
+			bits_written = size;
+		}
+		else
+		{
+			for (; bits_written < size; bits_written += window_bits)
+			{
+				const std::streamsize bits = std::min(
+					std::streamsize(window_bits), size - bits_written);
+				if (xsputn(load_wide(bytes + bits_written / CHAR_BIT,
+					static_cast<size_t>(bits)), bits) != bits)
+				{
+					break;
+				}
+			}
+			bits_written = std::min(bits_written, size);
+		}
+		BOOST_BITSTREAM_COUNT(m_stats.count_write(pptr() - bits_written, bits_written));
+
+		return bits_written;
+	}
+
+protected:
+	// Input functions ////////////////////////////////////////////////////////
+
+	/**
+        Returns first bit position in accessible input sequence.
+
+        \return Position of first bit.
+    */
+    bitpos eback() const
+    {
+        return m_eback;
+    }
+
+	/**
+		Returns bit position within accessible input sequence of next bit to be
+		read.
+
+		\note The "get pointer."
+
+		\return Next bit position.
+	*/
+	bitpos gptr() const
+	{
+		return m_gptr;
+	}
+
+	/**
+		Returns bit position just past last bit in accessible input sequence.
+
+		\return Position after last bit.
+	*/
+	bitpos egptr() const
+	{
+		return m_egptr;
+	}
+
+	/**
+		Advances the get pointer by specified number of bit positions.
+
+		\note Like streambuf::gbump(), this does not check bounds; callers
+		have already verified that the new position is within the accessible
+		input sequence. Repositioning with bounds checking is done by
+		seekoff() and seekpos(), which are reserved for actual seeks.
+
+		\param[in] offset Value by which to increase the get pointer.
+	*/
+	void gbump(std::streamoff offset)
+	{
+		m_gptr += offset;
+	}
+
+	/**
+        Set pointer and offsets that define boundaries of and position within
+        accessible input sequence.
+
+        \param[in] buffer Pointer to char array to be accessed.
+        \param[in] gbeg Position of first accessible bit in char array.
+        \param[in] gnext Position of next bit to read.
+        \param[in] gend Position of bit immediately after last accessible bit
+        in char array.
+    */
+    void setg(unsigned char *buffer, bitpos gbeg, bitpos gnext,
+        bitpos gend)
+    {
+        set_buffer(buffer);
         m_eback = gbeg;
         m_gptr = gnext;
         m_egptr = gend;
@@ -404,9 +1297,9 @@ protected:
 
 		\return Position of first bit.
 	*/
-	std::streampos pbase() const
+	bitpos pbase() const
 	{
-		return 0;
+		return m_pbase;
 	}
 
 	/**
@@ -417,7 +1310,7 @@ protected:
 
 		\return Next bit position.
 	*/
-	std::streampos pptr() const
+	bitpos pptr() const
 	{
 		return m_pptr;
 	}
@@ -427,7 +1320,7 @@ protected:
 
 		\return Position after last bit.
 	*/
-	std::streampos epptr() const
+	bitpos epptr() const
 	{
 		return m_epptr;
 	}
@@ -435,11 +1328,13 @@ protected:
 	/**
 		Advances the put pointer by specified number of bit positions.
 
-		\param[in] offset Value by which to decrease the get pointer.
+		\note See note for gbump().
+
+		\param[in] offset Value by which to increase the put pointer.
 	*/
 	void pbump(std::streamoff offset)
 	{
-		seekoff(offset, std::ios_base::cur, std::ios_base::out);
+		m_pptr += offset;
 	}
 
 	/**
@@ -451,11 +1346,9 @@ protected:
 		\param[in] gend Position of bit immediately after last accessible bit
 		in char array.
 	*/
-	void setp(unsigned char *buffer, std::streampos pbeg, std::streampos pend)
+	void setp(unsigned char *buffer, bitpos pbeg, bitpos pend)
 	{
-		// TBD I can't let both setg and setp set m_buffer. How to resolve?
-
-		m_buffer = buffer;
+		set_buffer(buffer);
 		m_pbase = m_pptr = pbeg;
 		m_epptr = pend;
 	}
@@ -477,9 +1370,28 @@ protected:
 		return this;
 	}
 
+	/**
+		Determine whether slices may be made of the get area.
+
+		\note A slice views the char array in place, so it is only valid
+		while the bits stay where they are. Buffers that move or reuse their
+		bytes, such as a window that is refilled, or whose get area is only
+		part of the input sequence, such as one segment of a chain, override
+		this to refuse.
+
+		\return Whether slice() and sgetslice() may succeed.
+	*/
+	virtual bool sliceable() const
+	{
+		return true;
+	}
+
 	/**
 		Set get pointer relative to current position.
 
+		\note Positions are relative to eback(), or pbase() for output, so
+		those of a slice() start at 0.
+
 		\param[in] offset Amount by which get pointer is adjusted.
 		\param[in] way From which pointer offset is applied for new position.
 		\param[in] which Open mode.
@@ -489,7 +1401,7 @@ protected:
 		std::ios_base::seekdir way,
 		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
 	{
-		std::streampos new_position = std::streampos(-1);
+		bitpos new_position = bitpos(-1);
 
 		// TBD What does it mean to seekoff for both which's? Invalid for cur?
 
@@ -512,239 +1424,1128 @@ protected:
 			default:
 				break;
 			}
+
+			if (new_position != bitpos(-1))
+			{
+				new_position -= eback();
+			}
 		}
 
 		if ((which & std::ios_base::out) != 0)
 		{
-			switch (way)
-			{
-			case std::ios_base::beg:
-				new_position = assure_valid_put_pointer(pbase() + offset);
-				break;
+			switch (way)
+			{
+			case std::ios_base::beg:
+				new_position = assure_valid_put_pointer(pbase() + offset);
+				break;
+
+			case std::ios_base::cur:
+				new_position = assure_valid_put_pointer(pptr() + offset);
+				break;
+
+			case std::ios_base::end:
+				new_position = assure_valid_put_pointer(epptr() + offset);
+				break;
+
+			default:
+				break;
+			}
+
+			if (new_position != bitpos(-1))
+			{
+				new_position -= pbase();
+			}
+		}
+
+		// TBD What position do I return if both which's selected?
+
+		return std::streampos(new_position);
+	}
+
+    /**
+        Set get pointer to absolute position.
+
+        \param[in] position New absolute position for get pointer.
+		\param[in] which Open mode.
+		\return New position after get pointer modified or std::streampos(-1)
+		if error.
+    */
+    virtual std::streampos seekpos(std::streampos position,
+		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+    {
+		const bitpos requested_position = std::streamoff(position);
+		bitpos new_position = bitpos(-1);
+
+		// TBD What does it mean to seekpos for both which's?
+
+		if ((which & std::ios_base::in) != 0)
+		{
+			new_position = assure_valid_get_pointer(eback() + requested_position);
+			if (new_position != bitpos(-1))
+			{
+				new_position -= eback();
+			}
+		}
+
+		if ((which & std::ios_base::out) != 0)
+		{
+			new_position = assure_valid_put_pointer(pbase() + requested_position);
+			if (new_position != bitpos(-1))
+			{
+				new_position -= pbase();
+			}
+		}
+
+		// TBD What position do I return if both which's selected?
+
+		return std::streampos(new_position);
+	}
+
+	/**
+		Synchronize stream buffer with input or output device.
+
+		\note Bits in memory are already where they belong, so there is
+		nothing to synchronize and this succeeds, like streambuf::sync().
+		Subclasses with a device override this.
+
+		\return 0 if successful; -1 otherwise.
+	*/
+	virtual int sync()
+	{
+		return 0;
+	}
+
+	// Virtual input functions ////////////////////////////////////////////////
+
+	/**
+		Get number of bits available beyond the get area.
+
+		\note This is only called by in_avail() when the get area is empty.
+		The whole buffer is the get area, so there is nothing more, like
+		stringbuf::showmanyc(). Subclasses with a source override this.
+
+		\return Number of bits that can be read; -1 if none.
+	*/
+	virtual std::streamsize showmanyb()
+	{
+		return -1;
+	}
+
+	/**
+		Get sequence of bits.
+
+		\param[out] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits read from buffer or zero if error or eof.
+	*/
+	virtual std::streamsize xsgetn(bitfield &value, std::streamsize size)
+	{
+		std::streamsize bits_read = xsgetn_nobump(value, size);
+
+		// Advance bit pointer past field in preparation for next access.
+		gbump(bits_read);
+
+		return bits_read;
+	}
+
+	/**
+		Get sequence of bits without advancing get pointer.
+
+		\note This is only called when the bits are not all in the get area.
+		Derived classes that can make more bits available, without seeking,
+		override it.
+
+		\param[out] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits peeked at or zero if error or eof.
+	*/
+	virtual std::streamsize xspeekn(bitfield &value, std::streamsize size)
+	{
+		return xsgetn_nobump(value, size);
+	}
+
+	/**
+		Get bit without changing current position.
+
+		\param[out] value Bit at the current position.
+		\return Whether there are more bits to read.
+	*/
+	virtual bool underflow(bitfield &value)
+	{
+		return xsgetn_nobump(value, 1) == 1;
+	}
+
+	/**
+		Get bit and advance position.
+
+		\param[out] value Bit at the current position.
+		\return Whether there are more bits to read.
+	*/
+	virtual bool uflow(bitfield &value)
+	{
+		const bool got_bit = underflow(value);
+		if (got_bit)
+		{
+			gbump(1);
+		}
+
+		return got_bit;
+	}
+
+	/**
+		Put a bit back into input sequence and decrease the position.
+
+		\param[out] value Bit to be put back.
+		\return Whether there are more bits to read.
+	*/
+	bool pbackfail(const bitfield &value)
+	{
+		// Default behavior.
+		return false;
+	}
+
+	// Virtual output functions ///////////////////////////////////////////////
+
+	/**
+		Put sequence of bits.
+
+		\param[out] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits written to buffer or zero if error or eof.
+	*/
+	virtual std::streamsize xsputn(bitfield value, std::streamsize size)
+	{
+		std::streamsize bits_read = xsputn_nobump(value, size);
+
+		// Advance bit pointer past field in preparation for next access.
+		pbump(bits_read);
+
+		return bits_read;
+	}
+
+	/**
+		Put bit without changing current position.
+
+		\param[in] value Bit to be put.
+		\return Whether the bit was successully put.
+	*/
+	virtual bool overflow(bitfield b)
+	{
+		// (Default behavior.)
+		return false;
+	}
+
+private:
+	/**
+		Cursors (see cursor.hpp), record codecs (see codec.hpp), unchecked
+		extraction (see unchecked.hpp) and packet templates (see patch.hpp)
+		use the kernels directly, and checksumming buffers (see
+		checksum.hpp) share another's areas.
+	*/
+	///@{
+	friend class bit_reader;
+	friend class bit_writer;
+	friend class codec_access;
+	friend class unchecked;
+	friend class packet_template;
+	template <typename Checksum> friend class basic_checksumbitbuf;
+	///@}
+
+	/**
+		Set pointer to char array shared by get and put areas.
+
+		\note setg() and setp() both set it, so it is only written when it
+		changes. Then, once the areas are on one char array, a reader and a
+		writer in different threads may each reset their own area without
+		touching the same memory (see ringbuf.hpp).
+
+		\param[in] buffer Pointer to char array to be accessed.
+	*/
+	void set_buffer(unsigned char *buffer)
+	{
+		if (m_buffer != buffer)
+		{
+			m_buffer = buffer;
+		}
+	}
+
+	// Bit-field kernels /////////////////////////////////////////////////////
+
+	/**
+		Get number of bytes in buffer from byte containing position to end of
+		accessible sequence.
+
+		\param[in] ptr Bit position within accessible sequence.
+		\param[in] eptr Position of bit after last bit in sequence.
+		\return Number of bytes that may be read starting at byte containing
+		ptr.
+	*/
+	static size_t bytes_remaining(bitpos ptr, bitpos eptr)
+	{
+		return (static_cast<size_t>(eptr) + CHAR_BIT - 1) / CHAR_BIT -
+			static_cast<size_t>(ptr) / CHAR_BIT;
+	}
+
+	/**
+		Get mask of low-order bits.
+
+		\param[in] size Number of bits in mask, 1 through 64.
+		\return Right-justified mask, e.g., 0000000000111111.
+	*/
+	static boost::uint64_t low_bits_mask(size_t size)
+	{
+		return ~boost::uint64_t(0) >> (sizeof(boost::uint64_t) * CHAR_BIT - size);
+	}
+
+	/**
+		Load next 64 bits, MSB first, starting at byte.
+
+		\note If fewer than eight bytes remain in the buffer, the missing
+		low-order bytes are zero; the buffer is never read past its end.
+
+		\param[in] byte_pointer Pointer to first byte to load.
+		\param[in] byte_count Number of bytes that may be read at byte_pointer.
+		\return Bits in big-endian order, i.e., first bit in MSB.
+	*/
+	static boost::uint64_t load_window(const unsigned char *byte_pointer,
+		size_t byte_count)
+	{
+		boost::uint64_t window;
+
+		if (byte_count >= sizeof window)
+		{
+			// (memcpy() is how to ask for an unaligned load without UB;
+			// compilers emit a single mov/ldr for it.)
+			std::memcpy(&window, byte_pointer, sizeof window);
+			window = boost::endian::big_to_native(window);
+		}
+		else
+		{
+			window = 0;
+			for (size_t i = 0; i < byte_count; ++i)
+			{
+				window |= static_cast<boost::uint64_t>(byte_pointer[i]) <<
+					((sizeof window - 1 - i) * CHAR_BIT);
+			}
+		}
+
+		return window;
+	}
+
+	/**
+		Store 64 bits, MSB first, starting at byte.
+
+		\note If fewer than eight bytes remain in the buffer, only that many
+		high-order bytes of the window are stored.
+
+		\param[in] byte_pointer Pointer to first byte to store.
+		\param[in] window Bits in big-endian order, i.e., first bit in MSB.
+		\param[in] byte_count Number of bytes that may be written at
+		byte_pointer.
+	*/
+	static void store_window(unsigned char *byte_pointer,
+		boost::uint64_t window, size_t byte_count)
+	{
+		if (byte_count >= sizeof window)
+		{
+			window = boost::endian::native_to_big(window);
+			std::memcpy(byte_pointer, &window, sizeof window);
+		}
+		else
+		{
+			for (size_t i = 0; i < byte_count; ++i)
+			{
+				byte_pointer[i] = static_cast<unsigned char>(window >>
+					((sizeof window - 1 - i) * CHAR_BIT));
+			}
+		}
+	}
+
+	/**
+		Get sequence of bits.
+
+		\note The bits are extracted from a 64-bit big-endian window loaded
+		with a single unaligned read at the byte containing the first bit, so a
+		field of any width costs a load, a shift and a mask. A 64-bit field
+		that does not start on a byte boundary spans nine bytes, so the ninth
+		byte's leading bits are merged into the window separately.
+
+		\pre 0 < size <= number of bits in bitfield.
+		\pre All size bits are within the accessible sequence.
+
+		\param[in] byte_pointer Pointer to byte containing current bit position.
+		\param[in] intra_byte_bit_offset Bit position within *byte_pointer,
+		where 0 is the MSB.
+		\param[in] size Number of bits in sequence of bits.
+		\param[in] byte_count Number of bytes that may be read at byte_pointer.
+		\return Value of bit field, right-justified.
+	*/
+	static bitfield get_bits(const unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t size, size_t byte_count)
+	{
+		static const size_t window_bits = sizeof(boost::uint64_t) * CHAR_BIT;
+
+		boost::uint64_t window = load_window(byte_pointer, byte_count);
+		window <<= intra_byte_bit_offset;
+		if (intra_byte_bit_offset + size > window_bits)
+		{
+			window |= byte_pointer[sizeof window] >>
+				(CHAR_BIT - intra_byte_bit_offset);
+		}
+
+		return static_cast<bitfield>(window >> (window_bits - size));
+	}
+
+	/**
+		Get sequence of bits whose size is known at compile time.
+
+		\note Byte-aligned fields of 8, 16, 32 and 64 bits are loaded as a
+		single big-endian integral; everything else uses the window.
+
+		\param[in] byte_pointer Pointer to byte containing current bit position.
+		\param[in] intra_byte_bit_offset Bit position within *byte_pointer.
+		\param[in] byte_count Number of bytes that may be read at byte_pointer.
+		\return Value of bit field, right-justified.
+	*/
+	template <size_t N>
+	static bitfield get_bits(const unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t byte_count)
+	{
+		return get_bits<N>(byte_pointer, intra_byte_bit_offset, byte_count,
+			is_word_size<N>());
+	}
+
+	template <size_t N>
+	static bitfield get_bits(const unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t byte_count, boost::true_type)
+	{
+		bitfield value;
+
+		if (intra_byte_bit_offset == 0)
+		{
+			typename boost::uint_t<N>::exact word;
+			std::memcpy(&word, byte_pointer, sizeof word);
+			value = boost::endian::big_to_native(word);
+		}
+		else
+		{
+			value = get_bits(byte_pointer, intra_byte_bit_offset, N, byte_count);
+		}
+
+		return value;
+	}
+
+	template <size_t N>
+	static bitfield get_bits(const unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t byte_count, boost::false_type)
+	{
+		return get_bits(byte_pointer, intra_byte_bit_offset, N, byte_count);
+	}
+
+	/**
+		Put sequence of bits.
+
+		\note This is the counterpart of get_bits(): the bytes spanned by the
+		field are loaded as one 64-bit big-endian window, the field is merged
+		in under a mask, and the window is stored back. Bits of value above
+		size are ignored.
+
+		\pre 0 < size <= number of bits in bitfield.
+		\pre All size bits are within the accessible sequence.
+
+		\param[in] byte_pointer Pointer to byte containing current bit position.
+		\param[in] intra_byte_bit_offset Bit position within *byte_pointer,
+		where 0 is the MSB.
+		\param[in] size Number of bits in sequence of bits.
+		\param[in] value Value of bit field, right-justified.
+		\param[in] byte_count Number of bytes that may be written at
+		byte_pointer.
+	*/
+	static void put_bits(unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t size, bitfield value,
+		size_t byte_count)
+	{
+		static const size_t window_bits = sizeof(boost::uint64_t) * CHAR_BIT;
+
+		const boost::uint64_t field = value & low_bits_mask(size);
+		boost::uint64_t window = load_window(byte_pointer, byte_count);
+
+		if (intra_byte_bit_offset + size > window_bits)
+		{
+			// The field spills into a ninth byte.
+			const size_t spill = intra_byte_bit_offset + size - window_bits;
+			const boost::uint64_t mask = low_bits_mask(window_bits - intra_byte_bit_offset);
+			window = (window & ~mask) | (field >> spill);
+
+			unsigned char &last_byte = byte_pointer[sizeof window];
+			last_byte = static_cast<unsigned char>((last_byte & (UCHAR_MAX >> spill)) |
+				(field << (CHAR_BIT - spill)));
+		}
+		else
+		{
+			const size_t shift_amount = window_bits - intra_byte_bit_offset - size;
+			const boost::uint64_t mask = low_bits_mask(size) << shift_amount;
+			window = (window & ~mask) | (field << shift_amount);
+		}
+
+		store_window(byte_pointer, window, byte_count);
+	}
+
+	/**
+		Put sequence of bits whose size is known at compile time.
+
+		\note See note for get_bits<N>().
+
+		\param[in] byte_pointer Pointer to byte containing current bit position.
+		\param[in] intra_byte_bit_offset Bit position within *byte_pointer.
+		\param[in] value Value of bit field, right-justified.
+		\param[in] byte_count Number of bytes that may be written at
+		byte_pointer.
+	*/
+	template <size_t N>
+	static void put_bits(unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, bitfield value, size_t byte_count)
+	{
+		put_bits<N>(byte_pointer, intra_byte_bit_offset, value, byte_count,
+			is_word_size<N>());
+	}
+
+	template <size_t N>
+	static void put_bits(unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, bitfield value, size_t byte_count,
+		boost::true_type)
+	{
+		if (intra_byte_bit_offset == 0)
+		{
+			typename boost::uint_t<N>::exact word =
+				static_cast<typename boost::uint_t<N>::exact>(value);
+			word = boost::endian::native_to_big(word);
+			std::memcpy(byte_pointer, &word, sizeof word);
+		}
+		else
+		{
+			put_bits(byte_pointer, intra_byte_bit_offset, N, value, byte_count);
+		}
+	}
+
+	template <size_t N>
+	static void put_bits(unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, bitfield value, size_t byte_count,
+		boost::false_type)
+	{
+		put_bits(byte_pointer, intra_byte_bit_offset, N, value, byte_count);
+	}
+
+	/**
+		Load next 64 bits, LSB first, starting at byte.
+
+		\note This is the lsb_first counterpart of load_window().
+
+		\param[in] byte_pointer Pointer to first byte to load.
+		\param[in] byte_count Number of bytes that may be read at byte_pointer.
+		\return Bits in little-endian order, i.e., first bit in LSB.
+	*/
+	static boost::uint64_t load_lsb_window(const unsigned char *byte_pointer,
+		size_t byte_count)
+	{
+		boost::uint64_t window;
+
+		if (byte_count >= sizeof window)
+		{
+			std::memcpy(&window, byte_pointer, sizeof window);
+			window = boost::endian::little_to_native(window);
+		}
+		else
+		{
+			window = 0;
+			for (size_t i = 0; i < byte_count; ++i)
+			{
+				window |= static_cast<boost::uint64_t>(byte_pointer[i]) <<
+					(i * CHAR_BIT);
+			}
+		}
+
+		return window;
+	}
+
+	/**
+		Store 64 bits, LSB first, starting at byte.
+
+		\note This is the lsb_first counterpart of store_window().
+
+		\param[in] byte_pointer Pointer to first byte to store.
+		\param[in] window Bits in little-endian order, i.e., first bit in LSB.
+		\param[in] byte_count Number of bytes that may be written at
+		byte_pointer.
+	*/
+	static void store_lsb_window(unsigned char *byte_pointer,
+		boost::uint64_t window, size_t byte_count)
+	{
+		if (byte_count >= sizeof window)
+		{
+			window = boost::endian::native_to_little(window);
+			std::memcpy(byte_pointer, &window, sizeof window);
+		}
+		else
+		{
+			for (size_t i = 0; i < byte_count; ++i)
+			{
+				byte_pointer[i] = static_cast<unsigned char>(window >>
+					(i * CHAR_BIT));
+			}
+		}
+	}
+
+	/**
+		Get sequence of bits, LSB first.
+
+		\note This is the lsb_first counterpart of get_bits(): the window is
+		loaded little endian, so the field is a shift right and a mask, with
+		no byte swap on little-endian machines.
+
+		\pre 0 < size <= number of bits in bitfield.
+		\pre All size bits are within the accessible sequence.
+
+		\param[in] byte_pointer Pointer to byte containing current bit position.
+		\param[in] intra_byte_bit_offset Bit position within *byte_pointer,
+		where 0 is the LSB.
+		\param[in] size Number of bits in sequence of bits.
+		\param[in] byte_count Number of bytes that may be read at byte_pointer.
+		\return Value of bit field, whose LSB is its first bit.
+	*/
+	static bitfield get_lsb_bits(const unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t size, size_t byte_count)
+	{
+		static const size_t window_bits = sizeof(boost::uint64_t) * CHAR_BIT;
+
+		boost::uint64_t window = load_lsb_window(byte_pointer, byte_count) >>
+			intra_byte_bit_offset;
+		if (intra_byte_bit_offset + size > window_bits)
+		{
+			window |= static_cast<boost::uint64_t>(byte_pointer[sizeof window]) <<
+				(window_bits - intra_byte_bit_offset);
+		}
+
+		return static_cast<bitfield>(window & low_bits_mask(size));
+	}
+
+	/**
+		Get sequence of bits, LSB first, whose size is known at compile time.
+
+		\note Byte-aligned fields of 8, 16, 32 and 64 bits are loaded as a
+		single little-endian integral; everything else uses the window.
+
+		\param[in] byte_pointer Pointer to byte containing current bit position.
+		\param[in] intra_byte_bit_offset Bit position within *byte_pointer.
+		\param[in] byte_count Number of bytes that may be read at byte_pointer.
+		\return Value of bit field.
+	*/
+	template <size_t N>
+	static bitfield get_lsb_bits(const unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t byte_count)
+	{
+		return get_lsb_bits<N>(byte_pointer, intra_byte_bit_offset, byte_count,
+			is_word_size<N>());
+	}
+
+	template <size_t N>
+	static bitfield get_lsb_bits(const unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t byte_count, boost::true_type)
+	{
+		bitfield value;
+
+		if (intra_byte_bit_offset == 0)
+		{
+			typename boost::uint_t<N>::exact word;
+			std::memcpy(&word, byte_pointer, sizeof word);
+			value = boost::endian::little_to_native(word);
+		}
+		else
+		{
+			value = get_lsb_bits(byte_pointer, intra_byte_bit_offset, N,
+				byte_count);
+		}
+
+		return value;
+	}
+
+	template <size_t N>
+	static bitfield get_lsb_bits(const unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t byte_count, boost::false_type)
+	{
+		return get_lsb_bits(byte_pointer, intra_byte_bit_offset, N, byte_count);
+	}
+
+	/**
+		Put sequence of bits, LSB first.
+
+		\note This is the lsb_first counterpart of put_bits().
+
+		\pre 0 < size <= number of bits in bitfield.
+		\pre All size bits are within the accessible sequence.
+
+		\param[in] byte_pointer Pointer to byte containing current bit position.
+		\param[in] intra_byte_bit_offset Bit position within *byte_pointer,
+		where 0 is the LSB.
+		\param[in] size Number of bits in sequence of bits.
+		\param[in] value Value of bit field, whose LSB is its first bit.
+		\param[in] byte_count Number of bytes that may be written at
+		byte_pointer.
+	*/
+	static void put_lsb_bits(unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t size, bitfield value,
+		size_t byte_count)
+	{
+		static const size_t window_bits = sizeof(boost::uint64_t) * CHAR_BIT;
+
+		const boost::uint64_t field = value & low_bits_mask(size);
+		boost::uint64_t window = load_lsb_window(byte_pointer, byte_count);
+
+		if (intra_byte_bit_offset + size > window_bits)
+		{
+			// The field spills into a ninth byte.
+			const size_t spill = intra_byte_bit_offset + size - window_bits;
+			window = (window & low_bits_mask(intra_byte_bit_offset)) |
+				(field << intra_byte_bit_offset);
+
+			unsigned char &last_byte = byte_pointer[sizeof window];
+			last_byte = static_cast<unsigned char>((last_byte & (UCHAR_MAX << spill)) |
+				(field >> (window_bits - intra_byte_bit_offset)));
+		}
+		else
+		{
+			const boost::uint64_t mask = low_bits_mask(size) << intra_byte_bit_offset;
+			window = (window & ~mask) | (field << intra_byte_bit_offset);
+		}
+
+		store_lsb_window(byte_pointer, window, byte_count);
+	}
+
+	/**
+		Put sequence of bits, LSB first, whose size is known at compile time.
+
+		\note See note for get_lsb_bits<N>().
+
+		\param[in] byte_pointer Pointer to byte containing current bit position.
+		\param[in] intra_byte_bit_offset Bit position within *byte_pointer.
+		\param[in] value Value of bit field.
+		\param[in] byte_count Number of bytes that may be written at
+		byte_pointer.
+	*/
+	template <size_t N>
+	static void put_lsb_bits(unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, bitfield value, size_t byte_count)
+	{
+		put_lsb_bits<N>(byte_pointer, intra_byte_bit_offset, value, byte_count,
+			is_word_size<N>());
+	}
+
+	template <size_t N>
+	static void put_lsb_bits(unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, bitfield value, size_t byte_count,
+		boost::true_type)
+	{
+		if (intra_byte_bit_offset == 0)
+		{
+			typename boost::uint_t<N>::exact word =
+				static_cast<typename boost::uint_t<N>::exact>(value);
+			word = boost::endian::native_to_little(word);
+			std::memcpy(byte_pointer, &word, sizeof word);
+		}
+		else
+		{
+			put_lsb_bits(byte_pointer, intra_byte_bit_offset, N, value,
+				byte_count);
+		}
+	}
 
-			case std::ios_base::cur:
-				new_position = assure_valid_put_pointer(pptr() + offset);
-				break;
+	template <size_t N>
+	static void put_lsb_bits(unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, bitfield value, size_t byte_count,
+		boost::false_type)
+	{
+		put_lsb_bits(byte_pointer, intra_byte_bit_offset, N, value, byte_count);
+	}
 
-			case std::ios_base::end:
-				new_position = assure_valid_put_pointer(epptr() + offset);
-				break;
+	/**
+		Copy a field of any number of bits out of a buffer.
+
+		\note Each 64 bits of the field are one get_bits() or get_lsb_bits(),
+		i.e., two loads merged with a funnel shift, and one store. When the
+		field is byte aligned, the whole bytes are a memcpy().
+
+		\param[in] order Order of bits in buffer and bytes.
+		\param[in] byte_pointer Pointer to byte containing first bit.
+		\param[in] intra_byte_bit_offset Bit position within *byte_pointer.
+		\param[in] size Number of bits in field.
+		\param[in] byte_count Number of bytes that may be read at byte_pointer.
+		\param[out] bytes (size + CHAR_BIT - 1) / CHAR_BIT bytes of field.
+	*/
+	static void get_wide(bit_order order, const unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t size, size_t byte_count,
+		unsigned char *bytes)
+	{
+		static const size_t window_bits = sizeof(boost::uint64_t) * CHAR_BIT;
 
-			default:
-				break;
-			}
+		size_t done = 0;
+		if (intra_byte_bit_offset == 0)
+		{
+			std::memcpy(bytes, byte_pointer, size / CHAR_BIT);
+			done = size / CHAR_BIT * CHAR_BIT;
 		}
 
-		// TBD What position do I return if both which's selected?
-
-		return new_position;
+		for (; done < size; done += window_bits)
+		{
+			const size_t i = done / CHAR_BIT;
+			const size_t bits = std::min(size_t(window_bits), size - done);
+			const bitfield value = order == msb_first ?
+				get_bits(byte_pointer + i, intra_byte_bit_offset, bits, byte_count - i) :
+				get_lsb_bits(byte_pointer + i, intra_byte_bit_offset, bits, byte_count - i);
+			store_wide(order, bytes + i, value, bits);
+		}
 	}
 
-    /**
-        Set get pointer to absolute position.
+	/**
+		Copy a field of any number of bits into a buffer.
 
-        \param[in] position New absolute position for get pointer.
-		\param[in] which Open mode.
-		\return New position after get pointer modified or std::streampos(-1)
-		if error.
-    */
-    virtual std::streampos seekpos(std::streampos position,
-		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
-    {
-		std::streampos new_position = std::streampos(-1);
+		\note See get_wide().
 
-		// TBD What does it mean to seekpos for both which's?
+		\param[in] order Order of bits in buffer and bytes.
+		\param[in] byte_pointer Pointer to byte containing first bit.
+		\param[in] intra_byte_bit_offset Bit position within *byte_pointer.
+		\param[in] size Number of bits in field.
+		\param[in] byte_count Number of bytes that may be written at
+		byte_pointer.
+		\param[in] bytes (size + CHAR_BIT - 1) / CHAR_BIT bytes of field.
+	*/
+	static void put_wide(bit_order order, unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t size, size_t byte_count,
+		const unsigned char *bytes)
+	{
+		static const size_t window_bits = sizeof(boost::uint64_t) * CHAR_BIT;
 
-		if ((which & std::ios_base::in) != 0)
+		size_t done = 0;
+		if (intra_byte_bit_offset == 0)
 		{
-			new_position = assure_valid_get_pointer(position);
+			std::memcpy(byte_pointer, bytes, size / CHAR_BIT);
+			done = size / CHAR_BIT * CHAR_BIT;
 		}
 
-		if ((which & std::ios_base::out) != 0)
+		for (; done < size; done += window_bits)
 		{
-			new_position = assure_valid_put_pointer(position);
+			const size_t i = done / CHAR_BIT;
+			const size_t bits = std::min(size_t(window_bits), size - done);
+			const bitfield value = load_wide(order, bytes + i, bits);
+			if (order == msb_first)
+			{
+				put_bits(byte_pointer + i, intra_byte_bit_offset, bits, value,
+					byte_count - i);
+			}
+			else
+			{
+				put_lsb_bits(byte_pointer + i, intra_byte_bit_offset, bits, value,
+					byte_count - i);
+			}
 		}
-
-		// TBD What position do I return if both which's selected?
-
-		return new_position;
 	}
 
 	/**
-		Synchronize stream buffer with input or output device.
-
-		\note Since we do not currently have an I/O device with which to
-		synchronize (we are unbuffered) this function always returns in error
-		with -1.
+		Store up to 64 bits of a wide field.
 
-		\return 0 if buffered stream and successful; -1 otherwise.
+		\param[in] order Order of bits in bytes.
+		\param[out] bytes Where to store bits.
+		\param[in] value Bits, right-justified.
+		\param[in] bits Number of bits, 1 through 64.
 	*/
-	virtual int sync()
+	static void store_wide(bit_order order, unsigned char *bytes,
+		bitfield value, size_t bits)
 	{
-		return -1;
+		const size_t count = (bits + CHAR_BIT - 1) / CHAR_BIT;
+		if (order == msb_first)
+		{
+			store_window(bytes, value << (sizeof value * CHAR_BIT - bits), count);
+		}
+		else
+		{
+			store_lsb_window(bytes, value, count);
+		}
 	}
 
-	// Virtual input functions ////////////////////////////////////////////////
+	void store_wide(unsigned char *bytes, bitfield value, size_t bits) const
+	{
+		store_wide(m_order, bytes, value, bits);
+	}
 
 	/**
-		Get number of bits available.
+		Load up to 64 bits of a wide field.
 
-		\return (No information).
+		\param[in] order Order of bits in bytes.
+		\param[in] bytes Where to load bits from.
+		\param[in] bits Number of bits, 1 through 64.
+		\return Bits, right-justified.
 	*/
-	virtual std::streamsize showmanyb()
+	static bitfield load_wide(bit_order order, const unsigned char *bytes,
+		size_t bits)
 	{
-		// (Default behavior.)
-		return 0;
+		const size_t count = (bits + CHAR_BIT - 1) / CHAR_BIT;
+
+		return order == msb_first ?
+			load_window(bytes, count) >> (sizeof(bitfield) * CHAR_BIT - bits) :
+			load_lsb_window(bytes, count) & low_bits_mask(bits);
 	}
 
-	/**
-		Get sequence of bits.
+	bitfield load_wide(const unsigned char *bytes, size_t bits) const
+	{
+		return load_wide(m_order, bytes, bits);
+	}
 
-		\param[out] value Value of bit field.
-		\param[in] size Number of bits in sequence of bits.
-		\return Number of bits read from buffer or zero if error or eof.
+	/**
+		Copy bits from one char array to another, or within one.
+
+		\note See copy_bits(const bitbuf &, std::streampos, bitbuf &,
+		std::streampos, std::streamsize). Bits of the destination bytes
+		outside the copy are kept.
+
+		\param[in] order Order of bits in both arrays.
+		\param[in] src Char array to copy from.
+		\param[in] src_pos Position of first bit relative to src.
+		\param[out] dst Char array to copy to.
+		\param[in] dst_pos Position of first bit relative to dst.
+		\param[in] size Number of bits to copy.
 	*/
-	virtual std::streamsize xsgetn(bitfield &value, std::streamsize size)
+	static void blit_bits(bit_order order, const unsigned char *src,
+		bitpos src_pos, unsigned char *dst, bitpos dst_pos, size_t size)
 	{
-		std::streamsize bits_read = xsgetn_nobump(value, size);
+		static const size_t window_bits = sizeof(boost::uint64_t) * CHAR_BIT;
 
-		// Advance bit pointer past field in preparation for next access.
-		gbump(bits_read);
+		if (size == 0)
+		{
+			return;
+		}
 
-		return bits_read;
+		const unsigned char * const s = src + src_pos / CHAR_BIT;
+		const size_t s_offset = static_cast<size_t>(src_pos % CHAR_BIT);
+		const size_t s_count = bytes_remaining(src_pos, src_pos + bitpos(size));
+		unsigned char * const d = dst + dst_pos / CHAR_BIT;
+		const size_t d_offset = static_cast<size_t>(dst_pos % CHAR_BIT);
+		const size_t d_count = bytes_remaining(dst_pos, dst_pos + bitpos(size));
+
+		if (s_offset == d_offset)
+		{
+			// Partial bytes at either end, memmove() between. The ends are
+			// read first in case the ranges overlap.
+			const size_t head = std::min(size,
+				(CHAR_BIT - d_offset) % CHAR_BIT);
+			const size_t i = head > 0 ? 1 : 0;
+			const size_t middle = (size - head) / CHAR_BIT;
+			const size_t tail = size - head - middle * CHAR_BIT;
+			const bitfield head_bits = head > 0 ? get_window_bits(order,
+				s, s_offset, head, s_count) : 0;
+			const bitfield tail_bits = tail > 0 ? get_window_bits(order,
+				s + i + middle, 0, tail, s_count - i - middle) : 0;
+
+			std::memmove(d + i, s + i, middle);
+			if (head > 0)
+			{
+				put_window_bits(order, d, d_offset, head, head_bits, d_count);
+			}
+			if (tail > 0)
+			{
+				put_window_bits(order, d + i + middle, 0, tail, tail_bits,
+					d_count - i - middle);
+			}
+		}
+		else if ((std::less<const unsigned char *>()(s, d) ||
+			(s == d && s_offset < d_offset)) &&
+			std::less<const unsigned char *>()(d, s + s_count))
+		{
+			// The destination overlaps the source further on, so copy from
+			// the end; each 64 bits are read before they can be written.
+			for (size_t done = (size - 1) / window_bits * window_bits + window_bits;
+				done > 0; done -= window_bits)
+			{
+				const size_t first = done - window_bits;
+				const size_t bits = std::min(size_t(window_bits), size - first);
+				const bitpos from = src_pos + bitpos(first);
+				const bitpos to = dst_pos + bitpos(first);
+				const size_t i = static_cast<size_t>(from / CHAR_BIT - src_pos / CHAR_BIT);
+				const size_t j = static_cast<size_t>(to / CHAR_BIT - dst_pos / CHAR_BIT);
+				put_window_bits(order, d + j, static_cast<size_t>(to % CHAR_BIT),
+					bits, get_window_bits(order, s + i,
+					static_cast<size_t>(from % CHAR_BIT), bits, s_count - i),
+					d_count - j);
+			}
+		}
+		else
+		{
+			// Bring the destination to a byte boundary; then each 64 bits
+			// are one funnel-shifted get and a plain store.
+			size_t done = std::min(size, (CHAR_BIT - d_offset) % CHAR_BIT);
+			if (done > 0)
+			{
+				put_window_bits(order, d, d_offset, done,
+					get_window_bits(order, s, s_offset, done, s_count), d_count);
+			}
+
+			for (; done < size; done += window_bits)
+			{
+				const size_t bits = std::min(size_t(window_bits), size - done);
+				const bitpos from = src_pos + bitpos(done);
+				const size_t i = static_cast<size_t>(from / CHAR_BIT - src_pos / CHAR_BIT);
+				const size_t j = (d_offset + done) / CHAR_BIT;
+				const bitfield value = get_window_bits(order, s + i,
+					static_cast<size_t>(from % CHAR_BIT), bits, s_count - i);
+				if (bits == window_bits)
+				{
+					store_wide(order, d + j, value, bits);
+				}
+				else
+				{
+					put_window_bits(order, d + j, 0, bits, value, d_count - j);
+				}
+			}
+		}
 	}
 
 	/**
-		Get bit without changing current position.
+		Get sequence of bits in either order.
 
-		\param[out] value Bit at the current position.
-		\return Whether there are more bits to read.
+		\note See get_bits() and get_lsb_bits().
 	*/
-	bool underflow(bitfield &value)
+	static bitfield get_window_bits(bit_order order,
+		const unsigned char *byte_pointer, size_t intra_byte_bit_offset,
+		size_t size, size_t byte_count)
 	{
-		return xsgetn_nobump(value, 1) == 1;
+		return order == msb_first ?
+			get_bits(byte_pointer, intra_byte_bit_offset, size, byte_count) :
+			get_lsb_bits(byte_pointer, intra_byte_bit_offset, size, byte_count);
 	}
 
 	/**
-		Get bit and advance position.
+		Put sequence of bits in either order.
 
-		\param[out] value Bit at the current position.
-		\return Whether there are more bits to read.
+		\note See put_bits() and put_lsb_bits().
 	*/
-	bool uflow(bitfield &value)
+	static void put_window_bits(bit_order order, unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t size, bitfield value,
+		size_t byte_count)
 	{
-		const bool got_bit = underflow(value);
-		if (got_bit)
+		if (order == msb_first)
 		{
-			gbump(1);
+			put_bits(byte_pointer, intra_byte_bit_offset, size, value, byte_count);
+		}
+		else
+		{
+			put_lsb_bits(byte_pointer, intra_byte_bit_offset, size, value,
+				byte_count);
 		}
-
-		return got_bit;
 	}
 
 	/**
-		Put a bit back into input sequence and decrease the position.
+		Get shift of bit within its byte.
 
-		\param[out] value Bit to be put back.
-		\return Whether there are more bits to read.
+		\param[in] position Bit position.
+		\return Number of bits right of the bit in its byte.
 	*/
-	bool pbackfail(const bitfield &value)
+	size_t bit_shift(bitpos position) const
 	{
-		// Default behavior.
-		return false;
-	}
+		const size_t intra_byte_bit_offset = static_cast<size_t>(position % CHAR_BIT);
 
-	// Virtual output functions ///////////////////////////////////////////////
+		return m_order == msb_first ?
+			CHAR_BIT - 1 - intra_byte_bit_offset : intra_byte_bit_offset;
+	}
 
 	/**
-		Put sequence of bits.
+		Get sequence of bits in the order of this buffer.
 
-		\param[out] value Value of bit field.
-		\param[in] size Number of bits in sequence of bits.
-		\return Number of bits written to buffer or zero if error or eof.
+		\note See get_bits() and get_lsb_bits().
 	*/
-	virtual std::streamsize xsputn(bitfield value, std::streamsize size)
+	bitfield get_field(const unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t size, size_t byte_count) const
 	{
-		std::streamsize bits_read = xsputn_nobump(value, size);
-
-		// Advance bit pointer past field in preparation for next access.
-		pbump(bits_read);
+		return m_order == msb_first ?
+			get_bits(byte_pointer, intra_byte_bit_offset, size, byte_count) :
+			get_lsb_bits(byte_pointer, intra_byte_bit_offset, size, byte_count);
+	}
 
-		return bits_read;
+	template <size_t N>
+	bitfield get_field(const unsigned char *byte_pointer,
+		size_t intra_byte_bit_offset, size_t byte_count) const
+	{
+		return m_order == msb_first ?
+			get_bits<N>(byte_pointer, intra_byte_bit_offset, byte_count) :
+			get_lsb_bits<N>(byte_pointer, intra_byte_bit_offset, byte_count);
 	}
 
 	/**
-		Put bit without changing current position.
+		Put sequence of bits in the order of this buffer.
 
-		\param[in] value Bit to be put.
-		\return Whether the bit was successully put.
+		\note See put_bits() and put_lsb_bits().
 	*/
-	virtual bool overflow(bitfield b)
+	void put_field(unsigned char *byte_pointer, size_t intra_byte_bit_offset,
+		size_t size, bitfield value, size_t byte_count) const
 	{
-		// (Default behavior.)
-		return false;
+		if (m_order == msb_first)
+		{
+			put_bits(byte_pointer, intra_byte_bit_offset, size, value, byte_count);
+		}
+		else
+		{
+			put_lsb_bits(byte_pointer, intra_byte_bit_offset, size, value,
+				byte_count);
+		}
 	}
 
-private:
-	/**
-		Process sequence of bits.
+	template <size_t N>
+	void put_field(unsigned char *byte_pointer, size_t intra_byte_bit_offset,
+		bitfield value, size_t byte_count) const
+	{
+		if (m_order == msb_first)
+		{
+			put_bits<N>(byte_pointer, intra_byte_bit_offset, value, byte_count);
+		}
+		else
+		{
+			put_lsb_bits<N>(byte_pointer, intra_byte_bit_offset, value,
+				byte_count);
+		}
+	}
 
-		\note This is the typedef for a callback function called exclusively by
-		xsprocessn_nobump().
+	/**
+		Whether bit-field size is that of an exact-width integral.
 
-		\param[in] value Value of bit field.
-		\param[in] mask Mask to isolate bit field in stream, e.g., 0000000111111000.
-		\param[in] shift_amount Number of bit positions mask had to be shifted left, e.g., 4.
-		\param[in] byte_count Number of bytes to be processed for this bit field.
-		\param[in] byte_pointer Pointer to byte containing current bit position.
+		\param[out] value Whether N is 8, 16, 32 or 64.
 	*/
-	typedef void(*process_bits)(bitfield &value, bitfield mask,
-		size_t shift_amount, size_t byte_count, unsigned char *byte_pointer);
+	template <size_t N>
+	struct is_word_size : boost::integral_constant<bool,
+		N == 8 || N == 16 || N == 32 || N == 64>
+	{
+	};
 
 	/**
-		Process sequence of bits without advancing pointer.
+		Make buffer that views bits of this one.
 
-		\note The get/put pointer is not advanced. Use xsgetn()/xsputn() for that.
-
-		\param[out] value Value of bit field.
-		\param[in] size Number of bits in sequence of bits.
-		\param[in] ptr Position of next bit to process.
-		\param[in] eptr Position of bit after last bit in stream.
-		\param[in] byte_pointer Pointer to byte containing current bit position.
-		\param[in] process_bits_ Callback to process, i.e., get or put, bit field.
-		\return Number of bits processed from buffer or zero if error or eof.
+		\param[in] begin Position of first bit in slice.
+		\param[in] end Position just past last bit in slice.
+		\return Buffer for bits [begin, end); empty if they are not all
+		within the accessible input sequence or sliceable() is false.
 	*/
-	std::streamsize xsprocessn_nobump(bitfield &value, std::streamsize size,
-		std::streampos ptr, std::streampos eptr, unsigned char *byte_pointer,
-		process_bits process_bits_)
+	bitbuf make_slice(bitpos begin, bitpos end) const
 	{
-		std::streamsize bits_processed = 0;
+		bitbuf slice(std::ios_base::in);
+		slice.m_order = m_order;
 
-		if (size > 0 && size <= eptr - ptr)
+		if (sliceable() && eback() <= begin && begin <= end && end <= egptr())
 		{
-			// Generate "right-justified" mask, e.g., 0000000000111111.
-			bitfield mask = -1;
-			// (Had to break up shift into two parts because shifting the width
-			// of the integral all at once had no effect.)
-			mask <<= size - 1;
-			mask <<= 1;
-			mask = ~mask;
-
-			// Shift left so mask appears at correct location within integral,
-			// e.g., 0000000111111000.
-			const size_t intra_byte_bit_offset = ptr % CHAR_BIT;
-			const size_t shift_amount = (CHAR_BIT - ((size + intra_byte_bit_offset) % CHAR_BIT)) % CHAR_BIT;
-			mask <<= shift_amount;
-
-			// Number of bytes to be processed for this bit field.
-			const size_t byte_count = (static_cast<size_t>(size) + shift_amount + CHAR_BIT - 1) / CHAR_BIT;
-
-			process_bits_(value, mask, shift_amount, byte_count, byte_pointer);
-
-			bits_processed = size;
+			unsigned char * const buffer = m_buffer + begin / CHAR_BIT;
+			const bitpos first = begin % CHAR_BIT;
+			const bitpos last = first + (end - begin);
+			slice.setg(buffer, first, first, last);
+			slice.setp(buffer, first,
+				pbase() <= begin && end <= epptr() ? last : first);
 		}
 
-		return bits_processed;
+		return slice;
 	}
 
 	// Input functions ////////////////////////////////////////////////////////
@@ -752,6 +2553,8 @@ private:
 	/**
 		Get bit at offset relative to gptr().
 
+		\note This reads the get area directly; outside it, the bit is 0.
+
 		\param[in] offset Offset from gptr() to get bit.
 		\return Value of bit at offset from gptr().
 	*/
@@ -759,11 +2562,10 @@ private:
 	{
 		bitfield b = 0;
 
-		if (seekoff(offset, std::ios_base::cur, std::ios_base::in) !=
-			std::streampos(-1))
+		const bitpos position = gptr() + offset;
+		if (position >= eback() && position < egptr())
 		{
-			xsgetn_nobump(b, 1);
-			seekoff(-offset, std::ios_base::cur, std::ios_base::in);
+			b = (m_buffer[position / CHAR_BIT] >> bit_shift(position)) & 1;
 		}
 
 		return b;
@@ -786,15 +2588,15 @@ private:
 		\note If bit position is within bounds, use as internal get pointer.
 
 		\param[in] position Candidate for new get position.
-		\return position if valid; otherwise, std::streampos(-1).
+		\return position if valid; otherwise, bitpos(-1).
 	*/
-	std::streampos assure_valid_get_pointer(std::streampos position)
+	bitpos assure_valid_get_pointer(bitpos position)
 	{
-		std::streampos new_position;
+		bitpos new_position;
 
 		if (position < eback() || position > egptr())
 		{
-			new_position = std::streampos(-1);
+			new_position = bitpos(-1);
 		}
 		else
 		{
@@ -815,31 +2617,6 @@ private:
 		return &m_buffer[m_gptr / CHAR_BIT];
 	}
 
-	/**
-		Get sequence of bits.
-
-		\note This is a callback function called exclusively by xsprocessn_nobump().
-
-		\param[in] value Value of bit field.
-		\param[in] mask Mask to isolate bit field in stream, e.g., 0000000111111000.
-		\param[in] shift_amount Number of bit positions mask had to be shifted left, e.g., 4.
-		\param[in] byte_count Number of bytes to be read to get this bit field.
-		\param[in] byte_pointer Pointer to byte containing current bit position.
-	*/
-	static void get_bits_callback(bitfield &value, bitfield mask, size_t shift_amount,
-		size_t byte_count, unsigned char *byte_pointer)
-	{
-		bitfield pre_mask_value = 0;
-		for (size_t i = 0; i < byte_count; ++i)
-		{
-			pre_mask_value <<= static_cast<unsigned>(CHAR_BIT);
-			pre_mask_value |= byte_pointer[i];
-		}
-
-		value = pre_mask_value & mask;
-		value >>= shift_amount;
-	}
-
 	/**
 		Get sequence of bits without advancing pointer.
 
@@ -851,8 +2628,18 @@ private:
 	*/
 	std::streamsize xsgetn_nobump(bitfield &value, std::streamsize size)
 	{
-		return xsprocessn_nobump(value, size, gptr(), egptr(),
-			current_get_byte(), get_bits_callback);
+		std::streamsize bits_read = 0;
+
+		if (size > 0 && size <= egptr() - gptr() &&
+			size <= static_cast<std::streamsize>(sizeof value * CHAR_BIT))
+		{
+			value = get_field(current_get_byte(), gptr() % CHAR_BIT,
+				static_cast<size_t>(size), bytes_remaining(gptr(), egptr()));
+
+			bits_read = size;
+		}
+
+		return bits_read;
 	}
 
 	// Output functions ///////////////////////////////////////////////////////
@@ -863,15 +2650,15 @@ private:
 		\note If bit position is within bounds, use as internal put pointer.
 
 		\param[in] position Candidate for new put position.
-		\return position if valid; otherwise, std::streampos(-1).
+		\return position if valid; otherwise, bitpos(-1).
 		*/
-	std::streampos assure_valid_put_pointer(std::streampos position)
+	bitpos assure_valid_put_pointer(bitpos position)
 	{
-		std::streampos new_position;
+		bitpos new_position;
 
 		if (position < pbase() || position > epptr())
 		{
-			new_position = std::streampos(-1);
+			new_position = bitpos(-1);
 		}
 		else
 		{
@@ -893,107 +2680,128 @@ private:
 	}
 
 	/**
-		Put sequence of bits.
+		Put sequence of bits without advancing pointer.
 
-		\note This is a callback function called exclusively by xsprocessn_nobump().
+		\note The put pointer is not advanced. Use xsputn() for that.
 
 		\param[in] value Value of bit field.
-		\param[in] mask Mask to isolate bit field in stream, e.g., 0000000111111000.
-		\param[in] shift_amount Number of bit positions mask had to be shifted left, e.g., 4.
-		\param[in] byte_count Number of bytes to be written to get this bit field.
-		\param[in] byte_pointer Pointer to byte containing current bit position.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits written to buffer or zero if error or eof.
 	*/
-	static void put_bits_callback(bitfield &value, bitfield mask, size_t shift_amount,
-		size_t byte_count, unsigned char *byte_pointer)
+	std::streamsize xsputn_nobump(bitfield value, std::streamsize size)
 	{
-		mask = ~mask;
-		value <<= shift_amount;
-		for (size_t i = byte_count - 1; ; --i, mask >>= CHAR_BIT, value >>= CHAR_BIT)
+		std::streamsize bits_written = 0;
+
+		if (size > 0 && size <= epptr() - pptr() &&
+			size <= static_cast<std::streamsize>(sizeof value * CHAR_BIT))
 		{
-			byte_pointer[i] &= mask;
-			byte_pointer[i] |= value;
-			if (i == 0)
-			{
-				break;
-			}
+			put_field(current_put_byte(), pptr() % CHAR_BIT,
+				static_cast<size_t>(size), value, bytes_remaining(pptr(), epptr()));
+
+			bits_written = size;
 		}
+
+		return bits_written;
 	}
 
-	/**
-		Put sequence of bits without advancing pointer.
+	// Buffer-management variables ////////////////////////////////////////////
 
-		\note The put pointer is not advanced. Use xsputn() for that.
+    /**
+        Pointer to first byte of char array containing the bits.
+    */
+    unsigned char *m_buffer;
 
-		\param[out] value Value of bit field.
-		\param[in] size Number of bits in sequence of bits.
-		\return Number of bits written to buffer or zero if error or eof.
+	/**
+		Order in which bits of char array are numbered.
 	*/
-	std::streamsize xsputn_nobump(bitfield value, std::streamsize size)
-	{
-		return xsprocessn_nobump(value, size, pptr(), epptr(),
-			current_put_byte(), put_bits_callback);
-	}
+	bit_order m_order;
+
+#ifdef BOOST_BITSTREAM_PAD_AREAS
+	/**
+		Padding between buffer-management and input variables.
+	*/
+	char m_shared_padding[detail::cache_line_bytes];
+#endif
 
 	// Input variables ////////////////////////////////////////////////////////
 
 	/**
 		Beginning of accessible input sequence.
 
-		\note Not currently used. Always 0, which is first bit in first byte.
+		\note Usually 0, which is first bit in first byte. A ring buffer
+		moves it up past bits no longer kept (see ringbuf.hpp).
 	*/
-	std::streampos m_eback;
+	bitpos m_eback;
 
 	/**
         Current bit position in buffer.
 
         \note Position is zero-based, starting with MSB in byte pointed to by
         m_buffer, progressing to LSB of that byte, then MSB of next byte, etc.
+		With lsb_first, it is the other way around within each byte.
 
         \note This is analogous to streambuf::gptr, except it "points" to a
         bit position rather than a character position.
     */
-    std::streampos m_gptr;
+    bitpos m_gptr;
 
     /**
         End of accessible input sequence.
 
         \note Points just past last bit.
     */
-    std::streampos m_egptr;
+    bitpos m_egptr;
+
+#ifdef BOOST_BITSTREAM_PAD_AREAS
+	/**
+		Padding between input and output variables.
+	*/
+	char m_get_padding[detail::cache_line_bytes];
+#endif
 
 	// Output variables ////////////////////////////////////////////////////////
 
 	/**
 		Beginning of accessible output sequence.
 
-		\note Not currently used. Always 0, which is first bit in first byte.
+		\note Usually 0, which is first bit in first byte. A ring buffer
+		moves it up to where writing resumes on each pass (see ringbuf.hpp),
+		and a checksum buffer starts its own put area here (see checksum.hpp).
 	*/
-	std::streampos m_pbase;
+	bitpos m_pbase;
 
 	/**
 		Current bit position in buffer.
 
 		\note Position is zero-based, starting with MSB in byte pointed to by
 		m_buffer, progressing to LSB of that byte, then MSB of next byte, etc.
+		With lsb_first, it is the other way around within each byte.
 
 		\note This is analogous to streambuf::pptr, except it "points" to a
 		bit position rather than a character position.
 	*/
-	std::streampos m_pptr;
+	bitpos m_pptr;
 
 	/**
 		End of accessible output sequence.
 
 		\note Points just past last bit.
 	*/
-	std::streampos m_epptr;
+	bitpos m_epptr;
 
-	// Buffer-management variables ////////////////////////////////////////////
+#ifdef BOOST_BITSTREAM_PAD_AREAS
+	/**
+		Padding between output variables and what follows.
+	*/
+	char m_put_padding[detail::cache_line_bytes];
+#endif
 
-    /**
-        Pointer to first byte of char array containing the bits.
-    */
-    unsigned char *m_buffer;
+#ifdef BOOST_BITSTREAM_STATS
+	/**
+		Instrumentation counters.
+	*/
+	stream_stats m_stats;
+#endif
 };
 
 /**
@@ -1007,7 +2815,7 @@ public:
 
         \param[in] bb Pointer to a bitbuf object.
     */
-    explicit iob(bitbuf *bb)
+    explicit iob(bitbuf *bb) : m_state(std::ios_base::goodbit)
     {
         init(bb);
     }
@@ -1129,6 +2937,7 @@ public:
     */
     void clear(std::ios_base::iostate state = std::ios_base::goodbit)
     {
+		BOOST_BITSTREAM_COUNT(m_stats.count_state(m_state, state));
         m_state = state;
 
 		if (rdbuf() == NULL)
@@ -1158,6 +2967,32 @@ public:
 		init(bb);
         return previous_bitbuf;
     }
+
+	/**
+		Get instrumentation counters of stream.
+
+		\note Counters are only kept if BOOST_BITSTREAM_STATS is defined;
+		otherwise, they are all 0. The bitbuf counts bits and fields; add
+		rdbuf()->stats() for those. See stream_stats.
+
+		\return Snapshot of putback, unget, eof and failure counters.
+	*/
+	stream_stats stats() const
+	{
+#ifdef BOOST_BITSTREAM_STATS
+		return m_stats;
+#else
+		return stream_stats();
+#endif
+	}
+
+	/**
+		Zero instrumentation counters of stream.
+	*/
+	void reset_stats()
+	{
+		BOOST_BITSTREAM_COUNT(m_stats.reset());
+	}
 #if 0
     /**
         Get tied stream.
@@ -1186,7 +3021,7 @@ protected:
 
         \note Consumer must call init() after calling this constructor.
     */
-    iob()
+    iob() : m_bitbuf(NULL), m_state(std::ios_base::goodbit)
     {
         // Do nothing.
     }
@@ -1207,6 +3042,7 @@ protected:
     */
     void badbit()
     {
+		BOOST_BITSTREAM_COUNT(m_stats.count_state(m_state, m_state | std::ios_base::badbit));
         m_state |= std::ios_base::badbit;
     }
 
@@ -1215,6 +3051,7 @@ protected:
     */
     void failbit()
     {
+		BOOST_BITSTREAM_COUNT(m_stats.count_state(m_state, m_state | std::ios_base::failbit));
         m_state |= std::ios_base::failbit;
     }
 
@@ -1223,6 +3060,7 @@ protected:
     */
     void eofbit()
     {
+		BOOST_BITSTREAM_COUNT(m_stats.count_state(m_state, m_state | std::ios_base::eofbit));
         m_state |= std::ios_base::eofbit;
     }
 
@@ -1239,6 +3077,14 @@ private:
         multiple states including eof and failure.
     */
     std::ios_base::iostate m_state;
+
+protected:
+#ifdef BOOST_BITSTREAM_STATS
+	/**
+		Instrumentation counters of stream.
+	*/
+	stream_stats m_stats;
+#endif
 };
 
 } // namespace bitstream
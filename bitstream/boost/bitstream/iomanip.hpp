@@ -12,6 +12,7 @@
 #ifndef BOOST_BITSTREAM_IOMANIP_HPP
 #define BOOST_BITSTREAM_IOMANIP_HPP
 
+#include <boost/bitstream/cursor.hpp>
 #include <boost/bitstream/istream.hpp>
 #include <boost/bitstream/ostream.hpp>
 
@@ -62,6 +63,28 @@ public:
 		return obs.repeat(m_repeat);
 	}
 
+	/**
+		Overload for the (bit_reader &) operator on this class.
+
+		\param[in,out] r Reference to bit_reader on lhs of >> operator.
+		\return Reference to bit_reader parameter.
+	*/
+	bit_reader &operator()(bit_reader &r) const
+	{
+		return r.repeat(m_repeat);
+	}
+
+	/**
+		Overload for the (bit_writer &) operator on this class.
+
+		\param[in,out] w Reference to bit_writer on lhs of << operator.
+		\return Reference to bit_writer parameter.
+	*/
+	bit_writer &operator()(bit_writer &w) const
+	{
+		return w.repeat(m_repeat);
+	}
+
 private:
     /**
         Number of bit fields to extract/insert per container.
@@ -94,6 +117,32 @@ inline ostream &operator>>(ostream &obs, setrepeat repeat)
 {
 	return repeat(obs);
 }
+
+/**
+	Manipulator for bit_reader that sets repeat count for subsequent
+	container extractions.
+
+	\param[in,out] r Reference to bit_reader on left-hand side of operator.
+	\param[in] repeat Instance of setrepeat class.
+	\return Reference to bit_reader parameter.
+*/
+inline bit_reader &operator>>(bit_reader &r, setrepeat repeat)
+{
+	return repeat(r);
+}
+
+/**
+	Manipulator for bit_writer that sets repeat count for subsequent
+	container insertions.
+
+	\param[in,out] w Reference to bit_writer on left-hand side of operator.
+	\param[in] repeat Instance of setrepeat class.
+	\return Reference to bit_writer parameter.
+*/
+inline bit_writer &operator<<(bit_writer &w, setrepeat repeat)
+{
+	return repeat(w);
+}
 ///@}
 
 ///@{
@@ -137,6 +186,28 @@ public:
 		return obs.ignore(m_bits);
 	}
 
+	/**
+		Overload for the () operator on this class.
+
+		\param[in,out] r Reference to bit_reader on lhs of >> operator.
+		\return Reference to bit_reader parameter.
+	*/
+	bit_reader &operator()(bit_reader &r) const
+	{
+		return r.ignore(m_bits);
+	}
+
+	/**
+		Overload for the () operator on this class.
+
+		\param[in,out] w Reference to bit_writer on lhs of << operator.
+		\return Reference to bit_writer parameter.
+	*/
+	bit_writer &operator()(bit_writer &w) const
+	{
+		return w.ignore(m_bits);
+	}
+
 private:
     /**
         Number of bit fields to ignore in bit stream.
@@ -167,6 +238,30 @@ inline ostream &operator>>(ostream &obs, ignore skip)
 {
 	return skip(obs);
 }
+
+/**
+	Manipulator for bit_reader that ignores bits.
+
+	\param[in,out] r Reference to bit_reader on left-hand side of operator.
+	\param[in] skip Instance of ignore class.
+	\return Reference to bit_reader parameter.
+*/
+inline bit_reader &operator>>(bit_reader &r, ignore skip)
+{
+	return skip(r);
+}
+
+/**
+	Manipulator for bit_writer that ignores bits.
+
+	\param[in,out] w Reference to bit_writer on left-hand side of operator.
+	\param[in] skip Instance of ignore class.
+	\return Reference to bit_writer parameter.
+*/
+inline bit_writer &operator<<(bit_writer &w, ignore skip)
+{
+	return skip(w);
+}
 ///@}
 
 ///@{
@@ -229,6 +324,17 @@ public:
         return ibs.aligng(m_bits);
     }
 
+	/**
+		Overload for the () operator on this class.
+
+		\param[in,out] r Reference to bit_reader on lhs of >> operator.
+		\return Reference to bit_reader parameter.
+	*/
+	bit_reader &operator()(bit_reader &r) const
+	{
+		return r.aligng(m_bits);
+	}
+
 private:
     /**
         Number of bit at which to align the get pointer.
@@ -247,6 +353,18 @@ inline istream &operator>>(istream &ibs, aligng align)
 {
     return align(ibs);
 }
+
+/**
+	Manipulator for bit_reader that aligns its position.
+
+	\param[in,out] r Reference to bit_reader on left-hand side of operator.
+	\param[in] align Instance of aligng class.
+	\return Reference to bit_reader parameter.
+*/
+inline bit_reader &operator>>(bit_reader &r, aligng align)
+{
+	return align(r);
+}
 ///@}
 
 } // namespace bitstream
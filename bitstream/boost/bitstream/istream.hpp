@@ -14,6 +14,10 @@
 
 #include <boost/bitstream/iob.hpp>
 #include <boost/spirit/home/support/container.hpp>
+#include <boost/typeof/typeof.hpp>
+#include <algorithm>
+#include <bitset>
+#include <cstring>
 
 namespace boost {
 
@@ -108,12 +112,68 @@ public:
 		sequence fails (in which case the bit that could not be inserted, is
 		not extracted).
 
+		\note Runs of bits that are in this stream's get area and fit in bb's
+		put area are copied with bitbuf::sgetcopy(), a word at a time or a
+		memmove(), rather than bit by bit. If the buffers' bit orders differ,
+		bits are copied one at a time so that they keep their order.
+
 		\param[in] bb bitbuf object into which bits are inserted.
 		\return This bit stream.
 	*/
 	istream &get(bitbuf &bb)
 	{
-		// TBD Implement get().
+		static const std::streamsize window_bits = sizeof(bitfield) * CHAR_BIT;
+
+		bitbuf * const in = rdbuf();
+		std::streamsize bits_copied = 0;
+		bool one_bit = in->order() != bb.order();
+
+		for (;;)
+		{
+			const std::streamsize available = in->in_avail();
+			if (available <= 0)
+			{
+				eofbit();
+				break;
+			}
+
+			// Copy straight from get area to put area as far as both go.
+			const std::streamsize copied = in->sgetcopy(bb, available);
+			if (copied > 0)
+			{
+				bits_copied += copied;
+				continue;
+			}
+
+			// Otherwise, put one field, which may make room in bb; if a whole
+			// field does not fit, put what does a bit at a time.
+			const std::streamsize bits = one_bit ? 1 :
+				std::min(window_bits, available);
+			bitfield value;
+			if (in->speekn(value, bits) != bits)
+			{
+				eofbit();
+				break;
+			}
+			if (bb.sputn(value, bits) != bits)
+			{
+				if (one_bit)
+				{
+					break;
+				}
+				one_bit = true;
+				continue;
+			}
+			in->sskipn(bits);
+			bits_copied += bits;
+		}
+
+		if (bits_copied == 0)
+		{
+			failbit();
+		}
+		m_gcount = bits_copied;
+
 		return *this;
 	}
 
@@ -200,6 +260,87 @@ public:
         return tellg() % bit == 0;
     }
 
+	/**
+		Skip to the next occurrence of a sequence of bits, such as a start
+		code or sync word.
+
+		Example:
+		\code
+		// Resynchronize on an H.264 start code.
+		if (bin.seek_to_pattern(0x000001, 24, 8) != std::streampos(-1))
+		{
+			bin.ignore(24) >> nal_header;
+		}
+		\endcode
+
+		\note The get pointer is left at the first bit of the pattern. Only
+		positions that are multiples of alignment are tried. The get area is
+		searched directly with bitbuf::sfind(); a byte-aligned pattern is
+		found by its first byte with memchr(), anything else with a sliding
+		64-bit window. A streambitbuf is refilled as the search goes, so a
+		pattern may straddle chunks. If there is no match, the stream is left
+		at its end with eofbit set.
+
+		\param[in] pattern Sequence of bits, right-justified.
+		\param[in] bits Number of bits in pattern, 1 through the number of
+		bits in bitfield.
+		\param[in] alignment Bit multiple of positions to try, e.g., 8 for
+		byte-aligned start codes.
+		\return New position of get pointer; std::streampos(-1) if not found.
+	*/
+	std::streampos seek_to_pattern(bitfield pattern, std::streamsize bits,
+		size_t alignment = 1)
+	{
+		bitbuf * const in = rdbuf();
+		const std::streamsize step = static_cast<std::streamsize>(
+			std::max(alignment, size_t(1)));
+		std::streampos position(-1);
+
+		if (bits <= 0 || bits > static_cast<std::streamsize>(sizeof(bitfield) * CHAR_BIT))
+		{
+			failbit();
+		}
+		else if (!fail())
+		{
+			const bitfield mask = ~bitfield(0) >>
+				(sizeof(bitfield) * CHAR_BIT - static_cast<size_t>(bits));
+			for (;;)
+			{
+				const std::streamoff phase = std::streamoff(tellg()) % step;
+				std::streamsize offset = phase == 0 ? 0 : step - phase;
+				if (in->sfind(pattern, bits, offset, step))
+				{
+					in->sskipn(offset);
+					position = tellg();
+					break;
+				}
+
+				// Compare the first candidate that did not fit with a peek,
+				// which refills a streambitbuf or spans segments of a
+				// chainbitbuf, and go on from the one after it.
+				bitfield value;
+				bool more = in->sskipn(offset) == offset &&
+					in->speekn(value, bits) == bits;
+				if (more && value == (pattern & mask))
+				{
+					position = tellg();
+					break;
+				}
+				more = more && in->sskipn(step) == step;
+				if (!more)
+				{
+					in->sskipn(std::max(in->in_avail(), std::streamsize(0)));
+					eofbit();
+					break;
+				}
+			}
+		}
+
+		m_gcount = 0;
+
+		return position;
+	}
+
     /**
         Get next bit from stream without advancing get pointer.
 
@@ -220,6 +361,105 @@ public:
         return m_gvalue;
     }
 
+	/**
+		Get bits from stream without advancing get pointer.
+
+		\note Unlike read(), there being too few bits only sets eofbit, and
+		value is zero. See bitbuf::speekn(); the get pointer is never
+		repositioned to do this.
+
+		\param[out] value Integral to receive bits from stream.
+		\param[in] bits Number of bits to peek at.
+		\return This bit stream.
+	*/
+	istream &peek(bitfield &value, std::streamsize bits)
+	{
+		if (rdbuf()->speekn(value, bits) != bits)
+		{
+			eofbit();
+			value = 0;
+			m_gcount = 0;
+		}
+		else
+		{
+			m_gcount = bits;
+		}
+
+		m_gvalue = value;
+
+		return *this;
+	}
+
+	/**
+		Get next N bits from stream without advancing get pointer.
+
+		\note This is for table-driven decoding, e.g.,
+		\code
+		const vlc_entry &e = table[bin.show_bits<9>()];
+		bin.skip(e.length);
+		\endcode
+		Near the end of the stream, where fewer than N bits are left, what is
+		left is returned followed by zeros, so a table lookup still works. The
+		state of the stream is not changed.
+
+		\tparam N Number of bits to peek at.
+		\return Next N bits, right-justified.
+	*/
+	template <size_t N>
+	bitfield show_bits()
+	{
+		bitfield value;
+
+		return rdbuf()->speekn<N>(value) == static_cast<std::streamsize>(N) ?
+			value : show_remaining_bits(N);
+	}
+
+	/**
+		Get next bits from stream without advancing get pointer.
+
+		\note See show_bits<N>().
+
+		\param[in] bits Number of bits to peek at, up to the number of bits
+		in bitfield.
+		\return Next bits, right-justified.
+	*/
+	bitfield show_bits(std::streamsize bits)
+	{
+		bitfield value;
+
+		return rdbuf()->speekn(value, bits) == bits ?
+			value : show_remaining_bits(bits);
+	}
+
+	/**
+		Skip bits, e.g., those of a code found with show_bits().
+
+		\note Unlike ignore(), skipping past the end sets failbit, too, just
+		like reading past it. See bitbuf::sskipn().
+
+		\param[in] bits Number of bits to skip.
+		\return This bit stream.
+	*/
+	istream &skip(std::streamsize bits)
+	{
+		if (rdbuf()->sskipn(bits) != bits)
+		{
+			eofbit();
+			failbit();
+			m_gcount = 0;
+		}
+		else
+		{
+			if (rdbuf()->in_avail() <= 0)
+			{
+				eofbit();
+			}
+			m_gcount = bits;
+		}
+
+		return *this;
+	}
+
     /**
         Get bits from stream.
 
@@ -229,32 +469,180 @@ public:
     */
     istream &read(bitfield &value, std::streamsize bits)
     {
-		std::streamsize bits_read = rdbuf()->sgetn(value, bits);
-        if (bits_read != bits)
-        {
-			// This read failed. Was it because there aren't enough available bits?
+		return read_done(value, bits, rdbuf()->sgetn(value, bits));
+    }
+
+	/**
+		Get bits from stream, where number of bits is known at compile time.
+
+		\note This is what the extraction operators for bool, bitset and
+		integrals use. See bitbuf::sgetn<N>().
+
+		\tparam N Number of bits to read.
+		\param[out] value Integral to receive bits from stream.
+		\return This bit stream.
+	*/
+	template <size_t N>
+	istream &read(bitfield &value)
+	{
+		return read_done(value, N, rdbuf()->sgetn<N>(value));
+	}
+
+	/**
+		Get array of integrals from stream, each a bit field of
+		sizeof(T) * CHAR_BIT bits.
+
+		\note When the get pointer is byte aligned and enough bits are
+		available, this is a single copy; see bitbuf::sgetaligned().
+		Otherwise, each integral is extracted in turn, just like
+		ibs >> values[i].
+
+		\param[out] values Array to receive integrals.
+		\param[in] count Number of integrals to read.
+		\return This bit stream.
+	*/
+	template <typename T>
+	typename boost::enable_if_c<is_bulk_integral<T>::value, istream &>::type
+	read(T *values, size_t count)
+	{
+		static const size_t bits = sizeof(T) * CHAR_BIT;
+
+		if (count > 0 && rdbuf()->sgetaligned(values, count) == count)
+		{
+			if (rdbuf()->in_avail() <= 0)
+			{
+				eofbit();
+			}
+			m_gcount = static_cast<std::streamsize>(count * bits);
+			m_gvalue = static_cast<bitfield>(values[count - 1]) &
+				(~bitfield(0) >> (sizeof(bitfield) * CHAR_BIT - bits));
+		}
+		else
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				bitfield value;
+				read<bits>(value);
+				values[i] = static_cast<T>(value);
+			}
+		}
+
+		return *this;
+	}
+
+	/**
+		Get the next bits as a buffer of their own, without copying them.
+
+		\note This is for nested, length-prefixed structures such as header
+		extensions or encapsulated packets: the returned bitbuf views the bits
+		in place (see bitbuf::slice()), and this stream advances past them.
+		Like read(), this fails if there are not enough bits, and it also
+		fails if the bitbuf makes no slices, e.g., a streambitbuf; then an
+		empty bitbuf is returned.
+
+		Example:
+		\code
+		bin >> profile >> length;
+		ibitstream extension(bin.substream(length * 32));
+		extension >> element >> element_length;
+		\endcode
+
+		\param[in] bits Number of bits.
+		\return Buffer for the bits.
+	*/
+	bitbuf substream(std::streamsize bits)
+	{
+		bitbuf slice(std::ios_base::in);
+
+		if (rdbuf()->sgetslice(slice, bits))
+		{
+			if (rdbuf()->in_avail() <= 0)
+			{
+				eofbit();
+			}
+			m_gcount = bits;
+		}
+		else
+		{
 			if (rdbuf()->in_avail() < bits)
 			{
 				eofbit();
 			}
 			failbit();
-            m_gcount = 0;
-            value = 0;
-        }
-        else
-        {
-			// This read succeeded, but have we reached eof (without going past it)?
-			if (rdbuf()->in_avail() == 0)
+			m_gcount = 0;
+		}
+
+		return slice;
+	}
+
+	/**
+		Get array of N-bit fields packed back to back from stream, each into
+		an integral.
+
+		\note This is equivalent to extracting count std::bitset<N> and
+		converting each to T, but when enough bits are available the fields
+		are unpacked in bulk; see bitbuf::sgetpacked().
+
+		Example:
+		\code
+		std::vector<boost::uint16_t> samples(count);
+		bin.read_packed<12>(&samples[0], samples.size());
+		\endcode
+
+		\tparam N Number of bits in each field.
+		\param[out] values Array to receive integrals.
+		\param[in] count Number of fields to read.
+		\return This bit stream.
+	*/
+	template <size_t N, typename T>
+	typename boost::enable_if_c<is_bulk_integral<T>::value, istream &>::type
+	read_packed(T *values, size_t count)
+	{
+		if (count > 0 && rdbuf()->sgetpacked<N>(values, count) == count)
+		{
+			if (rdbuf()->in_avail() <= 0)
 			{
 				eofbit();
 			}
-			m_gcount = bits_read;
-        }
+			m_gcount = static_cast<std::streamsize>(count * N);
+			m_gvalue = static_cast<bitfield>(values[count - 1]) &
+				(~bitfield(0) >> (sizeof(bitfield) * CHAR_BIT - N));
+		}
+		else
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				bitfield value;
+				read<N>(value);
+				values[i] = static_cast<T>(value);
+			}
+		}
 
-        m_gvalue = value;
+		return *this;
+	}
 
-        return *this;
-    }
+	/**
+		Get field of any number of bits from stream.
+
+		\note This is for fields wider than bitfield. See bitbuf::sgetwide()
+		for the layout of bytes. On failure, bytes is zeroed.
+
+		\param[out] bytes Array of (bits + CHAR_BIT - 1) / CHAR_BIT bytes to
+		receive field.
+		\param[in] bits Number of bits in field.
+		\return This bit stream.
+	*/
+	istream &read_wide(unsigned char *bytes, std::streamsize bits)
+	{
+		bitfield value = 0;
+		if (read_done(value, bits, rdbuf()->sgetwide(bytes, bits)).fail() &&
+			bits > 0)
+		{
+			std::memset(bytes, 0, static_cast<size_t>(bits + CHAR_BIT - 1) / CHAR_BIT);
+		}
+
+		return *this;
+	}
 
     /**
         Get "some" bits from stream.
@@ -282,6 +670,7 @@ public:
 	*/
 	istream& putback(bitfield value)
 	{
+		BOOST_BITSTREAM_COUNT(++m_stats.putbacks);
 // http://en.cppreference.com/w/cpp/io/basic_istream/putback says do this:
 #if 0
 		clear(rdstate() & ~std::ios_base::eofbit);
@@ -315,7 +704,7 @@ public:
         \param[in] dir Bit pointer to which offset is applied.
         \return This bit stream.
     */
-    istream &seekg(std::streamoff offset, std::ios_base::seek_dir dir)
+    istream &seekg(std::streamoff offset, std::ios_base::seekdir dir)
     {
 		if (eof() || rdbuf()->pubseekoff(offset, dir, std::ios_base::in) == std::streampos(-1))
 		{
@@ -368,6 +757,7 @@ public:
     */
     istream &unget()
     {
+		BOOST_BITSTREAM_COUNT(++m_stats.ungets);
         m_gcount = 0;
 
         if (rdbuf()->pubseekoff(-1, std::ios_base::cur, std::ios_base::in) == std::streampos(-1))
@@ -395,6 +785,68 @@ protected:
     size_t m_repeat;
 
 private:
+	/**
+		Get what is left of stream, followed by zeros.
+
+		\note This is only called near the end, so it simply tries fewer and
+		fewer bits.
+
+		\param[in] bits Number of bits asked for, which are not all there.
+		\return Remaining bits, shifted left to make bits bits or, with
+		lsb_first, where the first bit is the LSB, as they are.
+	*/
+	bitfield show_remaining_bits(std::streamsize bits)
+	{
+		bitfield value = 0;
+
+		std::streamsize available = std::min(bits - 1,
+			static_cast<std::streamsize>(sizeof value * CHAR_BIT));
+		while (available > 0 && rdbuf()->speekn(value, available) != available)
+		{
+			--available;
+		}
+
+		return available == 0 ? 0 :
+			rdbuf()->order() == lsb_first ? value : value << (bits - available);
+	}
+
+	/**
+		Update state after reading bits.
+
+		\param[in,out] value Integral that received bits; zeroed on failure.
+		\param[in] bits Number of bits requested.
+		\param[in] bits_read Number of bits actually read.
+		\return This bit stream.
+	*/
+	istream &read_done(bitfield &value, std::streamsize bits,
+		std::streamsize bits_read)
+	{
+        if (bits_read != bits)
+        {
+			// This read failed. Was it because there aren't enough available bits?
+			if (rdbuf()->in_avail() < bits)
+			{
+				eofbit();
+			}
+			failbit();
+            m_gcount = 0;
+            value = 0;
+        }
+        else
+        {
+			// This read succeeded, but have we reached eof (without going past it)?
+			if (rdbuf()->in_avail() <= 0)
+			{
+				eofbit();
+			}
+			m_gcount = bits_read;
+        }
+
+        m_gvalue = value;
+
+        return *this;
+	}
+
     /**
         Friend const functions for access to badbit().
     */
@@ -482,7 +934,7 @@ struct has_resize
 inline istream &operator>>(istream &ibs, bool &b)
 {
     bitfield value;
-    ibs.read(value, 1);
+    ibs.read<1>(value);
     b = value != 0;
 
     return ibs;
@@ -519,15 +971,36 @@ inline istream &operator>>(istream &ibs, const bool &b)
 	\return Reference to istream parameter.
 */
 template <size_t N>
-istream &operator>>(istream &ibs, std::bitset<N> &bs)
+typename boost::enable_if_c<(N <= sizeof(bitfield) * CHAR_BIT), istream &>::type
+operator>>(istream &ibs, std::bitset<N> &bs)
 {
 	bitfield value;
-	ibs.read(value, N);
+	ibs.read<N>(value);
 	bs = value;
 
 	return ibs;
 }
 
+/**
+	Get bits from input stream and place in bitset wider than bitfield.
+
+	\note See istream::read_wide().
+
+	\param[in,out] ibs Reference to istream on left-hand side of operator.
+	\param[out] bs bitset on right-hand side of operator.
+	\return Reference to istream parameter.
+*/
+template <size_t N>
+typename boost::enable_if_c<(N > sizeof(bitfield) * CHAR_BIT), istream &>::type
+operator>>(istream &ibs, std::bitset<N> &bs)
+{
+	unsigned char bytes[(N + CHAR_BIT - 1) / CHAR_BIT];
+	ibs.read_wide(bytes, N);
+	bs = detail::bytes_to_bitset<N>(bytes, ibs.rdbuf()->order());
+
+	return ibs;
+}
+
 /**
 	Get bits from input stream that must be equal to bitset value.
 
@@ -562,7 +1035,7 @@ typename boost::enable_if_c<
 	operator>>(istream &ibs, T &b)
 {
 	bitfield value;
-	ibs.read(value, sizeof b * CHAR_BIT);
+	ibs.read<sizeof(T) * CHAR_BIT>(value);
 	b = static_cast<T>(value);
 
 	return ibs;
@@ -620,6 +1093,55 @@ operator>>(istream &ibs, const C &c)
 	return ibs;
 }
 
+// Templates for extracting elements of sequence containers ///////////////////
+
+/**
+	Get bit fields from input stream and place in each element of container.
+
+	\param[in,out] ibs Reference to istream.
+	\param[out] c Container, already sized.
+	\return Reference to istream parameter.
+*/
+template <typename C>
+typename boost::enable_if_c<
+	!is_contiguous_integral<C>::value,
+	istream &
+>::type
+extract_elements(istream &ibs, C &c)
+{
+	for (BOOST_AUTO_TPL(it, c.begin()); it != c.end(); ++it)
+	{
+		// (This is a workaround specifcally for std::vector<bool>. Otherwise,
+		// I'd extract directly into the dereferenced iterator, i.e.,
+		// ibs >> *it.)
+		typename C::value_type v;
+		ibs >> v;
+		*it = v;
+	}
+
+	return ibs;
+}
+
+/**
+	Get bit fields from input stream and place in each element of container
+	whose integral elements are contiguous.
+
+	\note See istream::read(T *, size_t).
+
+	\param[in,out] ibs Reference to istream.
+	\param[out] c Container, already sized.
+	\return Reference to istream parameter.
+*/
+template <typename C>
+typename boost::enable_if_c<
+	is_contiguous_integral<C>::value,
+	istream &
+>::type
+extract_elements(istream &ibs, C &c)
+{
+	return c.empty() ? ibs : ibs.read(&c[0], c.size());
+}
+
 // Templates for variable-size sequence containers ////////////////////////////
 
 /**
@@ -641,17 +1163,8 @@ typename boost::enable_if_c<
 operator>>(istream &ibs, C &c)
 {
 	c.resize(ibs.repeat() == 0 ? c.size() : ibs.repeat());
-	for (BOOST_AUTO_TPL(it, c.begin()); it != c.end(); ++it)
-	{
-		// (This is a workaround specifcally for std::vector<bool>. Otherwise,
-		// I'd extract directly into the dereferenced iterator, i.e.,
-		// ibs >> *it.)
-		C::value_type v;
-		ibs >> v;
-		*it = v;
-	}
 
-	return ibs;
+	return extract_elements(ibs, c);
 }
 
 // Templates for fixed-size sequence containers ///////////////////////////////
@@ -674,12 +1187,7 @@ typename boost::enable_if_c<
 >::type
 operator>>(istream &ibs, C &c)
 {
-	for (BOOST_AUTO_TPL(it, c.begin()); it != c.end(); ++it)
-	{
-		ibs >> *it;
-	}
-
-	return ibs;
+	return extract_elements(ibs, c);
 }
 
 } // namespace bitstream
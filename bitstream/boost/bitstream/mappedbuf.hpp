@@ -0,0 +1,182 @@
+/** \file
+    \brief Memory-mapped file bit-stream buffer.
+    \details This header file contains a bitbuf that accesses the bits of
+        a file mapped into memory.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_MAPPEDBUF_HPP
+#define BOOST_BITSTREAM_MAPPEDBUF_HPP
+
+#include <boost/bitstream/iob.hpp>
+#include <boost/interprocess/exceptions.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace boost {
+
+namespace bitstream {
+
+// mapped_bitbuf //////////////////////////////////////////////////////////////
+
+/**
+    This class represents the whole of a file, mapped into memory, as a
+	sequence of bits.
+
+    \note Mapping is done with boost::interprocess, i.e., mmap() on POSIX and
+	MapViewOfFile() on Windows. Nothing is read up front: pages are brought in
+	as bits are accessed, so seeking to any offset costs nothing, and there is
+	no copy. Positions are 64 bits, so files of more than 2^31 bytes (2^34
+	bits) are fine as long as the process has address space for them.
+
+	\note Open with std::ios_base::out to write bits into the file in place;
+	the file does not grow.
+*/
+class mapped_bitbuf : public bitbuf
+{
+public:
+	/**
+		Constructor.
+
+		\note The buffer is empty until open() succeeds.
+	*/
+	mapped_bitbuf() : bitbuf(std::ios_base::in)
+	{
+	}
+
+	/**
+		Constructor.
+
+		\note Check is_open() to see whether mapping succeeded.
+
+		\param[in] path Name of file to map.
+		\param[in] which Open mode.
+	*/
+	explicit mapped_bitbuf(const char *path,
+		std::ios_base::openmode which = std::ios_base::in) :
+		bitbuf(which)
+	{
+		open(path, which);
+	}
+
+	/**
+		Map file.
+
+		\note Any file already mapped is unmapped first. The whole file is
+		mapped; a file that is empty, or that cannot be opened or mapped,
+		leaves the buffer empty.
+
+		\param[in] path Name of file to map.
+		\param[in] which Open mode.
+		\return Whether the file is mapped.
+	*/
+	bool open(const char *path,
+		std::ios_base::openmode which = std::ios_base::in)
+	{
+		close();
+
+		const boost::interprocess::mode_t mode =
+			(which & std::ios_base::out) != 0 ?
+			boost::interprocess::read_write : boost::interprocess::read_only;
+
+		try
+		{
+			boost::interprocess::file_mapping file(path, mode);
+			boost::interprocess::mapped_region region(file, mode);
+			m_region.swap(region);
+		}
+		catch (const boost::interprocess::interprocess_exception &)
+		{
+			// (Leave empty, like std::filebuf::open() on failure.)
+		}
+
+		unsigned char * const buffer =
+			static_cast<unsigned char *>(m_region.get_address());
+		const bitpos size = static_cast<bitpos>(m_region.get_size()) * CHAR_BIT;
+		setg(buffer, 0, 0, size);
+		setp(buffer, 0, (which & std::ios_base::out) != 0 ? size : 0);
+
+		return is_open();
+	}
+
+	/**
+		Unmap file.
+	*/
+	void close()
+	{
+		boost::interprocess::mapped_region region;
+		m_region.swap(region);
+		setg(NULL, 0, 0, 0);
+		setp(NULL, 0, 0);
+	}
+
+	/**
+		Determine whether a file is mapped.
+
+		\return Whether a file is mapped.
+	*/
+	bool is_open() const
+	{
+		return m_region.get_address() != NULL;
+	}
+
+	/**
+		Get number of bits in mapped file.
+
+		\note Unlike std::streamsize, this is always 64 bits.
+
+		\return Number of bits.
+	*/
+	bitpos bits() const
+	{
+		return egptr();
+	}
+
+	/**
+		Tell the operating system how the bits will be accessed.
+
+		\note This is madvise() on POSIX. Where there is no equivalent, such
+		as on Windows, this does nothing and returns false.
+
+		\param[in] advice E.g., boost::interprocess::mapped_region::
+		advice_sequential for a front-to-back scan or advice_random for
+		seeking from packet to packet through an index.
+		\return Whether advice was given.
+	*/
+	bool advise(boost::interprocess::mapped_region::advice_types advice)
+	{
+		return is_open() && m_region.advise(advice);
+	}
+
+protected:
+	// Virtual buffer-management and positioning functions ////////////////////
+
+	/**
+		Set buffer to access.
+
+		\note Not supported; use open().
+
+		\return NULL.
+	*/
+	virtual bitbuf *setbuf(unsigned char *, std::streamsize)
+	{
+		return NULL;
+	}
+
+private:
+	/**
+		Mapping of the file.
+	*/
+	boost::interprocess::mapped_region m_region;
+};
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
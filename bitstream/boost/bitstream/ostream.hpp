@@ -14,6 +14,8 @@
 
 #include <boost/bitstream/iob.hpp>
 #include <boost/spirit/home/support/container.hpp>
+#include <boost/typeof/typeof.hpp>
+#include <bitset>
 
 namespace boost {
 
@@ -27,7 +29,8 @@ public:
     /**
         Constructor.
     */
-    explicit ostream(bitbuf *bb) : iob(bb), m_repeat(0)
+    explicit ostream(bitbuf *bb) : iob(bb), m_repeat(0), m_unitbuf(true),
+		m_combiner(0), m_combined(0)
     {
         // Do nothing.
     }
@@ -53,9 +56,16 @@ public:
 	*/
     ostream &put(bitfield value)
     {
-		if (good() && !rdbuf()->sputb(value))
+		if (good())
 		{
-			failbit();
+			if (!m_unitbuf)
+			{
+				combine(value, 1);
+			}
+			else if (!rdbuf()->sputb(value))
+			{
+				failbit();
+			}
 		}
 
         return *this;
@@ -69,7 +79,8 @@ public:
 	*/
 	ostream &ignore(std::streamsize bits = 1)
 	{
-		if (rdbuf()->pubseekoff(bits, std::ios_base::cur, std::ios_base::out) == std::streampos(-1))
+		if (!commit() ||
+			rdbuf()->pubseekoff(bits, std::ios_base::cur, std::ios_base::out) == std::streampos(-1))
 		{
 			eofbit();
 		}
@@ -122,6 +133,48 @@ public:
         return tellp() % bit == 0;
     }
 
+	/**
+		Get whether bits are written through to bitbuf by each output
+		operation.
+
+		\see unitbuf(bool).
+
+		\return Whether output is unbuffered.
+	*/
+	bool unitbuf() const
+	{
+		return m_unitbuf;
+	}
+
+	/**
+		Set whether bits are written through to bitbuf by each output
+		operation.
+
+		\note This is analogous to the std::ios_base::unitbuf flag, which is
+		set by default for this class. When it is cleared, bits are instead
+		collected in a 64-bit register and written to bitbuf a whole word at
+		a time, which avoids repeated read-modify-writes of the same bytes
+		when inserting many small fields. The collected bits are written
+		when the register fills, by flush(), and before repositioning the
+		put pointer; tellp() includes them. Until then, the contents of
+		bitbuf do not reflect them, and a write past the end of bitbuf is
+		only detected when they are written.
+
+		\param[in] unit Whether output is unbuffered.
+		\return This bit stream.
+	*/
+	ostream &unitbuf(bool unit)
+	{
+		if (unit)
+		{
+			commit();
+		}
+
+		m_unitbuf = unit;
+
+		return *this;
+	}
+
     /**
         Write bits to stream.
 
@@ -131,14 +184,137 @@ public:
     */
     ostream &write(bitfield value, std::streamsize bits)
     {
-		if (good() && !rdbuf()->sputn(value, bits))
+		if (good())
 		{
-			badbit();
+			if (!m_unitbuf && bits > 0 &&
+				bits <= static_cast<std::streamsize>(sizeof value * CHAR_BIT))
+			{
+				combine(value, static_cast<size_t>(bits));
+			}
+			else if (!commit() || !rdbuf()->sputn(value, bits))
+			{
+				badbit();
+			}
 		}
 
         return *this;
     }
 
+	/**
+		Put array of integrals to stream, each as a bit field of
+		sizeof(T) * CHAR_BIT bits.
+
+		\note When the put pointer is byte aligned and there is room, this is
+		a single copy; see bitbuf::sputaligned(). Otherwise, each integral is
+		inserted in turn, just like obs << values[i].
+
+		\param[in] values Array of integrals.
+		\param[in] count Number of integrals to write.
+		\return This bit stream.
+	*/
+	template <typename T>
+	typename boost::enable_if_c<is_bulk_integral<T>::value, ostream &>::type
+	write(const T *values, size_t count)
+	{
+		if (good() && count > 0 && commit() &&
+			rdbuf()->sputaligned(values, count) != count)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				write<sizeof(T) * CHAR_BIT>(static_cast<bitfield>(values[i]));
+			}
+		}
+
+		return *this;
+	}
+
+	/**
+		Put array of integrals to stream as N-bit fields packed back to back.
+
+		\note This is equivalent to inserting std::bitset<N>(values[i]) for
+		each integral, but the fields are packed in bulk where there is room;
+		see bitbuf::sputpacked(). Where there is not, fields are put one at a
+		time until there is, which lets a growable bitbuf make room. They are
+		put straight to bitbuf, even if unitbuf() is false, so that they stay
+		in order with those packed in bulk.
+
+		\tparam N Number of bits in each field.
+		\param[in] values Array of integrals.
+		\param[in] count Number of fields to write.
+		\return This bit stream.
+	*/
+	template <size_t N, typename T>
+	typename boost::enable_if_c<is_bulk_integral<T>::value, ostream &>::type
+	write_packed(const T *values, size_t count)
+	{
+		if (good() && commit())
+		{
+			for (size_t i = 0; good() && i < count; ++i)
+			{
+				if (rdbuf()->sputpacked<N>(values + i, count - i) == count - i)
+				{
+					break;
+				}
+
+				if (rdbuf()->sputn<N>(static_cast<bitfield>(values[i])) != N)
+				{
+					badbit();
+				}
+			}
+		}
+
+		return *this;
+	}
+
+	/**
+		Write bits to stream, where number of bits is known at compile time.
+
+		\note This is what the insertion operators for bool, bitset and
+		integrals use. See bitbuf::sputn<N>().
+
+		\tparam N Number of bits to write.
+		\param[in] value Integral from which to write bits to stream.
+		\return This bit stream.
+	*/
+	template <size_t N>
+	ostream &write(bitfield value)
+	{
+		if (good())
+		{
+			if (!m_unitbuf)
+			{
+				combine(value, N);
+			}
+			else if (!rdbuf()->sputn<N>(value))
+			{
+				badbit();
+			}
+		}
+
+		return *this;
+	}
+
+	/**
+		Write field of any number of bits to stream.
+
+		\note This is for fields wider than bitfield. See bitbuf::sputwide()
+		for the layout of bytes.
+
+		\param[in] bytes Array of (bits + CHAR_BIT - 1) / CHAR_BIT bytes of
+		field.
+		\param[in] bits Number of bits in field.
+		\return This bit stream.
+	*/
+	ostream &write_wide(const unsigned char *bytes, std::streamsize bits)
+	{
+		if (good() && (!commit() || rdbuf()->sputwide(bytes, bits) != bits))
+		{
+			badbit();
+		}
+
+		return *this;
+	}
+
     /**
         Set position of put pointer relative to indicated internal pointer.
 
@@ -146,9 +322,10 @@ public:
         \param[in] dir Bit pointer to which offset is applied.
         \return This bit stream.
     */
-    ostream &seekp(std::streamoff offset, std::ios_base::seek_dir dir)
+    ostream &seekp(std::streamoff offset, std::ios_base::seekdir dir)
     {
-		if (!fail() && rdbuf()->pubseekoff(offset, dir, std::ios_base::out) == std::streampos(-1))
+		if (!fail() && (!commit() ||
+			rdbuf()->pubseekoff(offset, dir, std::ios_base::out) == std::streampos(-1)))
 		{
 			failbit();
 		}
@@ -164,7 +341,8 @@ public:
     */
     ostream &seekp(std::streampos position)
     {
-		if (!fail() && rdbuf()->pubseekpos(position) == std::streampos(-1))
+		if (!fail() && (!commit() ||
+			rdbuf()->pubseekpos(position) == std::streampos(-1)))
 		{
 			failbit();
 		}
@@ -180,19 +358,25 @@ public:
     std::streampos tellp()
     {
 		return fail() ? std::streampos(-1) :
-			rdbuf()->pubseekoff(0, std::ios_base::cur, std::ios_base::out);
+			rdbuf()->pubseekoff(0, std::ios_base::cur, std::ios_base::out) +
+			std::streamoff(m_combined);
     }
 
     /**
         Synchronize output buffer with destination of bits.
 
-		\note This currently does nothing because there are no intermediate
-		buffers to write.
+		\note Any bits collected while unitbuf() is false are written to
+		bitbuf, then bitbuf::pubsync() is called.
 
         \return This bit stream.
     */
     ostream &flush()
     {
+		if (good() && (!commit() || rdbuf()->pubsync() == -1))
+		{
+			badbit();
+		}
+
         return *this;
     }
 
@@ -203,16 +387,146 @@ protected:
 	size_t m_repeat;
 
 private:
+	/**
+		Collect bits to be written to bitbuf a word at a time.
+
+		\note The register is written as one field, so its first bits are
+		its most significant ones, or, with lsb_first, its least significant
+		ones.
+
+		\param[in] value Value of bit field.
+		\param[in] bits Number of bits in bit field, 1 through 64.
+	*/
+	void combine(bitfield value, size_t bits)
+	{
+		static const size_t register_bits = sizeof m_combiner * CHAR_BIT;
+
+		const bitfield field = value & (~bitfield(0) >> (register_bits - bits));
+		const size_t room = register_bits - m_combined;
+		const bool lsb_first = rdbuf()->order() == bitstream::lsb_first;
+
+		if (bits < room)
+		{
+			m_combiner = lsb_first ? m_combiner | (field << m_combined) :
+				(m_combiner << bits) | field;
+			m_combined += bits;
+		}
+		else
+		{
+			// Fill the register, write it and keep what is left over.
+			const size_t left_over = bits - room;
+			const bitfield word = room == register_bits ? field :
+				lsb_first ? m_combiner | (field << m_combined) :
+				(m_combiner << room) | (field >> left_over);
+			if (rdbuf()->sputn<register_bits>(word) != register_bits)
+			{
+				badbit();
+			}
+
+			m_combiner = left_over == 0 ? 0 : lsb_first ? field >> room :
+				field & (~bitfield(0) >> (register_bits - left_over));
+			m_combined = left_over;
+		}
+	}
+
+	/**
+		Write bits collected by combine() to bitbuf.
+
+		\return Whether all collected bits were written.
+	*/
+	bool commit()
+	{
+		bool committed = true;
+
+		if (m_combined > 0)
+		{
+			committed = rdbuf()->sputn(m_combiner,
+				static_cast<std::streamsize>(m_combined)) ==
+				static_cast<std::streamsize>(m_combined);
+			if (!committed)
+			{
+				badbit();
+			}
+
+			m_combiner = 0;
+			m_combined = 0;
+		}
+
+		return committed;
+	}
+
+	/**
+		Whether each output operation writes through to bitbuf.
+	*/
+	bool m_unitbuf;
+
+	/**
+		Bits collected while not unitbuf(), right-justified.
+	*/
+	bitfield m_combiner;
+
+	/**
+		Number of bits in m_combiner.
+	*/
+	size_t m_combined;
+
     /**
         Friend const functions for access to badbit().
     */
     ///@{
-    template <size_t N> friend ostream &operator<<(ostream &obs,
-        const std::bitset<N> &bs);
     friend ostream &operator<<(ostream &obs, const bool b);
     ///@}
 };
 
+// Manipulators ///////////////////////////////////////////////////////////////
+
+/**
+	Apply manipulator to output stream.
+
+	\param[in,out] obs Reference to ostream on left-hand side of operator.
+	\param[in] manipulator Function to apply to stream, e.g., flush.
+	\return Reference to ostream parameter.
+*/
+inline ostream &operator<<(ostream &obs, ostream &(*manipulator)(ostream &))
+{
+	return manipulator(obs);
+}
+
+/**
+	Manipulator that synchronizes output stream; see ostream::flush().
+
+	\param[in,out] obs Output stream.
+	\return Reference to ostream parameter.
+*/
+inline ostream &flush(ostream &obs)
+{
+	return obs.flush();
+}
+
+/**
+	Manipulator that makes each output operation write through to bitbuf;
+	see ostream::unitbuf(bool).
+
+	\param[in,out] obs Output stream.
+	\return Reference to ostream parameter.
+*/
+inline ostream &unitbuf(ostream &obs)
+{
+	return obs.unitbuf(true);
+}
+
+/**
+	Manipulator that makes output operations collect bits before writing
+	them to bitbuf; see ostream::unitbuf(bool).
+
+	\param[in,out] obs Output stream.
+	\return Reference to ostream parameter.
+*/
+inline ostream &nounitbuf(ostream &obs)
+{
+	return obs.unitbuf(false);
+}
+
 // Operator overloads /////////////////////////////////////////////////////////
 
 /**
@@ -224,7 +538,7 @@ private:
 */
 inline ostream &operator<<(ostream &obs, bool b)
 {
-    return obs.write(b != 0, 1);
+    return obs.write<1>(b != 0);
 }
 
 // Templates //////////////////////////////////////////////////////////////////
@@ -241,7 +555,7 @@ inline ostream &operator<<(ostream &obs, bool b)
 template <size_t N>
 ostream &operator<<(ostream &obs, std::bitset<N> &bs)
 {
-    return obs.write(bs.to_ulong(), N);
+    return obs << static_cast<const std::bitset<N> &>(bs);
 }
 
 /**
@@ -252,9 +566,29 @@ ostream &operator<<(ostream &obs, std::bitset<N> &bs)
 	\return Reference to ostream parameter.
 */
 template <size_t N>
-ostream &operator<<(ostream &obs, const std::bitset<N> &bs)
+typename boost::enable_if_c<(N <= sizeof(bitfield) * CHAR_BIT), ostream &>::type
+operator<<(ostream &obs, const std::bitset<N> &bs)
 {
-	return obs.write(bs.to_ulong(), N);
+	return obs.write<N>(bs.to_ullong());
+}
+
+/**
+	Put bits from bitset wider than bitfield to output stream.
+
+	\note See ostream::write_wide().
+
+	\param[in,out] obs Reference to ostream on left-hand side of operator.
+	\param[in] bs bitset on right-hand side of operator.
+	\return Reference to ostream parameter.
+*/
+template <size_t N>
+typename boost::enable_if_c<(N > sizeof(bitfield) * CHAR_BIT), ostream &>::type
+operator<<(ostream &obs, const std::bitset<N> &bs)
+{
+	unsigned char bytes[(N + CHAR_BIT - 1) / CHAR_BIT];
+	detail::bitset_to_bytes(bs, obs.rdbuf()->order(), bytes);
+
+	return obs.write_wide(bytes, N);
 }
 
 /**
@@ -271,24 +605,24 @@ typename boost::enable_if_c<
 >::type
 operator<<(ostream &obs, const T &b)
 {
-	return obs.write(static_cast<bitfield>(b), sizeof(T) * CHAR_BIT);
+	return obs.write<sizeof(T) * CHAR_BIT>(static_cast<bitfield>(b));
 }
 
-// Templates for sequence containers //////////////////////////////////////////
+// Templates for inserting elements of sequence containers ////////////////////
 
 /**
-	Put bit fields from containter to output stream.
+	Put bit fields from each element of container to output stream.
 
-	\param[in,out] obs Reference to ostream on left-hand side of operator.
-	\param[in] c Container on right-hand side of operator.
+	\param[in,out] obs Reference to ostream.
+	\param[in] c Container.
 	\return Reference to ostream parameter.
 */
 template <typename C>
 typename boost::enable_if_c<
-	boost::spirit::traits::is_container<C>::value,
+	!is_contiguous_integral<C>::value,
 	ostream &
 >::type
-operator<<(ostream &obs, C &c)
+insert_elements(ostream &obs, const C &c)
 {
 	for (BOOST_AUTO_TPL(it, c.begin()); it != c.end(); ++it)
 	{
@@ -299,27 +633,119 @@ operator<<(ostream &obs, C &c)
 }
 
 /**
-	Put bit fields from containter to output stream.
+	Put bit fields from each element of container whose integral elements
+	are contiguous to output stream.
 
-	\param[in,out] obs Reference to ostream on left-hand side of operator.
-	\param[in] c Container on right-hand side of operator.
+	\note See ostream::write(const T *, size_t).
+
+	\param[in,out] obs Reference to ostream.
+	\param[in] c Container.
 	\return Reference to ostream parameter.
 */
 template <typename C>
 typename boost::enable_if_c<
-	boost::spirit::traits::is_container<C>::value,
+	is_contiguous_integral<C>::value,
 	ostream &
 >::type
-operator<<(ostream &obs, const C &c)
+insert_elements(ostream &obs, const C &c)
 {
+	return c.empty() ? obs : obs.write(&c[0], c.size());
+}
+
+/**
+	Put bit fields from each element of container of std::bitset<N> to
+	output stream.
+
+	\note The bitsets are converted to integrals a block at a time and
+	inserted with ostream::write_packed(). This is only for bitsets that fit
+	bitfield; wider ones are inserted one at a time.
+
+	\param[in,out] obs Reference to ostream.
+	\param[in] c Container.
+	\return Reference to ostream parameter.
+*/
+template <size_t N, typename C>
+ostream &insert_bitsets(ostream &obs, const C &c)
+{
+	// Fields of up to 16 bits are packed from 16-bit integrals, which have
+	// SIMD kernels.
+	typedef typename boost::uint_t<(N < 16 ? 16 : N)>::least integral_type;
+
+	integral_type block[256];
+	size_t count = 0;
 	for (BOOST_AUTO_TPL(it, c.begin()); it != c.end(); ++it)
 	{
-		obs << *it;
+		block[count++] = static_cast<integral_type>(it->to_ullong());
+		if (count == sizeof block / sizeof block[0])
+		{
+			obs.write_packed<N>(block, count);
+			count = 0;
+		}
 	}
+	obs.write_packed<N>(block, count);
 
 	return obs;
 }
 
+template <size_t N, typename Allocator>
+typename boost::enable_if_c<(N <= sizeof(bitfield) * CHAR_BIT), ostream &>::type
+insert_elements(ostream &obs, const std::vector<std::bitset<N>, Allocator> &c)
+{
+	return insert_bitsets<N>(obs, c);
+}
+
+template <size_t N, std::size_t M>
+typename boost::enable_if_c<(N <= sizeof(bitfield) * CHAR_BIT), ostream &>::type
+insert_elements(ostream &obs, const boost::array<std::bitset<N>, M> &c)
+{
+	return insert_bitsets<N>(obs, c);
+}
+
+#ifndef BOOST_NO_CXX11_HDR_ARRAY
+template <size_t N, std::size_t M>
+typename boost::enable_if_c<(N <= sizeof(bitfield) * CHAR_BIT), ostream &>::type
+insert_elements(ostream &obs, const std::array<std::bitset<N>, M> &c)
+{
+	return insert_bitsets<N>(obs, c);
+}
+#endif
+
+// Templates for sequence containers //////////////////////////////////////////
+
+/**
+	Put bit fields from containter to output stream.
+
+	\param[in,out] obs Reference to ostream on left-hand side of operator.
+	\param[in] c Container on right-hand side of operator.
+	\return Reference to ostream parameter.
+*/
+template <typename C>
+typename boost::enable_if_c<
+	boost::spirit::traits::is_container<C>::value,
+	ostream &
+>::type
+operator<<(ostream &obs, C &c)
+{
+	return insert_elements(obs, c);
+}
+
+/**
+	Put bit fields from containter to output stream.
+
+	\param[in,out] obs Reference to ostream on left-hand side of operator.
+	\param[in] c Container on right-hand side of operator.
+	\return Reference to ostream parameter.
+*/
+template <typename C>
+typename boost::enable_if_c<
+	boost::spirit::traits::is_container<C>::value,
+	ostream &
+>::type
+operator<<(ostream &obs, const C &c)
+{
+	return insert_elements(obs, c);
+}
+
 } // namespace bitstream
 
 } // namespace boost
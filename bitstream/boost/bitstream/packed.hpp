@@ -0,0 +1,614 @@
+/** \file
+    \brief Kernels for arrays of packed bit fields.
+    \details This header file contains the kernels that bitbuf uses to
+        unpack and pack arrays of equal-width bit fields. Which instruction
+        set is used is decided at compile time from the target: for
+        unpacking, AVX2, else SSE4.1, else little-endian AArch64 NEON; for
+        packing, SSE2 or NEON. Without them, or if BOOST_BITSTREAM_NO_SIMD is
+        defined, only the scalar code is used.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_PACKED_HPP
+#define BOOST_BITSTREAM_PACKED_HPP
+
+#include <boost/cstdint.hpp>
+#include <boost/endian/conversion.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/type_traits/integral_constant.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+
+#if !defined(BOOST_BITSTREAM_NO_SIMD)
+#if defined(__AVX2__)
+#define BOOST_BITSTREAM_AVX2
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#define BOOST_BITSTREAM_SSE4_1
+#include <smmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__) && !defined(__ARM_BIG_ENDIAN)
+#define BOOST_BITSTREAM_NEON
+#include <arm_neon.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || \
+	(defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BOOST_BITSTREAM_SSE2
+#include <emmintrin.h>
+#endif
+#endif
+
+namespace boost {
+
+namespace bitstream {
+
+namespace detail {
+
+// Unpacking //////////////////////////////////////////////////////////////////
+
+/**
+	The value member of this class expresses whether there is a SIMD kernel
+	that unpacks N-bit fields into integrals of type T.
+
+	\note Each field is gathered into a 32-bit lane along with the bits that
+	precede it in its first byte, so fields are at most 25 bits wide.
+	Integrals must be 16 or 32 bits.
+
+	\param[out] value Whether such a kernel exists.
+*/
+template <size_t N, typename T>
+struct has_unpack_kernel : boost::integral_constant<bool,
+#if defined(BOOST_BITSTREAM_AVX2) || defined(BOOST_BITSTREAM_SSE4_1) || \
+	defined(BOOST_BITSTREAM_NEON)
+	boost::is_integral<T>::value && (sizeof(T) == 2 || sizeof(T) == 4) &&
+	N <= 25 && N <= sizeof(T) * CHAR_BIT
+#else
+	false
+#endif
+	>
+{
+};
+
+/**
+	Byte-shuffle and shift controls for unpacking a batch of eight N-bit
+	fields.
+
+	\note The batch is loaded as two 16-byte halves of four fields each. The
+	first half starts at the first byte of the batch and the second half at
+	byte second_half. For field j, the shuffle puts its four bytes into 32-bit
+	lane j, most significant byte first, so that shifting the lane left by
+	shift[j] and then right by 32 - N leaves just the field.
+
+	Because eight fields are exactly N bytes, every batch starts at the same
+	bit offset within its first byte, so one set of controls serves them all.
+*/
+template <size_t N>
+struct unpack_controls
+{
+	/**
+		Constructor.
+
+		\param[in] offset Bit position of first field within its first byte,
+		where 0 is the MSB.
+	*/
+	explicit unpack_controls(size_t offset) :
+		second_half((offset + 4 * N) / CHAR_BIT)
+	{
+		for (size_t j = 0; j < 8; ++j)
+		{
+			const size_t start = offset + j * N -
+				(j < 4 ? 0 : second_half * CHAR_BIT);
+			for (size_t k = 0; k < 4; ++k)
+			{
+				shuffle[j * 4 + k] =
+					static_cast<unsigned char>(start / CHAR_BIT + 3 - k);
+			}
+			shift[j] = static_cast<boost::int32_t>(start % CHAR_BIT);
+		}
+	}
+
+	/**
+		Offset of second half of batch in bytes.
+	*/
+	size_t second_half;
+
+	/**
+		Shuffle controls for first half, followed by second half.
+	*/
+	unsigned char shuffle[32];
+
+	/**
+		Left shift for each lane.
+	*/
+	boost::int32_t shift[8];
+};
+
+/**
+	Unpack N-bit fields into integrals, eight at a time, for as long as there
+	are at least eight fields left.
+
+	\note This is the version for when there is no SIMD kernel; it unpacks
+	nothing.
+
+	\return Number of fields unpacked, always 0.
+*/
+template <size_t N, typename T>
+size_t unpack(const unsigned char *, size_t, T *, size_t, size_t,
+	boost::false_type)
+{
+	return 0;
+}
+
+#if defined(BOOST_BITSTREAM_AVX2)
+
+inline void store_unpacked(boost::uint32_t *values, __m256i lanes)
+{
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(values), lanes);
+}
+
+inline void store_unpacked(boost::uint16_t *values, __m256i lanes)
+{
+	// The pack works within each 128-bit half, so gather the two results.
+	const __m256i packed = _mm256_permute4x64_epi64(
+		_mm256_packus_epi32(lanes, lanes), 0x08);
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(values),
+		_mm256_castsi256_si128(packed));
+}
+
+#elif defined(BOOST_BITSTREAM_SSE4_1)
+
+inline void store_unpacked(boost::uint32_t *values, __m128i low, __m128i high)
+{
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(values), low);
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(values + 4), high);
+}
+
+inline void store_unpacked(boost::uint16_t *values, __m128i low, __m128i high)
+{
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(values),
+		_mm_packus_epi32(low, high));
+}
+
+#elif defined(BOOST_BITSTREAM_NEON)
+
+inline void store_unpacked(boost::uint32_t *values, uint32x4_t low,
+	uint32x4_t high)
+{
+	vst1q_u32(values, low);
+	vst1q_u32(values + 4, high);
+}
+
+inline void store_unpacked(boost::uint16_t *values, uint32x4_t low,
+	uint32x4_t high)
+{
+	vst1q_u16(values, vcombine_u16(vmovn_u32(low), vmovn_u32(high)));
+}
+
+#endif
+
+#if defined(BOOST_BITSTREAM_AVX2) || defined(BOOST_BITSTREAM_SSE4_1) || \
+	defined(BOOST_BITSTREAM_NEON)
+
+/**
+	Unpack N-bit fields into integrals, eight at a time, for as long as there
+	are at least eight fields left.
+
+	\note Each batch does two unaligned 16-byte loads, so this stops early
+	enough that the loads stay within byte_count bytes; the caller unpacks
+	whatever is left.
+
+	\param[in] byte_pointer Pointer to byte containing first field.
+	\param[in] offset Bit position of first field within *byte_pointer.
+	\param[out] values Array to receive integrals.
+	\param[in] count Number of fields.
+	\param[in] byte_count Number of bytes that may be read at byte_pointer.
+	\return Number of fields unpacked, a multiple of eight.
+*/
+template <size_t N, typename T>
+size_t unpack(const unsigned char *byte_pointer, size_t offset, T *values,
+	size_t count, size_t byte_count, boost::true_type)
+{
+	// Store through the unsigned type of the same size; the bits are the same.
+	typedef typename boost::mpl::if_c<sizeof(T) == 2,
+		boost::uint16_t, boost::uint32_t>::type lane_type;
+
+	size_t i = 0;
+
+	if (count >= 8)
+	{
+		const unpack_controls<N> controls(offset);
+		const size_t load_bytes = controls.second_half + 16;
+		const unsigned char *p = byte_pointer;
+
+#if defined(BOOST_BITSTREAM_AVX2)
+		const __m256i shuffle = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i *>(controls.shuffle));
+		const __m256i shift = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i *>(controls.shift));
+#elif defined(BOOST_BITSTREAM_SSE4_1)
+		// There is no variable shift before AVX2, so multiply by 2^shift.
+		boost::int32_t multiplier[8];
+		for (size_t j = 0; j < 8; ++j)
+		{
+			multiplier[j] = boost::int32_t(1) << controls.shift[j];
+		}
+		const __m128i shuffle_low = _mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(controls.shuffle));
+		const __m128i shuffle_high = _mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(controls.shuffle + 16));
+		const __m128i multiplier_low = _mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(multiplier));
+		const __m128i multiplier_high = _mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(multiplier + 4));
+#elif defined(BOOST_BITSTREAM_NEON)
+		const uint8x16_t shuffle_low = vld1q_u8(controls.shuffle);
+		const uint8x16_t shuffle_high = vld1q_u8(controls.shuffle + 16);
+		const int32x4_t shift_low = vld1q_s32(controls.shift);
+		const int32x4_t shift_high = vld1q_s32(controls.shift + 4);
+		const int32x4_t shift_right = vdupq_n_s32(-static_cast<int>(32 - N));
+#endif
+
+		for (; i + 8 <= count &&
+			static_cast<size_t>(p - byte_pointer) + load_bytes <= byte_count;
+			i += 8, p += N)
+		{
+			lane_type * const out = reinterpret_cast<lane_type *>(values + i);
+#if defined(BOOST_BITSTREAM_AVX2)
+			const __m256i bytes = _mm256_inserti128_si256(
+				_mm256_castsi128_si256(
+					_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))),
+				_mm_loadu_si128(reinterpret_cast<const __m128i *>(
+					p + controls.second_half)), 1);
+			const __m256i lanes = _mm256_srli_epi32(_mm256_sllv_epi32(
+				_mm256_shuffle_epi8(bytes, shuffle), shift), 32 - N);
+			store_unpacked(out, lanes);
+#elif defined(BOOST_BITSTREAM_SSE4_1)
+			const __m128i low = _mm_srli_epi32(_mm_mullo_epi32(
+				_mm_shuffle_epi8(_mm_loadu_si128(
+					reinterpret_cast<const __m128i *>(p)), shuffle_low),
+				multiplier_low), 32 - N);
+			const __m128i high = _mm_srli_epi32(_mm_mullo_epi32(
+				_mm_shuffle_epi8(_mm_loadu_si128(
+					reinterpret_cast<const __m128i *>(p + controls.second_half)),
+					shuffle_high),
+				multiplier_high), 32 - N);
+			store_unpacked(out, low, high);
+#elif defined(BOOST_BITSTREAM_NEON)
+			const uint32x4_t low = vshlq_u32(vshlq_u32(vreinterpretq_u32_u8(
+				vqtbl1q_u8(vld1q_u8(p), shuffle_low)), shift_low), shift_right);
+			const uint32x4_t high = vshlq_u32(vshlq_u32(vreinterpretq_u32_u8(
+				vqtbl1q_u8(vld1q_u8(p + controls.second_half), shuffle_high)),
+				shift_high), shift_right);
+			store_unpacked(out, low, high);
+#endif
+		}
+	}
+
+	return i;
+}
+
+#endif
+
+/**
+	Unpack N-bit fields into integrals, eight at a time, for as long as there
+	are at least eight fields left.
+
+	\param[in] byte_pointer Pointer to byte containing first field.
+	\param[in] offset Bit position of first field within *byte_pointer.
+	\param[out] values Array to receive integrals.
+	\param[in] count Number of fields.
+	\param[in] byte_count Number of bytes that may be read at byte_pointer.
+	\return Number of fields unpacked; those left are for the caller.
+*/
+template <size_t N, typename T>
+size_t unpack(const unsigned char *byte_pointer, size_t offset, T *values,
+	size_t count, size_t byte_count)
+{
+	return unpack<N>(byte_pointer, offset, values, count, byte_count,
+		has_unpack_kernel<N, T>());
+}
+
+// Packing ////////////////////////////////////////////////////////////////////
+
+/**
+	Register that collects bit fields and stores them a big-endian 64-bit
+	word at a time.
+
+	\note Every byte is written once: the bits that precede the first field
+	in its byte are loaded into the register up front, and the bits that
+	follow the last field in its byte are preserved by flush().
+*/
+class pack_register
+{
+public:
+	/**
+		Constructor.
+
+		\param[in] byte_pointer Pointer to byte to contain first field.
+		\param[in] offset Bit position of first field within *byte_pointer,
+		where 0 is the MSB.
+	*/
+	pack_register(unsigned char *byte_pointer, size_t offset) :
+		m_byte_pointer(byte_pointer),
+		m_value(offset == 0 ? 0 : *byte_pointer >> (CHAR_BIT - offset)),
+		m_bits(offset)
+	{
+	}
+
+	/**
+		Append bit field.
+
+		\param[in] field Value of bit field, with no bits above size.
+		\param[in] size Number of bits in bit field, 1 through 64.
+	*/
+	void put(boost::uint64_t field, size_t size)
+	{
+		static const size_t register_bits = sizeof m_value * CHAR_BIT;
+
+		const size_t room = register_bits - m_bits;
+
+		if (size < room)
+		{
+			m_value = (m_value << size) | field;
+			m_bits += size;
+		}
+		else
+		{
+			const size_t left_over = size - room;
+			boost::uint64_t word = room == register_bits ? field :
+				(m_value << room) | (field >> left_over);
+			boost::endian::native_to_big_inplace(word);
+			std::memcpy(m_byte_pointer, &word, sizeof word);
+			m_byte_pointer += sizeof word;
+
+			m_value = left_over == 0 ? 0 :
+				field & (~boost::uint64_t(0) >> (register_bits - left_over));
+			m_bits = left_over;
+		}
+	}
+
+	/**
+		Store bits still in register.
+	*/
+	void flush()
+	{
+		for (; m_bits >= CHAR_BIT; m_bits -= CHAR_BIT)
+		{
+			*m_byte_pointer++ =
+				static_cast<unsigned char>(m_value >> (m_bits - CHAR_BIT));
+		}
+
+		if (m_bits > 0)
+		{
+			const size_t shift_amount = CHAR_BIT - m_bits;
+			*m_byte_pointer = static_cast<unsigned char>(
+				(*m_byte_pointer & ((1u << shift_amount) - 1)) |
+				(m_value << shift_amount));
+			m_bits = 0;
+		}
+	}
+
+private:
+	/**
+		Pointer to byte to receive next word.
+	*/
+	unsigned char *m_byte_pointer;
+
+	/**
+		Bits collected, right-justified.
+	*/
+	boost::uint64_t m_value;
+
+	/**
+		Number of bits in m_value.
+	*/
+	size_t m_bits;
+};
+
+/**
+	The value member of this class expresses whether there is a SIMD kernel
+	that packs integrals of type T into N-bit fields.
+
+	\note Four fields are combined into one 64-bit word, so fields are at
+	most 16 bits wide. Integrals must be 16 or 32 bits.
+
+	\param[out] value Whether such a kernel exists.
+*/
+template <size_t N, typename T>
+struct has_pack_kernel : boost::integral_constant<bool,
+#if defined(BOOST_BITSTREAM_SSE2) || defined(BOOST_BITSTREAM_NEON)
+	boost::is_integral<T>::value && (sizeof(T) == 2 || sizeof(T) == 4) &&
+	N <= 16
+#else
+	false
+#endif
+	>
+{
+};
+
+/**
+	Pack integrals into N-bit fields, eight at a time, for as long as there
+	are at least eight integrals left.
+
+	\note This is the version for when there is no SIMD kernel; it packs
+	nothing.
+
+	\return Number of integrals packed, always 0.
+*/
+template <size_t N, typename T>
+size_t pack(pack_register &, const T *, size_t, boost::false_type)
+{
+	return 0;
+}
+
+#if defined(BOOST_BITSTREAM_SSE2)
+
+inline void load_packable(const boost::uint32_t *values, __m128i &low,
+	__m128i &high)
+{
+	low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+	high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + 4));
+}
+
+inline void load_packable(const boost::uint16_t *values, __m128i &low,
+	__m128i &high)
+{
+	const __m128i words =
+		_mm_loadu_si128(reinterpret_cast<const __m128i *>(values));
+	low = _mm_unpacklo_epi16(words, _mm_setzero_si128());
+	high = _mm_unpackhi_epi16(words, _mm_setzero_si128());
+}
+
+/**
+	In each 64-bit lane, combine the field in the low 32 bits, which comes
+	first, with the field in the high 32 bits.
+*/
+inline __m128i pack_pairs(__m128i lanes, int size)
+{
+	const __m128i low_words = _mm_set_epi32(0, -1, 0, -1);
+	return _mm_or_si128(_mm_slli_epi64(_mm_and_si128(lanes, low_words), size),
+		_mm_srli_epi64(lanes, 32));
+}
+
+#elif defined(BOOST_BITSTREAM_NEON)
+
+inline void load_packable(const boost::uint32_t *values, uint32x4_t &low,
+	uint32x4_t &high)
+{
+	low = vld1q_u32(values);
+	high = vld1q_u32(values + 4);
+}
+
+inline void load_packable(const boost::uint16_t *values, uint32x4_t &low,
+	uint32x4_t &high)
+{
+	const uint16x8_t words = vld1q_u16(values);
+	low = vmovl_u16(vget_low_u16(words));
+	high = vmovl_u16(vget_high_u16(words));
+}
+
+/**
+	In each 64-bit lane, combine the field in the low 32 bits, which comes
+	first, with the field in the high 32 bits.
+*/
+inline uint64x2_t pack_pairs(uint64x2_t lanes, int size)
+{
+	return vorrq_u64(vshlq_u64(vandq_u64(lanes, vdupq_n_u64(0xffffffff)),
+		vdupq_n_s64(size)), vshrq_n_u64(lanes, 32));
+}
+
+#endif
+
+#if defined(BOOST_BITSTREAM_SSE2) || defined(BOOST_BITSTREAM_NEON)
+
+/**
+	Pack integrals into N-bit fields, eight at a time, for as long as there
+	are at least eight integrals left.
+
+	\note Fields are combined pairwise, first into 2N-bit and then into
+	4N-bit values, so each batch of eight is two appends to the register
+	instead of eight.
+
+	\param[in,out] bits Register to receive fields.
+	\param[in] values Array of integrals.
+	\param[in] count Number of integrals.
+	\return Number of integrals packed, a multiple of eight.
+*/
+template <size_t N, typename T>
+size_t pack(pack_register &bits, const T *values, size_t count,
+	boost::true_type)
+{
+	// Load through the unsigned type of the same size; the bits are the same.
+	typedef typename boost::mpl::if_c<sizeof(T) == 2,
+		boost::uint16_t, boost::uint32_t>::type lane_type;
+
+	size_t i = 0;
+
+#if defined(BOOST_BITSTREAM_SSE2)
+	const __m128i mask = _mm_set1_epi32(static_cast<int>((1u << N) - 1));
+	for (; i + 8 <= count; i += 8)
+	{
+		__m128i low, high;
+		load_packable(reinterpret_cast<const lane_type *>(values + i),
+			low, high);
+		low = pack_pairs(_mm_and_si128(low, mask), N);
+		high = pack_pairs(_mm_and_si128(high, mask), N);
+
+		// Gather the four 2N-bit values so that each lane holds a pair.
+		const __m128i pairs = _mm_castps_si128(_mm_shuffle_ps(
+			_mm_castsi128_ps(low), _mm_castsi128_ps(high),
+			_MM_SHUFFLE(2, 0, 2, 0)));
+
+		boost::uint64_t quads[2];
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(quads),
+			pack_pairs(pairs, 2 * N));
+		bits.put(quads[0], 4 * N);
+		bits.put(quads[1], 4 * N);
+	}
+#elif defined(BOOST_BITSTREAM_NEON)
+	const uint32x4_t mask = vdupq_n_u32((1u << N) - 1);
+	for (; i + 8 <= count; i += 8)
+	{
+		uint32x4_t low, high;
+		load_packable(reinterpret_cast<const lane_type *>(values + i),
+			low, high);
+		const uint64x2_t low_pairs =
+			pack_pairs(vreinterpretq_u64_u32(vandq_u32(low, mask)), N);
+		const uint64x2_t high_pairs =
+			pack_pairs(vreinterpretq_u64_u32(vandq_u32(high, mask)), N);
+
+		// Gather the four 2N-bit values so that each lane holds a pair.
+		const uint64x2_t quads = pack_pairs(vreinterpretq_u64_u32(vuzp1q_u32(
+			vreinterpretq_u32_u64(low_pairs),
+			vreinterpretq_u32_u64(high_pairs))), 2 * N);
+		bits.put(vgetq_lane_u64(quads, 0), 4 * N);
+		bits.put(vgetq_lane_u64(quads, 1), 4 * N);
+	}
+#endif
+
+	return i;
+}
+
+#endif
+
+/**
+	Pack integrals into N-bit fields, back to back.
+
+	\pre All the bits lie within the accessible sequence.
+
+	\param[in] byte_pointer Pointer to byte to contain first field.
+	\param[in] offset Bit position of first field within *byte_pointer.
+	\param[in] values Array of integrals.
+	\param[in] count Number of integrals.
+*/
+template <size_t N, typename T>
+void pack(unsigned char *byte_pointer, size_t offset, const T *values,
+	size_t count)
+{
+	static const boost::uint64_t mask =
+		~boost::uint64_t(0) >> (sizeof(boost::uint64_t) * CHAR_BIT - N);
+
+	pack_register bits(byte_pointer, offset);
+
+	size_t i = pack<N>(bits, values, count, has_pack_kernel<N, T>());
+	for (; i < count; ++i)
+	{
+		bits.put(static_cast<boost::uint64_t>(values[i]) & mask, N);
+	}
+
+	bits.flush();
+}
+
+} // namespace detail
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
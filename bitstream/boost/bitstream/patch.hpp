@@ -0,0 +1,269 @@
+/** \file
+    \brief Prebuilt packets with fields patched in place.
+    \details This header file contains a handle to a field of encoded bits,
+        a manipulator that captures one while encoding, and a packet
+        template whose fields are then patched directly.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_PATCH_HPP
+#define BOOST_BITSTREAM_PATCH_HPP
+
+#include <boost/bitstream/ostream.hpp>
+#include <boost/assert.hpp>
+#include <cstring>
+#include <vector>
+
+namespace boost {
+
+namespace bitstream {
+
+// field_handle ///////////////////////////////////////////////////////////////
+
+/**
+    This class identifies a field of encoded bits by where it is.
+*/
+struct field_handle
+{
+	/**
+		Constructor.
+
+		\param[in] position_ Bit position of field.
+		\param[in] bits_ Number of bits in field.
+	*/
+	field_handle(bitpos position_ = 0, std::streamsize bits_ = 0) :
+		position(position_), bits(bits_)
+	{
+		// Do nothing.
+	}
+
+	/**
+		Bit position of field from start of encoded bits.
+	*/
+	bitpos position;
+
+	/**
+		Number of bits in field, 1 through the number of bits in bitfield.
+	*/
+	std::streamsize bits;
+};
+
+// mark_field /////////////////////////////////////////////////////////////////
+
+/**
+    This class represents the mark_field bit-stream manipulator, which
+	captures the handle of the field inserted next, e.g.,
+	\code
+	boost::bitstream::field_handle sequence, timestamp;
+	out << version << padding << extension << csrc_count << marker <<
+		payload_type << boost::bitstream::mark_field(sequence, 16) <<
+		sequence_number << boost::bitstream::mark_field(timestamp, 32) <<
+		timestamp_value << ssrc;
+	\endcode
+*/
+class mark_field
+{
+public:
+	/**
+		Constructor.
+
+		\param[out] handle Handle to receive position of field.
+		\param[in] bits Number of bits in field.
+	*/
+	mark_field(field_handle &handle, std::streamsize bits) :
+		m_handle(handle), m_bits(bits)
+	{
+		// Do nothing.
+	}
+
+	/**
+		Overload for the (ostream &) operator on this class.
+
+		\param[in,out] obs Reference to ostream on lhs of << operator.
+		\return Reference to ostream parameter.
+	*/
+	ostream &operator()(ostream &obs) const
+	{
+		m_handle.position = std::streamoff(obs.tellp());
+		m_handle.bits = m_bits;
+
+		return obs;
+	}
+
+private:
+	/**
+		Handle to receive position of field.
+	*/
+	field_handle &m_handle;
+
+	/**
+		Number of bits in field.
+	*/
+	std::streamsize m_bits;
+};
+
+/**
+	Manipulator for ostream that captures the handle of the field inserted
+	next.
+
+	\param[in,out] obs Reference to ostream on left-hand side of operator.
+	\param[in] mark Instance of mark_field class.
+	\return Reference to ostream parameter.
+*/
+inline ostream &operator<<(ostream &obs, const mark_field &mark)
+{
+	return mark(obs);
+}
+
+// packet_template ////////////////////////////////////////////////////////////
+
+/**
+    This class holds a packet encoded once, whose fields are patched in
+	place for each packet sent, e.g.,
+	\code
+	boost::bitstream::packet_template header(out.data(), out.bits());
+	for (;;)
+	{
+		header.copy(packet);
+		header.patch(packet, sequence, sequence_number++);
+		header.patch(packet, timestamp, now());
+		send(packet);
+	}
+	\endcode
+
+	\note A patch is a masked store of the field into the bytes it spans,
+	with no stream, seek or virtual call; the other bits are left as they
+	are.
+*/
+class packet_template
+{
+public:
+	/**
+		Constructor.
+
+		\param[in] buffer Pointer to char array of encoded bits, copied.
+		\param[in] bits Number of encoded bits.
+		\param[in] order Order in which bits were encoded.
+	*/
+	packet_template(const char *buffer, std::streamsize bits,
+		bit_order order = msb_first) :
+		m_bytes(buffer, buffer + (static_cast<size_t>(bits) + CHAR_BIT - 1) / CHAR_BIT),
+		m_bits(bits), m_order(order)
+	{
+		// Do nothing.
+	}
+
+	/**
+		Get encoded bits.
+
+		\return Pointer to char array of template.
+	*/
+	const char *data() const
+	{
+		return m_bytes.empty() ? NULL : reinterpret_cast<const char *>(&m_bytes[0]);
+	}
+
+	/**
+		Get number of encoded bits.
+
+		\return Number of bits in template.
+	*/
+	std::streamsize bits() const
+	{
+		return m_bits;
+	}
+
+	/**
+		Get number of bytes spanned by encoded bits.
+
+		\return Number of bytes in template.
+	*/
+	size_t size() const
+	{
+		return m_bytes.size();
+	}
+
+	/**
+		Copy template to a packet.
+
+		\param[out] buffer Pointer to char array of at least size() bytes.
+	*/
+	void copy(char *buffer) const
+	{
+		if (!m_bytes.empty())
+		{
+			std::memcpy(buffer, &m_bytes[0], m_bytes.size());
+		}
+	}
+
+	/**
+		Patch a field of a copy of the template.
+
+		\pre field lies within the template and has 1 through the number of
+		bits in bitfield.
+
+		\param[in,out] buffer Pointer to char array copied from template.
+		\param[in] field Handle of field to patch.
+		\param[in] value New value of field; bits above its size are ignored.
+	*/
+	void patch(char *buffer, const field_handle &field, bitfield value) const
+	{
+		BOOST_ASSERT(field.bits > 0 &&
+			field.bits <= static_cast<std::streamsize>(sizeof value * CHAR_BIT) &&
+			field.position >= 0 && field.position + field.bits <= m_bits);
+
+		unsigned char * const byte_pointer =
+			reinterpret_cast<unsigned char *>(buffer) + field.position / CHAR_BIT;
+		const size_t intra_byte_bit_offset = static_cast<size_t>(field.position % CHAR_BIT);
+		const size_t byte_count = bitbuf::bytes_remaining(field.position, m_bits);
+
+		if (m_order == msb_first)
+		{
+			bitbuf::put_bits(byte_pointer, intra_byte_bit_offset,
+				static_cast<size_t>(field.bits), value, byte_count);
+		}
+		else
+		{
+			bitbuf::put_lsb_bits(byte_pointer, intra_byte_bit_offset,
+				static_cast<size_t>(field.bits), value, byte_count);
+		}
+	}
+
+	/**
+		Patch a field of the template itself.
+
+		\param[in] field Handle of field to patch.
+		\param[in] value New value of field; bits above its size are ignored.
+	*/
+	void patch(const field_handle &field, bitfield value)
+	{
+		patch(reinterpret_cast<char *>(&m_bytes[0]), field, value);
+	}
+
+private:
+	/**
+		Encoded bits.
+	*/
+	std::vector<unsigned char> m_bytes;
+
+	/**
+		Number of encoded bits.
+	*/
+	std::streamsize m_bits;
+
+	/**
+		Order in which bits were encoded.
+	*/
+	bit_order m_order;
+};
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
@@ -0,0 +1,682 @@
+/** \file
+    \brief Bit-stream ring buffer shared by a writing and a reading thread.
+    \details This header file contains a bitbuf on a ring of bytes into which
+        one thread writes while another thread reads, without locks.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_RINGBUF_HPP
+#define BOOST_BITSTREAM_RINGBUF_HPP
+
+#include <boost/bitstream/iob.hpp>
+#include <boost/atomic.hpp>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace boost {
+
+namespace bitstream {
+
+namespace detail {
+
+/**
+    This class holds a bit position published by one thread to another,
+	alone in its cache line, so that the two threads' positions do not
+	share one.
+*/
+struct ring_position
+{
+	/**
+		Constructor.
+	*/
+	ring_position() : value(0)
+	{
+		// Do nothing.
+	}
+
+	/**
+		Padding before position.
+	*/
+	char leading[cache_line_bytes];
+
+	/**
+		Bit position.
+	*/
+	boost::atomic<bitpos> value;
+
+	/**
+		Padding after position.
+	*/
+	char trailing[cache_line_bytes - sizeof(boost::atomic<bitpos>) % cache_line_bytes];
+};
+
+} // namespace detail
+
+// basic_ringbitbuf ///////////////////////////////////////////////////////////
+
+/**
+    This class represents a sequence of bits on a ring of bytes, written by a
+	producer thread through an obitstream and read by a consumer thread
+	through an ibitstream, e.g.,
+	\code
+	boost::bitstream::ringbitbuf ring(65536);
+
+	// Capture thread.
+	boost::bitstream::ostream out(&ring);
+	if (ring.writable() >= packet_bits)
+	{
+		out << header << payload << boost::bitstream::flush;
+	}
+
+	// Decoder thread.
+	boost::bitstream::istream in(&ring);
+	if (ring.readable() >= header_bits)
+	{
+		in >> header;
+	}
+	\endcode
+
+	\note The get area belongs to the consumer and the put area to the
+	producer; each thread only touches its own. Positions are absolute bit
+	counts since construction, so tellg() and tellp() keep growing as the
+	ring wraps. Fields that straddle the end of the ring are split in two.
+
+	\note Bits written are published to the consumer in a batch by sync(),
+	i.e., ostream::flush(), up to the last whole byte. The bits of a byte
+	still being written follow with it, or with close(). Bits read are made
+	available to the producer again as the consumer's get area runs out, and
+	by readable().
+
+	\note The positions published between the threads are each on cache
+	lines of their own, as are this class's consumer and producer variables.
+	The get and put positions in bitbuf, which the threads advance with
+	every field, are only separated if BOOST_BITSTREAM_PAD_AREAS is defined
+	(see bitbuf); otherwise they share a cache line, which then bounces
+	between the threads.
+
+	\note Neither side waits. Writing more than writable() bits fails, as
+	does reading more than readable(); the threads check these, or wait on
+	them, before a batch. The producer flushes before it waits for room.
+
+	\note sync() is for the producer; the consumer must not call
+	istream::sync() on this buffer. Seeking is forward only, and on output
+	writes zeros over the bits skipped. Bits can be put back down to the
+	last byte made available to the producer. Set order() before the
+	threads start.
+
+	\note With BOOST_BITSTREAM_STATS, each thread counts in its own side of
+	stats(), but take a snapshot, or reset_stats(), only while neither
+	thread is using this buffer, e.g., before they start or after they are
+	joined.
+*/
+template <class Allocator = std::allocator<unsigned char> >
+class basic_ringbitbuf : public bitbuf
+{
+public:
+	/**
+		Type of storage.
+	*/
+	typedef std::vector<unsigned char, Allocator> vector_type;
+
+	/**
+		Constructor.
+
+		\param[in] bytes Number of bytes in ring; at least one.
+		\param[in] allocator Allocator for storage.
+	*/
+	explicit basic_ringbitbuf(typename vector_type::size_type bytes,
+		const Allocator &allocator = Allocator()) :
+		bitbuf(std::ios_base::in | std::ios_base::out),
+		m_ring(std::max(bytes, typename vector_type::size_type(1)), 0, allocator),
+		m_capacity(static_cast<bitpos>(m_ring.size()) * CHAR_BIT),
+		m_closed(false), m_get_base(0), m_produced_seen(0),
+		m_consumed_shown(0), m_put_base(0), m_consumed_seen(0)
+	{
+		setg(&m_ring[0], 0, 0, 0);
+		setp(&m_ring[0], 0, m_capacity);
+	}
+
+	/**
+		Get number of bits in ring.
+
+		\return Most bits that can be written and not yet read.
+	*/
+	std::streamsize capacity() const
+	{
+		return static_cast<std::streamsize>(m_capacity);
+	}
+
+	// Producer functions /////////////////////////////////////////////////////
+
+	/**
+		Get number of bits that can be written.
+
+		\note Call from producer thread.
+
+		\return Number of bits free in ring.
+	*/
+	std::streamsize writable()
+	{
+		refresh_put();
+
+		return static_cast<std::streamsize>(m_consumed_seen + m_capacity -
+			(m_put_base + pptr()));
+	}
+
+	/**
+		Publish every bit written, including those of a partial byte, and
+		mark the end of the input sequence.
+
+		\note Call from producer thread, after flushing the stream; nothing
+		may be written afterwards.
+	*/
+	void close()
+	{
+		m_produced.value.store(m_put_base + pptr(), boost::memory_order_release);
+		m_closed.store(true, boost::memory_order_release);
+	}
+
+	// Consumer functions /////////////////////////////////////////////////////
+
+	/**
+		Get number of bits that can be read.
+
+		\note Call from consumer thread.
+
+		\return Number of bits published and not yet read.
+	*/
+	std::streamsize readable()
+	{
+		refresh_get();
+		show_consumed();
+
+		return static_cast<std::streamsize>(m_produced_seen -
+			(m_get_base + gptr()));
+	}
+
+	/**
+		Determine whether the producer has called close().
+
+		\return Whether nothing more will be published.
+	*/
+	bool closed() const
+	{
+		return m_closed.load(boost::memory_order_acquire);
+	}
+
+protected:
+	// Virtual buffer-management and positioning functions ////////////////////
+
+	/**
+		Set buffer to access.
+
+		\note Not supported; this object owns its storage.
+
+		\return NULL.
+	*/
+	virtual bitbuf *setbuf(unsigned char *, std::streamsize)
+	{
+		return NULL;
+	}
+
+	/**
+		Determine whether slices may be made of the get area.
+
+		\note Not supported. Bytes read are reused by the producer, so a
+		slice of them would be overwritten.
+
+		\return false.
+	*/
+	virtual bool sliceable() const
+	{
+		return false;
+	}
+
+	/**
+		Set get or put pointer relative to current position.
+
+		\note Output takes precedence if which includes it.
+
+		\param[in] offset Amount by which pointer is adjusted.
+		\param[in] way From which pointer offset is applied for new position.
+		\param[in] which Open mode.
+		\return New position after pointer modified.
+	*/
+	virtual std::streampos seekoff(std::streamoff offset,
+		std::ios_base::seekdir way,
+		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+	{
+		bitpos target = -1;
+
+		if ((which & std::ios_base::out) != 0)
+		{
+			if (way == std::ios_base::beg)
+			{
+				target = offset;
+			}
+			else if (way == std::ios_base::cur)
+			{
+				target = m_put_base + pptr() + offset;
+			}
+		}
+		else if ((which & std::ios_base::in) != 0)
+		{
+			switch (way)
+			{
+			case std::ios_base::beg:
+				target = offset;
+				break;
+
+			case std::ios_base::cur:
+				target = m_get_base + gptr() + offset;
+				break;
+
+			case std::ios_base::end:
+				refresh_get();
+				target = m_produced_seen + offset;
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		return target < 0 ? std::streampos(-1) : seekpos(std::streampos(target), which);
+	}
+
+	/**
+		Set get or put pointer to absolute position.
+
+		\note Output takes precedence if which includes it.
+
+		\param[in] position New absolute position for pointer.
+		\param[in] which Open mode.
+		\return New position after pointer modified or std::streampos(-1)
+		if it cannot be reached.
+	*/
+	virtual std::streampos seekpos(std::streampos position,
+		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+	{
+		std::streampos new_position = std::streampos(-1);
+		const bitpos target = std::streamoff(position);
+
+		if ((which & std::ios_base::out) != 0)
+		{
+			bitpos remaining = target - (m_put_base + pptr());
+
+			if (remaining >= 0 && remaining <= writable())
+			{
+				// Stale bits of the ring are not left in the sequence.
+				while (remaining > 0)
+				{
+					const bitpos bits = std::min(remaining,
+						static_cast<bitpos>(sizeof(bitfield) * CHAR_BIT));
+					remaining -= xsputn(0, static_cast<std::streamsize>(bits));
+				}
+				new_position = position;
+			}
+		}
+		else if ((which & std::ios_base::in) != 0)
+		{
+			refresh_get();
+
+			if (target >= m_consumed_shown && target <= m_produced_seen)
+			{
+				m_get_base = target / m_capacity * m_capacity;
+				set_get_area(target - m_get_base);
+				new_position = position;
+			}
+		}
+
+		return new_position;
+	}
+
+	/**
+		Publish bits written to the consumer.
+
+		\note Call from producer thread; see ostream::flush().
+
+		\return 0.
+	*/
+	virtual int sync()
+	{
+		const bitpos written = m_put_base + pptr();
+		m_produced.value.store(written - written % CHAR_BIT, boost::memory_order_release);
+
+		return 0;
+	}
+
+	// Virtual input functions ////////////////////////////////////////////////
+
+	/**
+		Get number of bits available beyond the get area.
+
+		\return Number of bits that can be read; -1 if none and the producer
+		has called close().
+	*/
+	virtual std::streamsize showmanyb()
+	{
+		const bool last = closed();
+		const std::streamsize available = readable();
+
+		return available == 0 && last ? -1 : available;
+	}
+
+	/**
+		Get sequence of bits.
+
+		\param[out] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits read from buffer or zero if error or eof.
+	*/
+	virtual std::streamsize xsgetn(bitfield &value, std::streamsize size)
+	{
+		std::streamsize bits_read;
+
+		if (size <= egptr() - gptr())
+		{
+			bits_read = bitbuf::xsgetn(value, size);
+		}
+		else
+		{
+			bits_read = get_wrapped(value, size);
+			show_consumed();
+		}
+
+		return bits_read;
+	}
+
+	/**
+		Get sequence of bits without advancing get pointer.
+
+		\param[out] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits peeked at or zero if error or eof.
+	*/
+	virtual std::streamsize xspeekn(bitfield &value, std::streamsize size)
+	{
+		const bitpos base = m_get_base;
+		const bitpos next = gptr();
+		const std::streamsize bits_read = get_wrapped(value, size);
+
+		m_get_base = base;
+		set_get_area(next);
+
+		return bits_read;
+	}
+
+	/**
+		Get bit without changing current position.
+
+		\param[out] value Bit at the current position.
+		\return Whether there are more bits to read.
+	*/
+	virtual bool underflow(bitfield &value)
+	{
+		return xspeekn(value, 1) == 1;
+	}
+
+	/**
+		Get bit and advance position.
+
+		\param[out] value Bit at the current position.
+		\return Whether there are more bits to read.
+	*/
+	virtual bool uflow(bitfield &value)
+	{
+		return xsgetn(value, 1) == 1;
+	}
+
+	// Virtual output functions ///////////////////////////////////////////////
+
+	/**
+		Put sequence of bits.
+
+		\param[in] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits written to buffer or zero if error or eof.
+	*/
+	virtual std::streamsize xsputn(bitfield value, std::streamsize size)
+	{
+		return size <= epptr() - pptr() ? bitbuf::xsputn(value, size) :
+			put_wrapped(value, size);
+	}
+
+	/**
+		Put bit and advance position.
+
+		\param[in] b Bit to be put.
+		\return Whether the bit was successully put.
+	*/
+	virtual bool overflow(bitfield b)
+	{
+		return xsputn(b, 1) == 1;
+	}
+
+private:
+	/**
+		Get field whether or not it straddles the end of the ring, without
+		making bits read available to the producer.
+
+		\param[out] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits read from buffer or zero if error or eof.
+	*/
+	std::streamsize get_wrapped(bitfield &value, std::streamsize size)
+	{
+		std::streamsize bits_read = 0;
+
+		refresh_get();
+
+		if (size <= egptr() - gptr())
+		{
+			bits_read = bitbuf::xsgetn(value, size);
+		}
+		else if (size > 0 && size <= static_cast<std::streamsize>(sizeof value * CHAR_BIT) &&
+			size <= m_produced_seen - (m_get_base + gptr()))
+		{
+			// The field runs from the get pointer to the end of the ring and
+			// on from its start.
+			const std::streamsize head_bits = static_cast<std::streamsize>(m_capacity - gptr());
+			const std::streamsize tail_bits = size - head_bits;
+			bitfield head;
+			bitfield tail;
+
+			bitbuf::xsgetn(head, head_bits);
+			refresh_get();
+			bitbuf::xsgetn(tail, tail_bits);
+
+			value = order() == msb_first ? head << tail_bits | tail :
+				head | tail << head_bits;
+			bits_read = size;
+		}
+		else
+		{
+			value = 0;
+		}
+
+		return bits_read;
+	}
+
+	/**
+		Put field whether or not it straddles the end of the ring.
+
+		\param[in] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits written to buffer or zero if error or eof.
+	*/
+	std::streamsize put_wrapped(bitfield value, std::streamsize size)
+	{
+		std::streamsize bits_written = 0;
+
+		refresh_put();
+
+		if (size <= epptr() - pptr())
+		{
+			bits_written = bitbuf::xsputn(value, size);
+		}
+		else if (size > 0 && size <= static_cast<std::streamsize>(sizeof value * CHAR_BIT) &&
+			size <= m_consumed_seen + m_capacity - (m_put_base + pptr()))
+		{
+			const std::streamsize head_bits = static_cast<std::streamsize>(m_capacity - pptr());
+			const std::streamsize tail_bits = size - head_bits;
+
+			if (order() == msb_first)
+			{
+				bitbuf::xsputn(value >> tail_bits, head_bits);
+				refresh_put();
+				bitbuf::xsputn(value, tail_bits);
+			}
+			else
+			{
+				bitbuf::xsputn(value, head_bits);
+				refresh_put();
+				bitbuf::xsputn(value >> head_bits, tail_bits);
+			}
+			bits_written = size;
+		}
+
+		return bits_written;
+	}
+
+	/**
+		Bring get area up to date with bits published by producer, moving to
+		the start of the ring if at its end.
+	*/
+	void refresh_get()
+	{
+		m_produced_seen = m_produced.value.load(boost::memory_order_acquire);
+
+		bitpos next = gptr();
+		if (next == m_capacity)
+		{
+			m_get_base += m_capacity;
+			next = 0;
+		}
+
+		set_get_area(next);
+	}
+
+	/**
+		Set get area to bits of this pass over the ring that were published
+		and not made available to the producer.
+
+		\param[in] next Position of get pointer within ring.
+	*/
+	void set_get_area(bitpos next)
+	{
+		setg(&m_ring[0], std::max(m_consumed_shown - m_get_base, bitpos(0)), next,
+			std::min(m_capacity, m_produced_seen - m_get_base));
+	}
+
+	/**
+		Make the whole bytes read available to the producer.
+	*/
+	void show_consumed()
+	{
+		const bitpos read = m_get_base + gptr();
+		const bitpos consumed = read - read % CHAR_BIT;
+
+		if (consumed > m_consumed_shown)
+		{
+			m_consumed_shown = consumed;
+			m_consumed.value.store(consumed, boost::memory_order_release);
+			set_get_area(gptr());
+		}
+	}
+
+	/**
+		Bring put area up to date with bytes read by consumer, moving to the
+		start of the ring if at its end.
+	*/
+	void refresh_put()
+	{
+		m_consumed_seen = m_consumed.value.load(boost::memory_order_acquire);
+
+		bitpos next = pptr();
+		if (next == m_capacity)
+		{
+			m_put_base += m_capacity;
+			next = 0;
+		}
+
+		setp(&m_ring[0], next, std::min(m_capacity,
+			m_consumed_seen + m_capacity - m_put_base));
+	}
+
+	/**
+		Bytes of ring.
+	*/
+	vector_type m_ring;
+
+	/**
+		Number of bits in ring.
+	*/
+	const bitpos m_capacity;
+
+	/**
+		Position just past bits published by producer.
+	*/
+	detail::ring_position m_produced;
+
+	/**
+		Whether producer has called close().
+	*/
+	boost::atomic<bool> m_closed;
+
+	/**
+		Position up to which consumer has read whole bytes.
+	*/
+	detail::ring_position m_consumed;
+
+	// Consumer variables /////////////////////////////////////////////////////
+
+	/**
+		Position of start of ring in consumer's pass over it.
+	*/
+	bitpos m_get_base;
+
+	/**
+		Value of m_produced when last loaded.
+	*/
+	bitpos m_produced_seen;
+
+	/**
+		Value of m_consumed when last stored.
+	*/
+	bitpos m_consumed_shown;
+
+	// Producer variables /////////////////////////////////////////////////////
+
+	/**
+		Padding between consumer and producer variables.
+	*/
+	char m_padding[detail::cache_line_bytes];
+
+	/**
+		Position of start of ring in producer's pass over it.
+	*/
+	bitpos m_put_base;
+
+	/**
+		Value of m_consumed when last loaded.
+	*/
+	bitpos m_consumed_seen;
+};
+
+/**
+	A ring bitbuf using the default allocator.
+*/
+typedef basic_ringbitbuf<> ringbitbuf;
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
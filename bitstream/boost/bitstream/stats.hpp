@@ -0,0 +1,403 @@
+/** \file
+    \brief Bit-stream instrumentation counters.
+    \details This header file contains the counters that bitbufs and streams
+        keep of what they do when BOOST_BITSTREAM_STATS is defined. Without
+        it, nothing is counted and nothing is stored.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_STATS_HPP
+#define BOOST_BITSTREAM_STATS_HPP
+
+#include <boost/cstdint.hpp>
+#include <climits>
+#include <cstddef>
+#include <ios>
+
+/**
+	Evaluate a counting statement only if BOOST_BITSTREAM_STATS is defined.
+
+	\note BOOST_BITSTREAM_STATS changes the layout of bitbuf and iob, so it
+	must be defined the same way in every translation unit of a program.
+*/
+#ifdef BOOST_BITSTREAM_STATS
+#  define BOOST_BITSTREAM_COUNT(statement) statement
+#else
+#  define BOOST_BITSTREAM_COUNT(statement) ((void)0)
+#endif
+
+namespace boost {
+
+namespace bitstream {
+
+namespace detail {
+
+/**
+	Number of bytes assumed to be in a cache line.
+*/
+static const size_t cache_line_bytes = 64;
+
+} // namespace detail
+
+// stream_stats ///////////////////////////////////////////////////////////////
+
+/**
+    This class is a snapshot of instrumentation counters.
+
+	\note A bitbuf counts the bits and fields read and written, and calls to
+	seek; see bitbuf::stats(). Fields are counted however they go, one at a
+	time with sgetn(), sputn() and sputb(), in bulk with sgetaligned(),
+	sgetpacked(), sgetcopy() and their put counterparts, as records of a
+	codec, or under an unchecked guard; a field wider than bitfield, with
+	sgetwide() or sputwide(), is one field. Peeks, with sgetb() or speekn(),
+	read nothing. With ostream::unitbuf(false), fields are counted as they
+	reach the bitbuf, i.e., a register at a time. A stream counts putbacks,
+	ungets and the times eofbit or failbit went from clear to set; see
+	iob::stats().
+
+	\note Counters are plain integers, kept by whichever thread uses the
+	object. The get-side and put-side counters of a bitbuf are separate, and
+	on separate cache lines, so the consumer and producer of a ringbitbuf
+	each update only their own without contending for a line. Taking a
+	snapshot reads both sides, though, and resetting writes both, so for a
+	bitbuf used by two threads these are only exact while neither thread is
+	using it. Snapshots of objects used by different threads are aggregated
+	with operator+=.
+*/
+struct stream_stats
+{
+	/**
+		Number of field-width buckets: 1, 2-4, 5-8, 9-16, 17-32 and 33 or
+		more bits.
+	*/
+	static const size_t width_buckets = 6;
+
+	/**
+		Constructor.
+	*/
+	stream_stats()
+	{
+		reset();
+	}
+
+	/**
+		Get bucket for field width.
+
+		\param[in] bits Number of bits in field.
+		\return Index into reads and writes.
+	*/
+	static size_t width_bucket(std::streamsize bits)
+	{
+		size_t bucket = 0;
+
+		for (std::streamsize limit = 1; bits > limit && bucket < width_buckets - 1;
+			limit = limit == 1 ? 4 : limit * 2)
+		{
+			++bucket;
+		}
+
+		return bucket;
+	}
+
+	/**
+		Zero all counters.
+	*/
+	void reset()
+	{
+		bits_read = bits_written = 0;
+		for (size_t i = 0; i < width_buckets; ++i)
+		{
+			reads[i] = writes[i] = 0;
+		}
+		aligned_reads = unaligned_reads = aligned_writes = unaligned_writes = 0;
+		get_seekoffs = get_seekposes = put_seekoffs = put_seekposes = 0;
+		putbacks = ungets = eofs = failures = 0;
+	}
+
+	/**
+		Count a field read.
+
+		\param[in] position Bit position of field.
+		\param[in] bits Number of bits read; nothing is counted if 0.
+	*/
+	void count_read(boost::int64_t position, std::streamsize bits)
+	{
+		if (bits > 0)
+		{
+			bits_read += static_cast<boost::uint64_t>(bits);
+			++reads[width_bucket(bits)];
+			++(position % CHAR_BIT == 0 ? aligned_reads : unaligned_reads);
+		}
+	}
+
+	/**
+		Count fields read back to back.
+
+		\param[in] position Bit position of first field.
+		\param[in] bits Number of bits in each field.
+		\param[in] count Number of fields; nothing is counted if 0.
+	*/
+	void count_reads(boost::int64_t position, std::streamsize bits, size_t count)
+	{
+		if (bits > 0 && count > 0)
+		{
+			bits_read += static_cast<boost::uint64_t>(bits) * count;
+			reads[width_bucket(bits)] += count;
+			const boost::uint64_t aligned = count_aligned(position, bits, count);
+			aligned_reads += aligned;
+			unaligned_reads += count - aligned;
+		}
+	}
+
+	/**
+		Count a field written.
+
+		\param[in] position Bit position of field.
+		\param[in] bits Number of bits written; nothing is counted if 0.
+	*/
+	void count_write(boost::int64_t position, std::streamsize bits)
+	{
+		if (bits > 0)
+		{
+			bits_written += static_cast<boost::uint64_t>(bits);
+			++writes[width_bucket(bits)];
+			++(position % CHAR_BIT == 0 ? aligned_writes : unaligned_writes);
+		}
+	}
+
+	/**
+		Count fields written back to back.
+
+		\param[in] position Bit position of first field.
+		\param[in] bits Number of bits in each field.
+		\param[in] count Number of fields; nothing is counted if 0.
+	*/
+	void count_writes(boost::int64_t position, std::streamsize bits, size_t count)
+	{
+		if (bits > 0 && count > 0)
+		{
+			bits_written += static_cast<boost::uint64_t>(bits) * count;
+			writes[width_bucket(bits)] += count;
+			const boost::uint64_t aligned = count_aligned(position, bits, count);
+			aligned_writes += aligned;
+			unaligned_writes += count - aligned;
+		}
+	}
+
+	/**
+		Count a call to seekoff().
+
+		\param[in] which Open mode; the put side is counted if it includes
+		output.
+	*/
+	void count_seekoff(std::ios_base::openmode which)
+	{
+		++((which & std::ios_base::out) != 0 ? put_seekoffs : get_seekoffs);
+	}
+
+	/**
+		Count a call to seekpos().
+
+		\param[in] which Open mode; the put side is counted if it includes
+		output.
+	*/
+	void count_seekpos(std::ios_base::openmode which)
+	{
+		++((which & std::ios_base::out) != 0 ? put_seekposes : get_seekposes);
+	}
+
+	/**
+		Count state flags that went from clear to set.
+
+		\param[in] previous State before.
+		\param[in] current State after.
+	*/
+	void count_state(std::ios_base::iostate previous,
+		std::ios_base::iostate current)
+	{
+		static const std::ios_base::iostate failed =
+			std::ios_base::failbit | std::ios_base::badbit;
+
+		if ((previous & std::ios_base::eofbit) == 0 &&
+			(current & std::ios_base::eofbit) != 0)
+		{
+			++eofs;
+		}
+		if ((previous & failed) == 0 && (current & failed) != 0)
+		{
+			++failures;
+		}
+	}
+
+	/**
+		Count fields back to back that start on a byte boundary.
+
+		\note Whether field i is aligned depends only on i % CHAR_BIT, so
+		this takes at most CHAR_BIT steps however many fields there are.
+
+		\param[in] position Bit position of first field.
+		\param[in] bits Number of bits in each field.
+		\param[in] count Number of fields.
+		\return Number of aligned fields.
+	*/
+	static boost::uint64_t count_aligned(boost::int64_t position,
+		std::streamsize bits, size_t count)
+	{
+		boost::uint64_t aligned = 0;
+
+		for (size_t i = 0; i < count && i < CHAR_BIT; ++i)
+		{
+			if ((position + static_cast<boost::int64_t>(i) * bits) % CHAR_BIT == 0)
+			{
+				aligned += (count - 1 - i) / CHAR_BIT + 1;
+			}
+		}
+
+		return aligned;
+	}
+
+	/**
+		Add counters of another snapshot, e.g., from another thread.
+
+		\param[in] other Snapshot to add.
+		\return This snapshot.
+	*/
+	stream_stats &operator+=(const stream_stats &other)
+	{
+		bits_read += other.bits_read;
+		bits_written += other.bits_written;
+		for (size_t i = 0; i < width_buckets; ++i)
+		{
+			reads[i] += other.reads[i];
+			writes[i] += other.writes[i];
+		}
+		aligned_reads += other.aligned_reads;
+		unaligned_reads += other.unaligned_reads;
+		aligned_writes += other.aligned_writes;
+		unaligned_writes += other.unaligned_writes;
+		get_seekoffs += other.get_seekoffs;
+		get_seekposes += other.get_seekposes;
+		put_seekoffs += other.put_seekoffs;
+		put_seekposes += other.put_seekposes;
+		putbacks += other.putbacks;
+		ungets += other.ungets;
+		eofs += other.eofs;
+		failures += other.failures;
+
+		return *this;
+	}
+
+	// Get side ///////////////////////////////////////////////////////////////
+
+	/**
+		Number of bits read.
+	*/
+	boost::uint64_t bits_read;
+
+	/**
+		Number of fields read, by width bucket.
+	*/
+	boost::uint64_t reads[width_buckets];
+
+	/**
+		Number of fields read that start on a byte boundary.
+	*/
+	boost::uint64_t aligned_reads;
+
+	/**
+		Number of fields read that do not start on a byte boundary.
+	*/
+	boost::uint64_t unaligned_reads;
+
+	/**
+		Number of calls to seekoff() for input.
+	*/
+	boost::uint64_t get_seekoffs;
+
+	/**
+		Number of calls to seekpos() for input.
+	*/
+	boost::uint64_t get_seekposes;
+
+	/**
+		Padding between get-side and put-side counters.
+	*/
+	char padding[detail::cache_line_bytes];
+
+	// Put side ///////////////////////////////////////////////////////////////
+
+	/**
+		Number of bits written.
+	*/
+	boost::uint64_t bits_written;
+
+	/**
+		Number of fields written, by width bucket.
+	*/
+	boost::uint64_t writes[width_buckets];
+
+	/**
+		Number of fields written that start on a byte boundary.
+	*/
+	boost::uint64_t aligned_writes;
+
+	/**
+		Number of fields written that do not start on a byte boundary.
+	*/
+	boost::uint64_t unaligned_writes;
+
+	/**
+		Number of calls to seekoff() for output.
+	*/
+	boost::uint64_t put_seekoffs;
+
+	/**
+		Number of calls to seekpos() for output.
+	*/
+	boost::uint64_t put_seekposes;
+
+	// Stream /////////////////////////////////////////////////////////////////
+
+	/**
+		Number of calls to istream::putback().
+	*/
+	boost::uint64_t putbacks;
+
+	/**
+		Number of calls to istream::unget().
+	*/
+	boost::uint64_t ungets;
+
+	/**
+		Number of times eofbit went from clear to set.
+	*/
+	boost::uint64_t eofs;
+
+	/**
+		Number of times failbit or badbit went from clear to set.
+	*/
+	boost::uint64_t failures;
+};
+
+/**
+	Add counters of two snapshots.
+
+	\param[in] left Snapshot on left-hand side of operator.
+	\param[in] right Snapshot on right-hand side of operator.
+	\return Sum.
+*/
+inline stream_stats operator+(stream_stats left, const stream_stats &right)
+{
+	return left += right;
+}
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
@@ -0,0 +1,370 @@
+/** \file
+    \brief Bit-stream buffer over a character stream buffer.
+    \details This header file contains a bitbuf that reads bits from a
+        std::streambuf a chunk at a time, so that a capture of any size can be
+        parsed in bounded memory.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_STREAMBUF_HPP
+#define BOOST_BITSTREAM_STREAMBUF_HPP
+
+#include <boost/bitstream/iob.hpp>
+#include <boost/noncopyable.hpp>
+#include <algorithm>
+#include <cstring>
+#include <streambuf>
+#include <vector>
+
+namespace boost {
+
+namespace bitstream {
+
+// streambitbuf ///////////////////////////////////////////////////////////////
+
+/**
+    This class represents the bits of a std::streambuf, read into a window
+	of fixed size as they are needed.
+
+    \note The get area is the window. When a bit field does not fit in what
+	is left of it, the unread bytes are moved to the front and the rest of
+	the window is refilled from the source, so fields straddle chunks
+	transparently and memory use does not depend on the size of the source.
+	The source may be a std::filebuf, the rdbuf() of std::cin, or any other
+	std::streambuf, such as a boost::iostreams::stream_buffer over a file
+	descriptor.
+
+	\note Positions are bit offsets from where the source was when this
+	object was constructed. Seeking within the window is free. Seeking
+	elsewhere repositions the source if it is seekable; otherwise, seeking
+	forward reads and discards, and seeking backward fails. std::ios_base::end
+	is not supported.
+
+    \note This is an input buffer; its output sequence is empty. It is not
+	copyable, as a copy would still point into this object's window.
+*/
+class streambitbuf : public bitbuf, private boost::noncopyable
+{
+public:
+	/**
+		Constructor.
+
+		\param[in] source Stream buffer from which to read bytes.
+		\param[in] chunk_bytes Number of bytes to read from source at a time.
+	*/
+	explicit streambitbuf(std::streambuf *source,
+		std::streamsize chunk_bytes = 64 * 1024) :
+		bitbuf(std::ios_base::in), m_source(source),
+		m_source_start(source == NULL ? std::streampos(-1) :
+			source->pubseekoff(0, std::ios_base::cur, std::ios_base::in)),
+		m_window(static_cast<size_t>(std::max(chunk_bytes, std::streamsize(1))) +
+			window_reserve),
+		m_origin(0)
+	{
+		setg(&m_window[0], 0, 0, 0);
+		setp(&m_window[0], 0, 0);
+	}
+
+	/**
+		Get the stream buffer from which bytes are read.
+
+		\return Pointer to source stream buffer.
+	*/
+	std::streambuf *source() const
+	{
+		return m_source;
+	}
+
+protected:
+	// Virtual buffer-management and positioning functions ////////////////////
+
+	/**
+		Set buffer to access.
+
+		\note Not supported; this object owns its window.
+
+		\return NULL.
+	*/
+	virtual bitbuf *setbuf(unsigned char *, std::streamsize)
+	{
+		return NULL;
+	}
+
+	/**
+		Determine whether slices may be made of the get area.
+
+		\note Not supported. The window is moved and refilled, so a slice of
+		it would dangle.
+
+		\return false.
+	*/
+	virtual bool sliceable() const
+	{
+		return false;
+	}
+
+	/**
+		Set get pointer relative to current position.
+
+		\note See class notes on seeking.
+
+		\param[in] offset Amount by which get pointer is adjusted.
+		\param[in] way From which pointer offset is applied for new position.
+		\param[in] which Open mode.
+		\return New position after get pointer modified.
+	*/
+	virtual std::streampos seekoff(std::streamoff offset,
+		std::ios_base::seekdir way,
+		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+	{
+		bitpos new_position = bitpos(-1);
+
+		if ((which & std::ios_base::in) != 0)
+		{
+			switch (way)
+			{
+			case std::ios_base::beg:
+				new_position = seek(offset);
+				break;
+
+			case std::ios_base::cur:
+				new_position = seek(m_origin + gptr() + offset);
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		return std::streampos(new_position);
+	}
+
+	/**
+		Set get pointer to absolute position.
+
+		\note See class notes on seeking.
+
+		\param[in] position New absolute position for get pointer.
+		\param[in] which Open mode.
+		\return New position after get pointer modified or
+		std::streampos(-1) if error.
+	*/
+	virtual std::streampos seekpos(std::streampos position,
+		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+	{
+		bitpos new_position = bitpos(-1);
+
+		if ((which & std::ios_base::in) != 0)
+		{
+			new_position = seek(std::streamoff(position));
+		}
+
+		return std::streampos(new_position);
+	}
+
+	// Virtual input functions ////////////////////////////////////////////////
+
+	/**
+		Get number of bits available.
+
+		\note This is only called when the window is empty, in which case the
+		next chunk is read to find out.
+
+		\return Number of bits in the window; -1 at the end of the source.
+	*/
+	virtual std::streamsize showmanyb()
+	{
+		while (gptr() == egptr() && refill())
+		{
+			// Keep reading until there is something or nothing more.
+		}
+
+		return gptr() < egptr() ? egptr() - gptr() : -1;
+	}
+
+	/**
+		Get sequence of bits.
+
+		\note This is only called when the field does not fit in what is left
+		of the window.
+
+		\param[out] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits read from buffer or zero if error or eof.
+	*/
+	virtual std::streamsize xsgetn(bitfield &value, std::streamsize size)
+	{
+		while (size <= static_cast<std::streamsize>(sizeof value * CHAR_BIT) &&
+			size > egptr() - gptr() && refill())
+		{
+			// Keep reading until the field fits or there is nothing more.
+		}
+
+		return bitbuf::xsgetn(value, size);
+	}
+
+	/**
+		Get sequence of bits without advancing get pointer.
+
+		\note This is only called when the bits do not all fit in what is
+		left of the window; see xsgetn().
+
+		\param[out] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits peeked at or zero if error or eof.
+	*/
+	virtual std::streamsize xspeekn(bitfield &value, std::streamsize size)
+	{
+		while (size <= static_cast<std::streamsize>(sizeof value * CHAR_BIT) &&
+			size > egptr() - gptr() && refill())
+		{
+			// Keep reading until the field fits or there is nothing more.
+		}
+
+		return bitbuf::xspeekn(value, size);
+	}
+
+	/**
+		Get bit without changing current position.
+
+		\param[out] value Bit at the current position.
+		\return Whether there are more bits to read.
+	*/
+	virtual bool underflow(bitfield &value)
+	{
+		while (gptr() == egptr() && refill())
+		{
+			// Keep reading until there is something or nothing more.
+		}
+
+		return bitbuf::underflow(value);
+	}
+
+private:
+	/**
+		Number of bytes in the window beyond one chunk, for the unread bytes
+		of a field that straddles chunks.
+	*/
+	static const size_t window_reserve = sizeof(bitfield) + 1;
+
+	/**
+		Move unread bytes to front of window and fill the rest from source.
+
+		\return Whether any bytes were read from source.
+	*/
+	bool refill()
+	{
+		const size_t keep_from = static_cast<size_t>(gptr() / CHAR_BIT);
+		const size_t kept = static_cast<size_t>(egptr() / CHAR_BIT) - keep_from;
+		if (kept > 0)
+		{
+			std::memmove(&m_window[0], &m_window[keep_from], kept);
+		}
+
+		const bitpos get_position = gptr() - static_cast<bitpos>(keep_from) * CHAR_BIT;
+		m_origin += static_cast<bitpos>(keep_from) * CHAR_BIT;
+
+		std::streamsize bytes_read = 0;
+		if (m_source != NULL)
+		{
+			bytes_read = std::max(std::streamsize(0), m_source->sgetn(
+				reinterpret_cast<char *>(&m_window[kept]),
+				static_cast<std::streamsize>(m_window.size() - kept)));
+		}
+
+		setg(&m_window[0], 0, get_position,
+			static_cast<bitpos>(kept + bytes_read) * CHAR_BIT);
+
+		return bytes_read > 0;
+	}
+
+	/**
+		Move get pointer to position, reading or repositioning the source if
+		it is outside the window.
+
+		\param[in] position Absolute bit position.
+		\return position if successful; otherwise, bitpos(-1).
+	*/
+	bitpos seek(bitpos position)
+	{
+		bitpos new_position = bitpos(-1);
+
+		if (position >= 0)
+		{
+			if (position < m_origin || position > m_origin + egptr())
+			{
+				reposition(position);
+			}
+
+			if (position >= m_origin && position <= m_origin + egptr())
+			{
+				setg(&m_window[0], 0, position - m_origin, egptr());
+				new_position = position;
+			}
+		}
+
+		return new_position;
+	}
+
+	/**
+		Make the window contain position.
+
+		\param[in] position Absolute bit position outside window.
+	*/
+	void reposition(bitpos position)
+	{
+		const bitpos byte_position = position / CHAR_BIT;
+
+		if (m_source_start != std::streampos(-1) &&
+			m_source->pubseekpos(m_source_start + std::streamoff(byte_position),
+				std::ios_base::in) != std::streampos(-1))
+		{
+			m_origin = byte_position * CHAR_BIT;
+			setg(&m_window[0], 0, 0, 0);
+			refill();
+		}
+		else
+		{
+			// Not seekable, so skip forward by reading.
+			while (position > m_origin + egptr())
+			{
+				setg(&m_window[0], 0, egptr(), egptr());
+				if (!refill())
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	/**
+		Stream buffer from which bytes are read.
+	*/
+	std::streambuf *m_source;
+
+	/**
+		Position of source at construction, or -1 if it is not seekable.
+	*/
+	std::streampos m_source_start;
+
+	/**
+		Storage for bytes read from source.
+	*/
+	std::vector<unsigned char> m_window;
+
+	/**
+		Absolute bit position of first bit in window.
+	*/
+	bitpos m_origin;
+};
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
@@ -0,0 +1,408 @@
+/** \file
+    \brief Unchecked extraction.
+    \details This header file contains a guard that checks once that a
+        stream holds a known number of bits and then extracts them without
+        checking each field.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_UNCHECKED_HPP
+#define BOOST_BITSTREAM_UNCHECKED_HPP
+
+#include <boost/bitstream/istream.hpp>
+#include <boost/assert.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <bitset>
+
+namespace boost {
+
+namespace bitstream {
+
+// unchecked //////////////////////////////////////////////////////////////////
+
+/**
+    Objects of this class extract a known number of bits from an istream
+	with a single bounds check, e.g.,
+	\code
+	{
+		boost::bitstream::unchecked in(bin, 96);
+		in >> version >> padding >> extension >> csrc_count >> marker >>
+			payload_type >> sequence_number >> timestamp >> ssrc;
+	}
+	if (!bin) ...
+	\endcode
+
+	\note The constructor checks that all the bits are in the get area of the
+	stream's bitbuf. If they are, extractions read them directly, with no
+	bounds check, no state bookkeeping and no virtual call; a const field
+	that does not match only sets a deferred flag. When the guard is
+	destroyed or release() is called, the stream is advanced past the bits
+	extracted and gets failbit if anything did not match, and eofbit if no
+	bits are left. Extracting more bits than were checked is a precondition
+	violation, which asserts in debug builds.
+
+	\note If the bits are not all in the get area, e.g., they straddle two
+	fills of a streambitbuf, or the stream is not good() or its bitbuf is not
+	msb_first, extractions go to the stream as usual, so the result is the
+	same, just without the speedup.
+
+	\note The stream must not be used directly while the guard is in scope.
+*/
+class unchecked : private boost::noncopyable
+{
+public:
+	/**
+		Constructor.
+
+		\param[in,out] ibs Stream from which to extract bits.
+		\param[in] bits Number of bits that will be extracted, at most.
+	*/
+	unchecked(istream &ibs, std::streamsize bits) : m_stream(ibs),
+		m_buffer(NULL), m_start(0), m_position(0), m_end(0), m_byte_count(0),
+		m_deferred(std::ios_base::goodbit)
+	{
+		bitbuf * const bb = ibs.rdbuf();
+		if (ibs.good() && bb != NULL && bb->order() == msb_first &&
+			bits >= 0 && bits <= bb->egptr() - bb->gptr())
+		{
+			m_buffer = bb->current_get_byte();
+			m_start = m_position = static_cast<size_t>(bb->gptr() % CHAR_BIT);
+			m_end = m_start + static_cast<size_t>(bits);
+			m_byte_count = bitbuf::bytes_remaining(bb->gptr(), bb->egptr());
+		}
+	}
+
+	/**
+		Destructor.
+
+		\note See release().
+	*/
+	~unchecked()
+	{
+		release();
+	}
+
+	/**
+		Determine whether the bits were all there, so that extractions are
+		unchecked.
+
+		\return Whether bits are extracted directly.
+	*/
+	bool validated() const
+	{
+		return m_buffer != NULL;
+	}
+
+	/**
+		Check whether nothing has failed so far.
+
+		\return Whether no const field mismatched and, if not validated(),
+		the stream has not failed.
+	*/
+	operator bool() const
+	{
+		return validated() ? m_deferred == std::ios_base::goodbit :
+			!m_stream.fail();
+	}
+
+	/**
+		Get bits, where number of bits is known at compile time.
+
+		\tparam N Number of bits to read.
+		\param[out] value Integral to receive bits.
+		\return This guard.
+	*/
+	template <size_t N>
+	unchecked &read(bitfield &value)
+	{
+		BOOST_STATIC_ASSERT(N > 0 && N <= sizeof(bitfield) * CHAR_BIT);
+
+		if (validated())
+		{
+			BOOST_ASSERT(m_position + N <= m_end);
+			value = bitbuf::get_bits<N>(m_buffer + m_position / CHAR_BIT,
+				m_position % CHAR_BIT, m_byte_count - m_position / CHAR_BIT);
+			BOOST_BITSTREAM_COUNT(count_read(N));
+			m_position += N;
+		}
+		else
+		{
+			m_stream.read<N>(value);
+		}
+
+		return *this;
+	}
+
+	/**
+		Get bits.
+
+		\param[out] value Integral to receive bits.
+		\param[in] bits Number of bits to read, 1 through the number of bits
+		in bitfield.
+		\return This guard.
+	*/
+	unchecked &read(bitfield &value, std::streamsize bits)
+	{
+		if (validated())
+		{
+			BOOST_ASSERT(bits > 0 &&
+				bits <= static_cast<std::streamsize>(sizeof value * CHAR_BIT) &&
+				m_position + static_cast<size_t>(bits) <= m_end);
+			value = bitbuf::get_bits(m_buffer + m_position / CHAR_BIT,
+				m_position % CHAR_BIT, static_cast<size_t>(bits),
+				m_byte_count - m_position / CHAR_BIT);
+			BOOST_BITSTREAM_COUNT(count_read(bits));
+			m_position += static_cast<size_t>(bits);
+		}
+		else
+		{
+			m_stream.read(value, bits);
+		}
+
+		return *this;
+	}
+
+	/**
+		Ignore, or skip over, bits.
+
+		\param[in] bits Number of bits to ignore.
+		\return This guard.
+	*/
+	unchecked &ignore(std::streamsize bits = 1)
+	{
+		if (validated())
+		{
+			BOOST_ASSERT(bits >= 0 && m_position + static_cast<size_t>(bits) <= m_end);
+			m_position += static_cast<size_t>(bits);
+		}
+		else
+		{
+			m_stream.ignore(bits);
+		}
+
+		return *this;
+	}
+
+	/**
+		Add to state, e.g., on a const field that does not match.
+
+		\note If validated(), this is deferred until release().
+
+		\param[in] state State bits to set.
+	*/
+	void setstate(std::ios_base::iostate state)
+	{
+		if (validated())
+		{
+			m_deferred |= state;
+		}
+		else
+		{
+			m_stream.setstate(state);
+		}
+	}
+
+	/**
+		Advance the stream past the bits extracted and give it the deferred
+		state.
+
+		\note Afterwards, extractions go to the stream as usual.
+	*/
+	void release()
+	{
+		if (validated())
+		{
+			bitbuf * const bb = m_stream.rdbuf();
+			bb->gbump(static_cast<std::streamoff>(m_position - m_start));
+			if (bb->in_avail() <= 0)
+			{
+				m_deferred |= std::ios_base::eofbit;
+			}
+			if (m_deferred != std::ios_base::goodbit)
+			{
+				m_stream.setstate(m_deferred);
+			}
+
+			m_buffer = NULL;
+		}
+	}
+
+private:
+#ifdef BOOST_BITSTREAM_STATS
+	/**
+		Count field read at m_position in stream's bitbuf, as sgetn() would
+		have.
+
+		\param[in] bits Number of bits in field.
+	*/
+	void count_read(std::streamsize bits)
+	{
+		bitbuf * const bb = m_stream.rdbuf();
+		bb->m_stats.count_read(bb->gptr() +
+			static_cast<bitpos>(m_position - m_start), bits);
+	}
+#endif
+
+	/**
+		Stream from which bits are extracted.
+	*/
+	istream &m_stream;
+
+	/**
+		Byte containing get pointer of stream on construction, or NULL if not
+		validated().
+	*/
+	const unsigned char *m_buffer;
+
+	/**
+		Bit position of get pointer within *m_buffer on construction.
+	*/
+	size_t m_start;
+
+	/**
+		Bit position of next bit relative to m_buffer.
+	*/
+	size_t m_position;
+
+	/**
+		Bit position just past bits checked relative to m_buffer.
+	*/
+	size_t m_end;
+
+	/**
+		Number of bytes that may be read at m_buffer.
+	*/
+	size_t m_byte_count;
+
+	/**
+		State to give the stream on release().
+	*/
+	std::ios_base::iostate m_deferred;
+};
+
+// Extractors /////////////////////////////////////////////////////////////////
+
+/**
+	Get single bit and place in bool.
+
+	\param[in,out] u Reference to unchecked on left-hand side of operator.
+	\param[out] b bool on right-hand side of operator.
+	\return Reference to unchecked parameter.
+*/
+inline unchecked &operator>>(unchecked &u, bool &b)
+{
+	bitfield value;
+	u.read<1>(value);
+	b = value != 0;
+
+	return u;
+}
+
+/**
+	Get single bit that must be equal to bool.
+
+	\param[in,out] u Reference to unchecked on left-hand side of operator.
+	\param[in] b bool on right-hand side of operator.
+	\return Reference to unchecked parameter.
+*/
+inline unchecked &operator>>(unchecked &u, const bool &b)
+{
+	bitfield value;
+	u.read<1>(value);
+	if (b != (value != 0))
+	{
+		u.setstate(std::ios_base::failbit);
+	}
+
+	return u;
+}
+
+/**
+	Get bits and place in bitset.
+
+	\param[in,out] u Reference to unchecked on left-hand side of operator.
+	\param[out] bs bitset on right-hand side of operator.
+	\return Reference to unchecked parameter.
+*/
+template <size_t N>
+unchecked &operator>>(unchecked &u, std::bitset<N> &bs)
+{
+	bitfield value;
+	u.read<N>(value);
+	bs = value;
+
+	return u;
+}
+
+/**
+	Get bits that must be equal to bitset value.
+
+	\param[in,out] u Reference to unchecked on left-hand side of operator.
+	\param[in] bs bitset on right-hand side of operator.
+	\return Reference to unchecked parameter.
+*/
+template <size_t N>
+unchecked &operator>>(unchecked &u, const std::bitset<N> &bs)
+{
+	bitfield value;
+	u.read<N>(value);
+	if (bs != std::bitset<N>(value))
+	{
+		u.setstate(std::ios_base::failbit);
+	}
+
+	return u;
+}
+
+/**
+	Get bit field and place in integral.
+
+	\param[in,out] u Reference to unchecked on left-hand side of operator.
+	\param[out] b Integral on right-hand side of operator.
+	\return Reference to unchecked parameter.
+*/
+template <typename T>
+typename boost::enable_if_c<boost::is_integral<T>::value, unchecked &>::type
+operator>>(unchecked &u, T &b)
+{
+	bitfield value;
+	u.read<sizeof(T) * CHAR_BIT>(value);
+	b = static_cast<T>(value);
+
+	return u;
+}
+
+/**
+	Get bit field that must be equal to integral value.
+
+	\param[in,out] u Reference to unchecked on left-hand side of operator.
+	\param[in] b Integral on right-hand side of operator.
+	\return Reference to unchecked parameter.
+*/
+template <typename T>
+typename boost::enable_if_c<boost::is_integral<T>::value, unchecked &>::type
+operator>>(unchecked &u, const T &b)
+{
+	bitfield value;
+	u.read<sizeof(T) * CHAR_BIT>(value);
+	if (b != static_cast<T>(value))
+	{
+		u.setstate(std::ios_base::failbit);
+	}
+
+	return u;
+}
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
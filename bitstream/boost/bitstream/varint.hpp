@@ -0,0 +1,1040 @@
+/** \file
+    \brief Variable-length integers.
+    \details This header file contains extractors and inserters of
+        Exp-Golomb codes, as in H.264 and H.265 headers, and of LEB128, or
+        varint, integers.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_VARINT_HPP
+#define BOOST_BITSTREAM_VARINT_HPP
+
+#include <boost/bitstream/cursor.hpp>
+#include <boost/bitstream/istream.hpp>
+#include <boost/bitstream/ostream.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <algorithm>
+#include <limits>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#  include <intrin.h>
+#  pragma intrinsic(_BitScanReverse64)
+#  pragma intrinsic(_BitScanForward64)
+#endif
+
+namespace boost {
+
+namespace bitstream {
+
+namespace detail {
+
+/**
+	Count leading zero bits of a 64-bit word.
+
+	\param[in] x Word, which must not be 0.
+	\return Number of zero bits before the most-significant 1 bit.
+*/
+inline size_t count_leading_zeros(boost::uint64_t x)
+{
+#if defined(__GNUC__)
+	return static_cast<size_t>(__builtin_clzll(x));
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+	unsigned long index;
+	_BitScanReverse64(&index, x);
+	return 63 - static_cast<size_t>(index);
+#else
+	size_t count = 0;
+	for (size_t shift = 32; shift > 0; shift /= 2)
+	{
+		if ((x >> (64 - shift)) == 0)
+		{
+			count += shift;
+			x <<= shift;
+		}
+	}
+	return count;
+#endif
+}
+
+/**
+	Count trailing zero bits of a 64-bit word.
+
+	\param[in] x Word, which must not be 0.
+	\return Number of zero bits below the least-significant 1 bit.
+*/
+inline size_t count_trailing_zeros(boost::uint64_t x)
+{
+#if defined(__GNUC__)
+	return static_cast<size_t>(__builtin_ctzll(x));
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+	unsigned long index;
+	_BitScanForward64(&index, x);
+	return static_cast<size_t>(index);
+#else
+	size_t count = 0;
+	for (size_t shift = 32; shift > 0; shift /= 2)
+	{
+		if ((x & (~boost::uint64_t(0) >> (64 - shift))) == 0)
+		{
+			count += shift;
+			x >>= shift;
+		}
+	}
+	return count;
+#endif
+}
+
+/**
+	Count zero bits before the first 1 bit of bits looked at.
+
+	\param[in] window Bits, first bit most significant or, with lsb_first,
+	least significant; must not be 0.
+	\param[in] order Order of bits.
+	\return Number of zero bits.
+*/
+inline size_t count_first_zeros(bitfield window, bit_order order)
+{
+	return order == msb_first ? count_leading_zeros(window) :
+		count_trailing_zeros(window);
+}
+
+/**
+	Get Exp-Golomb code number from the bits after the zeros of a code.
+
+	\note With msb_first, these are the 1 bit and the info bits as one
+	field, which is code number + 1. With lsb_first, they are in the order of
+	the stream, i.e., the 1 bit first, in the LSB, then the info bits as
+	their own field.
+
+	\param[in] bits Bits after zeros, right-justified.
+	\param[in] zeros Number of zeros, less than 64.
+	\param[in] order Order of bits.
+	\return Code number.
+*/
+inline boost::uint64_t exp_golomb_code(bitfield bits, size_t zeros,
+	bit_order order)
+{
+	const bitfield lead = bitfield(1) << zeros;
+
+	return (order == msb_first ? bits :
+		lead | ((bits >> 1) & (lead - 1))) - 1;
+}
+
+/**
+	Number of bits that can be looked at without running off the end.
+
+	\param[in] ibs Stream.
+	\return Number of bits in the get area, or less.
+*/
+inline std::streamsize varint_window(istream &ibs)
+{
+	return ibs.rdbuf()->in_avail();
+}
+
+/**
+	Number of bits that can be looked at without running off the end.
+
+	\param[in] r Reader.
+	\return Number of bits left.
+*/
+inline std::streamsize varint_window(const bit_reader &r)
+{
+	return r.in_avail();
+}
+
+/**
+	Get one Exp-Golomb code.
+
+	\note A code is some number of 0 bits, a 1 bit and as many bits again,
+	2 * zeros + 1 bits in all. The zeros are counted in one go from the next
+	64 bits, so any code of a value less than 2^32 - 1 is a peek, a
+	count-leading-zeros and a skip; longer ones take a few more steps. Codes
+	of more than 63 zeros, i.e., of values that do not fit 64 bits, fail the
+	reader. With lsb_first, the zeros are counted from the LSB, and the info
+	bits after the 1 bit are a field in that order; see exp_golomb_code().
+
+	\param[in,out] r Reader from which to get code.
+	\param[out] value Value of code.
+	\return Whether there was a code.
+*/
+template <typename Reader>
+bool get_exp_golomb(Reader &r, boost::uint64_t &value)
+{
+	const bit_order order = order_of(r);
+	bitfield window = r.show_bits(64);
+	if (window != 0)
+	{
+		const size_t zeros = count_first_zeros(window, order);
+		if (zeros < 32)
+		{
+			const size_t length = 2 * zeros + 1;
+			if (!r.skip(static_cast<std::streamsize>(length)))
+			{
+				return false;
+			}
+			value = exp_golomb_code(order == msb_first ?
+				window >> (64 - length) : window >> zeros, zeros, order);
+			return true;
+		}
+	}
+
+	// A long code, or the end of the reader.
+	size_t zeros = 0;
+	while ((window = r.show_bits(64)) == 0 && zeros < 64)
+	{
+		if (!r.skip(64))
+		{
+			return false;
+		}
+		zeros += 64;
+	}
+	if (window != 0)
+	{
+		const size_t count = count_first_zeros(window, order);
+		zeros += count;
+		r.skip(static_cast<std::streamsize>(count));
+	}
+	if (zeros > 63)
+	{
+		r.setstate(std::ios_base::failbit);
+		return false;
+	}
+
+	bitfield code = 1;
+	if (order == msb_first || zeros == 0 ?
+		!r.read(code, static_cast<std::streamsize>(zeros + 1)) :
+		!r.skip(1) || !r.read(code, static_cast<std::streamsize>(zeros)))
+	{
+		return false;
+	}
+	value = exp_golomb_code(order == msb_first || zeros == 0 ? code : code << 1 | 1,
+		zeros, order);
+	return true;
+}
+
+/**
+	Get array of Exp-Golomb codes.
+
+	\note The next 64 bits are looked at once and as many whole codes as
+	they hold are decoded from them with a count-leading-zeros each, then
+	skipped over at once. A code that straddles the window, or one near the
+	end, is gotten on its own.
+
+	\param[in,out] r Reader from which to get codes.
+	\param[out] values Array to receive values.
+	\param[in] count Number of codes to get.
+	\return Number of codes gotten, which is less than count only if the
+	reader failed.
+*/
+template <typename Reader>
+size_t get_exp_golomb(Reader &r, boost::uint64_t *values, size_t count)
+{
+	const bit_order order = order_of(r);
+	size_t decoded = 0;
+
+	while (decoded < count)
+	{
+		const size_t window_bits = static_cast<size_t>(std::max(std::streamsize(0),
+			std::min(std::streamsize(64), varint_window(r))));
+		const bitfield window = r.show_bits(64);
+
+		size_t used = 0;
+		while (decoded < count && used < window_bits)
+		{
+			const bitfield rest = order == msb_first ? window << used :
+				window >> used;
+			if (rest == 0)
+			{
+				break;
+			}
+			const size_t zeros = count_first_zeros(rest, order);
+			const size_t length = 2 * zeros + 1;
+			if (used + length > window_bits)
+			{
+				break;
+			}
+			values[decoded++] = exp_golomb_code(order == msb_first ?
+				rest >> (64 - length) : rest >> zeros, zeros, order);
+			used += length;
+		}
+
+		if (used > 0)
+		{
+			r.skip(static_cast<std::streamsize>(used));
+		}
+		else if (get_exp_golomb(r, values[decoded]))
+		{
+			++decoded;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	return decoded;
+}
+
+/**
+	Put one Exp-Golomb code.
+
+	\note See get_exp_golomb(Reader &, boost::uint64_t &) for the layout
+	with lsb_first.
+
+	\param[in,out] w Writer to which to put code.
+	\param[in] value Value, less than 2^64 - 1.
+*/
+template <typename Writer>
+void put_exp_golomb(Writer &w, boost::uint64_t value)
+{
+	if (value == ~boost::uint64_t(0))
+	{
+		w.setstate(std::ios_base::failbit);
+		return;
+	}
+
+	const bitfield code = value + 1;
+	const size_t zeros = 63 - count_leading_zeros(code);
+	if (order_of(w) == msb_first)
+	{
+		if (2 * zeros + 1 <= 64)
+		{
+			w.write(code, static_cast<std::streamsize>(2 * zeros + 1));
+		}
+		else
+		{
+			w.write(0, static_cast<std::streamsize>(zeros));
+			w.write(code, static_cast<std::streamsize>(zeros + 1));
+		}
+	}
+	else
+	{
+		// Zeros, then the 1 bit, then the info bits, from the LSB up.
+		const bitfield info = code ^ (bitfield(1) << zeros);
+		if (2 * zeros + 1 <= 64)
+		{
+			w.write((info << 1 | 1) << zeros,
+				static_cast<std::streamsize>(2 * zeros + 1));
+		}
+		else
+		{
+			w.write(0, static_cast<std::streamsize>(zeros));
+			w.write(1, 1);
+			w.write(info, static_cast<std::streamsize>(zeros));
+		}
+	}
+}
+
+/**
+	Map a signed Exp-Golomb code number to its value: 0, 1, -1, 2, -2...
+
+	\param[in] code Code number.
+	\return Value.
+*/
+inline boost::int64_t exp_golomb_to_signed(boost::uint64_t code)
+{
+	return (code & 1) != 0 ?
+		static_cast<boost::int64_t>(code / 2 + 1) :
+		-static_cast<boost::int64_t>(code / 2);
+}
+
+/**
+	Get one LEB128 integer.
+
+	\note An integer is 7 bits a byte, least-significant group first, with
+	the high bit of each byte but the last set. The next 8 bytes are looked
+	at once and the last byte found with a count-leading-zeros, so an integer
+	of up to 8 bytes, i.e., less than 2^56, is a peek, a gather and a skip.
+	The bytes need not be byte aligned. With lsb_first, each byte is an
+	8-bit field in that order, so the bytes looked at are little endian and
+	the last byte is found with a count-trailing-zeros.
+
+	\param[in,out] r Reader from which to get integer.
+	\param[out] value Integer, with the bits above the last group zero.
+	\param[out] bits Number of bits in groups.
+	\return Whether there was an integer that fits 64 bits.
+*/
+template <typename Reader>
+bool get_leb128(Reader &r, boost::uint64_t &value, size_t &bits)
+{
+	const bit_order order = order_of(r);
+	const bitfield window = r.show_bits(64);
+	const bitfield last = ~window & 0x8080808080808080ULL;
+	if (last != 0)
+	{
+		const size_t bytes = count_first_zeros(last, order) / CHAR_BIT + 1;
+		if (!r.skip(static_cast<std::streamsize>(bytes * CHAR_BIT)))
+		{
+			return false;
+		}
+		value = 0;
+		for (size_t i = 0; i < bytes; ++i)
+		{
+			const size_t shift = order == msb_first ? 56 - 8 * i : 8 * i;
+			value |= ((window >> shift) & 0x7f) << (7 * i);
+		}
+		bits = 7 * bytes;
+		return true;
+	}
+
+	// Longer than 8 bytes, which only values of more than 56 bits need.
+	value = 0;
+	for (bits = 0; bits < 70; bits += 7)
+	{
+		bitfield byte;
+		if (!r.read(byte, CHAR_BIT))
+		{
+			return false;
+		}
+		// Only a 0 or 1 bit is left, or, for a negative SLEB128, sign bits.
+		const bitfield group = byte & 0x7f;
+		if (bits == 63 && group > 1 && group != 0x7f)
+		{
+			break;
+		}
+		value |= group << bits;
+		if ((byte & 0x80) == 0)
+		{
+			bits += 7;
+			return true;
+		}
+	}
+
+	r.setstate(std::ios_base::failbit);
+	return false;
+}
+
+/**
+	Put one LEB128 integer.
+
+	\param[in,out] w Writer to which to put integer.
+	\param[in] value Integer.
+	\param[in] is_signed Whether to stop when the rest is all sign bits
+	rather than all zeros.
+*/
+template <typename Writer>
+void put_leb128(Writer &w, boost::uint64_t value, bool is_signed)
+{
+	const bool lsb_first = order_of(w) == bitstream::lsb_first;
+	bitfield bytes = 0;
+	size_t count = 0;
+	for (bool more = true; more; )
+	{
+		bitfield byte = value & 0x7f;
+		if (is_signed)
+		{
+			// Arithmetic shift, whatever the compiler does with >>.
+			const boost::uint64_t sign = value >> 63;
+			value = (value >> 7) | (-sign << 57);
+			more = !((value == 0 && (byte & 0x40) == 0) ||
+				(value == ~boost::uint64_t(0) && (byte & 0x40) != 0));
+		}
+		else
+		{
+			value >>= 7;
+			more = value != 0;
+		}
+		if (more)
+		{
+			byte |= 0x80;
+		}
+
+		// Up to eight bytes go in one write, first byte first in the order
+		// of the writer.
+		bytes = lsb_first ? bytes | (byte << (count * CHAR_BIT)) :
+			(bytes << CHAR_BIT) | byte;
+		if (++count == sizeof bytes || !more)
+		{
+			w.write(bytes, static_cast<std::streamsize>(count * CHAR_BIT));
+			bytes = 0;
+			count = 0;
+		}
+	}
+}
+
+/**
+	Assign a decoded value to an integral if it fits.
+
+	\param[out] value Integral.
+	\param[in] decoded Decoded value.
+	\return Whether it fit.
+*/
+template <typename T>
+bool assign_unsigned(T &value, boost::uint64_t decoded)
+{
+	if (decoded > static_cast<boost::uint64_t>(std::numeric_limits<T>::max()))
+	{
+		return false;
+	}
+	value = static_cast<T>(decoded);
+	return true;
+}
+
+/**
+	Assign a decoded value to an integral if it fits.
+
+	\param[out] value Integral.
+	\param[in] decoded Decoded value.
+	\return Whether it fit.
+*/
+template <typename T>
+bool assign_signed(T &value, boost::int64_t decoded)
+{
+	if (decoded < 0 ?
+		!std::numeric_limits<T>::is_signed ||
+			decoded < static_cast<boost::int64_t>(std::numeric_limits<T>::min()) :
+		static_cast<boost::uint64_t>(decoded) >
+			static_cast<boost::uint64_t>(std::numeric_limits<T>::max()))
+	{
+		return false;
+	}
+	value = static_cast<T>(decoded);
+	return true;
+}
+
+} // namespace detail
+
+// Exp-Golomb codes ///////////////////////////////////////////////////////////
+
+///@{
+/**
+	This class represents an unsigned Exp-Golomb code, ue(v), of an integral.
+
+	\see Implementation note for setrepeat manipulator.
+
+	\tparam T Integral type, possibly const for insertion.
+*/
+template <typename T>
+class unsigned_exp_golomb
+{
+public:
+	/**
+		Constructor.
+
+		\param[in] value Integral to extract to or insert.
+	*/
+	explicit unsigned_exp_golomb(T &value) : m_value(&value)
+	{
+		// Do nothing.
+	}
+
+	/**
+		Extract integral.
+
+		\param[in,out] r Reference to istream or bit_reader on lhs of >>
+		operator.
+		\return Reference to reader parameter.
+	*/
+	template <typename Reader>
+	Reader &get(Reader &r) const
+	{
+		boost::uint64_t code;
+		if (detail::get_exp_golomb(r, code) &&
+			!detail::assign_unsigned(*m_value, code))
+		{
+			r.setstate(std::ios_base::failbit);
+		}
+
+		return r;
+	}
+
+	/**
+		Insert integral.
+
+		\param[in,out] w Reference to ostream or bit_writer on lhs of <<
+		operator.
+		\return Reference to writer parameter.
+	*/
+	template <typename Writer>
+	Writer &put(Writer &w) const
+	{
+		if (*m_value < 0)
+		{
+			w.setstate(std::ios_base::failbit);
+		}
+		else
+		{
+			detail::put_exp_golomb(w, static_cast<boost::uint64_t>(*m_value));
+		}
+
+		return w;
+	}
+
+private:
+	BOOST_STATIC_ASSERT(boost::is_integral<T>::value);
+
+	/**
+		Integral to extract to or insert.
+	*/
+	T *m_value;
+};
+
+/**
+	This class represents a signed Exp-Golomb code, se(v), of an integral.
+
+	\note Values 0, 1, -1, 2, -2... are coded as unsigned codes 0, 1, 2, 3,
+	4...
+
+	\see Implementation note for setrepeat manipulator.
+
+	\tparam T Integral type, possibly const for insertion.
+*/
+template <typename T>
+class signed_exp_golomb
+{
+public:
+	/**
+		Constructor.
+
+		\param[in] value Integral to extract to or insert.
+	*/
+	explicit signed_exp_golomb(T &value) : m_value(&value)
+	{
+		// Do nothing.
+	}
+
+	/**
+		Extract integral.
+
+		\param[in,out] r Reference to istream or bit_reader on lhs of >>
+		operator.
+		\return Reference to reader parameter.
+	*/
+	template <typename Reader>
+	Reader &get(Reader &r) const
+	{
+		boost::uint64_t code;
+		if (detail::get_exp_golomb(r, code) &&
+			!detail::assign_signed(*m_value, detail::exp_golomb_to_signed(code)))
+		{
+			r.setstate(std::ios_base::failbit);
+		}
+
+		return r;
+	}
+
+	/**
+		Insert integral.
+
+		\param[in,out] w Reference to ostream or bit_writer on lhs of <<
+		operator.
+		\return Reference to writer parameter.
+	*/
+	template <typename Writer>
+	Writer &put(Writer &w) const
+	{
+		// Positive values map to odd codes, others to even codes.
+		const boost::uint64_t magnitude = *m_value > 0 ?
+			static_cast<boost::uint64_t>(*m_value) :
+			boost::uint64_t(0) - static_cast<boost::uint64_t>(*m_value);
+		if (magnitude > (~boost::uint64_t(0) >> 1))
+		{
+			w.setstate(std::ios_base::failbit);
+		}
+		else
+		{
+			detail::put_exp_golomb(w, *m_value > 0 ?
+				2 * magnitude - 1 : 2 * magnitude);
+		}
+
+		return w;
+	}
+
+private:
+	BOOST_STATIC_ASSERT(boost::is_integral<T>::value);
+
+	/**
+		Integral to extract to or insert.
+	*/
+	T *m_value;
+};
+///@}
+
+///@{
+/**
+	Make unsigned Exp-Golomb manipulator, e.g., bin >> ue(x) or bout << ue(x).
+
+	\note Extracting a value too big for the integral, or inserting a
+	negative one, fails the stream.
+
+	\param[in] value Integral to extract to or insert.
+	\return Manipulator.
+*/
+template <typename T>
+inline unsigned_exp_golomb<T> ue(T &value)
+{
+	return unsigned_exp_golomb<T>(value);
+}
+
+template <typename T>
+inline unsigned_exp_golomb<const T> ue(const T &value)
+{
+	return unsigned_exp_golomb<const T>(value);
+}
+///@}
+
+///@{
+/**
+	Make signed Exp-Golomb manipulator, e.g., bin >> se(x) or bout << se(x).
+
+	\note Extracting a value that does not fit the integral fails the
+	stream.
+
+	\param[in] value Integral to extract to or insert.
+	\return Manipulator.
+*/
+template <typename T>
+inline signed_exp_golomb<T> se(T &value)
+{
+	return signed_exp_golomb<T>(value);
+}
+
+template <typename T>
+inline signed_exp_golomb<const T> se(const T &value)
+{
+	return signed_exp_golomb<const T>(value);
+}
+///@}
+
+///@{
+/**
+	Extractor of an Exp-Golomb code.
+
+	\param[in,out] ibs Reference to istream on left-hand side of operator.
+	\param[in] code Manipulator returned by ue() or se().
+	\return Reference to istream parameter.
+*/
+template <typename T>
+inline istream &operator>>(istream &ibs, unsigned_exp_golomb<T> code)
+{
+	return code.get(ibs);
+}
+
+template <typename T>
+inline istream &operator>>(istream &ibs, signed_exp_golomb<T> code)
+{
+	return code.get(ibs);
+}
+///@}
+
+///@{
+/**
+	Extractor of an Exp-Golomb code.
+
+	\param[in,out] r Reference to bit_reader on left-hand side of operator.
+	\param[in] code Manipulator returned by ue() or se().
+	\return Reference to bit_reader parameter.
+*/
+template <typename T>
+inline bit_reader &operator>>(bit_reader &r, unsigned_exp_golomb<T> code)
+{
+	return code.get(r);
+}
+
+template <typename T>
+inline bit_reader &operator>>(bit_reader &r, signed_exp_golomb<T> code)
+{
+	return code.get(r);
+}
+///@}
+
+///@{
+/**
+	Inserter of an Exp-Golomb code.
+
+	\param[in,out] obs Reference to ostream on left-hand side of operator.
+	\param[in] code Manipulator returned by ue() or se().
+	\return Reference to ostream parameter.
+*/
+template <typename T>
+inline ostream &operator<<(ostream &obs, unsigned_exp_golomb<T> code)
+{
+	return code.put(obs);
+}
+
+template <typename T>
+inline ostream &operator<<(ostream &obs, signed_exp_golomb<T> code)
+{
+	return code.put(obs);
+}
+///@}
+
+///@{
+/**
+	Inserter of an Exp-Golomb code.
+
+	\param[in,out] w Reference to bit_writer on left-hand side of operator.
+	\param[in] code Manipulator returned by ue() or se().
+	\return Reference to bit_writer parameter.
+*/
+template <typename T>
+inline bit_writer &operator<<(bit_writer &w, unsigned_exp_golomb<T> code)
+{
+	return code.put(w);
+}
+
+template <typename T>
+inline bit_writer &operator<<(bit_writer &w, signed_exp_golomb<T> code)
+{
+	return code.put(w);
+}
+///@}
+
+/**
+	Get array of unsigned Exp-Golomb codes.
+
+	\note Runs of short codes, like those of H.264 slice data and
+	coefficient tables, are decoded several to a peek; see
+	detail::get_exp_golomb(Reader &, boost::uint64_t *, size_t).
+
+	\tparam Reader istream or bit_reader.
+	\param[in,out] r Reader from which to get codes.
+	\param[out] values Array to receive values.
+	\param[in] count Number of codes to get.
+	\return Number of codes gotten, which is less than count only if the
+	reader failed.
+*/
+template <typename Reader, typename T>
+size_t read_ue(Reader &r, T *values, size_t count)
+{
+	BOOST_STATIC_ASSERT(boost::is_integral<T>::value);
+
+	boost::uint64_t codes[64];
+	size_t done = 0;
+	while (done < count)
+	{
+		const size_t n = detail::get_exp_golomb(r, codes,
+			std::min(count - done, sizeof codes / sizeof codes[0]));
+		for (size_t i = 0; i < n; ++i, ++done)
+		{
+			if (!detail::assign_unsigned(values[done], codes[i]))
+			{
+				r.setstate(std::ios_base::failbit);
+				return done;
+			}
+		}
+		if (!r)
+		{
+			break;
+		}
+	}
+
+	return done;
+}
+
+/**
+	Get array of signed Exp-Golomb codes.
+
+	\note See read_ue().
+
+	\tparam Reader istream or bit_reader.
+	\param[in,out] r Reader from which to get codes.
+	\param[out] values Array to receive values.
+	\param[in] count Number of codes to get.
+	\return Number of codes gotten, which is less than count only if the
+	reader failed.
+*/
+template <typename Reader, typename T>
+size_t read_se(Reader &r, T *values, size_t count)
+{
+	BOOST_STATIC_ASSERT(boost::is_integral<T>::value);
+
+	boost::uint64_t codes[64];
+	size_t done = 0;
+	while (done < count)
+	{
+		const size_t n = detail::get_exp_golomb(r, codes,
+			std::min(count - done, sizeof codes / sizeof codes[0]));
+		for (size_t i = 0; i < n; ++i, ++done)
+		{
+			if (!detail::assign_signed(values[done],
+				detail::exp_golomb_to_signed(codes[i])))
+			{
+				r.setstate(std::ios_base::failbit);
+				return done;
+			}
+		}
+		if (!r)
+		{
+			break;
+		}
+	}
+
+	return done;
+}
+
+// LEB128 integers ////////////////////////////////////////////////////////////
+
+/**
+	This class represents a LEB128 integer (varint), as in DWARF,
+	WebAssembly and Protocol Buffers.
+
+	\note With an unsigned integral, the groups are the value; with a signed
+	one, the last group is sign extended, as in SLEB128.
+
+	\see Implementation note for setrepeat manipulator.
+
+	\tparam T Integral type, possibly const for insertion.
+*/
+template <typename T>
+class leb128_integer
+{
+public:
+	/**
+		Constructor.
+
+		\param[in] value Integral to extract to or insert.
+	*/
+	explicit leb128_integer(T &value) : m_value(&value)
+	{
+		// Do nothing.
+	}
+
+	/**
+		Extract integral.
+
+		\param[in,out] r Reference to istream or bit_reader on lhs of >>
+		operator.
+		\return Reference to reader parameter.
+	*/
+	template <typename Reader>
+	Reader &get(Reader &r) const
+	{
+		boost::uint64_t groups;
+		size_t bits;
+		if (detail::get_leb128(r, groups, bits))
+		{
+			bool fits;
+			if (std::numeric_limits<T>::is_signed)
+			{
+				if (bits < 64 && ((groups >> (bits - 1)) & 1) != 0)
+				{
+					groups |= ~boost::uint64_t(0) << bits;
+				}
+				fits = detail::assign_signed(*m_value,
+					static_cast<boost::int64_t>(groups));
+			}
+			else
+			{
+				fits = detail::assign_unsigned(*m_value, groups);
+			}
+			if (!fits)
+			{
+				r.setstate(std::ios_base::failbit);
+			}
+		}
+
+		return r;
+	}
+
+	/**
+		Insert integral.
+
+		\param[in,out] w Reference to ostream or bit_writer on lhs of <<
+		operator.
+		\return Reference to writer parameter.
+	*/
+	template <typename Writer>
+	Writer &put(Writer &w) const
+	{
+		detail::put_leb128(w, static_cast<boost::uint64_t>(*m_value),
+			std::numeric_limits<T>::is_signed);
+
+		return w;
+	}
+
+private:
+	BOOST_STATIC_ASSERT(boost::is_integral<T>::value);
+
+	/**
+		Integral to extract to or insert.
+	*/
+	T *m_value;
+};
+
+///@{
+/**
+	Make LEB128 manipulator, e.g., bin >> leb128(x) or bout << leb128(x).
+
+	\note Whether the integer is signed follows the integral.
+
+	\param[in] value Integral to extract to or insert.
+	\return Manipulator.
+*/
+template <typename T>
+inline leb128_integer<T> leb128(T &value)
+{
+	return leb128_integer<T>(value);
+}
+
+template <typename T>
+inline leb128_integer<const T> leb128(const T &value)
+{
+	return leb128_integer<const T>(value);
+}
+///@}
+
+/**
+	Extractor of a LEB128 integer.
+
+	\param[in,out] ibs Reference to istream on left-hand side of operator.
+	\param[in] integer Manipulator returned by leb128().
+	\return Reference to istream parameter.
+*/
+template <typename T>
+inline istream &operator>>(istream &ibs, leb128_integer<T> integer)
+{
+	return integer.get(ibs);
+}
+
+/**
+	Extractor of a LEB128 integer.
+
+	\param[in,out] r Reference to bit_reader on left-hand side of operator.
+	\param[in] integer Manipulator returned by leb128().
+	\return Reference to bit_reader parameter.
+*/
+template <typename T>
+inline bit_reader &operator>>(bit_reader &r, leb128_integer<T> integer)
+{
+	return integer.get(r);
+}
+
+/**
+	Inserter of a LEB128 integer.
+
+	\param[in,out] obs Reference to ostream on left-hand side of operator.
+	\param[in] integer Manipulator returned by leb128().
+	\return Reference to ostream parameter.
+*/
+template <typename T>
+inline ostream &operator<<(ostream &obs, leb128_integer<T> integer)
+{
+	return integer.put(obs);
+}
+
+/**
+	Inserter of a LEB128 integer.
+
+	\param[in,out] w Reference to bit_writer on left-hand side of operator.
+	\param[in] integer Manipulator returned by leb128().
+	\return Reference to bit_writer parameter.
+*/
+template <typename T>
+inline bit_writer &operator<<(bit_writer &w, leb128_integer<T> integer)
+{
+	return integer.put(w);
+}
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
@@ -0,0 +1,404 @@
+/** \file
+    \brief Growable bit-stream buffer and output stream.
+    \details This header file contains a bitbuf that owns and grows its
+        storage as bits are written to it, and an output bit-stream class
+        that uses it.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_VECTORBUF_HPP
+#define BOOST_BITSTREAM_VECTORBUF_HPP
+
+#include <boost/bitstream/ostream.hpp>
+#include <boost/noncopyable.hpp>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace boost {
+
+namespace bitstream {
+
+// basic_vectorbitbuf /////////////////////////////////////////////////////////
+
+/**
+    This class represents a sequence of bits written to storage that the
+    object owns and grows as needed.
+
+    \note This class is analogous to boost::interprocess::basic_vectorbuf,
+    except that it provides access to bits rather than characters. Storage is
+    a std::vector<unsigned char, Allocator>; the allocator may be an arena or
+    pool allocator. When a write does not fit, the storage grows
+    geometrically, so no worst-case sizing is needed up front.
+
+    \note This is an output buffer; its input sequence is empty. It is not
+    copyable, as a copy would still point into this object's storage.
+*/
+template <class Allocator = std::allocator<unsigned char> >
+class basic_vectorbitbuf : public bitbuf, private boost::noncopyable
+{
+public:
+	/**
+		Type of storage.
+	*/
+	typedef std::vector<unsigned char, Allocator> vector_type;
+
+	/**
+		Constructor.
+
+		\param[in] allocator Allocator for storage.
+	*/
+	explicit basic_vectorbitbuf(const Allocator &allocator = Allocator()) :
+		bitbuf(std::ios_base::out), m_bytes(allocator), m_high_water(0)
+	{
+	}
+
+	/**
+		Constructor.
+
+		\param[in] reserve_bytes Number of bytes to allocate up front.
+		\param[in] allocator Allocator for storage.
+	*/
+	explicit basic_vectorbitbuf(typename vector_type::size_type reserve_bytes,
+		const Allocator &allocator = Allocator()) :
+		bitbuf(std::ios_base::out), m_bytes(allocator), m_high_water(0)
+	{
+		grow(static_cast<bitpos>(reserve_bytes) * CHAR_BIT);
+	}
+
+	/**
+		Get number of bits written.
+
+		\note This is the position just past the furthest bit written, even
+		if the put pointer has since been moved back with seekp().
+
+		\return Number of bits written.
+	*/
+	std::streamsize bits() const
+	{
+		return static_cast<std::streamsize>(std::max(m_high_water, pptr()));
+	}
+
+	/**
+		Hand over the storage without copying it.
+
+		\note The storage is swapped into bytes and truncated to the number of
+		bytes spanned by bits(). Afterward, this object is empty and may be
+		written again.
+
+		\param[out] bytes Vector to receive the bytes written.
+	*/
+	void release(vector_type &bytes)
+	{
+		m_bytes.resize((static_cast<size_t>(bits()) + CHAR_BIT - 1) / CHAR_BIT);
+		bytes.swap(m_bytes);
+
+		m_bytes.clear();
+		m_high_water = 0;
+		setg(NULL, 0, 0, 0);
+		setp(NULL, 0, 0);
+	}
+
+protected:
+	// Virtual buffer-management and positioning functions ////////////////////
+
+	/**
+		Set buffer to access.
+
+		\note Not supported; this object owns its storage.
+
+		\return NULL.
+	*/
+	virtual bitbuf *setbuf(unsigned char *, std::streamsize)
+	{
+		return NULL;
+	}
+
+	/**
+		Set put pointer relative to current position.
+
+		\note Seeking the put pointer past the end of storage grows it; the
+		bits skipped over are zero. std::ios_base::end is relative to bits().
+
+		\param[in] offset Amount by which put pointer is adjusted.
+		\param[in] way From which pointer offset is applied for new position.
+		\param[in] which Open mode.
+		\return New position after put pointer modified.
+	*/
+	virtual std::streampos seekoff(std::streamoff offset,
+		std::ios_base::seekdir way,
+		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+	{
+		std::streampos new_position = std::streampos(-1);
+
+		if ((which & std::ios_base::out) != 0)
+		{
+			bitpos target = -1;
+
+			switch (way)
+			{
+			case std::ios_base::beg:
+				target = pbase() + offset;
+				break;
+
+			case std::ios_base::cur:
+				target = pptr() + offset;
+				break;
+
+			case std::ios_base::end:
+				target = bits() + offset;
+				break;
+
+			default:
+				break;
+			}
+
+			new_position = seekpos(std::streampos(target), which);
+		}
+
+		return new_position;
+	}
+
+	/**
+		Set put pointer to absolute position.
+
+		\note See note for seekoff().
+
+		\param[in] position New absolute position for put pointer.
+		\param[in] which Open mode.
+		\return New position after put pointer modified or
+		std::streampos(-1) if error.
+	*/
+	virtual std::streampos seekpos(std::streampos position,
+		std::ios_base::openmode which = std::ios_base::in | std::ios_base::out)
+	{
+		std::streampos new_position = std::streampos(-1);
+		const bitpos target = std::streamoff(position);
+
+		if ((which & std::ios_base::out) != 0 && target >= pbase() &&
+			grow(target))
+		{
+			m_high_water = std::max(m_high_water, pptr());
+			new_position = bitbuf::seekpos(position, std::ios_base::out);
+		}
+
+		return new_position;
+	}
+
+	// Virtual output functions ///////////////////////////////////////////////
+
+	/**
+		Put sequence of bits.
+
+		\note This is only called when the bits do not fit in the storage
+		allocated so far.
+
+		\param[in] value Value of bit field.
+		\param[in] size Number of bits in sequence of bits.
+		\return Number of bits written to buffer or zero if error.
+	*/
+	virtual std::streamsize xsputn(bitfield value, std::streamsize size)
+	{
+		return size > 0 && grow(pptr() + size) ? bitbuf::xsputn(value, size) : 0;
+	}
+
+	/**
+		Put bit at put pointer after growing storage.
+
+		\note The bit is put with bitbuf::xsputn(), not sputb(), which is
+		what called this and counts the bit.
+
+		\param[in] b Bit to be put.
+		\return Whether the bit was successully put.
+	*/
+	virtual bool overflow(bitfield b)
+	{
+		return grow(pptr() + 1) && bitbuf::xsputn(b, 1) == 1;
+	}
+
+private:
+	/**
+		Minimum number of bytes allocated.
+	*/
+	static const size_t minimum_size = 64;
+
+	/**
+		Make storage large enough to hold bits.
+
+		\note Storage at least doubles each time it is reallocated. The get
+		and put positions are preserved across reallocation.
+
+		\param[in] end Position of bit just past last bit to be accessible.
+		\return Whether the storage is large enough.
+	*/
+	bool grow(bitpos end)
+	{
+		bool grew = true;
+
+		if (end > epptr())
+		{
+			const size_t needed = (static_cast<size_t>(end) + CHAR_BIT - 1) / CHAR_BIT;
+			const size_t new_size = std::max(needed,
+				std::max(m_bytes.size() * 2, size_t(minimum_size)));
+			const bitpos put_position = pptr();
+
+			try
+			{
+				m_bytes.resize(new_size);
+			}
+			catch (const std::bad_alloc &)
+			{
+				grew = false;
+			}
+
+			if (grew)
+			{
+				unsigned char * const buffer = &m_bytes[0];
+				setg(buffer, 0, 0, 0);
+				setp(buffer, 0, static_cast<bitpos>(m_bytes.size()) * CHAR_BIT);
+				pbump(put_position);
+			}
+		}
+
+		return grew;
+	}
+
+	/**
+		Storage for bits.
+	*/
+	vector_type m_bytes;
+
+	/**
+		Position just past the furthest bit written before the put pointer
+		was last moved back.
+	*/
+	bitpos m_high_water;
+};
+
+/**
+	A growable bitbuf using the default allocator.
+*/
+typedef basic_vectorbitbuf<> vectorbitbuf;
+
+// basic_ovectorbitstream /////////////////////////////////////////////////////
+
+/**
+    This class provides an interface to manipulate bits as an output stream
+    whose storage grows as needed.
+
+    \note This class is analogous to boost::interprocess::basic_ovectorstream.
+    Like its buffer, it is not copyable.
+*/
+template <class Allocator = std::allocator<unsigned char> >
+class basic_ovectorbitstream : public ostream, private boost::noncopyable
+{
+public:
+	/**
+		Type of storage.
+	*/
+	typedef typename basic_vectorbitbuf<Allocator>::vector_type vector_type;
+
+    /**
+        Constructor.
+
+        \param[in] allocator Allocator for storage.
+    */
+    explicit basic_ovectorbitstream(const Allocator &allocator = Allocator()) :
+        ostream(&m_bitbuf), m_bitbuf(allocator)
+    {
+    }
+
+    /**
+        Constructor.
+
+		\param[in] reserve_bytes Number of bytes to allocate up front.
+        \param[in] allocator Allocator for storage.
+    */
+    explicit basic_ovectorbitstream(typename vector_type::size_type reserve_bytes,
+		const Allocator &allocator = Allocator()) :
+        ostream(&m_bitbuf), m_bitbuf(reserve_bytes, allocator)
+    {
+    }
+
+	/**
+		Destructor.
+
+		\note Bits still collected by the stream are written to the buffer
+		here because the buffer is destroyed before the base class.
+	*/
+	~basic_ovectorbitstream()
+	{
+		flush();
+	}
+
+    /**
+        Get the bitbuf object associated with the stream upon construction.
+
+        \return A pointer to the bitbuf object associated with the stream.
+    */
+    basic_vectorbitbuf<Allocator> *rdbuf() const
+    {
+        return const_cast<basic_vectorbitbuf<Allocator> *>(&m_bitbuf);
+    }
+
+    /**
+        Get pointer to current contents of the stream.
+
+        \note This pointer is invalidated when the storage grows.
+
+        \return Pointer to stream buffer.
+    */
+    const char *data() const
+    {
+        return m_bitbuf.data();
+    }
+
+	/**
+		Get number of bits written.
+
+		\note Bits collected while unitbuf() is false are not counted until
+		flush().
+
+		\return Number of bits written.
+	*/
+	std::streamsize bits() const
+	{
+		return m_bitbuf.bits();
+	}
+
+	/**
+		Hand over the storage without copying it.
+
+		\see basic_vectorbitbuf::release().
+
+		\param[out] bytes Vector to receive the bytes written.
+	*/
+	void release(vector_type &bytes)
+	{
+		flush();
+		m_bitbuf.release(bytes);
+	}
+
+private:
+    /**
+        Buffer to which this class serially writes bits.
+    */
+    basic_vectorbitbuf<Allocator> m_bitbuf;
+};
+
+/**
+	A growable output bit stream using the default allocator.
+*/
+typedef basic_ovectorbitstream<> ovectorbitstream;
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
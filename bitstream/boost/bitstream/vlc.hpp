@@ -0,0 +1,410 @@
+/** \file
+    \brief Variable-length code decoding.
+    \details This header file contains a table-driven decoder of
+        variable-length codes, such as Huffman codes.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#ifndef BOOST_BITSTREAM_VLC_HPP
+#define BOOST_BITSTREAM_VLC_HPP
+
+#include <boost/bitstream/cursor.hpp>
+#include <boost/bitstream/istream.hpp>
+#include <boost/cstdint.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace boost {
+
+namespace bitstream {
+
+// vlc_code ///////////////////////////////////////////////////////////////////
+
+/**
+    This class represents one code of a variable-length code: its bits, how
+	many there are, and the symbol it stands for.
+*/
+template <typename Symbol>
+struct vlc_code
+{
+	/**
+		Constructor.
+
+		\param[in] bits_ Bits of code, right-justified, first bit most
+		significant.
+		\param[in] length_ Number of bits in code.
+		\param[in] symbol_ Symbol that code stands for.
+	*/
+	vlc_code(bitfield bits_, size_t length_, const Symbol &symbol_) :
+		bits(bits_), length(length_), symbol(symbol_)
+	{
+		// Do nothing.
+	}
+
+	/**
+		Bits of code, right-justified.
+	*/
+	bitfield bits;
+
+	/**
+		Number of bits in code.
+	*/
+	size_t length;
+
+	/**
+		Symbol that code stands for.
+	*/
+	Symbol symbol;
+};
+
+// vlc_table //////////////////////////////////////////////////////////////////
+
+/**
+    This class represents a variable-length code as a multi-level lookup
+	table, built once from the list of codes.
+
+	\note A symbol is decoded by peeking at the next index_bits bits, looking
+	them up, and skipping only as many bits as the code has. Codes longer
+	than index_bits continue in a subtable indexed by the bits that follow,
+	so most symbols take one lookup and memory stays small. This works with
+	either an istream or a bit_reader. For a reader with lsb_first, such as
+	one of DEFLATE's Huffman codes, the table is built for that order, with
+	the first bit of each index in its LSB, so lookups cost the same.
+
+	\tparam Symbol Type of decoded symbols.
+*/
+template <typename Symbol = int>
+class vlc_table
+{
+public:
+	/**
+		Longest code supported.
+	*/
+	static const size_t max_code_length = 32;
+
+	/**
+		Constructor.
+
+		\note If the codes are not prefix free, or any length is 0 or more
+		than max_code_length, the table is not valid(). The codes need not
+		be complete; bits that match no code fail to decode.
+
+		\param[in] first Iterator to first vlc_code<Symbol>.
+		\param[in] last Iterator just past last code.
+		\param[in] index_bits Number of bits looked up at a time; more is
+		faster for long codes but takes more memory.
+		\param[in] order Order of bits of readers to decode; the bits of each
+		code are first bit most significant either way.
+	*/
+	template <typename InputIterator>
+	vlc_table(InputIterator first, InputIterator last, size_t index_bits = 9,
+		bit_order order = msb_first) :
+		m_index_bits(std::max(size_t(1), std::min(index_bits, size_t(max_code_length)))),
+		m_order(order),
+		m_valid(true)
+	{
+		std::vector<prefix_code> codes;
+		for (; first != last; ++first)
+		{
+			if (first->length == 0 || first->length > max_code_length)
+			{
+				m_valid = false;
+			}
+			else
+			{
+				const prefix_code code = { first->bits & low_bits(first->length),
+					first->length, first->symbol };
+				codes.push_back(code);
+			}
+		}
+
+		if (m_valid)
+		{
+			m_entries.resize(size_t(1) << m_index_bits);
+			build(0, m_index_bits, codes);
+		}
+
+		if (!m_valid)
+		{
+			m_entries.assign(size_t(1) << m_index_bits, entry());
+		}
+	}
+
+	/**
+		Determine whether the table was built.
+
+		\return Whether the codes were usable.
+	*/
+	bool valid() const
+	{
+		return m_valid;
+	}
+
+	/**
+		Get number of bits looked up at a time at the first level.
+
+		\return Number of index bits.
+	*/
+	size_t index_bits() const
+	{
+		return m_index_bits;
+	}
+
+	/**
+		Get order of bits of readers that table decodes.
+
+		\return Bit order.
+	*/
+	bit_order order() const
+	{
+		return m_order;
+	}
+
+	/**
+		Get one symbol.
+
+		\note If the next bits match no code, or the stream ends within a
+		code, or the reader's order is not that of the table, the stream
+		fails.
+
+		\tparam Reader istream or bit_reader.
+		\param[in,out] r Reader from which to get symbol.
+		\param[out] symbol Symbol decoded.
+		\return Reference to reader parameter.
+	*/
+	template <typename Reader>
+	Reader &decode(Reader &r, Symbol &symbol) const
+	{
+		if (detail::order_of(r) != m_order)
+		{
+			r.setstate(std::ios_base::failbit);
+			return r;
+		}
+
+		size_t offset = 0;
+		std::streamsize bits = static_cast<std::streamsize>(m_index_bits);
+
+		for (;;)
+		{
+			const entry &e = m_entries[offset +
+				static_cast<size_t>(r.show_bits(bits))];
+			if (e.length > 0)
+			{
+				if (r.skip(e.length))
+				{
+					symbol = e.symbol;
+				}
+				break;
+			}
+			else if (e.sub_bits == 0)
+			{
+				r.setstate(std::ios_base::failbit);
+				break;
+			}
+			else if (!r.skip(bits))
+			{
+				break;
+			}
+
+			offset = e.next;
+			bits = e.sub_bits;
+		}
+
+		return r;
+	}
+
+	/**
+		Get array of symbols.
+
+		\param[in,out] r Reader from which to get symbols.
+		\param[out] symbols Array to receive symbols.
+		\param[in] count Number of symbols to get.
+		\return Number of symbols gotten, which is less than count only if
+		the reader failed.
+	*/
+	template <typename Reader>
+	size_t decode(Reader &r, Symbol *symbols, size_t count) const
+	{
+		size_t decoded = 0;
+
+		while (decoded < count && decode(r, symbols[decoded]))
+		{
+			++decoded;
+		}
+
+		return decoded;
+	}
+
+private:
+	/**
+		Code with the bits already looked up removed.
+	*/
+	struct prefix_code
+	{
+		bitfield bits;
+		size_t length;
+		Symbol symbol;
+	};
+
+	/**
+		Table entry: a symbol and length of its code at this level; or, if
+		length is 0, a subtable of sub_bits index bits at next; or, if both
+		are 0, no code.
+	*/
+	struct entry
+	{
+		entry() : symbol(), next(0), length(0), sub_bits(0)
+		{
+			// Do nothing.
+		}
+
+		Symbol symbol;
+		boost::uint32_t next;
+		boost::uint8_t length;
+		boost::uint8_t sub_bits;
+	};
+
+	/**
+		Get mask of low bits.
+
+		\param[in] bits Number of bits, up to max_code_length.
+		\return Mask.
+	*/
+	static bitfield low_bits(size_t bits)
+	{
+		return (bitfield(1) << bits) - 1;
+	}
+
+	/**
+		Get entry of table for index bits.
+
+		\param[in] offset Index of first entry of table.
+		\param[in] index Index bits, first bit most significant.
+		\param[in] bits Number of index bits of table.
+		\return Entry, whose position is index as looked up in m_order.
+	*/
+	entry &slot(size_t offset, size_t index, size_t bits)
+	{
+		if (m_order == lsb_first)
+		{
+			size_t reversed = 0;
+			for (size_t i = 0; i < bits; ++i, index >>= 1)
+			{
+				reversed = (reversed << 1) | (index & 1);
+			}
+			index = reversed;
+		}
+
+		return m_entries[offset + index];
+	}
+
+	/**
+		Fill table with codes.
+
+		\param[in] offset Index of first entry of table.
+		\param[in] bits Number of index bits of table.
+		\param[in] codes Codes, without the bits of the tables above.
+	*/
+	void build(size_t offset, size_t bits, const std::vector<prefix_code> &codes)
+	{
+		// Short codes fill every entry whose index starts with them.
+		for (size_t i = 0; m_valid && i < codes.size(); ++i)
+		{
+			const prefix_code &code = codes[i];
+			if (code.length <= bits)
+			{
+				const size_t first =
+					static_cast<size_t>(code.bits << (bits - code.length));
+				const size_t last = first + (size_t(1) << (bits - code.length));
+				for (size_t j = first; j < last; ++j)
+				{
+					entry &e = slot(offset, j, bits);
+					if (e.length != 0 || e.sub_bits != 0)
+					{
+						m_valid = false;
+					}
+					e.symbol = code.symbol;
+					e.length = static_cast<boost::uint8_t>(code.length);
+				}
+			}
+		}
+
+		// Long codes go in a subtable for each index they start with.
+		std::vector<bool> done(size_t(1) << bits);
+		for (size_t i = 0; m_valid && i < codes.size(); ++i)
+		{
+			if (codes[i].length <= bits)
+			{
+				continue;
+			}
+
+			const size_t index = static_cast<size_t>(
+				codes[i].bits >> (codes[i].length - bits));
+			if (done[index])
+			{
+				continue;
+			}
+			done[index] = true;
+
+			if (slot(offset, index, bits).length != 0)
+			{
+				m_valid = false;
+				break;
+			}
+
+			std::vector<prefix_code> rest;
+			size_t sub_bits = 0;
+			for (size_t j = i; j < codes.size(); ++j)
+			{
+				if (codes[j].length > bits &&
+					(codes[j].bits >> (codes[j].length - bits)) == index)
+				{
+					const size_t length = codes[j].length - bits;
+					const prefix_code code = { codes[j].bits & low_bits(length),
+						length, codes[j].symbol };
+					rest.push_back(code);
+					sub_bits = std::max(sub_bits, length);
+				}
+			}
+			sub_bits = std::min(sub_bits, m_index_bits);
+
+			const size_t next = m_entries.size();
+			m_entries.resize(next + (size_t(1) << sub_bits));
+			entry &e = slot(offset, index, bits);
+			e.next = static_cast<boost::uint32_t>(next);
+			e.sub_bits = static_cast<boost::uint8_t>(sub_bits);
+			build(next, sub_bits, rest);
+		}
+	}
+
+	/**
+		Number of index bits at first level.
+	*/
+	size_t m_index_bits;
+
+	/**
+		Order of bits of readers decoded.
+	*/
+	bit_order m_order;
+
+	/**
+		Whether codes were usable.
+	*/
+	bool m_valid;
+
+	/**
+		Entries of all tables, first level first.
+	*/
+	std::vector<entry> m_entries;
+};
+
+} // namespace bitstream
+
+} // namespace boost
+
+#endif
@@ -7,6 +7,66 @@
 // or copy at http://www.boost.org/LICENSE_1_0.txt)
 //
 
-// Placeholder for a codec example  bitstream_codec.cpp.
+// Example of decoding and encoding whole structs with codec.hpp.
 
+#include <boost/bitstream/bstream.hpp>
+#include <boost/bitstream/codec.hpp>
+#include <boost/fusion/include/adapt_struct.hpp>
 
+#include <iostream>
+
+// The bit layout of the fixed part of an RTP header (RFC 3550), described
+// once by the types of the members and the order in which they are adapted.
+typedef boost::bitstream::constant<2, 2> rtp_version;
+
+struct rtp_header
+{
+	rtp_version version;
+	bool padding, extension;
+	boost::bitstream::field<4> csrc_count;
+	bool marker;
+	boost::bitstream::field<7> payload_type;
+	boost::uint16_t sequence_number;
+	boost::uint32_t timestamp, ssrc;
+};
+
+BOOST_FUSION_ADAPT_STRUCT(
+	rtp_header,
+	(rtp_version, version)
+	(bool, padding)
+	(bool, extension)
+	(boost::bitstream::field<4>, csrc_count)
+	(bool, marker)
+	(boost::bitstream::field<7>, payload_type)
+	(boost::uint16_t, sequence_number)
+	(boost::uint32_t, timestamp)
+	(boost::uint32_t, ssrc)
+)
+
+int main()
+{
+	const char packet[] = { '\x80', '\x08', '\xe7', '\x3c', '\x00', '\x00', '\x3c', '\x00', '\xde', '\xe0', '\xee', '\x8f' };
+
+	// One bounds check for all 96 bits, then each field is extracted in turn.
+	boost::bitstream::ibitstream bin(packet, sizeof packet * CHAR_BIT);
+	rtp_header header;
+	if (!boost::bitstream::decode(bin, header))
+	{
+		std::cout << "Not an RTP header." << std::endl;
+		return 1;
+	}
+
+	std::cout << "Payload type " << static_cast<unsigned>(header.payload_type)
+		<< ", sequence number " << header.sequence_number
+		<< ", timestamp " << header.timestamp << std::endl;
+
+	// The same description drives the encoder. The version is always 2.
+	header.sequence_number++;
+	header.marker = true;
+	char buffer[sizeof packet];
+	boost::bitstream::obitstream bout(buffer, sizeof buffer * CHAR_BIT);
+	boost::bitstream::encode(bout, header);
+	std::cout << "Wrote " << bout.tellp() << " bits." << std::endl;
+
+	return bout ? 0 : 1;
+}
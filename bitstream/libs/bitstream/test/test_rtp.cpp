@@ -19,13 +19,32 @@
 
 #include <boost/test/included/unit_test.hpp>
 
+#include <boost/bitstream/batch.hpp>
 #include <boost/bitstream/bstream.hpp>
+#include <boost/bitstream/chainbuf.hpp>
+#include <boost/bitstream/checksum.hpp>
+#include <boost/bitstream/codec.hpp>
+#include <boost/bitstream/cursor.hpp>
+#include <boost/bitstream/feedbuf.hpp>
 #include <boost/bitstream/iomanip.hpp>
+#include <boost/bitstream/mappedbuf.hpp>
+#include <boost/bitstream/patch.hpp>
+#include <boost/bitstream/ringbuf.hpp>
+#include <boost/bitstream/streambuf.hpp>
+#include <boost/bitstream/unchecked.hpp>
+#include <boost/bitstream/varint.hpp>
+#include <boost/bitstream/vectorbuf.hpp>
+#include <boost/bitstream/vlc.hpp>
+#include <boost/fusion/include/adapt_struct.hpp>
 
+#include <cstdio>
+#include <fstream>
+#include <numeric>
 #include <sstream>
 #include <deque>
 #include <array>
 #include <forward_list>
+#include <thread>
 
 BOOST_AUTO_TEST_CASE(rtp)
 {
@@ -578,4 +597,2566 @@ BOOST_AUTO_TEST_CASE(operator_void_pointer)
 		BOOST_CHECK((void *)bin);
 		BOOST_CHECK(static_cast<void *>(bin));
 	}
-}
\ No newline at end of file
+}
+
+BOOST_AUTO_TEST_CASE(unaligned_64_bit)
+{
+	// A 64-bit field after a single bit spans nine bytes.
+	{
+		const char buffer[] = { '\x81', '\x02', '\x03', '\x04', '\x05', '\x06', '\x07', '\x08', '\x80' };
+		boost::bitstream::ibitstream bin(buffer, sizeof buffer * CHAR_BIT);
+		bool b;
+		boost::uint64_t u;
+		bin >> b >> u;
+		BOOST_CHECK(bin);
+		BOOST_CHECK(b);
+		BOOST_CHECK(u == 0x020406080a0c0e11ULL);
+		BOOST_CHECK(bin.tellg() == std::streampos(65));
+	}
+
+	// Fields near the end of a buffer shorter than a 64-bit window.
+	{
+		const char buffer[] = { '\xde', '\xad', '\xbe' };
+		boost::bitstream::ibitstream bin(buffer, sizeof buffer * CHAR_BIT);
+		std::bitset<3> a;
+		std::bitset<17> b;
+		std::bitset<4> c;
+		bin >> a >> b >> c;
+		BOOST_CHECK(bin);
+		BOOST_CHECK(bin.eof());
+		BOOST_CHECK(a.to_ulong() == 0x6);
+		BOOST_CHECK(b.to_ulong() == 0x1eadb);
+		BOOST_CHECK(c.to_ulong() == 0xe);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(bit_positions)
+{
+	// Positions are plain 64-bit integrals internally, so a bitbuf fits in a
+	// cache line on common platforms, unless padded apart on purpose.
+	BOOST_CHECK(sizeof(boost::bitstream::bitpos) == 8);
+#ifndef BOOST_BITSTREAM_PAD_AREAS
+	BOOST_CHECK(sizeof(boost::bitstream::bitbuf) <= 64 + sizeof(void *));
+#endif
+
+	const char buffer[] = { '\x12', '\x34', '\x56', '\x78' };
+	boost::bitstream::ibitstream bin(buffer, sizeof buffer * CHAR_BIT);
+	std::bitset<4> nibble;
+
+	bin.seekg(std::streampos(12));
+	BOOST_CHECK(bin.tellg() == std::streampos(12));
+	bin >> nibble;
+	BOOST_CHECK(nibble.to_ulong() == 0x4);
+
+	bin.seekg(-8, std::ios_base::end);
+	BOOST_CHECK(bin.tellg() == std::streampos(24));
+	bin >> nibble;
+	BOOST_CHECK(nibble.to_ulong() == 0x7);
+
+	bin.seekg(-12, std::ios_base::cur);
+	BOOST_CHECK(bin.tellg() == std::streampos(16));
+
+	bin.seekg(std::streampos(33));
+	BOOST_CHECK(bin.fail());
+}
+
+BOOST_AUTO_TEST_CASE(fixed_width_round_trip)
+{
+	char buffer[32];
+	std::memset(buffer, 0xa5, sizeof buffer);
+
+	{
+		boost::bitstream::obitstream bout(buffer, sizeof buffer * CHAR_BIT);
+		bout << true << boost::uint64_t(0x0123456789abcdefULL)
+			<< std::bitset<7>(0x55) << boost::uint8_t(0xc3)
+			<< boost::uint16_t(0xbeef) << boost::uint32_t(0xcafef00d)
+			<< boost::uint64_t(0xfedcba9876543210ULL) << std::bitset<3>(0x5);
+		BOOST_CHECK(bout);
+		BOOST_CHECK(bout.tellp() == std::streampos(1 + 64 + 7 + 8 + 16 + 32 + 64 + 3));
+	}
+
+	// The bits after the last field must be untouched.
+	BOOST_CHECK((buffer[24] & 0x1f) == 0x05);
+	BOOST_CHECK(buffer[25] == '\xa5');
+
+	{
+		boost::bitstream::ibitstream bin(buffer, sizeof buffer * CHAR_BIT);
+		bool b;
+		boost::uint64_t u64a, u64b;
+		std::bitset<7> bs7;
+		boost::uint8_t u8;
+		boost::uint16_t u16;
+		boost::uint32_t u32;
+		std::bitset<3> bs3;
+		bin >> b >> u64a >> bs7 >> u8 >> u16 >> u32 >> u64b >> bs3;
+		BOOST_CHECK(bin);
+		BOOST_CHECK(b);
+		BOOST_CHECK(u64a == 0x0123456789abcdefULL);
+		BOOST_CHECK(bs7.to_ulong() == 0x55);
+		BOOST_CHECK(u8 == 0xc3);
+		BOOST_CHECK(u16 == 0xbeef);
+		BOOST_CHECK(u32 == 0xcafef00d);
+		BOOST_CHECK(u64b == 0xfedcba9876543210ULL);
+		BOOST_CHECK(bs3.to_ulong() == 0x5);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(vector_output)
+{
+	const char rtpHeader[] = { '\x80', '\x08', '\xe7', '\x3c', '\x00', '\x00', '\x3c', '\x00', '\xde', '\xe0', '\xee', '\x8f' };
+
+#ifndef BOOST_NO_CXX11_HDR_TYPE_TRAITS
+	// A copy would point into the original's storage.
+	BOOST_CHECK(!std::is_copy_constructible<boost::bitstream::vectorbitbuf>::value);
+	BOOST_CHECK(!std::is_copy_assignable<boost::bitstream::vectorbitbuf>::value);
+	BOOST_CHECK(!std::is_copy_constructible<boost::bitstream::ovectorbitstream>::value);
+#endif
+
+	// No buffer needs to be provided, or sized for the worst case.
+	{
+		boost::bitstream::ovectorbitstream bout;
+		bout << std::bitset<2>(0x2) << false << false << std::bitset<4>(0)
+			<< false << std::bitset<7>(8) << boost::uint16_t(0xe73c)
+			<< boost::uint32_t(0x00003c00) << boost::uint32_t(0xdee0ee8f);
+		BOOST_CHECK(bout);
+		BOOST_CHECK(bout.bits() == sizeof rtpHeader * CHAR_BIT);
+		BOOST_CHECK(memcmp(bout.data(), rtpHeader, sizeof rtpHeader) == 0);
+
+		boost::bitstream::ovectorbitstream::vector_type bytes;
+		bout.release(bytes);
+		BOOST_CHECK(bytes.size() == sizeof rtpHeader);
+		BOOST_CHECK(memcmp(&bytes[0], rtpHeader, sizeof rtpHeader) == 0);
+		BOOST_CHECK(bout.bits() == 0);
+	}
+
+	// Storage grows across many reallocations, with fields straddling the
+	// old end of storage.
+	{
+		boost::bitstream::ovectorbitstream bout;
+		for (boost::uint32_t i = 0; i < 1000; ++i)
+		{
+			bout << std::bitset<3>(i) << i;
+		}
+		BOOST_CHECK(bout);
+		BOOST_CHECK(bout.tellp() == std::streampos(1000 * 35));
+
+		boost::bitstream::ovectorbitstream::vector_type bytes;
+		bout.release(bytes);
+		boost::bitstream::ibitstream bin(reinterpret_cast<const char *>(&bytes[0]),
+			1000 * 35);
+		bool okay = true;
+		for (boost::uint32_t i = 0; i < 1000; ++i)
+		{
+			std::bitset<3> bs;
+			boost::uint32_t u;
+			bin >> bs >> u;
+			okay = okay && bs.to_ulong() == (i & 0x7) && u == i;
+		}
+		BOOST_CHECK(bin);
+		BOOST_CHECK(okay);
+	}
+
+	// Ignoring bits past the end grows storage instead of failing, and
+	// seeking back does not lose the bits already written.
+	{
+		boost::bitstream::ovectorbitstream bout(1);
+		bout << boost::uint8_t(0xff);
+		bout.ignore(1000);
+		bout << true;
+		BOOST_CHECK(bout);
+		BOOST_CHECK(bout.bits() == 1009);
+		bout.seekp(std::streampos(4));
+		bout << std::bitset<4>(0);
+		BOOST_CHECK(bout.bits() == 1009);
+		BOOST_CHECK(bout.data()[0] == '\xf0');
+		BOOST_CHECK(bout.data()[1] == '\x00');
+		BOOST_CHECK(bout.data()[126] == '\x80');
+	}
+}
+
+BOOST_AUTO_TEST_CASE(write_combining)
+{
+	const char rtpHeader[] = { '\x80', '\x08', '\xe7', '\x3c', '\x00', '\x00', '\x3c', '\x00', '\xde', '\xe0', '\xee', '\x8f' };
+
+	// Collected bits are the same bits, and reach the buffer by flush().
+	{
+		char buffer[sizeof rtpHeader] = { 0 };
+		boost::bitstream::obitstream bout(buffer, sizeof buffer * CHAR_BIT);
+		bout << boost::bitstream::nounitbuf;
+		BOOST_CHECK(!bout.unitbuf());
+		bout << std::bitset<2>(0x2) << false << false << std::bitset<4>(0)
+			<< false << std::bitset<7>(8) << boost::uint16_t(0xe73c);
+		BOOST_CHECK(bout.tellp() == std::streampos(32));
+		bout << boost::uint32_t(0x00003c00) << boost::uint32_t(0xdee0ee8f);
+		BOOST_CHECK(bout.tellp() == std::streampos(96));
+		BOOST_CHECK(memcmp(buffer, rtpHeader, 8) == 0);
+		BOOST_CHECK(buffer[8] == 0);
+		bout << boost::bitstream::flush;
+		BOOST_CHECK(bout);
+		BOOST_CHECK(memcmp(buffer, rtpHeader, sizeof rtpHeader) == 0);
+	}
+
+	// Repositioning writes collected bits first; so does destruction.
+	{
+		char buffer[4] = { 0 };
+		{
+			boost::bitstream::obitstream bout(buffer, sizeof buffer * CHAR_BIT);
+			bout.unitbuf(false);
+			bout.write(0x5, 3);
+			bout.seekp(8, std::ios_base::beg);
+			BOOST_CHECK(buffer[0] == '\xa0');
+			bout << boost::uint8_t(0x3c);
+			bout.ignore(4);
+			bout.write(0xf, 4);
+			BOOST_CHECK(bout.tellp() == std::streampos(24));
+		}
+		BOOST_CHECK(buffer[1] == '\x3c');
+		BOOST_CHECK(buffer[2] == '\x0f');
+	}
+
+	// Writing past the end of the buffer is detected when bits are written.
+	{
+		char buffer[2] = { 0 };
+		boost::bitstream::obitstream bout(buffer, sizeof buffer * CHAR_BIT);
+		bout << boost::bitstream::nounitbuf << boost::uint8_t(0x12)
+			<< boost::uint16_t(0x3456);
+		BOOST_CHECK(bout);
+		bout.flush();
+		BOOST_CHECK(bout.bad());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(contiguous_containers)
+{
+	const char bytes[] = { '\x01', '\x02', '\x03', '\x04', '\x05', '\x06', '\x07', '\x08', '\x09', '\x0a', '\x0b', '\x0c', '\x0d' };
+
+	// Byte aligned, so copied in one go.
+	{
+		boost::bitstream::ibitstream bin(bytes, sizeof bytes * CHAR_BIT);
+		std::vector<boost::uint32_t> csrc;
+		boost::array<boost::uint8_t, 4> octets;
+		bin >> boost::bitstream::setrepeat(2) >> csrc >> octets;
+		BOOST_CHECK(bin);
+		BOOST_CHECK(bin.gcount() == 32);
+		BOOST_CHECK(csrc.size() == 2);
+		BOOST_CHECK(csrc[0] == 0x01020304 && csrc[1] == 0x05060708);
+		BOOST_CHECK(octets[0] == 0x09 && octets[3] == 0x0c);
+
+		char buffer[sizeof bytes] = { 0 };
+		boost::bitstream::obitstream bout(buffer, sizeof buffer * CHAR_BIT);
+		bout << csrc << octets << boost::uint8_t(0x0d);
+		BOOST_CHECK(bout);
+		BOOST_CHECK(memcmp(buffer, bytes, sizeof bytes) == 0);
+	}
+
+	// Not byte aligned, so extracted one element at a time.
+	{
+		boost::bitstream::ibitstream bin(bytes, sizeof bytes * CHAR_BIT);
+		std::vector<boost::uint16_t> v(3);
+		bin >> std::bitset<4>() >> v;
+		BOOST_CHECK(bin);
+		BOOST_CHECK(v[0] == 0x1020 && v[1] == 0x3040 && v[2] == 0x5060);
+
+		char buffer[7] = { 0 };
+		boost::bitstream::obitstream bout(buffer, sizeof buffer * CHAR_BIT);
+		bout << std::bitset<4>(0) << v;
+		BOOST_CHECK(bout);
+		BOOST_CHECK(memcmp(buffer, bytes, 6) == 0);
+		BOOST_CHECK(buffer[6] == 0);
+	}
+
+	// Too few bits, so it fails the same way element-by-element extraction
+	// does: the elements that fit are extracted, the rest zeroed.
+	{
+		boost::bitstream::ibitstream bin(bytes, sizeof bytes * CHAR_BIT);
+		std::vector<boost::uint32_t> v(4, 0xffffffff);
+		bin >> v;
+		BOOST_CHECK(bin.fail() && bin.eof());
+		BOOST_CHECK(v[2] == 0x090a0b0c && v[3] == 0);
+
+		char buffer[6] = { 0 };
+		boost::bitstream::obitstream bout(buffer, sizeof buffer * CHAR_BIT);
+		bout << v;
+		BOOST_CHECK(bout.bad());
+		BOOST_CHECK(memcmp(buffer, bytes, 4) == 0);
+	}
+}
+
+/**
+	Check that read_packed<N>() gets the same fields as extracting them one
+	at a time, from every bit offset within a byte.
+*/
+template <size_t N, typename T>
+bool read_packed_matches(const char *buffer, std::streamsize bits, size_t count)
+{
+	bool okay = true;
+
+	for (std::streamsize offset = 0; offset < CHAR_BIT; ++offset)
+	{
+		boost::bitstream::ibitstream bin(buffer, bits);
+		bin.ignore(offset);
+		std::vector<T> packed(count);
+		bin.read_packed<N>(&packed[0], count);
+		okay = okay && bin && bin.gcount() == std::streamsize(count * N);
+
+		boost::bitstream::ibitstream bin1(buffer, bits);
+		bin1.ignore(offset);
+		for (size_t i = 0; i < count; ++i)
+		{
+			std::bitset<N> bs;
+			bin1 >> bs;
+			okay = okay && packed[i] == static_cast<T>(bs.to_ulong());
+		}
+		okay = okay && bin.tellg() == bin1.tellg();
+	}
+
+	return okay;
+}
+
+BOOST_AUTO_TEST_CASE(packed_fields)
+{
+	char buffer[512];
+	for (size_t i = 0; i < sizeof buffer; ++i)
+	{
+		buffer[i] = static_cast<char>(i * 151 + 7);
+	}
+	const std::streamsize bits = sizeof buffer * CHAR_BIT;
+
+	// Field widths either side of those with SIMD kernels, and counts that
+	// leave a tail after the batches of eight.
+	BOOST_CHECK((read_packed_matches<1, boost::uint16_t>(buffer, bits, 1000)));
+	BOOST_CHECK((read_packed_matches<10, boost::uint16_t>(buffer, bits, 333)));
+	BOOST_CHECK((read_packed_matches<12, boost::uint16_t>(buffer, bits, 7)));
+	BOOST_CHECK((read_packed_matches<12, boost::uint16_t>(buffer, bits, 300)));
+	BOOST_CHECK((read_packed_matches<16, boost::uint16_t>(buffer, bits, 255)));
+	BOOST_CHECK((read_packed_matches<12, boost::uint32_t>(buffer, bits, 301)));
+	BOOST_CHECK((read_packed_matches<20, boost::uint32_t>(buffer, bits, 204)));
+	BOOST_CHECK((read_packed_matches<25, boost::int32_t>(buffer, bits, 163)));
+	BOOST_CHECK((read_packed_matches<31, boost::uint32_t>(buffer, bits, 131)));
+	BOOST_CHECK((read_packed_matches<5, boost::uint8_t>(buffer, bits, 800)));
+	BOOST_CHECK((read_packed_matches<40, boost::uint64_t>(buffer, bits, 100)));
+
+	// Too few bits: the fields that fit are read, like setrepeat does.
+	{
+		boost::bitstream::ibitstream bin(buffer, 100);
+		boost::uint16_t samples[10];
+		bin.read_packed<12>(samples, 10);
+		BOOST_CHECK(bin.fail() && bin.eof());
+		BOOST_CHECK(samples[8] == 0 && samples[9] == 0);
+	}
+}
+
+/**
+	Check that write_packed<N>() puts the same bits as inserting the fields
+	one at a time, from every bit offset within a byte, without disturbing
+	the bits either side.
+*/
+template <size_t N, typename T>
+bool write_packed_matches(size_t count)
+{
+	std::vector<T> values(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		values[i] = static_cast<T>(i * 2654435761u);
+	}
+
+	bool okay = true;
+
+	for (std::streamsize offset = 0; offset < CHAR_BIT; ++offset)
+	{
+		std::vector<char> packed(count * N / CHAR_BIT + 3, '\x5a');
+		boost::bitstream::obitstream bout(&packed[0], packed.size() * CHAR_BIT);
+		bout.ignore(offset);
+		bout.write_packed<N>(&values[0], count);
+		okay = okay && bout;
+
+		std::vector<char> expected(packed.size(), '\x5a');
+		boost::bitstream::obitstream bout1(&expected[0], expected.size() * CHAR_BIT);
+		bout1.ignore(offset);
+		for (size_t i = 0; i < count; ++i)
+		{
+			bout1 << std::bitset<N>(static_cast<unsigned long>(values[i]));
+		}
+
+		okay = okay && bout.tellp() == bout1.tellp() && packed == expected;
+	}
+
+	return okay;
+}
+
+BOOST_AUTO_TEST_CASE(packed_output)
+{
+	BOOST_CHECK((write_packed_matches<1, boost::uint16_t>(1001)));
+	BOOST_CHECK((write_packed_matches<10, boost::uint16_t>(333)));
+	BOOST_CHECK((write_packed_matches<12, boost::uint16_t>(7)));
+	BOOST_CHECK((write_packed_matches<12, boost::int16_t>(300)));
+	BOOST_CHECK((write_packed_matches<16, boost::uint16_t>(255)));
+	BOOST_CHECK((write_packed_matches<12, boost::uint32_t>(301)));
+	BOOST_CHECK((write_packed_matches<20, boost::uint32_t>(204)));
+	BOOST_CHECK((write_packed_matches<31, boost::uint32_t>(131)));
+	BOOST_CHECK((write_packed_matches<5, boost::uint8_t>(800)));
+	BOOST_CHECK((write_packed_matches<40, boost::uint64_t>(100)));
+
+	// Containers of bitsets are packed, and packing makes a growable buffer
+	// grow.
+	{
+		std::vector<std::bitset<12> > samples(1000);
+		for (size_t i = 0; i < samples.size(); ++i)
+		{
+			samples[i] = std::bitset<12>(i * 7);
+		}
+		boost::bitstream::ovectorbitstream bout;
+		bout << true << samples;
+		BOOST_CHECK(bout);
+		BOOST_CHECK(bout.bits() == 1 + 12 * 1000);
+
+		boost::bitstream::ibitstream bin(bout.data(), bout.bits());
+		std::vector<boost::uint16_t> v(samples.size());
+		bin >> true;
+		bin.read_packed<12>(&v[0], v.size());
+		BOOST_CHECK(bin);
+		BOOST_CHECK(v[0] == 0 && v[999] == ((999 * 7) & 0xfff));
+	}
+
+	// Collected bits are written ahead of the packed fields, and the fields
+	// put one at a time while the buffer grows stay in order too.
+	{
+		std::vector<boost::uint16_t> values(1000);
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			values[i] = static_cast<boost::uint16_t>(i * 7);
+		}
+		boost::bitstream::ovectorbitstream bout;
+		bout << true << std::bitset<3>(5);
+		bout.write_packed<12>(&values[0], values.size());
+		bout << false;
+		boost::bitstream::ovectorbitstream bout1;
+		bout1 << boost::bitstream::nounitbuf << true <<
+			std::bitset<3>(5);
+		bout1.write_packed<12>(&values[0], values.size());
+		bout1 << false << boost::bitstream::unitbuf;
+		BOOST_CHECK(bout && bout1);
+		BOOST_CHECK(bout1.bits() == bout.bits());
+		BOOST_CHECK(std::equal(bout.data(), bout.data() + bout.bits() / CHAR_BIT,
+			bout1.data()));
+	}
+
+	// Not enough room: the fields that fit are written, then badbit.
+	{
+		char buffer[2] = { 0 };
+		const boost::uint16_t values[] = { 0xabc, 0xdef };
+		boost::bitstream::obitstream bout(buffer, sizeof buffer * CHAR_BIT);
+		bout.write_packed<12>(values, 2);
+		BOOST_CHECK(bout.bad());
+		BOOST_CHECK(buffer[0] == '\xab');
+		BOOST_CHECK((buffer[1] & 0xf0) == 0xc0);
+	}
+}
+
+namespace {
+
+/**
+	Character stream buffer that can only be read forward, like a pipe.
+*/
+class forward_only_streambuf : public std::streambuf
+{
+public:
+	forward_only_streambuf(const std::string &s) : m_s(s), m_next(0)
+	{
+	}
+
+protected:
+	virtual int_type underflow()
+	{
+		if (m_next == m_s.size())
+		{
+			return traits_type::eof();
+		}
+
+		// Hand over a few bytes at a time.
+		const size_t n = std::min<size_t>(3, m_s.size() - m_next);
+		char *p = const_cast<char *>(m_s.data()) + m_next;
+		setg(p, p, p + n);
+		m_next += n;
+
+		return traits_type::to_int_type(*p);
+	}
+
+private:
+	std::string m_s;
+	size_t m_next;
+};
+
+/**
+	Decoder of RTP sequence number and timestamp for decode_batch(), which
+	throws for payload type 127.
+*/
+struct rtp_timing_decoder
+{
+	void operator()(boost::bitstream::bit_reader &r,
+		std::pair<boost::uint16_t, boost::uint32_t> &timing) const
+	{
+		std::bitset<7> payloadType;
+		r >> std::bitset<2>(0x2) >> boost::bitstream::ignore(7) >> payloadType
+			>> timing.first >> timing.second;
+		if (payloadType.to_ulong() == 127)
+		{
+			throw std::runtime_error("payload type 127");
+		}
+	}
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(stream_input)
+{
+#ifndef BOOST_NO_CXX11_HDR_TYPE_TRAITS
+	// A copy would point into the original's window.
+	BOOST_CHECK(!std::is_copy_constructible<boost::bitstream::streambitbuf>::value);
+#endif
+
+	std::string bytes(1000, '\0');
+	for (size_t i = 0; i < bytes.size(); ++i)
+	{
+		bytes[i] = static_cast<char>(i * 37 + 11);
+	}
+	const std::streamsize bits = static_cast<std::streamsize>(bytes.size()) * CHAR_BIT;
+
+	// Fields straddle chunks, and give the same values as from memory.
+	{
+		std::stringbuf source(bytes);
+		boost::bitstream::streambitbuf sbb(&source, 7);
+		boost::bitstream::ibitstream bin(&sbb);
+		boost::bitstream::ibitstream bin1(bytes.data(), bits);
+		bool okay = true;
+		for (int i = 0; i < 100; ++i)
+		{
+			std::bitset<13> bs, bs1;
+			boost::uint64_t u, u1;
+			bool b, b1;
+			bin >> bs >> u >> b;
+			bin1 >> bs1 >> u1 >> b1;
+			okay = okay && bs == bs1 && u == u1 && b == b1;
+		}
+		BOOST_CHECK(okay);
+		BOOST_CHECK(bin && !bin.eof());
+		BOOST_CHECK(bin.tellg() == bin1.tellg());
+		BOOST_CHECK(sbb.in_avail() > 0);
+	}
+
+	// Seeking outside the window repositions a seekable source.
+	{
+		std::stringbuf source(bytes);
+		boost::bitstream::streambitbuf sbb(&source, 16);
+		boost::bitstream::ibitstream bin(&sbb);
+		boost::uint32_t u;
+		bin.seekg(std::streampos(8 * 500 + 3));
+		bin >> u;
+		BOOST_CHECK(bin);
+		BOOST_CHECK(bin.tellg() == std::streampos(8 * 500 + 35));
+		bin.seekg(std::streampos(5));
+		boost::uint8_t octet;
+		bin >> octet;
+		BOOST_CHECK(octet == static_cast<boost::uint8_t>(
+			(static_cast<unsigned char>(bytes[0]) << 5) |
+			(static_cast<unsigned char>(bytes[1]) >> 3)));
+	}
+
+	// A source that cannot seek is skipped forward by reading; eof is
+	// reached exactly at its end.
+	{
+		forward_only_streambuf source(bytes);
+		boost::bitstream::streambitbuf sbb(&source, 10);
+		boost::bitstream::ibitstream bin(&sbb);
+		bin.ignore(bits - 12);
+		std::bitset<12> bs;
+		bin >> bs;
+		BOOST_CHECK(bin && bin.eof());
+		BOOST_CHECK(bs.to_ulong() == (((static_cast<unsigned char>(bytes[998]) & 0x0f) << 8) |
+			static_cast<unsigned char>(bytes[999])));
+		BOOST_CHECK(sbb.in_avail() == -1);
+		bin >> bs;
+		BOOST_CHECK(bin.fail());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(mapped_file)
+{
+	const char path[] = "test_rtp_mapped_file.bin";
+	const char rtpHeader[] = { '\x80', '\x08', '\xe7', '\x3c', '\x00', '\x00', '\x3c', '\x00', '\xde', '\xe0', '\xee', '\x8f' };
+	{
+		std::ofstream file(path, std::ios_base::binary);
+		file.write(rtpHeader, sizeof rtpHeader);
+	}
+
+	// Read, seek and patch bits in place.
+	{
+		boost::bitstream::mapped_bitbuf mbb(path, std::ios_base::in | std::ios_base::out);
+		BOOST_CHECK(mbb.is_open());
+		BOOST_CHECK(mbb.bits() == sizeof rtpHeader * CHAR_BIT);
+		mbb.advise(boost::interprocess::mapped_region::advice_random);
+
+		boost::bitstream::ibitstream bin(&mbb);
+		boost::uint32_t ssrc;
+		bin.seekg(std::streampos(64));
+		bin >> ssrc;
+		BOOST_CHECK(bin && bin.eof());
+		BOOST_CHECK(ssrc == 0xdee0ee8f);
+
+		boost::bitstream::ostream bout(&mbb);
+		bout.seekp(std::streampos(9));
+		bout << std::bitset<7>(0x60);
+		BOOST_CHECK(bout);
+	}
+	{
+		std::ifstream file(path, std::ios_base::binary);
+		char bytes[sizeof rtpHeader];
+		file.read(bytes, sizeof bytes);
+		BOOST_CHECK(bytes[1] == '\x60');
+		BOOST_CHECK(memcmp(bytes + 2, rtpHeader + 2, sizeof bytes - 2) == 0);
+	}
+
+	// Read-only mappings have no put area; missing files are not open.
+	{
+		boost::bitstream::mapped_bitbuf mbb(path);
+		boost::bitstream::ostream bout(&mbb);
+		bout << true;
+		BOOST_CHECK(bout.bad());
+
+		mbb.open("test_rtp_no_such_file.bin");
+		BOOST_CHECK(!mbb.is_open());
+		boost::bitstream::ibitstream bin(&mbb);
+		bool b;
+		bin >> b;
+		BOOST_CHECK(bin.fail());
+	}
+
+	std::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(substreams)
+{
+	// RTP header with a two-word header extension, then a payload byte.
+	const char packet[] = { '\x90', '\x08', '\xe7', '\x3c', '\x00', '\x00', '\x3c', '\x00', '\xde', '\xe0', '\xee', '\x8f',
+		'\xbe', '\xde', '\x00', '\x02', '\x10', '\xaa', '\x21', '\xbb', '\xcc', '\x00', '\x00', '\x00', '\x55' };
+
+	{
+		boost::bitstream::ibitstream bin(packet, sizeof packet * CHAR_BIT);
+		boost::uint16_t profile, length;
+		bin.ignore(96);
+		bin >> profile >> length;
+		boost::bitstream::ibitstream extension(bin.substream(length * 32));
+		BOOST_CHECK(bin);
+		BOOST_CHECK(bin.tellg() == std::streampos(128 + 64));
+		boost::uint8_t payload;
+		bin >> payload;
+		BOOST_CHECK(bin && payload == 0x55);
+
+		// One-byte header elements, in the extension's own positions.
+		BOOST_CHECK(extension.tellg() == std::streampos(0));
+		BOOST_CHECK(extension.rdbuf()->size() == 64);
+		std::bitset<4> id, len;
+		boost::uint8_t a;
+		boost::uint16_t bc;
+		extension >> id >> len >> a;
+		BOOST_CHECK(id.to_ulong() == 1 && len.to_ulong() == 0 && a == 0xaa);
+		extension >> id >> len >> bc;
+		BOOST_CHECK(id.to_ulong() == 2 && len.to_ulong() == 1 && bc == 0xbbcc);
+		BOOST_CHECK(extension.tellg() == std::streampos(40));
+		extension.seekg(std::streampos(0));
+		extension >> id;
+		BOOST_CHECK(extension && id.to_ulong() == 1);
+		BOOST_CHECK(!extension.seekg(std::streampos(65)));
+	}
+
+	// Unaligned slices, and slices that do not fit.
+	{
+		boost::bitstream::ibitstream bin(packet, sizeof packet * CHAR_BIT);
+		boost::bitstream::ibitstream csrcCount(bin.rdbuf()->slice(4, 8));
+		std::bitset<4> bs;
+		csrcCount >> bs;
+		BOOST_CHECK(csrcCount && csrcCount.eof());
+		BOOST_CHECK(bs.to_ulong() == 0);
+		BOOST_CHECK(bin.rdbuf()->slice(8, 8 * 26).size() == 0);
+
+		bin.seekg(std::streampos(11));
+		boost::bitstream::ibitstream payloadType(bin.substream(5));
+		payloadType >> std::bitset<5>(0x8);
+		BOOST_CHECK(payloadType);
+		BOOST_CHECK(bin.tellg() == std::streampos(16));
+
+		bin.substream(sizeof packet * CHAR_BIT);
+		BOOST_CHECK(bin.fail() && bin.eof());
+	}
+
+	// Windows and segments make no slices, even of bits in the get area.
+	{
+		std::stringbuf source(std::string(packet, sizeof packet));
+		boost::bitstream::streambitbuf sbb(&source, 8);
+		boost::bitstream::ibitstream bin(&sbb);
+		boost::uint8_t version;
+		bin >> version;
+		BOOST_CHECK(sbb.slice(8, 16).size() == 0);
+		bin.substream(8);
+		BOOST_CHECK(bin.fail() && !bin.eof());
+
+		std::vector<boost::bitstream::chainbitbuf::segment> segments;
+		segments.push_back(boost::bitstream::chainbitbuf::segment(packet, 2));
+		segments.push_back(boost::bitstream::chainbitbuf::segment(packet + 2, sizeof packet - 2));
+		boost::bitstream::chainbitbuf cbb(segments.begin(), segments.end());
+		boost::bitstream::ibitstream bin1(&cbb);
+		bin1.substream(12);
+		BOOST_CHECK(bin1.fail() && !bin1.eof());
+		BOOST_CHECK(bin1.rdbuf()->slice(0, 8).size() == 0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(scatter_gather_input)
+{
+	std::string bytes(300, '\0');
+	for (size_t i = 0; i < bytes.size(); ++i)
+	{
+		bytes[i] = static_cast<char>(i * 37 + 11);
+	}
+	const std::streamsize bits = static_cast<std::streamsize>(bytes.size()) * CHAR_BIT;
+
+	// Fragments of assorted sizes, including empty ones and ones smaller
+	// than a field.
+	std::vector<boost::bitstream::chainbitbuf::segment> segments;
+	const size_t sizes[] = { 5, 0, 1, 1, 3, 64, 0, 2, 100, 1, 1, 1, 1, 20 };
+	size_t offset = 0;
+	for (size_t i = 0; offset < bytes.size(); ++i)
+	{
+		const size_t size = std::min(sizes[i % (sizeof sizes / sizeof sizes[0])],
+			bytes.size() - offset);
+		segments.push_back(boost::bitstream::chainbitbuf::segment(bytes.data() + offset, size));
+		offset += size;
+	}
+
+	// Fields straddle segments, and give the same values as from one buffer.
+	{
+		boost::bitstream::chainbitbuf cbb(segments.begin(), segments.end());
+		BOOST_CHECK(cbb.bits() == bits);
+		boost::bitstream::ibitstream bin(&cbb);
+		boost::bitstream::ibitstream bin1(bytes.data(), bits);
+		bool okay = true;
+		for (int i = 0; i < 30; ++i)
+		{
+			std::bitset<13> bs, bs1;
+			boost::uint64_t u, u1;
+			bool b, b1;
+			bin >> bs >> u >> b;
+			bin1 >> bs1 >> u1 >> b1;
+			okay = okay && bs == bs1 && u == u1 && b == b1;
+		}
+		BOOST_CHECK(okay);
+		BOOST_CHECK(bin && !bin.eof());
+		BOOST_CHECK(bin.tellg() == bin1.tellg());
+		BOOST_CHECK(cbb.in_avail() > 0);
+	}
+
+	// Seeking is by absolute position, in either direction; eof is reached
+	// exactly at the end of the last segment.
+	{
+		boost::bitstream::chainbitbuf cbb(segments.begin(), segments.end());
+		boost::bitstream::ibitstream bin(&cbb);
+		boost::bitstream::ibitstream bin1(bytes.data(), bits);
+		boost::uint32_t u, u1;
+		bin.seekg(std::streampos(8 * 250 + 3));
+		bin1.seekg(std::streampos(8 * 250 + 3));
+		bin >> u;
+		bin1 >> u1;
+		BOOST_CHECK(bin && u == u1);
+		BOOST_CHECK(bin.tellg() == std::streampos(8 * 250 + 35));
+		bin.seekg(std::streampos(5));
+		bin1.seekg(std::streampos(5));
+		bin >> u;
+		bin1 >> u1;
+		BOOST_CHECK(bin && u == u1);
+
+		bin.seekg(-12, std::ios_base::end);
+		std::bitset<12> bs;
+		bin >> bs;
+		BOOST_CHECK(bin && bin.eof());
+		BOOST_CHECK(bs.to_ulong() == (((static_cast<unsigned char>(bytes[298]) & 0x0f) << 8) |
+			static_cast<unsigned char>(bytes[299])));
+		BOOST_CHECK(cbb.in_avail() == -1);
+		bin >> bs;
+		BOOST_CHECK(bin.fail());
+	}
+
+	// A field longer than what is left of the chain is not read at all.
+	{
+		boost::bitstream::chainbitbuf cbb(segments.begin(), segments.end());
+		boost::bitstream::ibitstream bin(&cbb);
+		bin.seekg(std::streampos(bits - 20));
+		boost::uint32_t u;
+		bin >> u;
+		BOOST_CHECK(bin.fail());
+		BOOST_CHECK(cbb.pubseekoff(0, std::ios_base::cur, std::ios_base::in) ==
+			std::streampos(bits - 20));
+	}
+}
+
+namespace {
+
+typedef boost::bitstream::constant<2, 2> rtp_version;
+
+struct rtp_fixed_header
+{
+	rtp_version version;
+	bool padding, extension;
+	boost::bitstream::field<4> csrc_count;
+	bool marker;
+	boost::bitstream::field<7> payload_type;
+	boost::uint16_t sequence_number;
+	boost::uint32_t timestamp, ssrc;
+};
+
+struct rtp_extended_header
+{
+	rtp_fixed_header fixed;
+	boost::uint16_t profile;
+	std::bitset<16> length;
+};
+
+} // namespace
+
+BOOST_FUSION_ADAPT_STRUCT(
+	rtp_fixed_header,
+	(rtp_version, version)
+	(bool, padding)
+	(bool, extension)
+	(boost::bitstream::field<4>, csrc_count)
+	(bool, marker)
+	(boost::bitstream::field<7>, payload_type)
+	(boost::uint16_t, sequence_number)
+	(boost::uint32_t, timestamp)
+	(boost::uint32_t, ssrc)
+)
+
+BOOST_FUSION_ADAPT_STRUCT(
+	rtp_extended_header,
+	(rtp_fixed_header, fixed)
+	(boost::uint16_t, profile)
+	(std::bitset<16>, length)
+)
+
+BOOST_AUTO_TEST_CASE(record_codec)
+{
+	const char rtpHeader[] = { '\x90', '\x08', '\xe7', '\x3c', '\x00', '\x00', '\x3c', '\x00', '\xde', '\xe0', '\xee', '\x8f',
+		'\xbe', '\xde', '\x00', '\x02' };
+
+	BOOST_CHECK(boost::bitstream::record_bits<rtp_fixed_header>::value == 96);
+	BOOST_CHECK(boost::bitstream::record_bits<rtp_extended_header>::value == 128);
+
+	// Whole record in the get area, including a nested one.
+	{
+		boost::bitstream::ibitstream bin(rtpHeader, sizeof rtpHeader * CHAR_BIT);
+		rtp_extended_header rtp;
+		boost::bitstream::decode(bin, rtp);
+		BOOST_CHECK(bin && bin.eof());
+		BOOST_CHECK(!rtp.fixed.padding && rtp.fixed.extension);
+		BOOST_CHECK(rtp.fixed.csrc_count == 0 && !rtp.fixed.marker);
+		BOOST_CHECK(rtp.fixed.payload_type == 8);
+		BOOST_CHECK(rtp.fixed.sequence_number == 0xe73c);
+		BOOST_CHECK(rtp.fixed.timestamp == 0x00003c00);
+		BOOST_CHECK(rtp.fixed.ssrc == 0xdee0ee8f);
+		BOOST_CHECK(rtp.profile == 0xbede && rtp.length.to_ulong() == 2);
+	}
+
+	// Encoding gives back the same bits, at any alignment and whether or not
+	// output is combined; decoding an unaligned record matches.
+	for (int combined = 0; combined < 2; ++combined)
+	{
+		boost::bitstream::ibitstream bin(rtpHeader, sizeof rtpHeader * CHAR_BIT);
+		rtp_extended_header rtp;
+		boost::bitstream::decode(bin, rtp);
+
+		char buffer[sizeof rtpHeader + 1] = { 0 };
+		boost::bitstream::obitstream bout(buffer, sizeof buffer * CHAR_BIT);
+		bout.unitbuf(combined == 0);
+		boost::bitstream::encode(bout, rtp);
+		bout.flush();
+		BOOST_CHECK(bout && bout.tellp() == std::streampos(128));
+		BOOST_CHECK(memcmp(buffer, rtpHeader, sizeof rtpHeader) == 0);
+
+		bout.seekp(std::streampos(3));
+		boost::bitstream::encode(bout, rtp);
+		bout.flush();
+		boost::bitstream::ibitstream bin3(buffer, sizeof buffer * CHAR_BIT);
+		bin3.ignore(3);
+		rtp_extended_header rtp3;
+		boost::bitstream::decode(bin3, rtp3);
+		BOOST_CHECK(bin3 && bin3.tellg() == std::streampos(131));
+		BOOST_CHECK(rtp3.fixed.sequence_number == 0xe73c && rtp3.fixed.ssrc == 0xdee0ee8f);
+		BOOST_CHECK(rtp3.fixed.payload_type == 8 && rtp3.length.to_ulong() == 2);
+	}
+
+	// A record that straddles segments is decoded field by field.
+	{
+		std::vector<boost::bitstream::chainbitbuf::segment> segments;
+		segments.push_back(boost::bitstream::chainbitbuf::segment(rtpHeader, 5));
+		segments.push_back(boost::bitstream::chainbitbuf::segment(rtpHeader + 5, sizeof rtpHeader - 5));
+		boost::bitstream::chainbitbuf cbb(segments.begin(), segments.end());
+		boost::bitstream::ibitstream bin(&cbb);
+		rtp_fixed_header rtp;
+		boost::bitstream::decode(bin, rtp);
+		BOOST_CHECK(bin && !bin.eof());
+		BOOST_CHECK(rtp.timestamp == 0x00003c00 && rtp.ssrc == 0xdee0ee8f);
+	}
+
+	// Wrong version, or too few bits, fails.
+	{
+		const char badVersion[] = { '\xd0', '\x08', '\xe7', '\x3c', '\x00', '\x00', '\x3c', '\x00', '\xde', '\xe0', '\xee', '\x8f' };
+		boost::bitstream::ibitstream bin(badVersion, sizeof badVersion * CHAR_BIT);
+		rtp_fixed_header rtp;
+		boost::bitstream::decode(bin, rtp);
+		BOOST_CHECK(bin.fail());
+
+		boost::bitstream::ibitstream bin1(rtpHeader, 95);
+		boost::bitstream::decode(bin1, rtp);
+		BOOST_CHECK(bin1.fail() && bin1.eof());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(cursors)
+{
+	const char rtpHeader[] = { '\x82', '\x08', '\xe7', '\x3c', '\x00', '\x00', '\x3c', '\x00', '\xde', '\xe0', '\xee', '\x8f',
+		'\x01', '\x02', '\x03', '\x04', '\x05', '\x06', '\x07', '\x08' };
+
+#ifndef BOOST_NO_CXX11_HDR_TYPE_TRAITS
+	BOOST_CHECK(std::is_trivially_copyable<boost::bitstream::bit_reader>::value);
+	BOOST_CHECK(std::is_trivially_copyable<boost::bitstream::bit_writer>::value);
+#endif
+
+	// Same operators and manipulators as istream.
+	{
+		boost::bitstream::bit_reader r(rtpHeader, sizeof rtpHeader * CHAR_BIT);
+		std::bitset<4> csrcCount;
+		bool marker;
+		std::bitset<7> payloadType;
+		boost::uint16_t sequenceNumber;
+		boost::uint32_t timestamp, ssrcIdentifier;
+		std::vector<boost::uint32_t> csrcIdentifier;
+		r >> std::bitset<2>(0x2) >> boost::bitstream::aligng(4) >> csrcCount
+			>> marker >> payloadType >> sequenceNumber >> timestamp >> ssrcIdentifier
+			>> boost::bitstream::setrepeat(csrcCount.to_ulong()) >> csrcIdentifier;
+		BOOST_CHECK(r && r.eof());
+		BOOST_CHECK(r.tellg() == std::streampos(160));
+		BOOST_CHECK(csrcCount.to_ulong() == 2 && !marker && payloadType.to_ulong() == 8);
+		BOOST_CHECK(sequenceNumber == 0xe73c && timestamp == 0x00003c00 && ssrcIdentifier == 0xdee0ee8f);
+		BOOST_CHECK(csrcIdentifier.size() == 2 && csrcIdentifier[0] == 0x01020304 &&
+			csrcIdentifier[1] == 0x05060708);
+		boost::uint8_t octet;
+		r >> octet;
+		BOOST_CHECK(r.fail() && octet == 0);
+		BOOST_CHECK(r.tellg() == std::streampos(-1));
+	}
+
+	// Copies backtrack; a mismatched constant fails.
+	{
+		boost::bitstream::bit_reader r(rtpHeader, sizeof rtpHeader * CHAR_BIT);
+		const boost::bitstream::bit_reader start = r;
+		r >> std::bitset<2>(0x3);
+		BOOST_CHECK(r.fail());
+		r = start;
+		r >> boost::bitstream::ignore(5);
+		boost::bitstream::bit_reader speculative = r;
+		boost::uint64_t u;
+		speculative >> u;
+		BOOST_CHECK(speculative && speculative.tellg() == std::streampos(69));
+		BOOST_CHECK(r.tellg() == std::streampos(5));
+		std::bitset<3> csrcCount;
+		r >> csrcCount;
+		BOOST_CHECK(r && csrcCount.to_ulong() == 2);
+		r.seekg(std::streampos(sizeof rtpHeader * CHAR_BIT + 1));
+		BOOST_CHECK(r.fail());
+	}
+
+	// bit_writer gives the same bits as obitstream.
+	{
+		char buffer[sizeof rtpHeader] = { 0 };
+		boost::bitstream::bit_writer w(buffer, sizeof buffer * CHAR_BIT);
+		std::vector<boost::uint32_t> csrcIdentifier;
+		csrcIdentifier.push_back(0x01020304);
+		csrcIdentifier.push_back(0x05060708);
+		w << std::bitset<2>(0x2) << false << false << std::bitset<4>(2) << false
+			<< std::bitset<7>(8) << boost::uint16_t(0xe73c) << boost::uint32_t(0x00003c00)
+			<< boost::uint32_t(0xdee0ee8f) << csrcIdentifier;
+		BOOST_CHECK(w && w.eof());
+		BOOST_CHECK(memcmp(buffer, rtpHeader, sizeof rtpHeader) == 0);
+		w << true;
+		BOOST_CHECK(w.fail());
+		BOOST_CHECK(memcmp(buffer, rtpHeader, sizeof rtpHeader) == 0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(batch_decode)
+{
+	// Packets of 64 bits, some truncated, some with a bad version, one that
+	// makes the decoder throw, and some with bits left over.
+	const size_t count = 5000;
+	std::vector<char> bytes(count * 9);
+	std::vector<boost::bitstream::bit_range> ranges;
+	for (size_t i = 0; i < count; ++i)
+	{
+		char * const p = &bytes[i * 9];
+		p[0] = i % 97 == 0 ? '\xc0' : '\x80';
+		p[1] = i == 1234 ? '\x7f' : '\x08';
+		p[2] = static_cast<char>(i >> 8);
+		p[3] = static_cast<char>(i);
+		p[4] = p[5] = p[6] = 0;
+		p[7] = static_cast<char>(i * 3);
+		ranges.push_back(boost::bitstream::bit_range(p,
+			i % 89 == 0 ? 60 : i % 83 == 0 ? 70 : 64));
+	}
+
+	std::vector<std::pair<boost::uint16_t, boost::uint32_t> > results, results1;
+	std::vector<std::ios_base::iostate> states, states1;
+	boost::bitstream::decode_batch(ranges, rtp_timing_decoder(), results, states, 4);
+	boost::bitstream::decode_batch(ranges, rtp_timing_decoder(), results1, states1, 1);
+	BOOST_CHECK(results.size() == count && states.size() == count);
+	BOOST_CHECK(results == results1 && states == states1);
+
+	bool okay = true;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const std::ios_base::iostate expected = i == 1234 ? std::ios_base::badbit :
+			i % 97 == 0 || i % 89 == 0 ? std::ios_base::failbit :
+			i % 83 == 0 ? std::ios_base::goodbit : std::ios_base::eofbit;
+		okay = okay && states[i] == expected;
+		if (expected == std::ios_base::eofbit || expected == std::ios_base::goodbit)
+		{
+			okay = okay && results[i].first == static_cast<boost::uint16_t>(i) &&
+				results[i].second == static_cast<boost::uint8_t>(i * 3);
+		}
+	}
+	BOOST_CHECK(okay);
+}
+
+BOOST_AUTO_TEST_CASE(look_ahead)
+{
+	const char bytes[] = { '\xa5', '\x3c', '\x0f', '\xf0', '\x81' };
+	const std::streamsize bits = sizeof bytes * CHAR_BIT;
+
+	// Peeking leaves the get pointer where it is; skipping moves it.
+	{
+		boost::bitstream::ibitstream bin(bytes, bits);
+		BOOST_CHECK(bin.peek() == 1 && bin.peek() == 1);
+		BOOST_CHECK(bin.tellg() == std::streampos(0));
+		boost::bitstream::bitfield value;
+		bin.peek(value, 12);
+		BOOST_CHECK(bin && value == 0xa53 && bin.gcount() == 12);
+		BOOST_CHECK(bin.show_bits<16>() == 0xa53c);
+		bin.skip(3);
+		BOOST_CHECK(bin.show_bits<9>() == 0x053);
+		BOOST_CHECK(bin.tellg() == std::streampos(3));
+		bin.skip(bits - 3 - 4);
+		BOOST_CHECK(bin && !bin.eof());
+
+		// Near the end, what is left is padded with zeros.
+		BOOST_CHECK(bin.show_bits<8>() == 0x10);
+		bin.peek(value, 8);
+		BOOST_CHECK(bin.eof() && !bin.fail() && value == 0);
+		bin.clear();
+		bin.skip(4);
+		BOOST_CHECK(bin && bin.eof());
+		BOOST_CHECK(bin.show_bits<8>() == 0);
+		bin.skip(1);
+		BOOST_CHECK(bin.fail());
+	}
+
+	// Look-ahead straddles segments and chunks without moving.
+	{
+		std::vector<boost::bitstream::chainbitbuf::segment> segments;
+		for (size_t i = 0; i < sizeof bytes; ++i)
+		{
+			segments.push_back(boost::bitstream::chainbitbuf::segment(bytes + i, 1));
+		}
+		boost::bitstream::chainbitbuf cbb(segments.begin(), segments.end());
+		boost::bitstream::ibitstream bin(&cbb);
+		bin.skip(6);
+		BOOST_CHECK(bin.show_bits<20>() == 0x4f03f);
+		BOOST_CHECK(bin.tellg() == std::streampos(6));
+		bin.skip(20);
+		boost::bitstream::bitfield value;
+		bin.read(value, 6);
+		BOOST_CHECK(bin && value == 0x30);
+		BOOST_CHECK(bin.show_bits<16>() == 0x8100);
+
+		std::stringbuf source(std::string(bytes, sizeof bytes));
+		boost::bitstream::streambitbuf sbb(&source, 1);
+		boost::bitstream::ibitstream sin(&sbb);
+		sin.skip(6);
+		BOOST_CHECK(sin.show_bits<20>() == 0x4f03f);
+		sin.read(value, 20);
+		BOOST_CHECK(sin && value == 0x4f03f);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(vlc_decoding)
+{
+	// Codes of 1 through 14 bits, 0, 10, 110, ..., 1111111111110 and
+	// 11111111111110, plus 11111111111111 00 through 11.
+	std::vector<boost::bitstream::vlc_code<int> > codes;
+	for (size_t length = 1; length <= 14; ++length)
+	{
+		codes.push_back(boost::bitstream::vlc_code<int>(
+			((boost::bitstream::bitfield(1) << length) - 1) - 1, length, static_cast<int>(length)));
+	}
+	for (int i = 0; i < 4; ++i)
+	{
+		codes.push_back(boost::bitstream::vlc_code<int>((0x3fff << 2) | i, 16, 100 + i));
+	}
+
+	// Encode symbols, then decode them with tables of any index size.
+	char buffer[1000] = { 0 };
+	std::vector<int> symbols;
+	boost::bitstream::obitstream bout(buffer, sizeof buffer * CHAR_BIT);
+	for (size_t i = 0; i < 500; ++i)
+	{
+		const boost::bitstream::vlc_code<int> &code = codes[(i * 7) % codes.size()];
+		bout.write(code.bits, static_cast<std::streamsize>(code.length));
+		symbols.push_back(code.symbol);
+	}
+	const std::streamsize bits = static_cast<std::streamsize>(bout.tellp());
+
+	const size_t indexBits[] = { 1, 4, 9, 16 };
+	for (size_t i = 0; i < sizeof indexBits / sizeof indexBits[0]; ++i)
+	{
+		const boost::bitstream::vlc_table<int> table(codes.begin(), codes.end(), indexBits[i]);
+		BOOST_CHECK(table.valid());
+
+		boost::bitstream::ibitstream bin(buffer, bits);
+		std::vector<int> decoded(symbols.size());
+		BOOST_CHECK(table.decode(bin, &decoded[0], decoded.size()) == decoded.size());
+		BOOST_CHECK(bin && bin.eof());
+		BOOST_CHECK(decoded == symbols);
+
+		boost::bitstream::bit_reader r(buffer, bits);
+		std::vector<int> decoded1(symbols.size());
+		BOOST_CHECK(table.decode(r, &decoded1[0], decoded1.size()) == decoded1.size());
+		BOOST_CHECK(r && r.eof());
+		BOOST_CHECK(decoded1 == symbols);
+
+		// The stream ends within a code.
+		boost::bitstream::ibitstream bin1(buffer, bits - 1);
+		BOOST_CHECK(table.decode(bin1, &decoded[0], decoded.size()) == decoded.size() - 1);
+		BOOST_CHECK(bin1.fail());
+	}
+
+	// Bits that match no code fail; codes that are not prefix free make no
+	// table.
+	{
+		codes.pop_back();
+		const boost::bitstream::vlc_table<int> table(codes.begin(), codes.end());
+		const char bytes[] = { '\xff', '\xff' };
+		boost::bitstream::ibitstream bin(bytes, sizeof bytes * CHAR_BIT);
+		int symbol = -1;
+		table.decode(bin, symbol);
+		BOOST_CHECK(bin.fail() && symbol == -1);
+
+		codes.push_back(boost::bitstream::vlc_code<int>(0x3, 3, 200));
+		BOOST_CHECK(!boost::bitstream::vlc_table<int>(codes.begin(), codes.end()).valid());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(variable_length_integers)
+{
+	using boost::bitstream::ue;
+	using boost::bitstream::se;
+	using boost::bitstream::leb128;
+
+	// ue(v) of 0, 1, 2, 3 and 7 is 1 010 011 00100 0001000.
+	{
+		char buffer[3] = { 0 };
+		boost::bitstream::bit_writer w(buffer, sizeof buffer * CHAR_BIT);
+		w << ue(0) << ue(1u) << ue(2) << ue(3) << ue(7);
+		BOOST_CHECK(w && w.tellp() == 19);
+		BOOST_CHECK(buffer[0] == '\xa6' && buffer[1] == '\x41' && buffer[2] == '\x00');
+
+		char buffer1[3] = { 0 };
+		boost::bitstream::obitstream bout(buffer1, sizeof buffer1 * CHAR_BIT);
+		bout << ue(0) << ue(1u) << ue(2) << ue(3) << ue(7) << boost::bitstream::flush;
+		BOOST_CHECK(bout && std::equal(buffer, buffer + sizeof buffer, buffer1));
+
+		boost::bitstream::ibitstream bin(buffer, 19);
+		int a = -1, b = -1, c = -1, d = -1, e = -1;
+		bin >> ue(a) >> ue(b) >> ue(c) >> ue(d) >> ue(e);
+		BOOST_CHECK(bin && bin.eof());
+		BOOST_CHECK(a == 0 && b == 1 && c == 2 && d == 3 && e == 7);
+
+		// A stream that ends within a code fails.
+		boost::bitstream::bit_reader r(buffer, 18);
+		r >> ue(a) >> ue(b) >> ue(c) >> ue(d) >> ue(e);
+		BOOST_CHECK(r.fail() && e == 7);
+	}
+
+	// Long codes, signed codes and values that do not fit.
+	{
+		char buffer[64] = { 0 };
+		const boost::uint64_t big = ~boost::uint64_t(0) - 1;
+		const boost::int64_t smallest = -std::numeric_limits<boost::int64_t>::max();
+		boost::bitstream::bit_writer w(buffer, sizeof buffer * CHAR_BIT);
+		w << ue(big) << ue(boost::uint64_t(1) << 32) << se(0) << se(1) << se(-1) <<
+			se(-5) << se(smallest) << ue(300);
+		BOOST_CHECK(w);
+		w << ue(-1);
+		BOOST_CHECK(w.fail());
+
+		boost::bitstream::bit_reader r(buffer, sizeof buffer * CHAR_BIT);
+		boost::uint64_t x = 0, y = 0;
+		int p = -1, q = -1, n = 0, m = 0;
+		boost::int64_t z = 0;
+		r >> ue(x) >> ue(y) >> se(p) >> se(q) >> se(n) >> se(m) >> se(z);
+		BOOST_CHECK(r);
+		BOOST_CHECK(x == big && y == boost::uint64_t(1) << 32);
+		BOOST_CHECK(p == 0 && q == 1 && n == -1 && m == -5 && z == smallest);
+		boost::uint8_t narrow = 0;
+		r >> ue(narrow);
+		BOOST_CHECK(r.fail() && narrow == 0);
+	}
+
+	// Arrays of codes, several to a peek, including ones that straddle it.
+	{
+		std::vector<unsigned> values;
+		for (unsigned i = 0; i < 1000; ++i)
+		{
+			values.push_back(i % 7 == 0 ? i * 4099 : i % 5);
+		}
+		std::vector<char> buffer(8000);
+		boost::bitstream::bit_writer w(&buffer[0], buffer.size() * CHAR_BIT);
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			w << ue(values[i]);
+		}
+		BOOST_CHECK(w);
+		const std::streamsize bits = static_cast<std::streamsize>(w.tellp());
+
+		boost::bitstream::ibitstream bin(&buffer[0], bits);
+		std::vector<unsigned> decoded(values.size());
+		BOOST_CHECK(boost::bitstream::read_ue(bin, &decoded[0], decoded.size()) == decoded.size());
+		BOOST_CHECK(bin && bin.eof());
+		BOOST_CHECK(decoded == values);
+
+		boost::bitstream::bit_reader r(&buffer[0], bits - 1);
+		std::vector<unsigned> decoded1(values.size());
+		BOOST_CHECK(boost::bitstream::read_ue(r, &decoded1[0], decoded1.size()) == decoded1.size() - 1);
+		BOOST_CHECK(r.fail());
+		BOOST_CHECK(std::equal(decoded1.begin(), decoded1.end() - 1, values.begin()));
+
+		std::vector<int> signed_values;
+		for (int i = -500; i < 500; ++i)
+		{
+			signed_values.push_back(i % 3 == 0 ? i * 1000 : i % 4);
+		}
+		boost::bitstream::bit_writer w1(&buffer[0], buffer.size() * CHAR_BIT);
+		for (size_t i = 0; i < signed_values.size(); ++i)
+		{
+			w1 << se(signed_values[i]);
+		}
+		boost::bitstream::bit_reader r1(&buffer[0], static_cast<std::streamsize>(w1.tellp()));
+		std::vector<int> decoded2(signed_values.size());
+		BOOST_CHECK(boost::bitstream::read_se(r1, &decoded2[0], decoded2.size()) == decoded2.size());
+		BOOST_CHECK(r1.eof() && decoded2 == signed_values);
+	}
+
+	// LEB128: 624485 is e5 8e 26 and -123456 is c0 bb 78, here after one bit.
+	{
+		char buffer[32] = { 0 };
+		boost::bitstream::obitstream bout(buffer, sizeof buffer * CHAR_BIT);
+		bout << leb128(624485u) << leb128(-123456) << boost::bitstream::flush;
+		BOOST_CHECK(bout && bout.tellp() == 48);
+		const char expected[] = { '\xe5', '\x8e', '\x26', '\xc0', '\xbb', '\x78' };
+		BOOST_CHECK(std::equal(expected, expected + sizeof expected, buffer));
+
+		const boost::uint64_t largest = ~boost::uint64_t(0);
+		const boost::int64_t smallest = std::numeric_limits<boost::int64_t>::min();
+		boost::bitstream::bit_writer w(buffer, sizeof buffer * CHAR_BIT);
+		w.put(1);
+		w << leb128(624485u) << leb128(-123456) << leb128(largest) << leb128(smallest) <<
+			leb128(boost::int8_t(-1)) << leb128(300);
+		BOOST_CHECK(w && w.tellp() == 1 + 48 + 80 + 80 + 8 + 16);
+
+		boost::bitstream::bit_reader r(buffer, w.tellp());
+		unsigned a = 0;
+		int b = 0;
+		boost::uint64_t c = 0;
+		boost::int64_t d = 0;
+		boost::int8_t e = 0;
+		boost::uint8_t f = 0;
+		r.ignore(1);
+		r >> leb128(a) >> leb128(b) >> leb128(c) >> leb128(d) >> leb128(e);
+		BOOST_CHECK(r && a == 624485u && b == -123456);
+		BOOST_CHECK(c == largest && d == smallest && e == -1);
+		r >> leb128(f);
+		BOOST_CHECK(r.fail() && f == 0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(lsb_first_order)
+{
+	using boost::bitstream::bitfield;
+
+	std::vector<char> bytes(200);
+	for (size_t i = 0; i < bytes.size(); ++i)
+	{
+		bytes[i] = static_cast<char>(i * 151 + 7);
+	}
+	const std::streamsize bits = static_cast<std::streamsize>(bytes.size()) * CHAR_BIT;
+	const size_t widths[] = { 1, 3, 64, 7, 8, 13, 16, 5, 32, 63, 2, 24, 64, 9 };
+	const size_t width_count = sizeof widths / sizeof widths[0];
+
+	// Bit i of a field is the bit after bit i - 1, starting from bit 0 of
+	// each byte.
+	std::vector<bitfield> fields;
+	for (std::streamsize position = 0, i = 0; ; ++i)
+	{
+		const size_t width = widths[i % width_count];
+		if (position + static_cast<std::streamsize>(width) > bits)
+		{
+			break;
+		}
+		bitfield field = 0;
+		for (size_t j = 0; j < width; ++j, ++position)
+		{
+			field |= bitfield((bytes[position / CHAR_BIT] >> (position % CHAR_BIT)) & 1) << j;
+		}
+		fields.push_back(field);
+	}
+
+	// Reading, from the buffer as it is.
+	{
+		boost::bitstream::ibitstream bin(&bytes[0], bits, boost::bitstream::lsb_first);
+		for (size_t i = 0; i < fields.size(); ++i)
+		{
+			bitfield value;
+			bin.read(value, static_cast<std::streamsize>(widths[i % width_count]));
+			BOOST_CHECK(value == fields[i]);
+		}
+		BOOST_CHECK(bin);
+
+		// A DEFLATE block header: BFINAL, then a 2-bit BTYPE.
+		const char header[] = { '\x03' };
+		boost::bitstream::ibitstream bin1(header, 3, boost::bitstream::lsb_first);
+		bool final_block = false;
+		bitfield type = 0;
+		bin1 >> final_block;
+		bin1.read(type, 2);
+		BOOST_CHECK(bin1 && final_block && type == 1);
+		BOOST_CHECK(bin1.eof());
+	}
+
+	// Byte-aligned integrals are little endian, one at a time or in bulk.
+	{
+		boost::bitstream::ibitstream bin(&bytes[0], bits, boost::bitstream::lsb_first);
+		boost::uint16_t a = 0;
+		std::vector<boost::uint32_t> b(3);
+		bin >> a >> b;
+		BOOST_CHECK(bin);
+		BOOST_CHECK(a == boost::uint16_t(fields[0] | fields[1] << 1 | fields[2] << 4));
+		const unsigned char *p = reinterpret_cast<const unsigned char *>(&bytes[2]);
+		BOOST_CHECK(b[0] == (boost::uint32_t(p[0]) | boost::uint32_t(p[1]) << 8 |
+			boost::uint32_t(p[2]) << 16 | boost::uint32_t(p[3]) << 24));
+		bool bit;
+		bin.seekg(9);
+		bin >> bit;
+		BOOST_CHECK(bit == (((bytes[1] >> 1) & 1) != 0));
+		BOOST_CHECK(bin.peek() == bitfield((bytes[1] >> 2) & 1));
+	}
+
+	// Writing, with and without write combining, gives the same bytes.
+	for (int unitbuf = 0; unitbuf < 2; ++unitbuf)
+	{
+		std::vector<char> buffer(bytes.size(), '\x55');
+		{
+			boost::bitstream::obitstream bout(&buffer[0], bits, boost::bitstream::lsb_first);
+			if (unitbuf)
+			{
+				bout << boost::bitstream::unitbuf;
+			}
+			for (size_t i = 0; i < fields.size(); ++i)
+			{
+				bout.write(fields[i], static_cast<std::streamsize>(widths[i % width_count]));
+			}
+			BOOST_CHECK(bout);
+		}
+		const std::streamsize written = std::accumulate(widths, widths + width_count, std::streamsize(0)) *
+			static_cast<std::streamsize>(fields.size() / width_count);
+		BOOST_CHECK(std::equal(bytes.begin(), bytes.begin() + written / CHAR_BIT, buffer.begin()));
+	}
+
+	// Chains and slices keep the order.
+	{
+		std::vector<boost::bitstream::chainbitbuf::segment> segments;
+		for (size_t offset = 0; offset < bytes.size(); offset += 3)
+		{
+			segments.push_back(boost::bitstream::chainbitbuf::segment(&bytes[offset],
+				std::min(size_t(3), bytes.size() - offset)));
+		}
+		boost::bitstream::chainbitbuf cbb(segments.begin(), segments.end());
+		cbb.order(boost::bitstream::lsb_first);
+		boost::bitstream::ibitstream bin(&cbb);
+		for (size_t i = 0; i < fields.size(); ++i)
+		{
+			bitfield value;
+			bin.read(value, static_cast<std::streamsize>(widths[i % width_count]));
+			BOOST_CHECK(value == fields[i]);
+		}
+
+		boost::bitstream::bitbuf bb(&bytes[0], bits);
+		bb.order(boost::bitstream::lsb_first);
+		boost::bitstream::ibitstream bin1(bb.slice(1, 1 + 3 + 64));
+		bitfield value;
+		bin1.read(value, 3);
+		BOOST_CHECK(value == fields[1]);
+		bin1.read(value, 64);
+		BOOST_CHECK(bin1 && value == fields[2]);
+	}
+
+	// Cursors give the same bits as streams.
+	{
+		boost::bitstream::bit_reader r(&bytes[0], bits, boost::bitstream::lsb_first);
+		std::vector<char> buffer(bytes.size(), '\x55');
+		boost::bitstream::bit_writer w(&buffer[0], bits, boost::bitstream::lsb_first);
+		for (size_t i = 0; i < fields.size(); ++i)
+		{
+			bitfield value;
+			r.read(value, static_cast<std::streamsize>(widths[i % width_count]));
+			BOOST_CHECK(value == fields[i]);
+			w.write(fields[i], static_cast<std::streamsize>(widths[i % width_count]));
+		}
+		BOOST_CHECK(r && w);
+		BOOST_CHECK(std::equal(buffer.begin(), buffer.begin() + w.tellp() / CHAR_BIT, bytes.begin()));
+
+		std::bitset<100> wide;
+		r.seekg(5);
+		r >> wide;
+		boost::bitstream::ibitstream bin(&bytes[0], bits, boost::bitstream::lsb_first);
+		std::bitset<100> wide1;
+		bin.seekg(5);
+		bin >> wide1;
+		BOOST_CHECK(r && bin && wide == wide1);
+	}
+
+	// Near the end, what is left is followed by zeros, which come after it,
+	// i.e., above it.
+	{
+		const char last[] = { '\x01' };
+		boost::bitstream::ibitstream bin(last, 1, boost::bitstream::lsb_first);
+		BOOST_CHECK(bin.show_bits<4>() == 1 && bin.show_bits(4) == 1);
+		boost::bitstream::bit_reader r(last, 1, boost::bitstream::lsb_first);
+		BOOST_CHECK(r.show_bits(4) == 1);
+	}
+
+	// Variable-length integers round-trip; LEB128 bytes are as in memory.
+	{
+		using boost::bitstream::ue;
+		using boost::bitstream::se;
+		using boost::bitstream::leb128;
+
+		char buffer[64] = { 0 };
+		boost::bitstream::obitstream bout(buffer, sizeof buffer * CHAR_BIT, boost::bitstream::lsb_first);
+		bout << leb128(300u) << boost::bitstream::flush;
+		BOOST_CHECK(bout && buffer[0] == '\xac' && buffer[1] == '\x02');
+		boost::bitstream::ibitstream bin(buffer, 16, boost::bitstream::lsb_first);
+		unsigned a = 0;
+		bin >> leb128(a);
+		BOOST_CHECK(bin && a == 300);
+
+		const boost::uint64_t big = ~boost::uint64_t(0) - 1;
+		const boost::int64_t smallest = std::numeric_limits<boost::int64_t>::min();
+		boost::bitstream::bit_writer w(buffer, sizeof buffer * CHAR_BIT, boost::bitstream::lsb_first);
+		w.put(1);
+		w << ue(0) << ue(1u) << ue(7) << ue(big) << ue(boost::uint64_t(1) << 32) <<
+			se(-5) << se(300) << leb128(624485u) << leb128(smallest) << ue(6);
+		BOOST_CHECK(w);
+
+		boost::bitstream::bit_reader r(buffer, w.tellp(), boost::bitstream::lsb_first);
+		boost::bitstream::ibitstream bin1(buffer, w.tellp(), boost::bitstream::lsb_first);
+		for (int i = 0; i < 2; ++i)
+		{
+			unsigned b = 1, c = 0, d = 0, e = 0, h = 0;
+			boost::uint64_t x = 0, y = 0;
+			int p = 0, q = 0;
+			boost::int64_t z = 0;
+			if (i == 0)
+			{
+				r.ignore(1);
+				r >> ue(b) >> ue(c) >> ue(d) >> ue(x) >> ue(y) >> se(p) >> se(q) >>
+					leb128(e) >> leb128(z) >> ue(h);
+				BOOST_CHECK(r && r.eof());
+			}
+			else
+			{
+				bin1.ignore(1);
+				bin1 >> ue(b) >> ue(c) >> ue(d) >> ue(x) >> ue(y) >> se(p) >> se(q) >>
+					leb128(e) >> leb128(z) >> ue(h);
+				BOOST_CHECK(bin1 && bin1.eof());
+			}
+			BOOST_CHECK(b == 0 && c == 1 && d == 7 && h == 6);
+			BOOST_CHECK(x == big && y == boost::uint64_t(1) << 32);
+			BOOST_CHECK(p == -5 && q == 300 && e == 624485u && z == smallest);
+		}
+
+		// Arrays of codes, several to a peek.
+		std::vector<unsigned> values;
+		for (unsigned i = 0; i < 300; ++i)
+		{
+			values.push_back(i % 7 == 0 ? i * 4099 : i % 5);
+		}
+		std::vector<char> buffer1(3000);
+		boost::bitstream::bit_writer w1(&buffer1[0], buffer1.size() * CHAR_BIT, boost::bitstream::lsb_first);
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			w1 << ue(values[i]);
+		}
+		BOOST_CHECK(w1);
+		boost::bitstream::ibitstream bin2(&buffer1[0], w1.tellp(), boost::bitstream::lsb_first);
+		std::vector<unsigned> decoded(values.size());
+		BOOST_CHECK(boost::bitstream::read_ue(bin2, &decoded[0], decoded.size()) == decoded.size());
+		BOOST_CHECK(bin2.eof() && decoded == values);
+	}
+
+	// Variable-length codes, e.g., DEFLATE's, which are put first bit first.
+	{
+		std::vector<boost::bitstream::vlc_code<int> > codes;
+		for (size_t length = 1; length <= 14; ++length)
+		{
+			codes.push_back(boost::bitstream::vlc_code<int>(
+				((bitfield(1) << length) - 1) - 1, length, static_cast<int>(length)));
+		}
+		codes.push_back(boost::bitstream::vlc_code<int>(0x3fff, 14, 100));
+
+		char buffer[1000] = { 0 };
+		std::vector<int> symbols;
+		boost::bitstream::bit_writer w(buffer, sizeof buffer * CHAR_BIT, boost::bitstream::lsb_first);
+		for (size_t i = 0; i < 500; ++i)
+		{
+			const boost::bitstream::vlc_code<int> &code = codes[(i * 7) % codes.size()];
+			for (size_t j = code.length; j-- > 0; )
+			{
+				w.put((code.bits >> j) & 1);
+			}
+			symbols.push_back(code.symbol);
+		}
+		BOOST_CHECK(w);
+		const std::streamsize written = static_cast<std::streamsize>(w.tellp());
+
+		const size_t indexBits[] = { 1, 4, 9 };
+		for (size_t i = 0; i < sizeof indexBits / sizeof indexBits[0]; ++i)
+		{
+			const boost::bitstream::vlc_table<int> table(codes.begin(), codes.end(), indexBits[i],
+				boost::bitstream::lsb_first);
+			BOOST_CHECK(table.valid() && table.order() == boost::bitstream::lsb_first);
+
+			boost::bitstream::ibitstream bin(buffer, written, boost::bitstream::lsb_first);
+			std::vector<int> decoded(symbols.size());
+			BOOST_CHECK(table.decode(bin, &decoded[0], decoded.size()) == decoded.size());
+			BOOST_CHECK(bin.eof() && decoded == symbols);
+
+			boost::bitstream::bit_reader r(buffer, written, boost::bitstream::lsb_first);
+			std::vector<int> decoded1(symbols.size());
+			BOOST_CHECK(table.decode(r, &decoded1[0], decoded1.size()) == decoded1.size());
+			BOOST_CHECK(r.eof() && decoded1 == symbols);
+		}
+
+		// A table for the other order fails the reader.
+		const boost::bitstream::vlc_table<int> table(codes.begin(), codes.end());
+		boost::bitstream::ibitstream bin(buffer, written, boost::bitstream::lsb_first);
+		int symbol = -1;
+		table.decode(bin, symbol);
+		BOOST_CHECK(bin.fail() && symbol == -1);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(unchecked_extraction)
+{
+	const char rtpHeader[] = { '\x80', '\x08', '\xe7', '\x3c', '\x00', '\x00', '\x3c', '\x00', '\xde', '\xe0', '\xee', '\x8f' };
+	const std::streamsize bits = sizeof rtpHeader * CHAR_BIT;
+	const std::bitset<2> version(2);
+
+	// One check for the whole fixed header.
+	{
+		boost::bitstream::ibitstream bin(rtpHeader, bits);
+		bool padding = true, extension = true, marker = true;
+		std::bitset<4> csrc_count;
+		std::bitset<7> payload_type;
+		boost::uint16_t sequence_number = 0;
+		boost::uint32_t timestamp = 0, ssrc = 0;
+		{
+			boost::bitstream::unchecked in(bin, bits);
+			BOOST_CHECK(in.validated());
+			in >> version >> padding >> extension >> csrc_count >> marker >>
+				payload_type >> sequence_number >> timestamp;
+			BOOST_CHECK(in && bin.tellg() == 0);
+			in >> ssrc;
+		}
+		BOOST_CHECK(bin && bin.eof() && bin.tellg() == bits);
+		BOOST_CHECK(!padding && !extension && !marker);
+		BOOST_CHECK(csrc_count == 0 && payload_type == 8);
+		BOOST_CHECK(sequence_number == 0xe73c && timestamp == 0x3c00 && ssrc == 0xdee0ee8f);
+	}
+
+	// A mismatch is deferred until release(); unread bits are left.
+	{
+		boost::bitstream::ibitstream bin(rtpHeader, bits);
+		boost::uint16_t sequence_number = 0;
+		boost::bitstream::unchecked in(bin, 32);
+		in >> std::bitset<2>(3);
+		BOOST_CHECK(!in && bin.good());
+		in.ignore(14) >> sequence_number;
+		in.release();
+		BOOST_CHECK(bin.fail() && !bin.eof() && bin.tellg() == 32);
+		BOOST_CHECK(sequence_number == 0xe73c);
+	}
+
+	// Without all the bits, extractions are checked as usual.
+	{
+		boost::bitstream::ibitstream bin(rtpHeader, 40);
+		boost::uint32_t timestamp = 0, ssrc = 0;
+		{
+			boost::bitstream::unchecked in(bin, bits);
+			BOOST_CHECK(!in.validated());
+			in >> timestamp >> ssrc;
+			BOOST_CHECK(!in);
+		}
+		BOOST_CHECK(bin.fail() && bin.eof() && timestamp == 0x8008e73c);
+
+		const std::string header(rtpHeader, sizeof rtpHeader);
+		std::stringbuf source(header + header + header + header);
+		boost::bitstream::streambitbuf sbb(&source, 5);
+		boost::bitstream::ibitstream bin1(&sbb);
+		bin1.ignore(16);
+		{
+			boost::bitstream::unchecked in(bin1, 3 * bits);
+			BOOST_CHECK(!in.validated());
+			in >> timestamp >> ssrc;
+		}
+		BOOST_CHECK(bin1 && timestamp == 0xe73c0000 && ssrc == 0x3c00dee0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(wide_fields)
+{
+	std::string bytes(64, '\0');
+	for (size_t i = 0; i < bytes.size(); ++i)
+	{
+		bytes[i] = static_cast<char>(i * 73 + 29);
+	}
+	const std::streamsize bits = static_cast<std::streamsize>(bytes.size()) * CHAR_BIT;
+	const unsigned char *data = reinterpret_cast<const unsigned char *>(bytes.data());
+
+	// Bit of buffer, MSB first or LSB first.
+	struct
+	{
+		bool operator()(const unsigned char *p, std::streamsize position, bool lsb) const
+		{
+			return ((p[position / CHAR_BIT] >> (lsb ? position % CHAR_BIT :
+				CHAR_BIT - 1 - position % CHAR_BIT)) & 1) != 0;
+		}
+	} bit_at;
+
+	// bitsets wider than bitfield, at every bit offset, in both orders; the
+	// last bit of the field is bit 0 of the bitset, or, LSB first, the first.
+	for (int lsb = 0; lsb < 2; ++lsb)
+	{
+		const boost::bitstream::bit_order order = lsb ?
+			boost::bitstream::lsb_first : boost::bitstream::msb_first;
+		bool okay = true;
+		for (std::streamsize offset = 0; offset < 16; ++offset)
+		{
+			boost::bitstream::ibitstream bin(bytes.data(), bits, order);
+			bin.ignore(offset);
+			std::bitset<128> id;
+			std::bitset<200> bitmap;
+			bin >> id >> bitmap;
+			okay = okay && bin;
+			for (size_t i = 0; i < id.size(); ++i)
+			{
+				okay = okay && id[lsb ? i : id.size() - 1 - i] == bit_at(data, offset + i, lsb);
+			}
+			for (size_t i = 0; i < bitmap.size(); ++i)
+			{
+				okay = okay && bitmap[lsb ? i : bitmap.size() - 1 - i] ==
+					bit_at(data, offset + 128 + i, lsb);
+			}
+
+			// Writing them back, with a field before, gives the same bits.
+			std::string buffer(bytes.size(), '\0');
+			{
+				boost::bitstream::obitstream bout(&buffer[0], bits, order);
+				boost::bitstream::bitfield head = 0;
+				if (offset > 0)
+				{
+					boost::bitstream::ibitstream(bytes.data(), bits, order).read(head, offset);
+					bout.write(head, offset);
+				}
+				bout << id << bitmap;
+				okay = okay && bout;
+			}
+			okay = okay && buffer.compare(0, static_cast<size_t>(offset + 328) / CHAR_BIT,
+				bytes, 0, static_cast<size_t>(offset + 328) / CHAR_BIT) == 0;
+		}
+		BOOST_CHECK(okay);
+	}
+
+	// Into a byte span, which is a plain copy when aligned; straddling the
+	// windows of a streambitbuf; and from a bit_reader.
+	{
+		unsigned char span[17];
+		boost::bitstream::ibitstream bin(bytes.data(), bits);
+		bin.ignore(3).read_wide(span, 130);
+		BOOST_CHECK(bin);
+		bool okay = (span[16] & 0x3f) == 0;
+		for (std::streamsize i = 0; i < 130; ++i)
+		{
+			okay = okay && bit_at(span, i, false) == bit_at(data, 3 + i, false);
+		}
+		BOOST_CHECK(okay);
+
+		unsigned char span1[17];
+		std::stringbuf source(bytes);
+		boost::bitstream::streambitbuf sbb(&source, 3);
+		boost::bitstream::ibitstream bin1(&sbb);
+		bin1.ignore(3).read_wide(span1, 130);
+		BOOST_CHECK(bin1 && std::equal(span, span + sizeof span, span1));
+
+		unsigned char span2[17];
+		boost::bitstream::bit_reader r(bytes.data(), bits);
+		r.ignore(3).read_wide(span2, 130);
+		BOOST_CHECK(r && std::equal(span, span + sizeof span, span2));
+
+		std::bitset<400> too_wide;
+		too_wide.set();
+		bin >> too_wide;
+		BOOST_CHECK(bin.fail() && too_wide.none());
+
+		std::string buffer(bytes.size(), '\0');
+		boost::bitstream::bit_writer w(&buffer[0], bits);
+		w.ignore(3).write_wide(span, 130);
+		std::bitset<130> bs;
+		boost::bitstream::bit_reader r1(buffer.data(), bits);
+		r1.ignore(3) >> bs;
+		BOOST_CHECK(w && r1);
+		BOOST_CHECK(buffer.compare(1, 15, bytes, 1, 15) == 0);
+		bin.clear();
+		bin.seekg(3);
+		BOOST_CHECK(bin >> std::bitset<130>(bs));
+	}
+
+	// Containers of them go a bitset at a time, both ways.
+	{
+		boost::bitstream::ibitstream bin(bytes.data(), bits);
+		std::vector<std::bitset<128> > ids;
+		boost::array<std::bitset<128>, 2> ids1;
+		bin >> boost::bitstream::setrepeat(2) >> ids >> ids1;
+		BOOST_CHECK(bin && ids.size() == 2);
+
+		std::string buffer(bytes.size(), '\0');
+		boost::bitstream::obitstream bout(&buffer[0], bits);
+		bout << ids << ids1 << boost::bitstream::flush;
+		BOOST_CHECK(bout && bout.tellp() == std::streampos(512));
+		BOOST_CHECK(buffer == bytes);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(bit_blit)
+{
+	std::string bytes(64, '\0');
+	for (size_t i = 0; i < bytes.size(); ++i)
+	{
+		bytes[i] = static_cast<char>(i * 73 + 29);
+	}
+	const std::streamsize bits = static_cast<std::streamsize>(bytes.size()) * CHAR_BIT;
+
+	// Bit of buffer, MSB first or LSB first.
+	struct
+	{
+		bool operator()(const std::string &s, std::streamsize position, bool lsb) const
+		{
+			return ((static_cast<unsigned char>(s[static_cast<size_t>(position / CHAR_BIT)]) >>
+				(lsb ? position % CHAR_BIT : CHAR_BIT - 1 - position % CHAR_BIT)) & 1) != 0;
+		}
+	} bit_at;
+
+	// Between buffers at every pair of bit offsets, in both orders, with
+	// bits of the destination outside the copy kept.
+	static const std::streamsize sizes[] = { 1, 5, 8, 63, 64, 65, 200 };
+	for (int lsb = 0; lsb < 2; ++lsb)
+	{
+		const boost::bitstream::bit_order order = lsb ?
+			boost::bitstream::lsb_first : boost::bitstream::msb_first;
+		bool okay = true;
+		for (std::streamsize from = 0; from < 16; ++from)
+		{
+			for (std::streamsize to = 0; to < 16; ++to)
+			{
+				for (size_t k = 0; k < sizeof sizes / sizeof sizes[0]; ++k)
+				{
+					const std::streamsize size = sizes[k];
+					std::string buffer(bytes.size(), '\x5a');
+					boost::bitstream::bitbuf src(bytes.data(), bits);
+					boost::bitstream::bitbuf dst(buffer.data(), bits);
+					src.order(order);
+					dst.order(order);
+					okay = okay && boost::bitstream::bitbuf::copy_bits(src, from,
+						dst, to, size) == size;
+					const std::string untouched(bytes.size(), '\x5a');
+					for (std::streamsize i = 0; i < bits; ++i)
+					{
+						okay = okay && bit_at(buffer, i, lsb != 0) ==
+							(i >= to && i < to + size ? bit_at(bytes, from + i - to, lsb != 0) :
+							bit_at(untouched, i, lsb != 0));
+					}
+				}
+			}
+		}
+		BOOST_CHECK(okay);
+	}
+
+	// Within one buffer, overlapping either way, including within a byte.
+	{
+		bool okay = true;
+		for (std::streamsize from = 0; from < 24; ++from)
+		{
+			for (std::streamsize to = 0; to < 24; ++to)
+			{
+				std::string buffer(bytes);
+				boost::bitstream::bitbuf bb(buffer.data(), bits);
+				okay = okay && boost::bitstream::bitbuf::copy_bits(bb, from, bb, to,
+					300) == 300;
+				for (std::streamsize i = 0; i < 300; ++i)
+				{
+					okay = okay && bit_at(buffer, to + i, false) == bit_at(bytes, from + i, false);
+				}
+			}
+		}
+		BOOST_CHECK(okay);
+	}
+
+	// Out of range or orders that differ copy nothing.
+	{
+		std::string buffer(bytes.size(), '\0');
+		boost::bitstream::bitbuf src(bytes.data(), bits);
+		boost::bitstream::bitbuf dst(buffer.data(), bits);
+		BOOST_CHECK_EQUAL(boost::bitstream::bitbuf::copy_bits(src, bits - 8, dst, 0, 9), 0);
+		BOOST_CHECK_EQUAL(boost::bitstream::bitbuf::copy_bits(src, 0, dst, bits - 8, 9), 0);
+		dst.order(boost::bitstream::lsb_first);
+		BOOST_CHECK_EQUAL(boost::bitstream::bitbuf::copy_bits(src, 0, dst, 0, 8), 0);
+	}
+
+	// get(bitbuf &) stops when the destination is full, leaving the rest.
+	{
+		std::string buffer(bytes.size(), '\0');
+		boost::bitstream::bitbuf dst(buffer.data(), 100);
+		dst.pubseekpos(3, std::ios_base::out);
+		boost::bitstream::ibitstream bin(bytes.data(), bits);
+		bin.ignore(5);
+		BOOST_CHECK(bin.get(dst));
+		BOOST_CHECK_EQUAL(bin.gcount(), 97);
+		BOOST_CHECK_EQUAL(bin.tellg(), std::streampos(102));
+		bool okay = true;
+		for (std::streamsize i = 0; i < 97; ++i)
+		{
+			okay = okay && bit_at(buffer, 3 + i, false) == bit_at(bytes, 5 + i, false);
+		}
+		BOOST_CHECK(okay);
+		BOOST_CHECK(!bin.get(dst));
+		BOOST_CHECK_EQUAL(bin.gcount(), 0);
+	}
+
+	// Everything from a streambitbuf into a growing buffer, and from an
+	// lsb_first stream, which goes a bit at a time.
+	{
+		std::stringbuf source(bytes);
+		boost::bitstream::streambitbuf sbb(&source, 3);
+		boost::bitstream::ibitstream bin(&sbb);
+		boost::bitstream::ovectorbitstream bout;
+		bout.write(1, 1);
+		bout.flush();
+		BOOST_CHECK(bin.get(*bout.rdbuf()));
+		BOOST_CHECK(bin.eof() && !bin.fail());
+		BOOST_CHECK_EQUAL(bin.gcount(), bits);
+		BOOST_CHECK_EQUAL(bout.bits(), bits + 1);
+		std::string copy(bout.data(), static_cast<size_t>(bout.bits() + CHAR_BIT - 1) / CHAR_BIT);
+		bool okay = bit_at(copy, 0, false);
+		for (std::streamsize i = 0; i < bits; ++i)
+		{
+			okay = okay && bit_at(copy, 1 + i, false) == bit_at(bytes, i, false);
+		}
+		BOOST_CHECK(okay);
+
+		boost::bitstream::ibitstream bin1(bytes.data(), bits, boost::bitstream::lsb_first);
+		std::string buffer(bytes.size(), '\0');
+		boost::bitstream::bitbuf dst(buffer.data(), bits);
+		BOOST_CHECK(bin1.get(dst) && bin1.eof());
+		okay = true;
+		for (std::streamsize i = 0; i < bits; ++i)
+		{
+			okay = okay && bit_at(buffer, i, false) == bit_at(bytes, i, true);
+		}
+		BOOST_CHECK(okay);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(pattern_search)
+{
+	// Bytes with the high bit set, so no start codes, and two start codes.
+	std::string bytes(160, '\0');
+	for (size_t i = 0; i < bytes.size(); ++i)
+	{
+		bytes[i] = static_cast<char>(0x80 | (i * 73 + 29));
+	}
+	bytes.replace(37, 3, std::string("\0\0\1", 3));
+	bytes.replace(101, 3, std::string("\0\0\1", 3));
+	const std::streamsize bits = static_cast<std::streamsize>(bytes.size()) * CHAR_BIT;
+
+	// Byte-aligned start codes, from memory and straddling the chunks of a
+	// streambitbuf; when there are no more, the stream is at its end.
+	{
+		boost::bitstream::ibitstream bin(bytes.data(), bits);
+		BOOST_CHECK_EQUAL(bin.seek_to_pattern(0x000001, 24, 8), std::streampos(37 * 8));
+		BOOST_CHECK_EQUAL(bin.tellg(), std::streampos(37 * 8));
+		bin.ignore(1);
+		BOOST_CHECK_EQUAL(bin.seek_to_pattern(0x000001, 24, 8), std::streampos(101 * 8));
+		bin.ignore(24);
+		BOOST_CHECK_EQUAL(bin.seek_to_pattern(0x000001, 24, 8), std::streampos(-1));
+		BOOST_CHECK(bin.eof() && !bin.fail());
+		BOOST_CHECK_EQUAL(bin.tellg(), std::streampos(bits));
+
+		std::stringbuf source(bytes);
+		boost::bitstream::streambitbuf sbb(&source, 5);
+		boost::bitstream::ibitstream bin1(&sbb);
+		BOOST_CHECK_EQUAL(bin1.seek_to_pattern(0x000001, 24, 8), std::streampos(37 * 8));
+		bin1.ignore(24);
+		BOOST_CHECK_EQUAL(bin1.seek_to_pattern(0x000001, 24, 8), std::streampos(101 * 8));
+		bin1.ignore(24);
+		BOOST_CHECK_EQUAL(bin1.seek_to_pattern(0x000001, 24, 8), std::streampos(-1));
+		BOOST_CHECK(bin1.eof());
+
+		// MPEG-TS-like stride: only every 16th byte is tried.
+		boost::bitstream::ibitstream bin2(bytes.data(), bits);
+		BOOST_CHECK_EQUAL(bin2.seek_to_pattern(0x00, 8, 16 * 8), std::streampos(-1));
+		bytes[96] = 0;
+		boost::bitstream::ibitstream bin3(bytes.data(), bits);
+		BOOST_CHECK_EQUAL(bin3.seek_to_pattern(0x00, 8, 16 * 8), std::streampos(96 * 8));
+		bytes[96] = static_cast<char>(0x80);
+	}
+
+	// Any pattern, alignment and start against a brute-force search, in both
+	// orders, from memory, a streambitbuf and a chainbitbuf.
+	std::vector<boost::bitstream::chainbitbuf::segment> segments;
+	for (size_t offset = 0; offset < bytes.size(); offset += 7)
+	{
+		segments.push_back(boost::bitstream::chainbitbuf::segment(bytes.data() + offset,
+			std::min(size_t(7), bytes.size() - offset)));
+	}
+	static const size_t alignments[] = { 1, 3, 8, 16 };
+	static const std::streamsize sizes[] = { 5, 12, 24, 60, 64 };
+	for (int lsb = 0; lsb < 2; ++lsb)
+	{
+		const boost::bitstream::bit_order order = lsb ?
+			boost::bitstream::lsb_first : boost::bitstream::msb_first;
+		bool okay = true;
+		for (size_t a = 0; a < sizeof alignments / sizeof alignments[0]; ++a)
+		{
+			for (size_t k = 0; k < sizeof sizes / sizeof sizes[0]; ++k)
+			{
+				const std::streamsize size = sizes[k];
+				for (std::streamsize start = 0; start < 40; start += 13)
+				{
+					boost::bitstream::bitfield pattern;
+					boost::bitstream::ibitstream(bytes.data(), bits, order).
+						ignore(700 + start).read(pattern, size);
+
+					std::streampos expected(-1);
+					for (std::streamsize p = (start + alignments[a] - 1) / alignments[a] *
+						alignments[a]; p + size <= bits; p += alignments[a])
+					{
+						boost::bitstream::bitfield value;
+						boost::bitstream::ibitstream(bytes.data(), bits, order).
+							ignore(p).read(value, size);
+						if (value == pattern)
+						{
+							expected = p;
+							break;
+						}
+					}
+
+					boost::bitstream::ibitstream bin(bytes.data(), bits, order);
+					bin.ignore(start);
+					okay = okay && bin.seek_to_pattern(pattern, size, alignments[a]) == expected;
+
+					std::stringbuf source(bytes);
+					boost::bitstream::streambitbuf sbb(&source, 5);
+					sbb.order(order);
+					boost::bitstream::ibitstream bin1(&sbb);
+					bin1.ignore(start);
+					okay = okay && bin1.seek_to_pattern(pattern, size, alignments[a]) == expected;
+
+					boost::bitstream::chainbitbuf cbb(segments.begin(), segments.end());
+					cbb.order(order);
+					boost::bitstream::ibitstream bin2(&cbb);
+					bin2.ignore(start);
+					okay = okay && bin2.seek_to_pattern(pattern, size, alignments[a]) == expected;
+				}
+			}
+		}
+		BOOST_CHECK(okay);
+	}
+
+	// Patterns wider than bitfield cannot be searched for.
+	boost::bitstream::ibitstream bin(bytes.data(), bits);
+	BOOST_CHECK_EQUAL(bin.seek_to_pattern(0, 65), std::streampos(-1));
+	BOOST_CHECK(bin.fail());
+}
+
+/**
+	Compute checksum of bits [first, first + size) of s, regrouped into
+	bytes in the order given, a byte at a time.
+*/
+template <typename Checksum>
+typename Checksum::value_type reference_checksum(Checksum checksum, const std::string &s,
+	std::streamsize first, std::streamsize size, boost::bitstream::bit_order order)
+{
+	boost::bitstream::ibitstream bin(s.data(),
+		static_cast<std::streamsize>(s.size()) * CHAR_BIT, order);
+	bin.ignore(first);
+	for (; size >= CHAR_BIT; size -= CHAR_BIT)
+	{
+		boost::bitstream::bitfield byte;
+		bin.read(byte, CHAR_BIT);
+		const unsigned char c = static_cast<unsigned char>(byte);
+		checksum.process_bytes(&c, 1);
+	}
+	if (size > 0)
+	{
+		boost::bitstream::bitfield part;
+		bin.read(part, size);
+		checksum.process_bits(static_cast<unsigned char>(order ==
+			boost::bitstream::msb_first ? part << (CHAR_BIT - size) : part),
+			static_cast<size_t>(size), order);
+	}
+	return checksum.checksum();
+}
+
+BOOST_AUTO_TEST_CASE(checksum_filters)
+{
+	// Check values of the CRCs and of RFC 1071's example.
+	const std::string check("123456789");
+	const unsigned char *check_bytes = reinterpret_cast<const unsigned char *>(check.data());
+	{
+		boost::bitstream::crc32 crc32;
+		crc32.process_bytes(check_bytes, check.size());
+		BOOST_CHECK_EQUAL(crc32.checksum(), 0xCBF43926u);
+		boost::bitstream::crc32c crc32c;
+		crc32c.process_bytes(check_bytes, check.size());
+		BOOST_CHECK_EQUAL(crc32c.checksum(), 0xE3069283u);
+		boost::bitstream::crc16_ccitt crc16;
+		crc16.process_bytes(check_bytes, check.size());
+		BOOST_CHECK_EQUAL(crc16.checksum(), 0x29B1u);
+		boost::bitstream::crc32_mpeg2 mpeg2;
+		mpeg2.process_bytes(check_bytes, check.size());
+		BOOST_CHECK_EQUAL(mpeg2.checksum(), 0x0376E6E7u);
+
+		const unsigned char words[] = { 0x00, 0x01, 0xf2, 0x03, 0xf4, 0xf5, 0xf6, 0xf7 };
+		boost::bitstream::internet_checksum ip;
+		ip.process_bytes(words, 3);
+		ip.process_bytes(words + 3, 5);
+		BOOST_CHECK_EQUAL(ip.checksum(), 0x220Du);
+	}
+
+	std::string bytes(300, '\0');
+	for (size_t i = 0; i < bytes.size(); ++i)
+	{
+		bytes[i] = static_cast<char>(i * 73 + 29);
+	}
+	const std::streamsize bits = static_cast<std::streamsize>(bytes.size()) * CHAR_BIT;
+	const unsigned char *data = reinterpret_cast<const unsigned char *>(bytes.data());
+
+	// Slicing-by-8 agrees with a byte at a time for any split.
+	{
+		boost::bitstream::crc32 whole, split;
+		whole.process_bytes(data, bytes.size());
+		for (size_t i = 0; i < bytes.size(); i += 11)
+		{
+			split.process_bytes(data + i, std::min(size_t(11), bytes.size() - i));
+		}
+		BOOST_CHECK_EQUAL(whole.checksum(), split.checksum());
+		boost::bitstream::crc32c whole_c, split_c;
+		whole_c.process_bytes(data, bytes.size());
+		for (size_t i = 0; i < bytes.size(); ++i)
+		{
+			split_c.process_bytes(data + i, 1);
+		}
+		BOOST_CHECK_EQUAL(whole_c.checksum(), split_c.checksum());
+	}
+
+
+	// Fields of odd sizes read from memory, straddling the chunks of a
+	// streambitbuf, and at any offset, in both orders.
+	for (int lsb = 0; lsb < 2; ++lsb)
+	{
+		const boost::bitstream::bit_order order = lsb ?
+			boost::bitstream::lsb_first : boost::bitstream::msb_first;
+		bool okay = true;
+		for (std::streamsize first = 0; first < 20; first += 3)
+		{
+			std::stringbuf source(bytes);
+			boost::bitstream::streambitbuf sbb(&source, 7);
+			sbb.order(order);
+			boost::bitstream::ibitstream bin(bytes.data(), bits, order);
+			boost::bitstream::ibitstream bin1(&sbb);
+			for (int i = 0; i < 2; ++i)
+			{
+				boost::bitstream::istream &in = i == 0 ? static_cast<boost::bitstream::istream &>(bin) : bin1;
+				in.ignore(first);
+				std::streamsize size = 0;
+				boost::uint32_t computed;
+				{
+					boost::bitstream::checksum_filter<boost::bitstream::crc32> crc(in);
+					crc.begin_crc();
+					boost::bitstream::bitfield value;
+					for (std::streamsize field = 1; field <= 64 && size + field <= 1900; field += 9)
+					{
+						in.read(value, field);
+						size += field;
+					}
+					unsigned char wide[40];
+					in.read_wide(wide, 300);
+					size += 300;
+					computed = crc.end_crc();
+					in.ignore(5);
+				}
+				okay = okay && in && computed == reference_checksum(boost::bitstream::crc32(),
+					bytes, first, size, order);
+				okay = okay && in.tellg() == std::streampos(first + size + 5);
+			}
+		}
+		BOOST_CHECK(okay);
+	}
+
+	// Bits written, with and without unitbuf, into memory and into a
+	// growing buffer.
+	{
+		bool okay = true;
+		for (int unit = 0; unit < 2; ++unit)
+		{
+			std::string buffer(bytes.size(), '\0');
+			boost::bitstream::obitstream bout(&buffer[0], bits);
+			boost::bitstream::ovectorbitstream vout(1);
+			for (int i = 0; i < 2; ++i)
+			{
+				boost::bitstream::ostream &out = i == 0 ? static_cast<boost::bitstream::ostream &>(bout) : vout;
+				out.unitbuf(unit != 0);
+				out.write(5, 3);
+				boost::uint16_t computed;
+				{
+					boost::bitstream::checksum_filter<boost::bitstream::crc16_ccitt> crc(out);
+					crc.begin_crc();
+					for (size_t j = 0; j < 40; ++j)
+					{
+						out.write(static_cast<boost::bitstream::bitfield>(j * 2654435761u), 1 + j % 30);
+					}
+					computed = crc.end_crc();
+					out.write(1, 1);
+				}
+				out.flush();
+				const std::string written = i == 0 ? buffer : std::string(vout.data(),
+					static_cast<size_t>(vout.bits() + CHAR_BIT - 1) / CHAR_BIT);
+				std::streamsize size = 0;
+				for (size_t j = 0; j < 40; ++j)
+				{
+					size += 1 + j % 30;
+				}
+				okay = okay && out && computed == reference_checksum(boost::bitstream::crc16_ccitt(),
+					written, 3, size, boost::bitstream::msb_first);
+			}
+		}
+		BOOST_CHECK(okay);
+	}
+
+	// The Internet checksum of a header that includes its checksum is 0.
+	{
+		std::string header(bytes.substr(0, 20));
+		header[10] = header[11] = 0;
+		boost::bitstream::internet_checksum ip;
+		ip.process_bytes(reinterpret_cast<const unsigned char *>(header.data()), header.size());
+		header[10] = static_cast<char>(ip.checksum() >> 8);
+		header[11] = static_cast<char>(ip.checksum());
+		boost::bitstream::ibitstream bin(header.data(), 160);
+		boost::bitstream::checksum_filter<boost::bitstream::internet_checksum> sum(bin);
+		sum.begin_crc();
+		boost::uint32_t word;
+		for (int i = 0; i < 5; ++i)
+		{
+			bin >> word;
+		}
+		BOOST_CHECK(bin);
+		BOOST_CHECK_EQUAL(sum.end_crc(), 0);
+	}
+}
+
+/**
+	Record of variable length decoded in steps from a fed stream.
+*/
+struct fed_record
+{
+	bool flag;
+	boost::uint16_t length;
+	std::vector<boost::uint8_t> payload;
+};
+
+/**
+	Decode a record: a 3-bit const, a flag, a 12-bit length and that many
+	bytes of payload.
+
+	\param[in,out] in Stream from which to decode.
+	\param[out] record Record decoded.
+*/
+void decode_fed_record(boost::bitstream::istream &in, fed_record &record)
+{
+	boost::bitstream::bitfield length;
+	in >> std::bitset<3>(5) >> record.flag;
+	in.read(length, 12);
+	record.length = static_cast<boost::uint16_t>(length);
+	record.payload.resize(record.length);
+	for (size_t i = 0; i < record.payload.size(); ++i)
+	{
+		in >> record.payload[i];
+	}
+}
+
+BOOST_AUTO_TEST_CASE(resumable_decoding)
+{
+#ifndef BOOST_NO_CXX11_HDR_TYPE_TRAITS
+	// A copy would point into the original's storage.
+	BOOST_CHECK(!std::is_copy_constructible<boost::bitstream::feedbitbuf>::value);
+	BOOST_CHECK(!std::is_copy_constructible<boost::bitstream::ifeedbitstream>::value);
+#endif
+
+	// Encode records.
+	std::vector<fed_record> records(50);
+	boost::bitstream::ovectorbitstream out;
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		records[i].flag = i % 3 == 0;
+		records[i].length = static_cast<boost::uint16_t>(i * 37 % 300);
+		out << std::bitset<3>(5) << records[i].flag;
+		out.write(records[i].length, 12);
+		for (size_t j = 0; j < records[i].length; ++j)
+		{
+			records[i].payload.push_back(static_cast<boost::uint8_t>(i + j * 7));
+			out << records[i].payload.back();
+		}
+	}
+	out.flush();
+	const std::streamsize bits = out.bits();
+	const std::string encoded(out.data(), static_cast<size_t>(bits + CHAR_BIT - 1) / CHAR_BIT);
+
+	// Feed in chunks of 1 through 17 bytes, decoding whatever has arrived
+	// after each, and discarding what has been decoded.
+	{
+		boost::bitstream::ifeedbitstream in;
+		boost::bitstream::resume_point step(in);
+		size_t decoded = 0;
+		size_t need_more = 0;
+		bool okay = true;
+		std::streampos expected = 0;
+		for (size_t fed = 0, chunk = 1; fed < encoded.size() && okay; fed += chunk, chunk = chunk % 17 + 1)
+		{
+			chunk = std::min(chunk, encoded.size() - fed);
+			in.feed(encoded.data() + fed, static_cast<std::streamsize>(chunk));
+			if (fed + chunk == encoded.size())
+			{
+				in.finish();
+			}
+			for (;;)
+			{
+				fed_record record;
+				decode_fed_record(in, record);
+				const boost::bitstream::decode_status status = decoded < records.size() ?
+					step.result() : boost::bitstream::decode_failed;
+				if (status == boost::bitstream::decode_need_more)
+				{
+					okay = okay && in.good() && in.tellg() == expected;
+					++need_more;
+					break;
+				}
+				if (status == boost::bitstream::decode_failed)
+				{
+					break;
+				}
+				okay = okay && record.flag == records[decoded].flag &&
+					record.payload == records[decoded].payload;
+				expected = step.position();
+				okay = okay && in.tellg() == expected;
+				++decoded;
+				in.discard();
+				okay = okay && in.bits() == static_cast<std::streamsize>(fed + chunk) * CHAR_BIT;
+			}
+		}
+		BOOST_CHECK(okay);
+		BOOST_CHECK_EQUAL(decoded, records.size());
+		BOOST_CHECK(need_more > 0);
+		BOOST_CHECK_EQUAL(in.tellg(), std::streampos(bits));
+	}
+
+	// Input cut short fails once it is finished.
+	{
+		boost::bitstream::ifeedbitstream in;
+		boost::bitstream::resume_point step(in);
+		in.feed(encoded.data(), 10);
+		fed_record record;
+		decode_fed_record(in, record);
+		BOOST_CHECK_EQUAL(step.result(), boost::bitstream::decode_complete);
+		decode_fed_record(in, record);
+		BOOST_CHECK_EQUAL(step.result(), boost::bitstream::decode_need_more);
+		BOOST_CHECK_EQUAL(in.tellg(), std::streampos(16));
+		BOOST_CHECK(in.good());
+		in.finish();
+		decode_fed_record(in, record);
+		BOOST_CHECK_EQUAL(step.result(), boost::bitstream::decode_failed);
+		BOOST_CHECK(!in.feed(encoded.data() + 10, 1));
+	}
+
+	// A const field that does not match fails right away.
+	{
+		boost::bitstream::ifeedbitstream in;
+		boost::bitstream::resume_point step(in);
+		in.feed("\x40\x00\x00", 3);
+		fed_record record;
+		decode_fed_record(in, record);
+		BOOST_CHECK_EQUAL(step.result(), boost::bitstream::decode_failed);
+	}
+
+	// Positions stay absolute across discard(); bytes discarded are gone.
+	{
+		boost::bitstream::ifeedbitstream in;
+		in.feed(encoded.data(), 8);
+		in.ignore(20);
+		in.discard();
+		BOOST_CHECK_EQUAL(in.tellg(), std::streampos(20));
+		in.seekg(18);
+		BOOST_CHECK(in.good());
+		in.seekg(15);
+		BOOST_CHECK(in.fail());
+	}
+}
+
+/**
+	Width of the ith field written to the ring in ring_buffer.
+
+	\param[in] i Index of field.
+	\return Width, 1 through 64.
+*/
+std::streamsize ring_width(size_t i)
+{
+	return static_cast<std::streamsize>(1 + i * 7 % 64);
+}
+
+/**
+	Value of the ith field written to the ring in ring_buffer.
+
+	\param[in] i Index of field.
+	\return Value, masked to ring_width(i) bits.
+*/
+boost::bitstream::bitfield ring_value(size_t i)
+{
+	const boost::bitstream::bitfield value = (i + 1) * 0x9e3779b97f4a7c15ull;
+	const std::streamsize width = ring_width(i);
+
+	return width == 64 ? value : value & ((boost::bitstream::bitfield(1) << width) - 1);
+}
+
+BOOST_AUTO_TEST_CASE(ring_buffer)
+{
+	// One thread taking turns, in both orders, on a ring of an odd number
+	// of bytes so that fields straddle its end at every offset. It holds a
+	// 64-bit field besides one waiting on the byte still being written.
+	for (int lsb = 0; lsb < 2; ++lsb)
+	{
+		boost::bitstream::ringbitbuf ring(19);
+		ring.order(lsb != 0 ? boost::bitstream::lsb_first : boost::bitstream::msb_first);
+		boost::bitstream::ostream out(&ring);
+		boost::bitstream::istream in(&ring);
+		BOOST_CHECK_EQUAL(ring.capacity(), 152);
+		BOOST_CHECK_EQUAL(ring.writable(), 152);
+		BOOST_CHECK_EQUAL(ring.readable(), 0);
+		size_t written = 0;
+		size_t read = 0;
+		bool okay = true;
+		while (read < 2000)
+		{
+			while (ring.writable() >= ring_width(written))
+			{
+				out.write(ring_value(written), ring_width(written));
+				++written;
+			}
+			out.flush();
+			while (ring.readable() >= ring_width(read))
+			{
+				boost::bitstream::bitfield value;
+				in.read(value, ring_width(read));
+				okay = okay && value == ring_value(read);
+				++read;
+			}
+		}
+		BOOST_CHECK(okay);
+		BOOST_CHECK(out && in);
+		BOOST_CHECK(in.tellg() > std::streampos(ring.capacity() * 100));
+		BOOST_CHECK(out.tellp() >= in.tellg());
+
+		// Writing more than there is room for or reading more than has been
+		// published fails.
+		out.ignore(ring.writable() - 3);
+		BOOST_CHECK(out);
+		out.write(0, 4);
+		BOOST_CHECK(!out);
+		boost::bitstream::bitfield value;
+		in.ignore(ring.readable() - 1);
+		in.read(value, 9);
+		BOOST_CHECK(!in);
+	}
+
+	// A capture thread and a decoder thread.
+	{
+		static const size_t count = 100000;
+		boost::bitstream::ringbitbuf ring(64);
+		std::thread producer([&ring]()
+		{
+			boost::bitstream::ostream out(&ring);
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (ring.writable() < ring_width(i))
+				{
+					out.flush();
+					while (ring.writable() < ring_width(i))
+					{
+						std::this_thread::yield();
+					}
+				}
+				out.write(ring_value(i), ring_width(i));
+				if (i % 10 == 9)
+				{
+					out.flush();
+				}
+			}
+			out.flush();
+			ring.close();
+		});
+		boost::bitstream::istream in(&ring);
+		bool okay = true;
+		size_t i = 0;
+		for (; i < count && okay; ++i)
+		{
+			while (ring.readable() < ring_width(i) && !ring.closed())
+			{
+				std::this_thread::yield();
+			}
+			boost::bitstream::bitfield value;
+			in.read(value, ring_width(i));
+			okay = in && value == ring_value(i);
+		}
+		producer.join();
+		BOOST_CHECK(okay);
+		BOOST_CHECK_EQUAL(i, count);
+		BOOST_CHECK_EQUAL(ring.readable(), 0);
+		BOOST_CHECK(in.eof());
+	}
+}
+
+/**
+	Write an RTP header after a few bits of something else, capturing the
+	handles of its marker, sequence number and timestamp.
+
+	\param[in,out] out Stream to write to.
+	\param[in] prefix Number of bits before header.
+	\param[in] marker Marker bit.
+	\param[in] sequence Sequence number.
+	\param[in] timestamp Timestamp.
+	\param[out] handles Handles of marker, sequence number and timestamp.
+*/
+void write_patch_header(boost::bitstream::ostream &out, std::streamsize prefix,
+	bool marker, boost::uint16_t sequence, boost::uint32_t timestamp,
+	boost::bitstream::field_handle handles[3])
+{
+	if (prefix > 0)
+	{
+		out.write(0x5, prefix);
+	}
+	out << std::bitset<2>(2) << false << false << std::bitset<4>(0) <<
+		boost::bitstream::mark_field(handles[0], 1) << marker <<
+		std::bitset<7>(96) <<
+		boost::bitstream::mark_field(handles[1], 16) << sequence <<
+		boost::bitstream::mark_field(handles[2], 32) << timestamp <<
+		boost::uint32_t(0xdeadbeef);
+	out.flush();
+}
+
+BOOST_AUTO_TEST_CASE(header_patching)
+{
+	bool okay = true;
+	for (int lsb = 0; lsb < 2; ++lsb)
+	{
+		const boost::bitstream::bit_order order =
+			lsb != 0 ? boost::bitstream::lsb_first : boost::bitstream::msb_first;
+		for (std::streamsize prefix = 0; prefix < 8; prefix += 3)
+		{
+			const std::streamsize bits = prefix + 96;
+			char encoded[13] = { 0 };
+			boost::bitstream::field_handle handles[3];
+			{
+				boost::bitstream::obitstream out(encoded, bits, order);
+				write_patch_header(out, prefix, false, 0, 0, handles);
+				okay = okay && out;
+			}
+			okay = okay && handles[0].position == prefix + 8 && handles[0].bits == 1 &&
+				handles[1].position == prefix + 16 && handles[1].bits == 16 &&
+				handles[2].position == prefix + 32 && handles[2].bits == 32;
+			const boost::bitstream::packet_template header(encoded, bits, order);
+			okay = okay && header.bits() == bits &&
+				header.size() == static_cast<size_t>(bits + 7) / 8;
+
+			// Each patched copy is what encoding the whole header gives.
+			for (boost::uint32_t i = 0; i < 1000; ++i)
+			{
+				const bool marker = i % 3 == 0;
+				const boost::uint16_t sequence = static_cast<boost::uint16_t>(i * 40503u);
+				const boost::uint32_t timestamp = i * 2654435761u;
+				char expected[13] = { 0 };
+				{
+					boost::bitstream::field_handle ignored[3];
+					boost::bitstream::obitstream out(expected, bits, order);
+					write_patch_header(out, prefix, marker, sequence, timestamp, ignored);
+				}
+				char packet[13] = { 0 };
+				header.copy(packet);
+				header.patch(packet, handles[0], marker);
+				header.patch(packet, handles[1], sequence);
+				// Bits above the field are ignored.
+				header.patch(packet, handles[2], timestamp | 0xff00000000ull);
+				okay = okay && std::memcmp(packet, expected, header.size()) == 0;
+			}
+		}
+	}
+	BOOST_CHECK(okay);
+
+	// Patching the template itself.
+	{
+		char encoded[12] = { 0 };
+		boost::bitstream::field_handle handles[3];
+		boost::bitstream::obitstream out(encoded, 96);
+		write_patch_header(out, 0, false, 0, 0, handles);
+		boost::bitstream::packet_template header(encoded, 96);
+		header.patch(handles[1], 0x1234);
+		boost::bitstream::ibitstream in(header.data(), header.bits());
+		boost::uint16_t sequence;
+		in.ignore(16);
+		in >> sequence;
+		BOOST_CHECK(in);
+		BOOST_CHECK_EQUAL(sequence, 0x1234);
+	}
+}
@@ -0,0 +1,218 @@
+/** \file
+    \brief Regression tests for instrumentation counters.
+    \details This file contains tests of the counters kept by bitbufs and
+        streams when BOOST_BITSTREAM_STATS is defined, which changes their
+        layout, so they are built apart from test_rtp.cpp.
+    \see http://www.boost.org/ for latest version.
+    \see http://www.boost.org/libs/bitstream for documentation.
+
+    Use, modification, and distribution is subject to the Boost Software
+        License, Version 1.0. (See accompanying file LICENSE_1_0.txt or copy at
+        http://www.boost.org/LICENSE_1_0.txt)
+*/
+
+#define BOOST_TEST_MAIN  "Bitstream Instrumentation Tests"
+
+#define BOOST_BITSTREAM_STATS
+
+#include <boost/test/included/unit_test.hpp>
+
+#include <boost/bitstream/bstream.hpp>
+#include <boost/bitstream/iomanip.hpp>
+#include <boost/bitstream/unchecked.hpp>
+#include <boost/bitstream/vectorbuf.hpp>
+
+#include <bitset>
+#include <climits>
+#include <cstddef>
+#include <vector>
+
+BOOST_AUTO_TEST_CASE(instrumentation)
+{
+	BOOST_CHECK_EQUAL(boost::bitstream::stream_stats::width_bucket(1), 0u);
+	BOOST_CHECK_EQUAL(boost::bitstream::stream_stats::width_bucket(4), 1u);
+	BOOST_CHECK_EQUAL(boost::bitstream::stream_stats::width_bucket(5), 2u);
+	BOOST_CHECK_EQUAL(boost::bitstream::stream_stats::width_bucket(16), 3u);
+	BOOST_CHECK_EQUAL(boost::bitstream::stream_stats::width_bucket(17), 4u);
+	BOOST_CHECK_EQUAL(boost::bitstream::stream_stats::width_bucket(64), 5u);
+
+	const char buffer[] = { '\xb7', '\x40', '\x12', '\x34', '\x56', '\x78',
+		'\x9a', '\xbc', '\xde', '\xf0', '\x11', '\x22' };
+	boost::bitstream::ibitstream bin(buffer, sizeof buffer * CHAR_BIT);
+
+	// Reads by width and alignment.
+	bool b;
+	boost::uint8_t octet;
+	boost::uint16_t word;
+	boost::bitstream::bitfield value;
+	bin >> b;
+	bin.read(value, 7);
+	bin >> octet;
+	bin.read<3>(value);
+	bin >> word;
+	bin.read(value, 57);
+	BOOST_CHECK(bin);
+	boost::bitstream::stream_stats bits = bin.rdbuf()->stats();
+	BOOST_CHECK_EQUAL(bits.bits_read, 1u + 7 + 8 + 3 + 16 + 57);
+	BOOST_CHECK_EQUAL(bits.reads[0], 1u);
+	BOOST_CHECK_EQUAL(bits.reads[2], 2u);
+	BOOST_CHECK_EQUAL(bits.reads[1], 1u);
+	BOOST_CHECK_EQUAL(bits.reads[3], 1u);
+	BOOST_CHECK_EQUAL(bits.reads[5], 1u);
+	BOOST_CHECK_EQUAL(bits.aligned_reads, 3u);
+	BOOST_CHECK_EQUAL(bits.unaligned_reads, 3u);
+	BOOST_CHECK_EQUAL(bits.bits_written, 0u);
+
+	// Seeks, ungets and putbacks.
+	bin.seekg(8);
+	bin.tellg();
+	bin.unget();
+	bin.putback(1);
+	bits = bin.rdbuf()->stats();
+	BOOST_CHECK_EQUAL(bits.get_seekposes, 1u);
+	BOOST_CHECK(bits.get_seekoffs >= 2u);
+	BOOST_CHECK_EQUAL(bits.put_seekoffs + bits.put_seekposes, 0u);
+	boost::bitstream::stream_stats stream = bin.stats();
+	BOOST_CHECK_EQUAL(stream.ungets, 1u);
+	BOOST_CHECK_EQUAL(stream.putbacks, 1u);
+
+	// A const field that does not match, twice, then the end.
+	BOOST_CHECK_EQUAL(stream.failures, 0u);
+	bin.seekg(0);
+	bin >> false;
+	bin.clear();
+	bin >> true;
+	bin.clear();
+	bin.ignore(bin.rdbuf()->in_avail());
+	bin.read(value, 1);
+	stream = bin.stats();
+	BOOST_CHECK_EQUAL(stream.failures, 3u);
+	BOOST_CHECK_EQUAL(stream.eofs, 1u);
+	bin.reset_stats();
+	bin.rdbuf()->reset_stats();
+	BOOST_CHECK_EQUAL(bin.stats().failures, 0u);
+	BOOST_CHECK_EQUAL(bin.rdbuf()->stats().bits_read, 0u);
+
+	// Writes, and snapshots added together, e.g., from two threads.
+	char output[4];
+	boost::bitstream::obitstream bout(output, sizeof output * CHAR_BIT);
+	bout.write(5, 3);
+	bout.write(0x1234, 16);
+	bout.flush();
+	bits = bout.rdbuf()->stats();
+	BOOST_CHECK_EQUAL(bits.bits_written, 19u);
+	BOOST_CHECK_EQUAL(bits.aligned_writes, 1u);
+	BOOST_CHECK_EQUAL(bits.unaligned_writes, 1u);
+	const boost::bitstream::stream_stats total = bits + bits;
+	BOOST_CHECK_EQUAL(total.bits_written, 38u);
+	BOOST_CHECK_EQUAL(total.writes[3], 2u);
+
+	// The two sides, e.g., of a ringbitbuf, do not share a cache line.
+	BOOST_CHECK(offsetof(boost::bitstream::stream_stats, bits_written) >=
+		offsetof(boost::bitstream::stream_stats, get_seekposes) + sizeof(boost::uint64_t) +
+		boost::bitstream::detail::cache_line_bytes);
+}
+
+BOOST_AUTO_TEST_CASE(bulk_instrumentation)
+{
+	char buffer[64];
+	for (size_t i = 0; i < sizeof buffer; ++i)
+	{
+		buffer[i] = static_cast<char>(i * 37 + 11);
+	}
+
+	// Containers of integrals, copied in bulk.
+	{
+		boost::bitstream::ibitstream bin(buffer, sizeof buffer * CHAR_BIT);
+		std::vector<boost::uint16_t> words;
+		boost::uint32_t dword;
+		bin >> boost::bitstream::setrepeat(8) >> words >> dword;
+		BOOST_CHECK(bin && words.size() == 8);
+		const boost::bitstream::stream_stats bits = bin.rdbuf()->stats();
+		BOOST_CHECK_EQUAL(bits.bits_read, 160u);
+		BOOST_CHECK_EQUAL(bits.reads[3], 8u);
+		BOOST_CHECK_EQUAL(bits.reads[4], 1u);
+		BOOST_CHECK_EQUAL(bits.aligned_reads, 9u);
+
+		char output[sizeof buffer];
+		boost::bitstream::obitstream bout(output, sizeof output * CHAR_BIT);
+		bout << boost::bitstream::unitbuf << words;
+		BOOST_CHECK(bout);
+		BOOST_CHECK_EQUAL(bout.rdbuf()->stats().bits_written, 128u);
+		BOOST_CHECK_EQUAL(bout.rdbuf()->stats().writes[3], 8u);
+	}
+
+	// Packed fields, all unaligned after the first three bits.
+	{
+		boost::bitstream::ibitstream bin(buffer, sizeof buffer * CHAR_BIT);
+		boost::bitstream::bitfield value;
+		bin.read<3>(value);
+		boost::uint16_t samples[10];
+		bin.read_packed<12>(samples, 10);
+		BOOST_CHECK(bin);
+		const boost::bitstream::stream_stats bits = bin.rdbuf()->stats();
+		BOOST_CHECK_EQUAL(bits.bits_read, 3u + 120);
+		BOOST_CHECK_EQUAL(bits.reads[3], 10u);
+		BOOST_CHECK_EQUAL(bits.aligned_reads, 1u);
+		BOOST_CHECK_EQUAL(bits.unaligned_reads, 10u);
+
+		char output[sizeof buffer];
+		boost::bitstream::obitstream bout(output, sizeof output * CHAR_BIT);
+		bout.write_packed<12>(samples, 10);
+		BOOST_CHECK(bout);
+		const boost::bitstream::stream_stats written = bout.rdbuf()->stats();
+		BOOST_CHECK_EQUAL(written.bits_written, 120u);
+		BOOST_CHECK_EQUAL(written.aligned_writes, 5u);
+		BOOST_CHECK_EQUAL(written.unaligned_writes, 5u);
+	}
+
+	// A field wider than bitfield is one field.
+	{
+		boost::bitstream::ibitstream bin(buffer, sizeof buffer * CHAR_BIT);
+		std::bitset<100> wide;
+		bin >> wide;
+		BOOST_CHECK(bin);
+		BOOST_CHECK_EQUAL(bin.rdbuf()->stats().bits_read, 100u);
+		BOOST_CHECK_EQUAL(bin.rdbuf()->stats().reads[5], 1u);
+
+		char output[sizeof buffer];
+		boost::bitstream::obitstream bout(output, sizeof output * CHAR_BIT);
+		bout << boost::bitstream::unitbuf << wide;
+		BOOST_CHECK(bout);
+		BOOST_CHECK_EQUAL(bout.rdbuf()->stats().bits_written, 100u);
+		BOOST_CHECK_EQUAL(bout.rdbuf()->stats().writes[5], 1u);
+	}
+
+	// Reads under an unchecked guard, and peeks, which are not counted.
+	{
+		boost::bitstream::ibitstream bin(buffer, sizeof buffer * CHAR_BIT);
+		bin.peek();
+		bin.show_bits<16>();
+		{
+			boost::bitstream::unchecked in(bin, 24);
+			BOOST_CHECK(in.validated());
+			boost::bitstream::bitfield value;
+			in.read<4>(value);
+			in.read(value, 20);
+		}
+		BOOST_CHECK(bin);
+		const boost::bitstream::stream_stats bits = bin.rdbuf()->stats();
+		BOOST_CHECK_EQUAL(bits.bits_read, 24u);
+		BOOST_CHECK_EQUAL(bits.aligned_reads, 1u);
+		BOOST_CHECK_EQUAL(bits.unaligned_reads, 1u);
+	}
+
+	// Bits that grow a buffer are counted once.
+	{
+		boost::bitstream::vectorbitbuf vbb;
+		vbb.sputb(1);
+		BOOST_CHECK_EQUAL(vbb.stats().bits_written, 1u);
+		BOOST_CHECK_EQUAL(vbb.stats().writes[0], 1u);
+
+		boost::bitstream::ovectorbitstream bout;
+		bout << boost::bitstream::unitbuf << true;
+		bout.write(0x1234, 16);
+		BOOST_CHECK(bout);
+		BOOST_CHECK_EQUAL(bout.rdbuf()->stats().bits_written, 17u);
+	}
+}